@@ -3,4 +3,13 @@
 #include "DragonBoat.h"
 #include "Modules/ModuleManager.h"
 
+LLM_DEFINE_TAG(DragonBoat_Match3);
+LLM_DEFINE_TAG(DragonBoat_Race);
+
+DEFINE_LOG_CATEGORY(LogDragonBoatMatch3);
+DEFINE_LOG_CATEGORY(LogDragonBoatRace);
+
+UE_TRACE_CHANNEL_DEFINE(Match3Channel);
+UE_TRACE_CHANNEL_DEFINE(RaceChannel);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, DragonBoat, "DragonBoat" );
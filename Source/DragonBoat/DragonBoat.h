@@ -3,4 +3,40 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
 
+// LLM 内存标签：三消逻辑（棋盘、消除缓冲区、时间线） / 龙舟竞速（比赛进度、排名）
+LLM_DECLARE_TAG_API(DragonBoat_Match3, DRAGONBOAT_API);
+LLM_DECLARE_TAG_API(DragonBoat_Race, DRAGONBOAT_API);
+
+// ========== 日志分类 ==========
+// Shipping 中编译期最高级别为 Warning：逐步骤的 Log/Verbose 日志连同格式化参数一起被编译掉，只保留警告与错误
+#if UE_BUILD_SHIPPING
+DECLARE_LOG_CATEGORY_EXTERN(LogDragonBoatMatch3, Log, Warning);
+DECLARE_LOG_CATEGORY_EXTERN(LogDragonBoatRace, Log, Warning);
+#else
+DECLARE_LOG_CATEGORY_EXTERN(LogDragonBoatMatch3, Log, All);
+DECLARE_LOG_CATEGORY_EXTERN(LogDragonBoatRace, Log, All);
+#endif
+
+// ========== Insights 追踪通道 ==========
+// 启动参数 -trace=cpu,Match3,Race 或运行时 Trace.Enable Match3,Race 打开
+UE_TRACE_CHANNEL_EXTERN(Match3Channel, DRAGONBOAT_API);
+UE_TRACE_CHANNEL_EXTERN(RaceChannel, DRAGONBOAT_API);
+
+// ========== 周期统计 ==========
+// 控制台 stat DragonBoat 查看
+DECLARE_STATS_GROUP(TEXT("DragonBoat"), STATGROUP_DragonBoat, STATCAT_Advanced);
+
+// 同一个阶段同时记录为 Insights 中对应通道的 CPU 事件和 stat DragonBoat 中的周期统计
+#define DRAGONBOAT_MATCH3_SCOPE(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, Match3Channel); \
+	SCOPE_CYCLE_COUNTER(Stat)
+
+#define DRAGONBOAT_RACE_SCOPE(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, RaceChannel); \
+	SCOPE_CYCLE_COUNTER(Stat)
@@ -1,16 +1,68 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Datamanagement.h"
+#include "DragonBoat.h"
+#include "RaceSimulationComponent.h"
+#include "RaceBoatRegistry.h"
+#include "Misc/FileHelper.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Match3 SwapValidation"), STAT_Match3_SwapValidation, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 MatchCheck"), STAT_Match3_MatchCheck, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 Fill"), STAT_Match3_Fill, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 Generate"), STAT_Match3_Generate, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 Reshuffle"), STAT_Match3_Reshuffle, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 ResolveCascade"), STAT_Match3_ResolveCascade, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 MoveHints"), STAT_Match3_MoveHints, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race AISkillCast"), STAT_Race_AISkillCast, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race AISkillSchedule"), STAT_Race_AISkillSchedule, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race AIMatch3 Tick"), STAT_Race_AIMatch3Tick, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race AIMatch3 Batch"), STAT_Race_AIMatch3Batch, STATGROUP_DragonBoat);
+
+// Insights 计数器：每次交换的连消深度，以及累计的校验/生成/洗牌/施法次数
+TRACE_DECLARE_INT_COUNTER(Match3_CascadeDepth, TEXT("DragonBoat/Match3/CascadeDepth"));
+TRACE_DECLARE_INT_COUNTER(Match3_SwapValidations, TEXT("DragonBoat/Match3/SwapValidations"));
+TRACE_DECLARE_INT_COUNTER(Match3_BoardGenerations, TEXT("DragonBoat/Match3/BoardGenerations"));
+TRACE_DECLARE_INT_COUNTER(Match3_GenerationRetries, TEXT("DragonBoat/Match3/GenerationRetries"));
+TRACE_DECLARE_INT_COUNTER(Match3_DeadlockReshuffles, TEXT("DragonBoat/Match3/DeadlockReshuffles"));
+TRACE_DECLARE_INT_COUNTER(Race_AISkillCasts, TEXT("DragonBoat/Race/AISkillCasts"));
+TRACE_DECLARE_INT_COUNTER(Race_AIMatch3Moves, TEXT("DragonBoat/Race/AIMatch3Moves"));
+
+// 三消核心使用的颜色与效果数值必须与蓝图枚举一致
+static_assert((uint8)ETileColor::Empty == FMatch3Board::EmptyColor, "ETileColor must match FMatch3Board colors");
+static_assert((uint8)ESlotEffectType::MoraleBoost == (uint8)EMatch3Effect::MoraleBoost, "ESlotEffectType must match EMatch3Effect");
+static_assert((uint8)EAIMatch3Policy::Mixed == (uint8)EMatch3AIPolicy::Mixed, "EAIMatch3Policy must match EMatch3AIPolicy");
+static_assert((uint8)EAISkillTargetPolicy::Adaptive + 1 == (uint8)ERaceTargetPolicy::Count, "EAISkillTargetPolicy must mirror ERaceTargetPolicy");
+static_assert(std::is_same_v<FMatch3Board::FMask, uint64>, "Match check statistics and logs assume a board of at most 64 cells");
+static_assert((uint8)EMatch3State::PlayingTimeline < (1 << FMatch3NetDeltaWriter::StateBits), "EMatch3State must fit in the keyframe state bits");
 
 ADatamanagement::ADatamanagement()
 {
 	PrimaryActorTick.bCanEverTick = true;
+
+	// 双人对战：棋盘由服务器结算，改变以增量消息同步给所有客户端（对手的棋盘也显示）
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
 	SelectedTileIndex = -1;
 	PendingSwapIndexA = -1;
 	PendingSwapIndexB = -1;
+	CurrentCascadeDepth = 0;
 	GameState = EMatch3State::Idle;
-
-	// ʿֵϵͳʼ
+	bResolveCascadeInOneCall = false;
+	bExpandEffectTriggerIndices = true;
+	bCoalesceStepEvents = false;
+	bUseNativeBoardWidget = false;
+	bResolvingStep = false;
+	bDebugVerifyLocalMatchCheck = false;
+
+	// 交换提示初始化
+	HintBudgetMicroseconds = 50.0f;
+	HintWeightPerTile = 1.0f;
+	HintWeightPerSpecialArea = 5.0f;
+	HintWeightPerMorale = 0.2f;
+
+	// 士气值系统初始化
 	CurrentMorale = 0;
 	MaxMorale = 100;
 	MoralePerTile = 5;
@@ -18,19 +70,19 @@ ADatamanagement::ADatamanagement()
 	SkillPoints = 0;
 	MaxSkillPoints = 3;
 
-	// ۾Чʼ
+	// 龙舟竞速效果初始化
 	SpeedBoostPerTrigger = 50.0f;
 	SlowDownPerTrigger = 30.0f;
 
-	// ϵͳʼĬװ2ܣ
+	// 技能系统初始化（默认装备2个技能）
 	EquippedSkills.SetNum(2);
-	EquippedSkills[0] = ESkillType::EastWind; // λ1ɽ趫
-	EquippedSkills[1] = ESkillType::FloodSeven;   // λ2ˮ߾
+	EquippedSkills[0] = ESkillType::EastWind; // 槽位1：巧借东风
+	EquippedSkills[1] = ESkillType::FloodSeven;   // 槽位2：水淹七军
 
-	// ʼ
+	// 初始化技能配置
 	FSkillConfig EastWindConfig;
 	EastWindConfig.Duration = 5.0f;
-	EastWindConfig.EffectValue = 250.0f;  // ٶȼӳ
+	EastWindConfig.EffectValue = 250.0f;  // 速度加成
 	SkillConfigs.Add(ESkillType::EastWind, EastWindConfig);
 
 	FSkillConfig FloodConfig;
@@ -40,83 +92,199 @@ ADatamanagement::ADatamanagement()
 
 	FSkillConfig FogConfig;
 	FogConfig.Duration = 5.0f;
-	FogConfig.EffectValue = 0.5f;  // ͸
+	FogConfig.EffectValue = 0.5f;  // 雾的透明度
 	SkillConfigs.Add(ESkillType::HeavyFog, FogConfig);
 
 	FSkillConfig ChainConfig;
 	ChainConfig.Duration = 5.0f;
-	ChainConfig.EffectValue = 4.0f;  // 
+	ChainConfig.EffectValue = 4.0f;  // 锁定格子数量
 	SkillConfigs.Add(ESkillType::IronChain, ChainConfig);
 
-	// ճǼ
+	// 空城计配置
 	FSkillConfig EmptyCityConfig;
-	EmptyCityConfig.Duration = 8.0f;   // ߳ʱ
+	EmptyCityConfig.Duration = 8.0f;   // 免疫持续时间
 	EmptyCityConfig.EffectValue = 0.0f;
 	SkillConfigs.Add(ESkillType::EmptyCity, EmptyCityConfig);
 
-	// AIϵͳʼ
-	bEnableAISkills = true;  // Ĭ
-	AISkillIntervalMin = 10.0f;  // С10
-	AISkillIntervalMax = 20.0f;  // 20
-	bRandomizeAISkillsEachRace = false;  // Ĭϲʹù̶
-
-	// AI1 2ܣ
-	AI1_EquippedSkills.SetNum(2);
-	AI1_EquippedSkills[0] = ESkillType::EastWind;     // λ1ɽ趫
-	AI1_EquippedSkills[1] = ESkillType::FloodSeven;   // λ2ˮ߾
-
-	// AI2 2ܣ
-	AI2_EquippedSkills.SetNum(2);
-	AI2_EquippedSkills[0] = ESkillType::HeavyFog;     // λ1
-	AI2_EquippedSkills[1] = ESkillType::IronChain;    // λ2
-
-	// ʼĿӳ
-	SkillTargetTypeMap.Add(ESkillType::EastWind, ESkillTargetType::Self);      // 棺Լ
-	SkillTargetTypeMap.Add(ESkillType::FloodSeven, ESkillTargetType::Enemy); // 棺
-	SkillTargetTypeMap.Add(ESkillType::HeavyFog, ESkillTargetType::Enemy);     // 棺
-	SkillTargetTypeMap.Add(ESkillType::IronChain, ESkillTargetType::Enemy);    // 棺
-	SkillTargetTypeMap.Add(ESkillType::EmptyCity, ESkillTargetType::Self);     // 棺Լ
+	// AI技能系统初始化
+	bEnableAISkills = true;  // 默认启用
+	AISkillIntervalMin = 10.0f;  // 最小10秒
+	AISkillIntervalMax = 20.0f;  // 最大20秒
+	bRandomizeAISkillsEachRace = false;  // 默认不随机，使用固定配置
+	AISkillTargetPolicy = EAISkillTargetPolicy::Adaptive;
+	AIOvertakeMemorySeconds = 8.0f;
+
+	// AI三消模拟初始化
+	bAIPlaysMatch3 = true;
+	AIMatch3Policy = EAIMatch3Policy::Greedy;
+	AIGreedyChance = 0.5f;
+	AIMovesPerSecond = 0.5f;  // 大约与玩家的操作节奏一致
+	AIBatchIntervalSeconds = 1.0f;
+	bAIMatch3Running = false;
+
+	// 网络对战初始化
+	BoardBoatIndex = 0;
+	NetKeyframeIntervalSeconds = 2.0f;
+	NetMaxDeltaBytes = 1024;
+	NetSequence = 0;
+	NetKeyframeTimer = 0.0f;
+	bNetKeyframeRequested = false;
+	bNetSynced = false;
+	bNetTimelineOpen = false;
+	bAwaitingSwapResult = false;
+	NetPredictedMoraleReward = 0;
+	HumanControlledAIMask = 0;
+
+	// AI1 配置2个技能：巧借东风、水淹七军；AI2：大雾、铁索连环
+	AIEquippedSkills.SetNum(2);
+	AIEquippedSkills[0].Skills = { ESkillType::EastWind, ESkillType::FloodSeven };
+	AIEquippedSkills[1].Skills = { ESkillType::HeavyFog, ESkillType::IronChain };
+
+	// 初始化技能目标类型映射
+	SkillTargetTypeMap.Add(ESkillType::EastWind, ESkillTargetType::Self);      // 增益：给自己加速
+	SkillTargetTypeMap.Add(ESkillType::FloodSeven, ESkillTargetType::Enemy); // 减益：攻击敌人
+	SkillTargetTypeMap.Add(ESkillType::HeavyFog, ESkillTargetType::Enemy);     // 减益：攻击敌人
+	SkillTargetTypeMap.Add(ESkillType::IronChain, ESkillTargetType::Enemy);    // 减益：攻击敌人
+	SkillTargetTypeMap.Add(ESkillType::EmptyCity, ESkillTargetType::Self);     // 增益：保护自己
 }
 
 void ADatamanagement::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// 默认随机播种，比赛开始时由 GameMode 用比赛种子重新播种
+	InitRandomStreams(FMath::Rand());
 	InitializeGame();
 
-	// AI ϵͳ GameMode ƣںʵʱ StartAISkillSystem()
+	// 客户端：棋盘来自服务器，BeginPlay 之前已经收到的关键帧在这里应用
+	if (!HasAuthority() && BoardKeyframe.Data.Num() > 0)
+	{
+		OnRep_BoardKeyframe();
+	}
+
+	// AI 技能系统启动由 GameMode 控制，在合适的时机调用 StartAISkillSystem()
+}
+
+void ADatamanagement::PostLoad()
+{
+	Super::PostLoad();
+
+	// 旧关卡与蓝图中保存的 AI1_/AI2_EquippedSkills
+	MigrateDeprecatedAISkills();
+}
+
+void ADatamanagement::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// 工作线程上的AI模拟引用本Actor持有的棋盘，销毁前必须结束
+	WaitForAIMatch3();
+	EndReplayRecording();
+	Super::EndPlay(EndPlayReason);
 }
 
 void ADatamanagement::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	if (bAIMatch3Running)
+	{
+		TickAIMatch3(DeltaTime);
+	}
+
+	if (ReplayArchive && ReplayRecorder.GetPendingBytes().Num() >= ReplayFlushBytes)
+	{
+		FlushReplay();
+	}
+
+	if (ShouldRecordNetDelta())
+	{
+		FlushNetDelta(DeltaTime);
+	}
+}
+
+void ADatamanagement::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// 棋盘、特殊格子、士气值与技能点通过增量消息同步，这里只复制配置与关键帧
+	DOREPLIFETIME(ADatamanagement, BoardBoatIndex);
+	DOREPLIFETIME(ADatamanagement, bResolveCascadeInOneCall);
+	DOREPLIFETIME(ADatamanagement, MaxMorale);
+	DOREPLIFETIME(ADatamanagement, MoralePerTile);
+	DOREPLIFETIME(ADatamanagement, SpecialMoraleBonus);
+	DOREPLIFETIME(ADatamanagement, MaxSkillPoints);
+	DOREPLIFETIME(ADatamanagement, SpeedBoostPerTrigger);
+	DOREPLIFETIME(ADatamanagement, SlowDownPerTrigger);
+	DOREPLIFETIME(ADatamanagement, EquippedSkills);
+	DOREPLIFETIME(ADatamanagement, BoardKeyframe);
 }
 
 // ========================================
-// Ľ߼
+// 核心交换逻辑
 // ========================================
 
 bool ADatamanagement::TrySwap(int32 IndexA, int32 IndexB)
 {
-	// ֻڿ״̬µĽ
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	// 只在空闲状态允许新的交换操作
 	if (GameState != EMatch3State::Idle)
 		return false;
 
-	// 1. Ԥִн
-	OrbGrid.Swap(IndexA, IndexB);
-	
-	// 2. 齻Ƿκƥ
-	bool bValidMove = HasMatch(); 
+	bool bValidMove;
+	{
+		DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_SwapValidation);
+		TRACE_COUNTER_INCREMENT(Match3_SwapValidations);
+
+		// 1. 查询可交换索引，O(1) 判断交换后是否产生匹配
+		bValidMove = Match3.IsValidSwap(IndexA, IndexB);
+	}
+
+	// 调试模式：在副本上预执行交换，与扫描结果交叉验证
+	if (bDebugVerifyLocalMatchCheck)
+	{
+		FMatch3Board Scratch = Match3.GetBoard();
+		Scratch.SwapCells(IndexA, IndexB);
+		const bool bScanValid = !IsCellLocked(IndexA) && !IsCellLocked(IndexB)
+			&& HasLocalMatch(Scratch, FMatch3Board::CellBit(IndexA) | FMatch3Board::CellBit(IndexB));
+
+		if (bScanValid != bValidMove)
+		{
+			UE_LOG(LogDragonBoatMatch3, Error, TEXT("TrySwap: MoveIndex mismatch for %d <-> %d! Index=%d, Scan=%d"),
+				IndexA, IndexB, bValidMove, bScanValid);
+			bValidMove = bScanValid;
+		}
+	}
 
 	if (bValidMove)
 	{
-		// Чƶݣ뽻״̬
-		StartSwap(IndexA, IndexB);
+		// 2. 有效移动：执行交换，进入交换动画状态
+		// 远端玩家的棋盘由服务器一次性结算，服务器的状态不由客户端的动画推进
+		const bool bRemoteBoard = !IsControlledLocally();
+		Match3.ApplySwap(IndexA, IndexB);
+		OrbGrid.Swap(IndexA, IndexB);
+		if (ShouldRecordNetDelta())
+		{
+			NetDelta.RecordSwap(IndexA, IndexB, bResolveCascadeInOneCall || bRemoteBoard);
+			++NetStats.Swaps;
+		}
+		if (bResolveCascadeInOneCall || bRemoteBoard)
+		{
+			ResolveCascade(IndexA, IndexB);
+			if (bRemoteBoard)
+			{
+				// 时间线只在客户端（与主机显示对手棋盘的UI）播放，服务器立即接受下一次交换
+				GameState = EMatch3State::Idle;
+			}
+		}
+		else
+		{
+			StartSwap(IndexA, IndexB);
+		}
 		return true;
 	}
 	else
 	{
-		// Чƶָԭݣʧܶ
-		OrbGrid.Swap(IndexA, IndexB);
+		// 无效移动：数据不变，播放失败动画
 		PendingSwapIndexA = IndexA;
 		PendingSwapIndexB = IndexB;
 		RevertSwap(IndexA, IndexB);
@@ -126,47 +294,78 @@ bool ADatamanagement::TrySwap(int32 IndexA, int32 IndexB)
 
 void ADatamanagement::AdvanceGameState()
 {
-	UE_LOG(LogTemp, Log, TEXT("AdvanceGameState called, Current State: %d"), (int32)GameState);
+	if (!HasAuthority())
+	{
+		// 客户端：失败动画与时间线只在本地播放；其余状态等服务器的下一条消息带来结果
+		// （服务器一次性结算客户端玩家的棋盘，不等待客户端的动画）
+		if (GameState == EMatch3State::RevertingSwap || GameState == EMatch3State::PlayingTimeline)
+		{
+			GameState = EMatch3State::Idle;
+		}
+		return;
+	}
+
+	// 远端玩家的棋盘只由它的客户端推进（主机UI显示对手棋盘时的回调忽略）
+	if (!IsControlledLocally())
+	{
+		return;
+	}
+
+	AdvanceBoardState();
+}
+
+void ADatamanagement::AdvanceBoardState()
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("AdvanceGameState called, Current State: %d"), (int32)GameState);
 	
 	switch (GameState)
 	{
 	case EMatch3State::Swapping:
-		//  -> ʼƥ
-		UE_LOG(LogTemp, Log, TEXT("  -> Swapping finished, checking matches..."));
+		// 交换动画完成 -> 开始检查匹配
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Swapping finished, checking matches..."));
 		ProcessMatchCheck();
 		break;
 		
 	case EMatch3State::RevertingSwap:
-		// ʧܻ˶ -> صУһβ
-		UE_LOG(LogTemp, Log, TEXT("  -> RevertingSwap finished, back to Idle"));
+		// 失败回退动画完成 -> 回到空闲，接受下一次操作
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> RevertingSwap finished, back to Idle"));
 		GameState = EMatch3State::Idle;
 		break;
 
 	case EMatch3State::Clearing:
 		{
-			//  -> ִ߼ո
-			UE_LOG(LogTemp, Log, TEXT("  -> Clearing finished, filling empty tiles..."));
+			// 消除动画完成 -> 执行下落逻辑，填充空格子
+			UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Clearing finished, filling empty tiles..."));
 			
-			LastFallMoves = FillEmptyTiles();
+			FillEmptyTiles(LastFallMoves);
 			GameState = EMatch3State::Falling;
 			
-			UE_LOG(LogTemp, Log, TEXT("  -> Generated %d fall moves, triggering OnFallAnimTriggered"), LastFallMoves.Num());
+			UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Generated %d fall moves, triggering OnFallAnimTriggered"), LastFallMoves.Num());
 			
-			// [ʱ4] ֪ͨUI䶯
+			// [时机4] 通知UI播放下落动画
 			OnFallAnimTriggered(LastFallMoves);
+			OnFallAnimNative.Broadcast(LastFallMoves);
 		}
 		break;
 
 	case EMatch3State::Falling:
-		// 䶯 -> ݹµƥ䣨⣩
-		UE_LOG(LogTemp, Log, TEXT("  -> Falling finished, checking matches again (combo check)..."));
+		// 下落动画完成 -> 递归检查新的匹配（连消检测）
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Falling finished, checking matches again (combo check)..."));
 		ProcessMatchCheck();
 		break;
+
+	case EMatch3State::PlayingTimeline:
+		// 时间线动画全部播放完成 -> 回到空闲
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> PlayingTimeline finished, back to Idle"));
+		GameState = EMatch3State::Idle;
+		break;
 		
 	case EMatch3State::CheckMatching:
 	case EMatch3State::Idle:
 	default:
-		UE_LOG(LogTemp, Warning, TEXT("  -> AdvanceGameState called in unexpected state: %d"), (int32)GameState);
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("  -> AdvanceGameState called in unexpected state: %d"), (int32)GameState);
 		break;
 	}
 }
@@ -174,380 +373,421 @@ void ADatamanagement::AdvanceGameState()
 void ADatamanagement::StartSwap(int32 IndexA, int32 IndexB)
 {
 	GameState = EMatch3State::Swapping;
-	UE_LOG(LogTemp, Log, TEXT("StartSwap: State -> Swapping"));
+	CurrentCascadeDepth = 0;
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("StartSwap: State -> Swapping"));
 	
-	// [ʱ2] ֪ͨUIųɹĽ
+	// [时机2] 通知UI播放成功的交换动画
 	OnSwapAnimTriggered(IndexA, IndexB, true);
+	OnSwapAnimNative.Broadcast(IndexA, IndexB, true);
 }
 
 void ADatamanagement::RevertSwap(int32 IndexA, int32 IndexB)
 {
 	GameState = EMatch3State::RevertingSwap;
-	UE_LOG(LogTemp, Log, TEXT("RevertSwap: State -> RevertingSwap"));
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("RevertSwap: State -> RevertingSwap"));
 	
-	// [ʱ2] ֪ͨUIʧܵĽػζλ
+	// [时机2] 通知UI播放失败的交换动画（来回晃动后复位）
 	OnSwapAnimTriggered(IndexA, IndexB, false);
+	OnSwapAnimNative.Broadcast(IndexA, IndexB, false);
 }
 
 void ADatamanagement::ProcessMatchCheck()
 {
 	GameState = EMatch3State::CheckMatching;
-	UE_LOG(LogTemp, Log, TEXT("ProcessMatchCheck: State -> CheckMatching"));
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("ProcessMatchCheck: State -> CheckMatching"));
 
-	TSet<int32> MatchedIndices;
-
-	// ƥ
-	for (int32 Row = 0; Row < GridSize; ++Row)
+	// 复用成员缓冲区，预热后不再分配堆内存
+	if (ResolveMatchStep(LastStepResult))
+	{
+		DispatchClearingStep();
+	}
+	else
 	{
-		for (int32 Col = 0; Col < GridSize - 2; ++Col)
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> No matches found, checking for deadlock..."));
+		TRACE_COUNTER_SET(Match3_CascadeDepth, CurrentCascadeDepth);
+
+		if (SettleBoard())
 		{
-			int32 Idx = Row * GridSize + Col;
-			ETileColor Color = OrbGrid[Idx];
-			if (Color == ETileColor::Empty) continue;
+			UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Triggering OnBoardReshuffle"));
 			
-			if (OrbGrid[Idx + 1] == Color && OrbGrid[Idx + 2] == Color)
-			{
-				MatchedIndices.Add(Idx);
-				MatchedIndices.Add(Idx + 1);
-				MatchedIndices.Add(Idx + 2);
-				
-				// Ƿ񳬹345
-				int32 NextCol = Col + 3;
-				while (NextCol < GridSize && OrbGrid[Row * GridSize + NextCol] == Color)
-				{
-					MatchedIndices.Add(Row * GridSize + NextCol);
-					NextCol++;
-				}
-			}
+			// [时机5] 通知UI棋盘洗牌动画
+			OnBoardReshuffle();
+			OnBoardRebuiltNative.Broadcast(true);
 		}
+		RecordReplayChecksum();
+		if (ShouldRecordNetDelta())
+		{
+			NetDelta.RecordSettle();
+		}
+		
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> State -> Idle"));
+		GameState = EMatch3State::Idle;
 	}
+}
+
+void ADatamanagement::DispatchClearingStep()
+{
+	GameState = EMatch3State::Clearing;
+	++CurrentCascadeDepth;
+	LastStepResult.CascadeDepth = CurrentCascadeDepth;
+	OnStepResolvedNative.Broadcast(LastStepResult);
+	OnClearAnimNative.Broadcast(LastStepResult);
 
-	// ƥ
-	for (int32 Col = 0; Col < GridSize; ++Col)
+	if (bCoalesceStepEvents)
 	{
-		for (int32 Row = 0; Row < GridSize - 2; ++Row)
-		{
-			int32 Idx = Row * GridSize + Col;
-			ETileColor Color = OrbGrid[Idx];
-			if (Color == ETileColor::Empty) continue;
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Triggering OnMatchStepResolved (step %d)"), CurrentCascadeDepth);
 
-			if (OrbGrid[Idx + GridSize] == Color && OrbGrid[Idx + GridSize * 2] == Color)
-			{
-				MatchedIndices.Add(Idx);
-				MatchedIndices.Add(Idx + GridSize);
-				MatchedIndices.Add(Idx + GridSize * 2);
-
-				// Ƿ񳬹3
-				int32 NextRow = Row + 3;
-				while (NextRow < GridSize && OrbGrid[NextRow * GridSize + Col] == Color)
-				{
-					MatchedIndices.Add(NextRow * GridSize + Col);
-					NextRow++;
-				}
-			}
-		}
+		// [时机3'] 一个事件交付本步的全部结果
+		OnMatchStepResolved(LastStepResult);
+	}
+	else
+	{
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Triggering OnMatchesCleared with %d special effects"), LastStepResult.TriggeredEffects.Num());
+
+		// [时机3] 通知UI播放消除动画
+		OnMatchesCleared(LastStepResult.ClearedIndices, LastStepResult.TriggeredEffects);
 	}
+}
 
-	if (MatchedIndices.Num() > 0)
+bool ADatamanagement::ResolveMatchStep(FMatch3StepResult& OutStep)
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_MatchCheck);
+
+	// 位运算查找横向与纵向匹配（只检查经过上次改动格子的行与列）
+	uint64 HorizontalMatches, VerticalMatches;
+	FindLocalMatches(Match3.GetPendingDirtyMask(), HorizontalMatches, VerticalMatches);
+	const uint64 MatchedMask = HorizontalMatches | VerticalMatches;
+
+	if (MatchedMask == 0)
 	{
-		TArray<int32> ClearedArray = MatchedIndices.Array();
-		GameState = EMatch3State::Clearing;
-		
-		UE_LOG(LogTemp, Log, TEXT("-> Found %d matches! State -> Clearing"), ClearedArray.Num());
-		
-		// ռЧ
-		TArray<FSpecialEffectData> TriggeredEffects = CollectSpecialEffects(ClearedArray);
-		
-		// 㲢ʿֵ
-		int32 MoraleReward = CalculateMoraleReward(ClearedArray.Num(), TriggeredEffects);
-		if (MoraleReward > 0)
-		{
-			AddMorale(MoraleReward);
-		}
+		return false;
+	}
+
+	ClearMatchedCells(HorizontalMatches, VerticalMatches, OutStep);
+	return true;
+}
 
-		// ۾Ч
-		TriggerRaceEffects(TriggeredEffects);
+void ADatamanagement::ClearMatchedCells(uint64 HorizontalMatches, uint64 VerticalMatches, FMatch3StepResult& OutStep)
+{
+	const uint64 MatchedMask = HorizontalMatches | VerticalMatches;
 
-		// ƥķ
-		for (int32 Idx : ClearedArray)
-		{
-			OrbGrid[Idx] = ETileColor::Empty;
-		}
+	// 合并事件模式下，本步内的士气/技能点/效果事件推迟到汇总结果中
+	TGuardValue<bool> ResolvingStepGuard(bResolvingStep, true);
 
-		UE_LOG(LogTemp, Log, TEXT("  -> Triggering OnMatchesCleared with %d special effects"), TriggeredEffects.Num());
-		
-		// [ʱ3] ֪ͨUI
-		OnMatchesCleared(ClearedArray, TriggeredEffects);
+	// 展开为索引数组，顺序与旧版一致：先横向匹配（行优先），再仅属纵向匹配的格子（列优先）
+	OutStep.ClearedMask = MatchedMask;
+	OutStep.ClearedIndices.Reset(FMath::CountBits(MatchedMask));
+	FMatch3Game::ForEachMatchedCell(HorizontalMatches, VerticalMatches, [&OutStep](int32 Idx)
+	{
+		OutStep.ClearedIndices.Add(Idx);
+	});
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("-> Found %d matches!"), OutStep.ClearedIndices.Num());
+	
+	// 收集触发的特殊效果（供UI使用）
+	CollectSpecialEffects(MatchedMask, OutStep.TriggeredEffects);
+	
+	// 本步的士气值与龙舟竞速效果
+	const FMatch3SpecialAreas& SpecialAreas = Match3.GetSpecialAreas();
+	OutStep.MoraleReward = CalculateMoraleReward(MatchedMask);
+	OutStep.SpeedUpTriggers = SpecialAreas.CountHits(MatchedMask, EMatch3Effect::SpeedUpSelf);
+	OutStep.SlowDownTriggers = SpecialAreas.CountHits(MatchedMask, EMatch3Effect::SlowDownEnemy);
+	if (HasAuthority())
+	{
+		ApplyStepRewards(OutStep);
 	}
 	else
 	{
-		UE_LOG(LogTemp, Log, TEXT("  -> No matches found, checking for deadlock..."));
-		
-		// Ƿ
-		if (!HasAnyValidMove())
-		{
-			UE_LOG(LogTemp, Warning, TEXT("  -> DEADLOCK detected! Reshuffling board..."));
-			
-			// ̣λò䣩
-			GenerateBoard();
-			
-			UE_LOG(LogTemp, Log, TEXT("  -> Triggering OnBoardReshuffle"));
-			
-			// [ʱ5] ֪ͨUIϴƶ
-			OnBoardReshuffle();
-		}
-		
-		UE_LOG(LogTemp, Log, TEXT("  -> State -> Idle"));
-		GameState = EMatch3State::Idle;
+		PredictStepRewards(OutStep);
+	}
+
+	// 清空匹配的方块
+	Match3.ClearCells(MatchedMask);
+	for (int32 Idx : OutStep.ClearedIndices)
+	{
+		OrbGrid[Idx] = ETileColor::Empty;
+	}
+	if (ShouldRecordNetDelta())
+	{
+		NetDelta.RecordClear(MatchedMask);
 	}
 }
 
+void ADatamanagement::ApplyStepRewards(FMatch3StepResult& Step)
+{
+	// 添加士气值
+	const int32 SkillPointsBefore = SkillPoints;
+	if (Step.MoraleReward > 0)
+	{
+		AddMorale(Step.MoraleReward);
+	}
+	Step.MoraleAfterStep = CurrentMorale;
+	Step.SkillPointsAfterStep = SkillPoints;
+	Step.SkillPointsGained = SkillPoints - SkillPointsBefore;
+
+	// 触发龙舟竞速效果
+	TriggerRaceEffects(Step);
+}
+
+void ADatamanagement::PredictStepRewards(FMatch3StepResult& Step)
+{
+	// 客户端的棋盘只是镜像：不改变士气值、不触发竞速效果，实际结果由服务器的 Morale 操作同步
+	// 这里只按相同规则预测，供本步的动画显示
+	const int32 SkillPointsBefore = NetPredictedMorale.SkillPoints;
+	if (Step.MoraleReward > 0)
+	{
+		FMatch3Morale::AddMorale(NetPredictedMorale, GetMoraleConfig(), Step.MoraleReward);
+		NetPredictedMoraleReward += Step.MoraleReward;
+	}
+	Step.MoraleAfterStep = NetPredictedMorale.CurrentMorale;
+	Step.SkillPointsAfterStep = NetPredictedMorale.SkillPoints;
+	Step.SkillPointsGained = NetPredictedMorale.SkillPoints - SkillPointsBefore;
+}
+
+bool ADatamanagement::SettleBoard()
+{
+	// 棋盘已稳定：只重新评估改动格子附近的交换
+	Match3.Settle();
+	
+	// 检查是否死锁（可交换索引为空）
+	if (HasAnyValidMove())
+	{
+		return false;
+	}
+
+	UE_LOG(LogDragonBoatMatch3, Warning, TEXT("  -> DEADLOCK detected! Reshuffling board..."));
+	TRACE_COUNTER_INCREMENT(Match3_DeadlockReshuffles);
+	
+	// 重新排列现有方块（特殊格子位置不变）
+	ReshuffleBoard();
+	return true;
+}
+
+void ADatamanagement::ResolveCascade(int32 IndexA, int32 IndexB)
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_ResolveCascade);
+
+	BeginTimeline(IndexA, IndexB);
+
+	// 同步结算整条连消链：消除 -> 效果/士气 -> 下落，直到没有新的匹配
+	while (ResolveMatchStep(CascadeStepResult))
+	{
+		FillEmptyTiles(AddTimelineStep().FallMoves);
+	}
+
+	FCascadeTimeline& Timeline = LastCascadeTimeline;
+	TRACE_COUNTER_SET(Match3_CascadeDepth, Timeline.Steps.Num());
+	Timeline.bReshuffled = SettleBoard();
+	if (Timeline.bReshuffled)
+	{
+		OnBoardRebuiltNative.Broadcast(true);
+	}
+	RecordReplayChecksum();
+	if (ShouldRecordNetDelta())
+	{
+		NetDelta.RecordSettle();
+	}
+	FinishTimeline();
+}
+
+void ADatamanagement::BeginTimeline(int32 IndexA, int32 IndexB)
+{
+	GameState = EMatch3State::PlayingTimeline;
+
+	FCascadeTimeline& Timeline = LastCascadeTimeline;
+	Timeline.SwapIndexA = IndexA;
+	Timeline.SwapIndexB = IndexB;
+	Timeline.bReshuffled = false;
+
+	// 回收上一条时间线的步骤（各数组保留容量）
+	for (FCascadeStep& OldStep : Timeline.Steps)
+	{
+		CascadeStepPool.Add(MoveTemp(OldStep));
+	}
+	Timeline.Steps.Reset();
+}
+
+FCascadeStep& ADatamanagement::AddTimelineStep()
+{
+	FCascadeTimeline& Timeline = LastCascadeTimeline;
+	CascadeStepResult.CascadeDepth = Timeline.Steps.Num() + 1;
+	OnStepResolvedNative.Broadcast(CascadeStepResult);
+
+	// 结算缓冲与回收的步骤交换数组：步骤拿走本步结果，缓冲拿回旧数组的容量
+	FCascadeStep& Step = Timeline.Steps.Add_GetRef(
+		CascadeStepPool.Num() > 0 ? CascadeStepPool.Pop(EAllowShrinking::No) : FCascadeStep());
+	Swap(Step.ClearedIndices, CascadeStepResult.ClearedIndices);
+	Swap(Step.TriggeredEffects, CascadeStepResult.TriggeredEffects);
+	Step.MoraleReward = CascadeStepResult.MoraleReward;
+	Step.MoraleAfterStep = CascadeStepResult.MoraleAfterStep;
+	Step.SkillPointsAfterStep = CascadeStepResult.SkillPointsAfterStep;
+	return Step;
+}
+
+void ADatamanagement::FinishTimeline()
+{
+	FCascadeTimeline& Timeline = LastCascadeTimeline;
+	LastFallMoves.Reset();
+	if (Timeline.Steps.Num() > 0)
+	{
+		LastFallMoves.Append(Timeline.Steps.Last().FallMoves);
+	}
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("ResolveCascade: %d steps, reshuffled: %d, State -> PlayingTimeline"),
+		Timeline.Steps.Num(), Timeline.bReshuffled);
+
+	// [时机6] 通知UI按时间线连续播放全部动画，播放完成后调用 AdvanceGameState
+	GameState = EMatch3State::PlayingTimeline;
+	OnCascadeResolved(Timeline);
+	OnCascadeResolvedNative.Broadcast(Timeline);
+}
+
 // ========================================
-// ӿ
+// 公共接口
 // ========================================
 
 void ADatamanagement::InitializeGame()
 {
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
 	SelectedTileIndex = -1;
 	GameState = EMatch3State::Idle;
 
-	// ʿֵϵͳ
+	// 重置士气值系统
 	CurrentMorale = 0;
 	SkillPoints = 0;
 	
-	int32 TotalTiles = GridSize * GridSize;
+	const int32 TotalTiles = FMatch3Board::NumCells;
 	OrbGrid.Init(ETileColor::Empty, TotalTiles);
+	Match3.Reset();
 	
-	// ΪգʼĬ
+	// 如果特殊格子配置为空，初始化默认配置
 	if (SpecialAreaGrid.Num() != TotalTiles)
 	{
 		SpecialAreaGrid.Init(ESlotEffectType::None, TotalTiles);
 		
-		// ĬãԳƷֲ3
-		// λ (3, 3) = 24 -> ʿ
-		SpecialAreaGrid[24] = ESlotEffectType::MoraleBoost;
+		// 默认配置：中间一行对称分布的3个特殊格子（7x7 棋盘为 (3,3) / (3,1) / (3,5)）
+		const int32 CenterRow = BoardRows / 2;
+		const int32 CenterCol = BoardCols / 2;
+
+		// 中心位置 -> 士气提升
+		SpecialAreaGrid[RowColToIndex(CenterRow, CenterCol)] = ESlotEffectType::MoraleBoost;
 		
-		//  (3, 1) = 22 -> Լ
-		SpecialAreaGrid[22] = ESlotEffectType::SpeedUpSelf;
+		// 中心左侧两格 -> 加速自己
+		SpecialAreaGrid[RowColToIndex(CenterRow, CenterCol - 2)] = ESlotEffectType::SpeedUpSelf;
 		
-		// Ҳ (3, 5) = 26 -> ٵ
-		SpecialAreaGrid[26] = ESlotEffectType::SlowDownEnemy;
+		// 中心右侧两格 -> 减速敌人
+		SpecialAreaGrid[RowColToIndex(CenterRow, CenterCol + 2)] = ESlotEffectType::SlowDownEnemy;
 		
-		UE_LOG(LogTemp, Log, TEXT("InitializeGame: SpecialAreaGrid initialized with default symmetric layout"));
-		UE_LOG(LogTemp, Log, TEXT("  -> Center (3,3) = MoraleBoost"));
-		UE_LOG(LogTemp, Log, TEXT("  -> Left (3,1) = SpeedUpSelf"));
-		UE_LOG(LogTemp, Log, TEXT("  -> Right (3,5) = SlowDownEnemy"));
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("InitializeGame: SpecialAreaGrid initialized with default symmetric layout"));
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Center (%d,%d) = MoraleBoost"), CenterRow, CenterCol);
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Left (%d,%d) = SpeedUpSelf"), CenterRow, CenterCol - 2);
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Right (%d,%d) = SlowDownEnemy"), CenterRow, CenterCol + 2);
 	}
+	SyncSpecialAreasToCore();
+	ReserveMatchBuffers();
 
-	// ɳʼ
+	// 生成初始棋盘
 	GenerateBoard();
 	
-	// [ʱ1] ֪ͨUIзӱʶ
-	// UIӦã
-	// 1.  OrbGrid ӦɫķWidget
-	// 2.  SpecialAreaGridNoneڶӦλʾӱʶ/ͼȣ
-	UE_LOG(LogTemp, Log, TEXT("InitializeGame: Board initialized, triggering OnBoardInitialized"));
+	// [时机1] 通知UI创建所有方块和特殊格子标识
+	// UI应该：
+	// 1. 遍历 OrbGrid 创建对应颜色的方块Widget
+	// 2. 遍历 SpecialAreaGrid，如果不是None，则在对应位置显示特殊格子标识（光晕/图标等）
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("InitializeGame: Board initialized, triggering OnBoardInitialized"));
 	OnBoardInitialized();
+	OnBoardRebuiltNative.Broadcast(false);
 }
 
 void ADatamanagement::GenerateBoard()
 {
-	bool bIsValidBoard = false;
-	const int32 MaxRetries = 100;
-	int32 RetryCount = 0;
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_Generate);
+	TRACE_COUNTER_INCREMENT(Match3_BoardGenerations);
+
+	// 构造式生成：一次遍历得到没有匹配、且至少有一个有效交换的棋盘
+	Match3.Generate([this](int32 Max) { return BoardStream.RandHelper(Max); });
+	SyncOrbGridFromBoard();
+	RecordNetKeyframe(false);
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("GenerateBoard: Generated valid board with %d valid swaps"), Match3.GetMoveIndex().Num());
+}
+
+void ADatamanagement::ReshuffleBoard()
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_Reshuffle);
 
-	while (!bIsValidBoard && RetryCount < MaxRetries)
+	// 重新排列现有方块；颜色分布无法排成有效棋盘时改为重新生成
+	if (!Match3.Reshuffle([this](int32 Max) { return BoardStream.RandHelper(Max); }))
 	{
-		// 1. 
-		for (int32 i = 0; i < OrbGrid.Num(); i++)
-		{
-			int32 ColorInt = FMath::RandRange(0, 3);
-			OrbGrid[i] = static_cast<ETileColor>(ColorInt);
-		}
+		TRACE_COUNTER_INCREMENT(Match3_GenerationRetries);
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("ReshuffleBoard: Existing tiles cannot form a valid board, regenerated instead"));
+	}
+	SyncOrbGridFromBoard();
+	RecordNetKeyframe(true);
 
-		// 2. гʼƥ䣨鲢滻
-		bool bHadMatches = true;
-		int32 FixAttempts = 0;
-		const int32 MaxFixAttempts = 200;
-		
-		while (bHadMatches && FixAttempts < MaxFixAttempts)
-		{
-			bHadMatches = false;
-			FixAttempts++;
-			
-			// ÿӣǷγƥ
-			for (int32 Row = 0; Row < GridSize; ++Row)
-			{
-				for (int32 Col = 0; Col < GridSize; ++Col)
-				{
-					int32 Idx = Row * GridSize + Col;
-					ETileColor CurrentColor = OrbGrid[Idx];
-					
-					if (CurrentColor == ETileColor::Empty)
-						continue;
-					
-					bool bIsInMatch = false;
-					
-					// ƥ䣨ǰǷǺ3һ֣
-					if (Col >= 2)
-					{
-						// 
-						if (OrbGrid[Idx - 1] == CurrentColor && OrbGrid[Idx - 2] == CurrentColor)
-						{
-							bIsInMatch = true;
-						}
-					}
-					if (Col >= 1 && Col < GridSize - 1)
-					{
-						// Ҹһ
-						if (OrbGrid[Idx - 1] == CurrentColor && OrbGrid[Idx + 1] == CurrentColor)
-						{
-							bIsInMatch = true;
-						}
-					}
-					if (Col < GridSize - 2)
-					{
-						// Ҳ
-						if (OrbGrid[Idx + 1] == CurrentColor && OrbGrid[Idx + 2] == CurrentColor)
-						{
-							bIsInMatch = true;
-						}
-					}
-					
-					// ƥ
-					if (Row >= 2)
-					{
-						// Ϸ
-						if (OrbGrid[Idx - GridSize] == CurrentColor && OrbGrid[Idx - GridSize * 2] == CurrentColor)
-						{
-							bIsInMatch = true;
-						}
-					}
-					if (Row >= 1 && Row < GridSize - 1)
-					{
-						// ¸һ
-						if (OrbGrid[Idx - GridSize] == CurrentColor && OrbGrid[Idx + GridSize] == CurrentColor)
-						{
-							bIsInMatch = true;
-						}
-					}
-					if (Row < GridSize - 2)
-					{
-						// ·
-						if (OrbGrid[Idx + GridSize] == CurrentColor && OrbGrid[Idx + GridSize * 2] == CurrentColor)
-						{
-							bIsInMatch = true;
-						}
-					}
-					
-					// ƥ䣬滻Ϊγƥɫ
-					if (bIsInMatch)
-					{
-						bHadMatches = true;
-						
-						// пܵɫһγƥ
-						TArray<ETileColor> AvailableColors = {
-							ETileColor::Red,
-							ETileColor::Blue,
-							ETileColor::Green,
-							ETileColor::Yellow
-						};
-						
-						// Ƴǰɫ
-						AvailableColors.Remove(CurrentColor);
-						
-						// Ƴڵɫ2
-						if (Col >= 2 && OrbGrid[Idx - 1] == OrbGrid[Idx - 2])
-						{
-							AvailableColors.Remove(OrbGrid[Idx - 1]);
-						}
-						
-						// ƳϷڵɫ2
-						if (Row >= 2 && OrbGrid[Idx - GridSize] == OrbGrid[Idx - GridSize * 2])
-						{
-							AvailableColors.Remove(OrbGrid[Idx - GridSize]);
-						}
-						
-						// ѡһȫɫ
-						if (AvailableColors.Num() > 0)
-						{
-							int32 RandomIndex = FMath::RandRange(0, AvailableColors.Num() - 1);
-							OrbGrid[Idx] = AvailableColors[RandomIndex];
-						}
-						else
-						{
-							// ɫγƥ䣬ѡһ
-							int32 ColorInt = FMath::RandRange(0, 3);
-							OrbGrid[Idx] = static_cast<ETileColor>(ColorInt);
-						}
-					}
-				}
-			}
-		}
-		
-		if (FixAttempts >= MaxFixAttempts)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("GenerateBoard: Failed to fix initial matches after %d attempts, retrying..."), MaxFixAttempts);
-			RetryCount++;
-			continue;
-		}
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("ReshuffleBoard: Reshuffled board with %d valid swaps"), Match3.GetMoveIndex().Num());
+}
 
-		// 3. ֤ȷûƥ
-		if (HasMatch())
-		{
-			UE_LOG(LogTemp, Warning, TEXT("GenerateBoard: Board still has matches after fixing, retrying..."));
-			RetryCount++;
-			continue;
-		}
+bool ADatamanagement::HasAnyValidMove()
+{
+	// 可交换索引在棋盘稳定时保持最新，死锁即索引为空
+	return Match3.HasAnyValidMove();
+}
 
-		// 4. Ƿпƶ
-		if (!HasAnyValidMove())
-		{
-			UE_LOG(LogTemp, Warning, TEXT("GenerateBoard: Board has no valid moves, retrying..."));
-			RetryCount++;
-			continue;
-		}
-		
-		bIsValidBoard = true;
-		UE_LOG(LogTemp, Log, TEXT("GenerateBoard: Successfully generated valid board (Retries: %d, FixAttempts: %d)"), RetryCount, FixAttempts);
+int32 ADatamanagement::LockCells(int32 NumCells)
+{
+	// 目标格子的选择属于AI施法，使用AI施法流
+	const uint64 Picked = Match3.PickLockCells(NumCells, [this](int32 Max) { return AISkillStream.RandHelper(Max); });
+	if (!Picked)
+	{
+		return 0;
 	}
-	
-	if (RetryCount >= MaxRetries)
+	Match3.SetLockedMask(Match3.GetLockedMask() | Picked);
+	ReplayRecorder.RecordLockCells(GetWorld()->GetTimeSeconds(), Picked);
+	if (ShouldRecordNetDelta())
+	{
+		NetDelta.RecordLocked(Match3.GetLockedMask());
+	}
+
+	const int32 NumLocked = FMath::CountBits(Picked);
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("LockCells: Locked %d cells, %d valid swaps left"), NumLocked, Match3.GetMoveIndex().Num());
+	OnCellsLocked((int64)Picked);
+	OnCellStateChangedNative.Broadcast();
+
+	// 动画播放中由 SettleBoard 检查死锁
+	if (GameState == EMatch3State::Idle && !HasAnyValidMove())
 	{
-		UE_LOG(LogTemp, Error, TEXT("GenerateBoard: Failed to generate valid board after %d retries!"), MaxRetries);
+		TRACE_COUNTER_INCREMENT(Match3_DeadlockReshuffles);
+		ReshuffleBoard();
+		OnBoardReshuffle();
+		OnBoardRebuiltNative.Broadcast(true);
 	}
+	if (GameState == EMatch3State::Idle)
+	{
+		RecordReplayChecksum();
+	}
+	return NumLocked;
 }
 
-bool ADatamanagement::HasAnyValidMove()
+void ADatamanagement::UnlockAllCells()
 {
-	for (int32 Row = 0; Row < GridSize; ++Row)
+	if (Match3.GetLockedMask())
 	{
-		for (int32 Col = 0; Col < GridSize; ++Col)
+		Match3.SetLockedMask(0);
+		ReplayRecorder.RecordUnlockCells(GetWorld()->GetTimeSeconds());
+		if (ShouldRecordNetDelta())
 		{
-			int32 CurrentIdx = Row * GridSize + Col;
-			
-			// ҽ
-			if (Col < GridSize - 1)
-			{
-				int32 RightIdx = CurrentIdx + 1;
-				OrbGrid.Swap(CurrentIdx, RightIdx);
-				bool bCanMatch = HasMatch();
-				OrbGrid.Swap(CurrentIdx, RightIdx);
-				if (bCanMatch) return true;
-			}
-			
-			// ½
-			if (Row < GridSize - 1)
-			{
-				int32 DownIdx = CurrentIdx + GridSize;
-				OrbGrid.Swap(CurrentIdx, DownIdx);
-				bool bCanMatch = HasMatch();
-				OrbGrid.Swap(CurrentIdx, DownIdx);
-				if (bCanMatch) return true;
-			}
+			NetDelta.RecordLocked(0);
 		}
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("UnlockAllCells: %d valid swaps"), Match3.GetMoveIndex().Num());
+		OnCellsUnlocked();
+		OnCellStateChangedNative.Broadcast();
 	}
-	return false;
+}
+
+bool ADatamanagement::IsCellLocked(int32 TileIndex) const
+{
+	return TileIndex >= 0 && TileIndex < FMatch3Board::NumCells && (Match3.GetLockedMask() & FMatch3Board::CellBit(TileIndex)) != 0;
 }
 
 bool ADatamanagement::HandleTileInput(int32 TileIndex)
@@ -557,6 +797,15 @@ bool ADatamanagement::HandleTileInput(int32 TileIndex)
 		return false;
 	}
 
+	// 只有本机操作的棋盘接受点击（对手的棋盘只显示）
+	if (!IsControlledLocally())
+	{
+		return false;
+	}
+
+	// 录像记录点击本身，回放按同样的选中规则重放（结算期间的交换会被 TrySwap 拒绝）
+	ReplayRecorder.RecordTileInput(GetWorld()->GetTimeSeconds(), TileIndex, GameState != EMatch3State::Idle);
+
 	if (SelectedTileIndex == -1)
 	{
 		SelectedTileIndex = TileIndex;
@@ -571,7 +820,7 @@ bool ADatamanagement::HandleTileInput(int32 TileIndex)
 
 	if (IsAdjacent(SelectedTileIndex, TileIndex))
 	{
-		TrySwap(SelectedTileIndex, TileIndex);
+		RequestSwap(SelectedTileIndex, TileIndex);
 		SelectedTileIndex = -1; 
 		return true;
 	}
@@ -598,151 +847,313 @@ ESlotEffectType ADatamanagement::GetSpecialTileType(int32 Index) const
 	return ESlotEffectType::None;
 }
 
-// ========================================
-// 
-// ========================================
+bool ADatamanagement::IsValidSwap(int32 IndexA, int32 IndexB) const
+{
+	return Match3.IsValidSwap(IndexA, IndexB);
+}
 
-void ADatamanagement::IndexToRowCol(int32 Index, int32& OutRow, int32& OutCol) const
+void ADatamanagement::GetValidSwaps(TArray<FIntPoint>& OutSwaps) const
 {
-	OutRow = Index / GridSize;
-	OutCol = Index % GridSize;
+	OutSwaps.Reset(Match3.GetMoveIndex().Num());
+	Match3.GetMoveIndex().ForEachMove([&OutSwaps](int32 IndexA, int32 IndexB)
+	{
+		OutSwaps.Add(FIntPoint(IndexA, IndexB));
+	});
 }
 
-int32 ADatamanagement::RowColToIndex(int32 Row, int32 Col) const
+int32 ADatamanagement::GetValidSwapCount() const
 {
-	return Row * GridSize + Col;
+	return Match3.GetMoveIndex().Num();
 }
 
-bool ADatamanagement::HasMatch()
+bool ADatamanagement::GetBestMoves(int32 N, TArray<FMoveHint>& OutMoves)
 {
-	// 
-	for (int32 Row = 0; Row < GridSize; ++Row)
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_MoveHints);
+
+	OutMoves.Reset();
+
+	// 动画播放中棋盘不稳定，可交换索引尚未更新
+	if (GameState != EMatch3State::Idle)
 	{
-		for (int32 Col = 0; Col < GridSize - 2; ++Col)
-		{
-			int32 Idx = Row * GridSize + Col;
-			ETileColor Color = OrbGrid[Idx];
-			if (Color == ETileColor::Empty) continue;
-			if (OrbGrid[Idx + 1] == Color && OrbGrid[Idx + 2] == Color)
-			{
-				return true;
-			}
-		}
+		return false;
 	}
 
-	// 
-	for (int32 Col = 0; Col < GridSize; ++Col)
+	const FMatch3MoraleConfig MoraleConfig = GetMoraleConfig();
+
+	// 首次消除的得分：方块数 + 特殊格子 + 预计士气值（与 CalculateMoraleReward 使用同一公式）
+	auto ScoreMove = [this, &MoraleConfig](const FMatch3MoveScore& Move)
 	{
-		for (int32 Row = 0; Row < GridSize - 2; ++Row)
+		int32 SpecialAreaHits = 0;
+		for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
 		{
-			int32 Idx = Row * GridSize + Col;
-			ETileColor Color = OrbGrid[Idx];
-			if (Color == ETileColor::Empty) continue;
-			if (OrbGrid[Idx + GridSize] == Color && OrbGrid[Idx + GridSize * 2] == Color)
-			{
-				return true;
-			}
+			SpecialAreaHits += Move.EffectHits[Type];
 		}
-	}
+		const int32 MoraleReward = FMatch3Morale::CalculateReward(
+			MoraleConfig, Move.ClearedTiles, Move.EffectHits[(int32)EMatch3Effect::MoraleBoost]);
 
-	return false;
-}
+		return Move.ClearedTiles * HintWeightPerTile
+			+ SpecialAreaHits * HintWeightPerSpecialArea
+			+ MoraleReward * HintWeightPerMorale;
+	};
 
-TArray<FFallMove> ADatamanagement::FillEmptyTiles()
-{
-	TArray<FFallMove> FallMoves;
+	const uint64 BudgetCycles = FMath::Max<uint64>(1,
+		(uint64)(HintBudgetMicroseconds * 1e-6 / FPlatformTime::GetSecondsPerCycle64()));
+	const bool bComplete = HintRanker.Update(Match3, ScoreMove, BudgetCycles);
 
-	for (int32 Col = 0; Col < GridSize; ++Col)
+	const int32 NumMoves = FMath::Clamp(N, 0, HintRanker.Num());
+	OutMoves.Reserve(NumMoves);
+	for (int32 Rank = 0; Rank < NumMoves; ++Rank)
 	{
-		TArray<ETileColor> ExistingTiles;
-		TArray<int32> ExistingIndices;
-		
-		// ռеķǿշ
-		for (int32 Row = 0; Row < GridSize; ++Row)
+		const FMatch3MoveScore& Move = HintRanker[Rank];
+
+		FMoveHint& Hint = OutMoves.AddDefaulted_GetRef();
+		Hint.IndexA = Move.IndexA;
+		Hint.IndexB = Move.IndexB;
+		Hint.Score = Move.Score;
+		Hint.ClearedTiles = Move.ClearedTiles;
+		for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
 		{
-			int32 Idx = Row * GridSize + Col;
-			if (OrbGrid[Idx] != ETileColor::Empty)
-			{
-				ExistingTiles.Add(OrbGrid[Idx]);
-				ExistingIndices.Add(Idx);
-			}
+			Hint.SpecialAreaHits += Move.EffectHits[Type];
 		}
+		Hint.MoraleReward = FMatch3Morale::CalculateReward(
+			MoraleConfig, Move.ClearedTiles, Move.EffectHits[(int32)EMatch3Effect::MoraleBoost]);
+	}
+	return bComplete;
+}
 
-		int32 MissingCount = GridSize - ExistingTiles.Num();
+// ========================================
+// 辅助函数
+// ========================================
 
-		// 
-		for (int32 Row = 0; Row < GridSize; ++Row)
-		{
-			int32 ToIdx = Row * GridSize + Col;
-			
-			if (Row < MissingCount)
-			{
-				// ɵķ
-				int32 ColorInt = FMath::RandRange(0, 3);
-				ETileColor NewColor = static_cast<ETileColor>(ColorInt);
-				OrbGrid[ToIdx] = NewColor;
+void ADatamanagement::IndexToRowCol(int32 Index, int32& OutRow, int32& OutCol) const
+{
+	OutRow = Index / BoardCols;
+	OutCol = Index % BoardCols;
+}
 
-				int32 VirtualFromIdx = -(MissingCount - Row);
-				FallMoves.Add(FFallMove(VirtualFromIdx, ToIdx, NewColor, true));
-			}
-			else
+int32 ADatamanagement::RowColToIndex(int32 Row, int32 Col) const
+{
+	return FMatch3Board::ToIndex(Row, Col);
+}
+
+bool ADatamanagement::HasMatch()
+{
+	// 位棋盘：每种颜色做移位与运算，检查横向/纵向3连
+	return Match3.GetBoard().HasMatch();
+}
+
+void ADatamanagement::FillEmptyTiles(TArray<FFallMove>& OutFallMoves)
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_Fill);
+
+	// 保留容量：每次下落最多 NumCells 个移动，预分配后不再扩容
+	OutFallMoves.Reset();
+
+	// 同步只发送新方块的颜色，客户端用同一个 CollapseAndRefill 得到相同的下落
+	const bool bRecordNet = ShouldRecordNetDelta();
+	if (bRecordNet)
+	{
+		NetDelta.BeginFill();
+	}
+
+	// 记录被改写的格子，下落完成后只在这些格子附近检查连消
+	Match3.CollapseAndRefill(
+		// 新生成的方块
+		[this, bRecordNet]()
+		{
+			const uint8 Color = (uint8)RefillStream.RandRange(0, FMatch3Board::NumColors - 1);
+			if (bRecordNet)
 			{
-				// ķ
-				int32 SourceArrayIdx = Row - MissingCount;
-				ETileColor ExistingColor = ExistingTiles[SourceArrayIdx];
-				int32 FromIdx = ExistingIndices[SourceArrayIdx];
-				
-				OrbGrid[ToIdx] = ExistingColor;
-
-				if (FromIdx != ToIdx)
-				{
-					FallMoves.Add(FFallMove(FromIdx, ToIdx, ExistingColor, false));
-				}
+				NetDelta.RecordFillColor(Color);
 			}
-		}
+			return Color;
+		},
+		// 记录移动
+		[&OutFallMoves](int32 FromIdx, int32 ToIdx, uint8 Color, bool bIsNewTile)
+		{
+			OutFallMoves.Emplace(FromIdx, ToIdx, static_cast<ETileColor>(Color), bIsNewTile);
+		});
+
+	SyncOrbGridFromBoard();
+}
+
+bool ADatamanagement::HasLocalMatch(const FMatch3Board& InBoard, uint64 DirtyMask)
+{
+	if (!bDebugVerifyLocalMatchCheck)
+	{
+		return InBoard.HasMatchNear(DirtyMask);
+	}
+
+	// 调试模式：与全盘扫描交叉验证，以全盘结果为准
+	const uint64 LocalStart = FPlatformTime::Cycles64();
+	const bool bLocalMatch = InBoard.HasMatchNear(DirtyMask);
+	const uint64 FullStart = FPlatformTime::Cycles64();
+	const bool bFullMatch = InBoard.HasMatch();
+	const uint64 FullEnd = FPlatformTime::Cycles64();
+
+	SwapCheckStats.Record(DirtyMask, FullStart - LocalStart, FullEnd - FullStart, bLocalMatch == bFullMatch);
+	if (bLocalMatch != bFullMatch)
+	{
+		UE_LOG(LogDragonBoatMatch3, Error, TEXT("HasLocalMatch: Mismatch! Local=%d, Full=%d, DirtyMask=0x%llx"),
+			bLocalMatch, bFullMatch, DirtyMask);
+	}
+	return bFullMatch;
+}
+
+void ADatamanagement::FindLocalMatches(uint64 DirtyMask, uint64& OutHorizontal, uint64& OutVertical)
+{
+	const FMatch3Board& Board = Match3.GetBoard();
+	if (!bDebugVerifyLocalMatchCheck)
+	{
+		Board.FindMatchesNear(DirtyMask, OutHorizontal, OutVertical);
+		return;
+	}
+
+	// 调试模式：与全盘扫描交叉验证，以全盘结果为准
+	uint64 LocalHorizontal, LocalVertical;
+	const uint64 LocalStart = FPlatformTime::Cycles64();
+	Board.FindMatchesNear(DirtyMask, LocalHorizontal, LocalVertical);
+	const uint64 FullStart = FPlatformTime::Cycles64();
+	Board.FindMatches(OutHorizontal, OutVertical);
+	const uint64 FullEnd = FPlatformTime::Cycles64();
+
+	const bool bSame = (LocalHorizontal == OutHorizontal) && (LocalVertical == OutVertical);
+	CascadeCheckStats.Record(DirtyMask, FullStart - LocalStart, FullEnd - FullStart, bSame);
+	if (!bSame)
+	{
+		UE_LOG(LogDragonBoatMatch3, Error, TEXT("FindLocalMatches: Mismatch! Local=0x%llx, Full=0x%llx, DirtyMask=0x%llx"),
+			LocalHorizontal | LocalVertical, OutHorizontal | OutVertical, DirtyMask);
+	}
+}
+
+void ADatamanagement::FMatchCheckStats::Record(uint64 DirtyMask, uint64 InLocalCycles, uint64 InFullCycles, bool bMatchesFullScan)
+{
+	NumChecks++;
+	LocalRunStarts += FMatch3Board::CountRunStartsNear(DirtyMask);
+	FullRunStarts += FMatch3Board::NumRunStarts;
+	LocalCycles += InLocalCycles;
+	FullCycles += InFullCycles;
+	if (!bMatchesFullScan)
+	{
+		NumMismatches++;
+	}
+}
+
+void ADatamanagement::FMatchCheckStats::Log(const TCHAR* Label) const
+{
+	if (NumChecks == 0)
+	{
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  %s: no checks recorded"), Label);
+		return;
+	}
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("  %s: %d checks, %d mismatches"), Label, NumChecks, NumMismatches);
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("    -> Run starts per check: local %.1f / full %.1f"),
+		(double)LocalRunStarts / NumChecks, (double)FullRunStarts / NumChecks);
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("    -> Time per check: local %.3f us / full %.3f us"),
+		FPlatformTime::ToMilliseconds64(LocalCycles) * 1000.0 / NumChecks,
+		FPlatformTime::ToMilliseconds64(FullCycles) * 1000.0 / NumChecks);
+}
+
+void ADatamanagement::SyncOrbGridFromBoard()
+{
+	const FMatch3Board& Board = Match3.GetBoard();
+	for (int32 Idx = 0; Idx < OrbGrid.Num(); ++Idx)
+	{
+		OrbGrid[Idx] = static_cast<ETileColor>(Board.GetColor(Idx));
+	}
+}
+
+void ADatamanagement::SyncSpecialAreasToCore()
+{
+	FMatch3SpecialAreas& SpecialAreas = Match3.GetSpecialAreas();
+	SpecialAreas.Reset();
+	for (int32 Idx = 0; Idx < SpecialAreaGrid.Num() && Idx < FMatch3Board::NumCells; ++Idx)
+	{
+		SpecialAreas.SetEffect(Idx, static_cast<EMatch3Effect>(SpecialAreaGrid[Idx]));
 	}
 
-	return FallMoves;
+	// 特殊格子不计入棋盘修订号，已有的提示排名需要重新评估
+	HintRanker.Reset();
 }
 
-TArray<FSpecialEffectData> ADatamanagement::CollectSpecialEffects(const TArray<int32>& ClearedIndices)
+void ADatamanagement::CollectSpecialEffects(uint64 ClearedMask, TArray<FSpecialEffectData>& OutEffects)
 {
-	// Чͷռ
-	TMap<ESlotEffectType, TArray<int32>> EffectIndicesMap;
+	// 回收上一次的效果数据，索引数组的容量留给本次复用
+	RecycleSpecialEffects(OutEffects);
 	
-	// ͳ
-	for (int32 Idx : ClearedIndices)
+	// 按效果类型顺序逐个求交集：输出顺序固定，与消除索引的顺序无关
+	const FMatch3SpecialAreas& SpecialAreas = Match3.GetSpecialAreas();
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
 	{
-		if (SpecialAreaGrid.IsValidIndex(Idx))
+		const uint64 TriggerMask = ClearedMask & SpecialAreas.GetEffectMask(static_cast<EMatch3Effect>(Type));
+		if (TriggerMask == 0)
 		{
-			ESlotEffectType EffectType = SpecialAreaGrid[Idx];
-			if (EffectType != ESlotEffectType::None)
-			{
-				TArray<int32>& Indices = EffectIndicesMap.FindOrAdd(EffectType);
-				Indices.Add(Idx);
-				
-				UE_LOG(LogTemp, Log, TEXT("  -> Special tile at index %d, type %d"), Idx, (int32)EffectType);
-			}
+			continue;
+		}
+
+		FSpecialEffectData& Effect = OutEffects.Add_GetRef(EffectDataPool.Num() > 0 ? EffectDataPool.Pop(EAllowShrinking::No) : FSpecialEffectData());
+		Effect.EffectType = static_cast<ESlotEffectType>(Type);
+		Effect.TriggerMask = TriggerMask;
+		Effect.TriggerCount = FMath::CountBits(TriggerMask);
+		Effect.TriggerIndices.Reset();
+		if (bExpandEffectTriggerIndices)
+		{
+			GetEffectTriggerIndices(Effect, Effect.TriggerIndices);
 		}
+
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Effect: %d, Triggered at %d positions"), Type, Effect.TriggerCount);
 	}
-	
-	// Ч
-	TArray<FSpecialEffectData> TriggeredEffects;
-	for (const auto& Pair : EffectIndicesMap)
+}
+
+void ADatamanagement::GetEffectTriggerIndices(const FSpecialEffectData& Effect, TArray<int32>& OutIndices)
+{
+	OutIndices.Reset(Effect.TriggerCount);
+	for (uint64 Remaining = Effect.TriggerMask; Remaining; Remaining &= Remaining - 1)
 	{
-		TriggeredEffects.Add(FSpecialEffectData(Pair.Key, Pair.Value));
-		UE_LOG(LogTemp, Log, TEXT("  -> Effect: %d, Triggered at %d positions"), (int32)Pair.Key, Pair.Value.Num());
+		OutIndices.Add(FMatch3Bits::FirstIndex(Remaining));
+	}
+}
+
+void ADatamanagement::GetMaskCellIndices(int64 Mask, TArray<int32>& OutIndices)
+{
+	OutIndices.Reset(FMath::CountBits((uint64)Mask));
+	FMatch3Bits::ForEach((uint64)Mask, [&OutIndices](int32 Index) { OutIndices.Add(Index); });
+}
+
+void ADatamanagement::RecycleSpecialEffects(TArray<FSpecialEffectData>& Effects)
+{
+	for (FSpecialEffectData& Effect : Effects)
+	{
+		EffectDataPool.Add(MoveTemp(Effect));
+	}
+	Effects.Reset();
+}
+
+void ADatamanagement::ReserveMatchBuffers()
+{
+	// 一步消除最多 NumCells 个方块与下落移动；效果类型数量固定
+	for (FMatch3StepResult* StepResult : { &LastStepResult, &CascadeStepResult })
+	{
+		StepResult->ClearedIndices.Reserve(FMatch3Board::NumCells);
+		StepResult->TriggeredEffects.Reserve(FMatch3SpecialAreas::NumEffectTypes);
+		RecycleSpecialEffects(StepResult->TriggeredEffects);
+	}
+	LastFallMoves.Reserve(FMatch3Board::NumCells);
+
+	// 预先为每种效果准备一份索引数组
+	while (EffectDataPool.Num() < FMatch3SpecialAreas::NumEffectTypes - 1)
+	{
+		EffectDataPool.AddDefaulted_GetRef().TriggerIndices.Reserve(FMatch3Board::NumCells);
 	}
-	
-	return TriggeredEffects;
 }
 
 bool ADatamanagement::IsAdjacent(int32 IndexA, int32 IndexB) const
 {
-	int32 RowA = IndexA / GridSize;
-	int32 ColA = IndexA % GridSize;
-	int32 RowB = IndexB / GridSize;
-	int32 ColB = IndexB % GridSize;
+	int32 RowA = IndexA / BoardCols;
+	int32 ColA = IndexA % BoardCols;
+	int32 RowB = IndexB / BoardCols;
+	int32 ColB = IndexB % BoardCols;
 
 	return (FMath::Abs(RowA - RowB) + FMath::Abs(ColA - ColB)) == 1;
 }
@@ -753,7 +1164,7 @@ bool ADatamanagement::IsValidIndex(int32 Index) const
 }
 
 // ========================================
-// ʿֵϵͳ
+// 士气值系统
 // ========================================
 
 void ADatamanagement::AddMorale(int32 Amount)
@@ -761,31 +1172,85 @@ void ADatamanagement::AddMorale(int32 Amount)
 	if (Amount <= 0)
 		return;
 
-	// ܾܵʿֵ
-	if (SkillPoints >= MaxSkillPoints)
+	// 规则由三消核心计算，这里按原有顺序逐个通知UI
+	FMatch3MoraleState State(CurrentMorale, SkillPoints);
+	const int32 OldSkillPoints = SkillPoints;
+	const FMatch3MoraleResult Result = FMatch3Morale::AddMorale(State, GetMoraleConfig(), Amount);
+
+	// 如果技能点已满，拒绝添加士气值
+	if (Result.bRejected)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("AddMorale: Skill Points are full (%d/%d), cannot add morale!"), SkillPoints, MaxSkillPoints);
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("AddMorale: Skill Points are full (%d/%d), cannot add morale!"), SkillPoints, MaxSkillPoints);
 		
-		// ȷʿֵΪ0
+		// 确保士气值为0
 		if (CurrentMorale != 0)
 		{
 			CurrentMorale = 0;
-			OnMoraleChanged(CurrentMorale, MaxMorale, 0);
+			NotifyMoraleChanged(0);
 		}
 		
 		return;
 	}
 
-	int32 OldMorale = CurrentMorale;
-	CurrentMorale += Amount;
+	CurrentMorale = Result.MoraleAfterAdd;
 
-	UE_LOG(LogTemp, Log, TEXT("AddMorale: +%d (Total: %d/%d)"), Amount, CurrentMorale, MaxMorale);
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("AddMorale: +%d (Total: %d/%d)"), Amount, CurrentMorale, MaxMorale);
 
-	// ֪ͨUIʿֵ仯
-	OnMoraleChanged(CurrentMorale, MaxMorale, Amount);
+	// 通知UI士气值变化
+	NotifyMoraleChanged(Amount);
 
-	// ǷҪתΪܵ
-	CheckMoraleToSkillPoint();
+	// 士气值满时转换为技能点
+	for (int32 Gained = 1; Gained <= Result.SkillPointsGained; ++Gained)
+	{
+		CurrentMorale = Result.MoraleAfterAdd - Gained * MaxMorale;
+		SkillPoints = OldSkillPoints + Gained;
+
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("AddMorale: Morale Full! Converted to Skill Point (Total: %d/%d)"), 
+			SkillPoints, MaxSkillPoints);
+
+		// 通知UI技能点变化
+		NotifySkillPointChanged();
+	}
+
+	CurrentMorale = State.CurrentMorale;
+	SkillPoints = State.SkillPoints;
+
+	// 如果技能点已满，强制清零士气值
+	if (Result.bResetOnFull)
+	{
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("AddMorale: Skill Points full! Morale reset to 0"));
+		NotifyMoraleChanged(0);
+	}
+
+	// 确保士气值不超过上限（额外的安全检查）
+	if (Result.bCapped)
+	{
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("AddMorale: Morale exceeded max! Capping at %d"), MaxMorale);
+		NotifyMoraleChanged(0);
+	}
+}
+
+void ADatamanagement::NotifyMoraleChanged(int32 AddedAmount)
+{
+	// 合并事件模式与一次性结算下，消除步骤内的变化由汇总事件与 OnStepResolvedNative 一次通知
+	if (ShouldDeferStepEvents())
+	{
+		return;
+	}
+
+	OnMoraleChanged(CurrentMorale, MaxMorale, AddedAmount);
+	OnMoraleChangedNative.Broadcast(CurrentMorale, MaxMorale, AddedAmount);
+}
+
+void ADatamanagement::NotifySkillPointChanged()
+{
+	if (ShouldDeferStepEvents())
+	{
+		return;
+	}
+
+	OnSkillPointChanged(SkillPoints, MaxSkillPoints);
+	OnSkillPointChangedNative.Broadcast(SkillPoints, MaxSkillPoints);
 }
 
 float ADatamanagement::GetMoraleProgress() const
@@ -798,180 +1263,233 @@ float ADatamanagement::GetMoraleProgress() const
 
 bool ADatamanagement::ConsumeSkillPoint(int32 Amount)
 {
-	if (SkillPoints < Amount)
+	FMatch3MoraleState State(CurrentMorale, SkillPoints);
+	if (!FMatch3Morale::ConsumeSkillPoints(State, Amount))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("ConsumeSkillPoint: Not enough skill points! (Have: %d, Need: %d)"), SkillPoints, Amount);
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("ConsumeSkillPoint: Not enough skill points! (Have: %d, Need: %d)"), SkillPoints, Amount);
 		return false;
 	}
 
-	SkillPoints -= Amount;
-	UE_LOG(LogTemp, Log, TEXT("ConsumeSkillPoint: -%d (Remaining: %d)"), Amount, SkillPoints);
+	SkillPoints = State.SkillPoints;
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("ConsumeSkillPoint: -%d (Remaining: %d)"), Amount, SkillPoints);
 
-	// ֪ͨUIܵ仯
-	OnSkillPointChanged(SkillPoints, MaxSkillPoints);
+	// 通知UI技能点变化
+	NotifySkillPointChanged();
 
 	return true;
 }
 
-int32 ADatamanagement::CalculateMoraleReward(int32 TileCount, const TArray<FSpecialEffectData>& TriggeredEffects)
+int32 ADatamanagement::CalculateMoraleReward(uint64 ClearedMask)
 {
-	// ʿֵÿ鹱׹̶ֵ
-	int32 TotalMorale = TileCount * MoralePerTile;
+	const int32 TileCount = FMath::CountBits(ClearedMask);
 
-	// Ӷʿֵ
-	for (const FSpecialEffectData& Effect : TriggeredEffects)
+	// 特殊格子额外士气值
+	const int32 MoraleBoostCount = Match3.GetSpecialAreas().CountHits(ClearedMask, EMatch3Effect::MoraleBoost);
+	if (MoraleBoostCount > 0)
 	{
-		if (Effect.EffectType == ESlotEffectType::MoraleBoost)
-		{
-			int32 BonusMorale = Effect.TriggerIndices.Num() * SpecialMoraleBonus;
-			TotalMorale += BonusMorale;
-			UE_LOG(LogTemp, Log, TEXT("  -> MoraleBoost triggered %d times, bonus: +%d"), 
-				Effect.TriggerIndices.Num(), BonusMorale);
-		}
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> MoraleBoost triggered %d times, bonus: +%d"), 
+			MoraleBoostCount, MoraleBoostCount * SpecialMoraleBonus);
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("  -> Total Morale Reward: %d (Base: %d tiles x %d)"), 
+	// 基础士气值：每个方块贡献固定值
+	const int32 TotalMorale = FMatch3Morale::CalculateReward(GetMoraleConfig(), TileCount, MoraleBoostCount);
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Total Morale Reward: %d (Base: %d tiles x %d)"), 
 		TotalMorale, TileCount, MoralePerTile);
 
 	return TotalMorale;
 }
 
-void ADatamanagement::CheckMoraleToSkillPoint()
+FMatch3MoraleConfig ADatamanagement::GetMoraleConfig() const
 {
-	// ʿֵʱתΪܵ
-	while (CurrentMorale >= MaxMorale && SkillPoints < MaxSkillPoints)
-	{
-		CurrentMorale -= MaxMorale;
-		SkillPoints++;
-
-		UE_LOG(LogTemp, Log, TEXT("CheckMoraleToSkillPoint: Morale Full! Converted to Skill Point (Total: %d/%d)"), 
-			SkillPoints, MaxSkillPoints);
-
-		// ֪ͨUIܵ仯
-		OnSkillPointChanged(SkillPoints, MaxSkillPoints);
-
-		// ٴ֪ͨUIʿֵ仯ʾúֵ
-// 		OnMoraleChanged(CurrentMorale, MaxMorale, 0);
-		
-		// ܵǿʿֵ
-		if (SkillPoints >= MaxSkillPoints)
-		{
-			CurrentMorale = 0;
-			UE_LOG(LogTemp, Warning, TEXT("CheckMoraleToSkillPoint: Skill Points full! Morale reset to 0"));
-			OnMoraleChanged(CurrentMorale, MaxMorale, 0);
-		}
-	}
-
-	// ȷʿֵޣİȫ飩
-	if (CurrentMorale > MaxMorale)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("CheckMoraleToSkillPoint: Morale exceeded max! Capping at %d"), MaxMorale);
-		CurrentMorale = MaxMorale;
-		OnMoraleChanged(CurrentMorale, MaxMorale, 0);
-	}
+	FMatch3MoraleConfig Config;
+	Config.MaxMorale = MaxMorale;
+	Config.MoralePerTile = MoralePerTile;
+	Config.SpecialMoraleBonus = SpecialMoraleBonus;
+	Config.MaxSkillPoints = MaxSkillPoints;
+	return Config;
 }
 
 // ========================================
-// /Ժ
+// 测试/调试函数
 // ========================================
 
 void ADatamanagement::Debug_SetMorale(int32 NewMorale)
 {
 	CurrentMorale = FMath::Clamp(NewMorale, 0, MaxMorale * MaxSkillPoints);
-	UE_LOG(LogTemp, Warning, TEXT("[DEBUG] SetMorale: %d"), CurrentMorale);
-	OnMoraleChanged(CurrentMorale, MaxMorale, 0);
+	UE_LOG(LogDragonBoatMatch3, Warning, TEXT("[DEBUG] SetMorale: %d"), CurrentMorale);
+	NotifyMoraleChanged(0);
 }
 
 void ADatamanagement::Debug_SetSkillPoints(int32 NewSkillPoints)
 {
 	SkillPoints = FMath::Clamp(NewSkillPoints, 0, MaxSkillPoints);
-	UE_LOG(LogTemp, Warning, TEXT("[DEBUG] SetSkillPoints: %d"), SkillPoints);
-	OnSkillPointChanged(SkillPoints, MaxSkillPoints);
+	UE_LOG(LogDragonBoatMatch3, Warning, TEXT("[DEBUG] SetSkillPoints: %d"), SkillPoints);
+	NotifySkillPointChanged();
 }
 
-void ADatamanagement::Debug_SimulateMatch(int32 TileCount, bool bIncludeSpecialBonus)
+void ADatamanagement::Debug_LogMatchCheckStats(bool bResetAfterLog)
 {
-	UE_LOG(LogTemp, Warning, TEXT("[DEBUG] SimulateMatch: %d tiles, SpecialBonus: %s"), 
-		TileCount, bIncludeSpecialBonus ? TEXT("Yes") : TEXT("No"));
+	if (!bDebugVerifyLocalMatchCheck)
+	{
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("[DEBUG] MatchCheckStats: bDebugVerifyLocalMatchCheck is disabled, no stats recorded"));
+	}
 
-	// ʿֵ
-	int32 MoraleReward = TileCount * MoralePerTile;
-	if (bIncludeSpecialBonus)
+	UE_LOG(LogDragonBoatMatch3, Warning, TEXT("[DEBUG] MatchCheckStats (local vs full scan):"));
+	SwapCheckStats.Log(TEXT("Swap validation"));
+	CascadeCheckStats.Log(TEXT("Cascade step"));
+
+	if (bResetAfterLog)
 	{
-		MoraleReward += SpecialMoraleBonus;
+		SwapCheckStats = FMatchCheckStats();
+		CascadeCheckStats = FMatchCheckStats();
 	}
+}
 
-	UE_LOG(LogTemp, Log, TEXT("  -> Morale Reward: %d"), MoraleReward);
+void ADatamanagement::Debug_PlayReplay(const FString& FilePath, int32 NumRuns)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FilePath))
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("[DEBUG] PlayReplay: Cannot read %s"), *FilePath);
+		return;
+	}
 
-	// ʿֵ
+	// 每次都从文件头重新开始，回放结果与耗时只取决于录像内容
+	NumRuns = FMath::Max(1, NumRuns);
+	FRaceReplayPlayer Player;
+	const double StartSeconds = FPlatformTime::Seconds();
+	for (int32 Run = 0; Run < NumRuns; ++Run)
+	{
+		if (!Player.Open(Data.GetData(), Data.Num()))
+		{
+			UE_LOG(LogDragonBoatRace, Warning, TEXT("[DEBUG] PlayReplay: %s is not a valid replay (or was recorded with a different board size)"), *FilePath);
+			return;
+		}
+		Player.PlayToEnd();
+	}
+	const double WallSeconds = (FPlatformTime::Seconds() - StartSeconds) / NumRuns;
+
+	const FRaceReplayStats& Stats = Player.GetStats();
+	const float RaceSeconds = Player.GetSimulation().GetSimTime();
+	UE_LOG(LogDragonBoatRace, Warning, TEXT("[DEBUG] PlayReplay: %s, seed %d, %d bytes, %d events"),
+		*FilePath, Player.GetHeader().RaceSeed, Data.Num(), Stats.NumEvents);
+	UE_LOG(LogDragonBoatRace, Warning, TEXT("  -> %.2f s race replayed in %.3f ms (%.0fx real time, %d runs)"),
+		RaceSeconds, WallSeconds * 1000.0, RaceSeconds / FMath::Max(WallSeconds, 1e-9), NumRuns);
+	UE_LOG(LogDragonBoatRace, Warning, TEXT("  -> Swaps %d (rejected %d), reshuffles %d, skills %d, AI skills %d, statuses %d, checksums %d"),
+		Stats.NumSwaps, Stats.NumRejectedSwaps, Stats.NumReshuffles, Stats.NumSkillCasts, Stats.NumAISkills, Stats.NumStatuses, Stats.NumChecksums);
+
+	if (!Player.HasEnded())
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("  -> Replay is truncated or corrupt (no end event)"));
+	}
+	if (Stats.NumMismatches() > 0)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("  -> DIVERGED at %.3f s: checksum %d, skill %d, status %d, finish %d mismatches"),
+			Stats.FirstMismatchTime, Stats.NumChecksumMismatches, Stats.NumCastMismatches, Stats.NumStatusMismatches, Stats.NumFinishMismatches);
+	}
+	else
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("  -> Replay matches the recording"));
+	}
+}
+
+void ADatamanagement::Debug_SimulateMatch(int32 TileCount, bool bIncludeSpecialBonus)
+{
+	UE_LOG(LogDragonBoatMatch3, Warning, TEXT("[DEBUG] SimulateMatch: %d tiles, SpecialBonus: %s"), 
+		TileCount, bIncludeSpecialBonus ? TEXT("Yes") : TEXT("No"));
+
+	// 计算士气值
+	int32 MoraleReward = FMatch3Morale::CalculateReward(GetMoraleConfig(), TileCount, bIncludeSpecialBonus ? 1 : 0);
+
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> Morale Reward: %d"), MoraleReward);
+
+	// 添加士气值
 	AddMorale(MoraleReward);
 }
 
 // ========================================
-// ۾Чϵͳ
+// 龙舟竞速效果系统
 // ========================================
 
-void ADatamanagement::TriggerRaceEffects(const TArray<FSpecialEffectData>& TriggeredEffects)
+void ADatamanagement::TriggerRaceEffects(const FMatch3StepResult& Step)
 {
-	for (const FSpecialEffectData& Effect : TriggeredEffects)
+	// 合并事件模式与一次性结算下由汇总结果中的触发数代替
+	if (ShouldDeferStepEvents())
 	{
-		int32 TriggerCount = Effect.TriggerIndices.Num();
+		return;
+	}
 
-		if (Effect.EffectType == ESlotEffectType::SpeedUpSelf)
-		{
-			UE_LOG(LogTemp, Log, TEXT("  -> Player SpeedUp triggered %d times"), TriggerCount);
-			OnPlayerSpeedUpTriggered(TriggerCount, SpeedBoostPerTrigger);
-		}
-		else if (Effect.EffectType == ESlotEffectType::SlowDownEnemy)
-		{
-			UE_LOG(LogTemp, Log, TEXT("  -> Player SlowDown Enemy triggered %d times"), TriggerCount);
-			OnPlayerSlowDownEnemyTriggered(TriggerCount, SlowDownPerTrigger);
-		}
-		// MoraleBoostѾCalculateMoraleRewardдﲻҪ
+	if (Step.SpeedUpTriggers > 0)
+	{
+		UE_LOG(LogDragonBoatRace, Log, TEXT("  -> Player SpeedUp triggered %d times"), Step.SpeedUpTriggers);
+		OnPlayerSpeedUpTriggered(Step.SpeedUpTriggers, SpeedBoostPerTrigger);
 	}
+
+	if (Step.SlowDownTriggers > 0)
+	{
+		UE_LOG(LogDragonBoatRace, Log, TEXT("  -> Player SlowDown Enemy triggered %d times"), Step.SlowDownTriggers);
+		OnPlayerSlowDownEnemyTriggered(Step.SlowDownTriggers, SlowDownPerTrigger);
+	}
+
+	// MoraleBoost已经在CalculateMoraleReward中处理，这里不需要额外操作
 }
 
 // ========================================
-// ϵͳ
+// 技能系统
 // ========================================
 
 bool ADatamanagement::TryCastSkill(int32 SlotIndex)
 {
-	// λЧ
+	// 检查槽位有效性
 	if (!EquippedSkills.IsValidIndex(SlotIndex))
 	{
-		UE_LOG(LogTemp, Error, TEXT("TryCastSkill: Invalid slot index %d"), SlotIndex);
+		UE_LOG(LogDragonBoatRace, Error, TEXT("TryCastSkill: Invalid slot index %d"), SlotIndex);
 		return false;
 	}
 
-	// 鼼ܵ
+	ESkillType SkillType = EquippedSkills[SlotIndex];
+
+	// 客户端：技能点由服务器扣除，释放成功后服务器回调 Client_SkillCasted
+	if (!HasAuthority())
+	{
+		if (!IsControlledLocally() || !IsSkillAvailable(SlotIndex))
+		{
+			return false;
+		}
+		Server_CastSkill((uint8)SlotIndex);
+		return true;
+	}
+
+	// 检查技能点（录像记录技能点不足的释放，回放据此检查技能点是否一致）
 	if (!IsSkillAvailable(SlotIndex))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("TryCastSkill: Not enough skill points!"));
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("TryCastSkill: Not enough skill points!"));
+		ReplayRecorder.RecordCastSkill(GetWorld()->GetTimeSeconds(), SlotIndex, (int32)SkillType, false);
 		return false;
 	}
 
-	ESkillType SkillType = EquippedSkills[SlotIndex];
-
-	// ȡ
+	// 获取技能配置
 	FSkillConfig* Config = SkillConfigs.Find(SkillType);
 	if (!Config)
 	{
-		UE_LOG(LogTemp, Error, TEXT("TryCastSkill: Skill config not found for skill type %d!"), (int32)SkillType);
+		UE_LOG(LogDragonBoatRace, Error, TEXT("TryCastSkill: Skill config not found for skill type %d!"), (int32)SkillType);
 		return false;
 	}
 
-	// 1ܵ
+	// 消耗1个技能点
 	if (!ConsumeSkillPoint(1))
 	{
 		return false;
 	}
+	ReplayRecorder.RecordCastSkill(GetWorld()->GetTimeSeconds(), SlotIndex, (int32)SkillType, true);
 
-	UE_LOG(LogTemp, Log, TEXT("TryCastSkill: Success! Slot=%d, Type=%d, Duration=%.2f, EffectValue=%.2f"), 
+	UE_LOG(LogDragonBoatRace, Log, TEXT("TryCastSkill: Success! Slot=%d, Type=%d, Duration=%.2f, EffectValue=%.2f"), 
 		SlotIndex, (int32)SkillType, Config->Duration, Config->EffectValue);
 
-	// ͼ¼
+	// 触发蓝图事件
 	OnSkillCasted(SkillType, *Config);
+	OnSkillCastedNative.Broadcast(SkillType, *Config);
 
 	return true;
 }
@@ -989,7 +1507,7 @@ ESkillType ADatamanagement::GetEquippedSkill(int32 SlotIndex) const
 	if (EquippedSkills.IsValidIndex(SlotIndex))
 		return EquippedSkills[SlotIndex];
 
-	// ĬϷɽ趫
+	// 默认返回巧借东风
 	return ESkillType::EastWind;
 }
 
@@ -1005,148 +1523,487 @@ void ADatamanagement::SetEquippedSkill(int32 SlotIndex, ESkillType NewSkill)
 }
 
 // ========================================
-// AIϵͳ
+// AI技能系统
 // ========================================
 
-void ADatamanagement::StartAISkillSystem()
+void ADatamanagement::StartAISkillSystem(int32 NumRaceBoats)
 {
 	if (!bEnableAISkills)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("StartAISkillSystem: AI skills are disabled!"));
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("StartAISkillSystem: AI skills are disabled!"));
 		return;
 	}
 
-	// ÿܣAI
+	// 蓝图运行时仍可能写入旧的 AI1_/AI2_EquippedSkills
+	MigrateDeprecatedAISkills();
+
+	// 龙舟 0 为玩家，其余每条龙舟一个施法者（调度、三消模拟与装备的技能都按施法者索引）
+	const int32 NumAIBoats = FMath::Clamp(NumRaceBoats - 1, 0, MaxAIBoats);
+	WaitForAIMatch3();
+	AIMatch3Boats.SetNum(NumAIBoats);
+	AISkillTargeting.Reset(1 + NumAIBoats);
+	AISkillScheduler.Reset(NumAIBoats);
+
+	// 如果启用了每局随机技能，重新配置AI技能
 	if (bRandomizeAISkillsEachRace)
 	{
 		RandomizeAISkills();
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("StartAISkillSystem: Starting AI skill system..."));
-	UE_LOG(LogTemp, Log, TEXT("  -> AI1: Slot0=%d, Slot1=%d"), (int32)AI1_EquippedSkills[0], (int32)AI1_EquippedSkills[1]);
-	UE_LOG(LogTemp, Log, TEXT("  -> AI2: Slot0=%d, Slot1=%d"), (int32)AI2_EquippedSkills[0], (int32)AI2_EquippedSkills[1]);
-	
-	// ʼһ AI ͷ
-	ScheduleNextAISkill();
+	UE_LOG(LogDragonBoatRace, Log, TEXT("StartAISkillSystem: Starting AI skill system for %d AI boats..."), NumAIBoats);
+	for (int32 Caster = 0; Caster < NumAIBoats; ++Caster)
+	{
+		const FAISkillLoadout* Loadout = GetAISkillLoadout(Caster);
+		UE_LOG(LogDragonBoatRace, Log, TEXT("  -> AI%d: %d skills, Slot0=%d"), Caster + 1,
+			Loadout ? Loadout->Skills.Num() : 0, (Loadout && Loadout->Skills.Num() > 0) ? (int32)Loadout->Skills[0] : -1);
+	}
+
+	if (bAIPlaysMatch3)
+	{
+		// AI 在自己的棋盘上积累技能点，收取到技能点时才进入调度（见 CollectAIMatch3Batch）
+		StartAIMatch3();
+	}
+	else
+	{
+		// 每条AI独立计时，第一次释放同样在随机间隔之后
+		const double Now = GetWorld()->GetTimeSeconds();
+		for (int32 Caster = 0; Caster < NumAIBoats; ++Caster)
+		{
+			if (!IsAIHumanControlled(Caster))
+			{
+				ScheduleNextAISkill(Caster, Now);
+			}
+		}
+	}
+	ArmAISkillTimer();
 }
 
 void ADatamanagement::TriggerAISkill()
 {
-	// ѡһʩAIAI1  AI2
-	EAIBoatIndex CasterAI = (FMath::RandBool()) ? EAIBoatIndex::AI1 : EAIBoatIndex::AI2;
+	// 计时器对准的是堆顶，触发时堆顶一定到期（不受计时器与世界时间之间的舍入误差影响）
+	if (AISkillScheduler.IsEmpty())
+	{
+		return;
+	}
+	const double Now = FMath::Max(GetWorld()->GetTimeSeconds(), AISkillScheduler.GetNextCastTime());
+
+	// 释放所有到期的AI（通常只有一条），各自调度下一次释放
+	for (int32 Caster = AISkillScheduler.PopDue(Now); Caster != INDEX_NONE; Caster = AISkillScheduler.PopDue(Now))
+	{
+		if (bAIMatch3Running)
+		{
+			// AI三消：到期即冷却结束，有技能点时释放一个并重新进入冷却，没有时等下一批技能点
+			if (!AIMatch3Boats.IsValidIndex(Caster) || AIMatch3Boats[Caster].PendingSkillPoints <= 0 || IsAIHumanControlled(Caster))
+			{
+				continue;
+			}
+			AIMatch3Boats[Caster].PendingSkillPoints--;
+		}
+		CastAISkill(Caster);
+		ScheduleNextAISkill(Caster, Now);
+	}
+	ArmAISkillTimer();
+}
+
+bool ADatamanagement::CastAISkill(int32 CasterIndex)
+{
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_AISkillCast);
+	TRACE_COUNTER_INCREMENT(Race_AISkillCasts);
 
-	// ȡ AI װб
-	const TArray<ESkillType>& AvailableSkills = 
-		(CasterAI == EAIBoatIndex::AI1) ? AI1_EquippedSkills : AI2_EquippedSkills;
+	// 获取该 AI 的装备技能列表
+	const FAISkillLoadout* Loadout = GetAISkillLoadout(CasterIndex);
 
-	// ûпüܣֱӷ
-	if (AvailableSkills.Num() == 0)
+	// 如果没有可用技能，直接返回
+	if (!Loadout || Loadout->Skills.Num() == 0)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("TriggerAISkill: %s has no equipped skills!"),
-			(CasterAI == EAIBoatIndex::AI1) ? TEXT("AI1") : TEXT("AI2"));
-		ScheduleNextAISkill();
-		return;
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("CastAISkill: AI%d has no equipped skills!"), CasterIndex + 1);
+		return false;
 	}
+	const TArray<ESkillType>& AvailableSkills = Loadout->Skills;
 
-	// ѡһܲ
-	int32 SlotIndex = FMath::RandRange(0, AvailableSkills.Num() - 1);
+	// 随机选择一个技能槽
+	int32 SlotIndex = AISkillStream.RandRange(0, AvailableSkills.Num() - 1);
 	ESkillType SelectedSkill = AvailableSkills[SlotIndex];
 
-	// ȡ
+	// 获取技能配置
 	FSkillConfig* Config = SkillConfigs.Find(SelectedSkill);
 	if (!Config)
 	{
-		UE_LOG(LogTemp, Error, TEXT("TriggerAISkill: Skill config not found for skill type %d!"), (int32)SelectedSkill);
-		ScheduleNextAISkill();
-		return;
+		UE_LOG(LogDragonBoatRace, Error, TEXT("CastAISkill: Skill config not found for skill type %d!"), (int32)SelectedSkill);
+		return false;
 	}
 
-	// ȡĿ
+	// 获取技能目标类型
 	ESkillTargetType TargetType = GetSkillTargetType(SelectedSkill);
 
-	// ȷĿ
-	EAIBoatIndex TargetAI = EAIBoatIndex::AI1;  // Ĭֵ
+	// 确定目标（龙舟索引 0 为玩家，AI i 为龙舟 i + 1）
+	int32 TargetAI = INDEX_NONE;
 	bool bTargetIsPlayer = false;
+	const int32 CasterBoat = CasterIndex + 1;
+	int32 TargetBoat = CasterBoat;
+	const URaceSimulationComponent* Simulation = RaceSimulation.Get();
 
 	if (TargetType == ESkillTargetType::Self)
 	{
-		// 漼ܣʩӸԼ
-		TargetAI = CasterAI;
+		// 增益技能：施加给自己
+		TargetAI = CasterIndex;
 		bTargetIsPlayer = false;
 
-		UE_LOG(LogTemp, Log, TEXT("TriggerAISkill: %s casts Slot %d [%d] (BUFF) on SELF! Duration=%.2f"),
-			(CasterAI == EAIBoatIndex::AI1) ? TEXT("AI1") : TEXT("AI2"),
+		UE_LOG(LogDragonBoatRace, Log, TEXT("CastAISkill: AI%d casts Slot %d [%d] (BUFF) on SELF! Duration=%.2f"),
+			CasterBoat,
 			SlotIndex, (int32)SelectedSkill, Config->Duration);
 	}
 	else
 	{
-		// 漼ܣѡˣһһAI
-		// 50% ʹң50% ʹһAI
-		bTargetIsPlayer = FMath::RandBool();
+		// 减益技能：按实时排名与超越记录选择敌人（见 AISkillTargetPolicy）
+		// 优先选择不处于空城计的对手，所有对手都免疫时仍然释放（被免疫）
+		const int32 LastBoat = FMath::Min(AISkillTargeting.Num() - 1, AISkillScheduler.NumCasters());
+		const double Now = GetWorld()->GetTimeSeconds();
+		auto RandHelper = [this](int32 Max) { return AISkillStream.RandHelper(Max); };
+
+		TargetBoat = INDEX_NONE;
+		if (CasterBoat <= LastBoat)
+		{
+			TargetBoat = AISkillTargeting.PickTarget(CasterBoat, (ERaceTargetPolicy)AISkillTargetPolicy, Now, AIOvertakeMemorySeconds,
+				[Simulation, LastBoat](int32 BoatIndex) { return BoatIndex <= LastBoat && !(Simulation && Simulation->IsBoatImmune(BoatIndex)); },
+				RandHelper);
+			if (TargetBoat == INDEX_NONE)
+			{
+				TargetBoat = AISkillTargeting.PickTarget(CasterBoat, (ERaceTargetPolicy)AISkillTargetPolicy, Now, AIOvertakeMemorySeconds,
+					[LastBoat](int32 BoatIndex) { return BoatIndex <= LastBoat; }, RandHelper);
+			}
+		}
+		if (TargetBoat == INDEX_NONE)
+		{
+			UE_LOG(LogDragonBoatRace, Log, TEXT("CastAISkill: AI%d has no target for skill [%d], all opponents finished"),
+				CasterBoat, (int32)SelectedSkill);
+			return false;
+		}
 
+		bTargetIsPlayer = TargetBoat == 0;
 		if (bTargetIsPlayer)
 		{
-			UE_LOG(LogTemp, Log, TEXT("TriggerAISkill: %s casts Slot %d [%d] (DEBUFF) on PLAYER! Duration=%.2f"),
-				(CasterAI == EAIBoatIndex::AI1) ? TEXT("AI1") : TEXT("AI2"),
+			UE_LOG(LogDragonBoatRace, Log, TEXT("CastAISkill: AI%d casts Slot %d [%d] (DEBUFF) on PLAYER! Duration=%.2f"),
+				CasterBoat,
 				SlotIndex, (int32)SelectedSkill, Config->Duration);
 		}
 		else
 		{
-			// һAI
-			TargetAI = (CasterAI == EAIBoatIndex::AI1) ? EAIBoatIndex::AI2 : EAIBoatIndex::AI1;
+			// 攻击另一个AI
+			TargetAI = TargetBoat - 1;
 
-			UE_LOG(LogTemp, Log, TEXT("TriggerAISkill: %s casts Slot %d [%d] (DEBUFF) on %s! Duration=%.2f"),
-				(CasterAI == EAIBoatIndex::AI1) ? TEXT("AI1") : TEXT("AI2"),
+			UE_LOG(LogDragonBoatRace, Log, TEXT("CastAISkill: AI%d casts Slot %d [%d] (DEBUFF) on AI%d! Duration=%.2f"),
+				CasterBoat,
 				SlotIndex, (int32)SelectedSkill,
-				(TargetAI == EAIBoatIndex::AI1) ? TEXT("AI1") : TEXT("AI2"),
+				TargetBoat,
 				Config->Duration);
 		}
 	}
 
-	// ͼ¼
-	OnAISkillCasted(CasterAI, SelectedSkill, TargetType, TargetAI, bTargetIsPlayer, *Config);
+	// 目标处于空城计：减益被免疫（技能仍算作已释放）
+	if (TargetType == ESkillTargetType::Enemy && Simulation && Simulation->IsBoatImmune(TargetBoat))
+	{
+		UE_LOG(LogDragonBoatRace, Log, TEXT("CastAISkill: skill [%d] blocked, target boat %d is immune (Empty City)"),
+			(int32)SelectedSkill, TargetBoat);
+		OnAISkillBlocked(CasterIndex, SelectedSkill, TargetAI, bTargetIsPlayer);
+		ReplayRecorder.RecordAISkill(GetWorld()->GetTimeSeconds(), CasterBoat, (int32)SelectedSkill, TargetBoat, true);
+		return true;
+	}
 
-	// һͷ
-	ScheduleNextAISkill();
+	ReplayRecorder.RecordAISkill(GetWorld()->GetTimeSeconds(), CasterBoat, (int32)SelectedSkill, TargetBoat, false);
+
+	// 触发蓝图事件（旧事件只能表示 AI1/AI2）
+	OnAIBoatSkillCasted(CasterIndex, SelectedSkill, TargetType, TargetAI, bTargetIsPlayer, *Config);
+	constexpr int32 NumLegacyAIBoats = 2;
+	if (CasterIndex < NumLegacyAIBoats && TargetAI < NumLegacyAIBoats)
+	{
+		OnAISkillCasted((EAIBoatIndex)CasterIndex, SelectedSkill, TargetType,
+			bTargetIsPlayer ? EAIBoatIndex::AI1 : (EAIBoatIndex)TargetAI, bTargetIsPlayer, *Config);
+	}
+	OnAISkillCastedNative.Broadcast(CasterIndex, SelectedSkill, TargetType, TargetAI, bTargetIsPlayer, *Config);
+	return true;
 }
 
-void ADatamanagement::ScheduleNextAISkill()
+void ADatamanagement::ScheduleNextAISkill(int32 CasterIndex, double Now)
 {
 	if (!bEnableAISkills)
 		return;
 
-	// һͷŵʱ
-	float RandomInterval = FMath::RandRange(AISkillIntervalMin, AISkillIntervalMax);
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_AISkillSchedule);
+
+	// 随机生成下一次释放的时间间隔（至少一帧，避免同一时刻反复释放）
+	const float RandomInterval = FMath::Max(AIIntervalStream.FRandRange(AISkillIntervalMin, AISkillIntervalMax), 0.01f);
+	AISkillScheduler.Schedule(CasterIndex, Now + RandomInterval);
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("ScheduleNextAISkill: AI%d next skill in %.2f seconds"), CasterIndex + 1, RandomInterval);
+}
 
-	UE_LOG(LogTemp, Log, TEXT("ScheduleNextAISkill: Next AI skill in %.2f seconds"), RandomInterval);
+void ADatamanagement::ArmAISkillTimer()
+{
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (AISkillScheduler.IsEmpty())
+	{
+		TimerManager.ClearTimer(AISkillTimerHandle);
+		return;
+	}
 
-	// Timer
-	GetWorld()->GetTimerManager().SetTimer(
+	// 只有一个计时器，对准最早的一次释放（不重复，每次触发后重新对准）
+	const float Delay = FMath::Max((float)(AISkillScheduler.GetNextCastTime() - GetWorld()->GetTimeSeconds()), 0.001f);
+	TimerManager.SetTimer(
 		AISkillTimerHandle,
 		this,
 		&ADatamanagement::TriggerAISkill,
-		RandomInterval,
-		false  // ظÿֶ
+		Delay,
+		false
 	);
 }
 
+void ADatamanagement::StartAIMatch3()
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Race);
+
+	WaitForAIMatch3();
+
+	// 每条AI一块独立棋盘，种子来自AI棋盘流，特殊格子布局与玩家相同
+	for (FAIMatch3Boat& Boat : AIMatch3Boats)
+	{
+		if (!Boat.Player)
+		{
+			Boat.Player = MakeUnique<FMatch3AIPlayer>();
+		}
+		Boat.Player->Initialize(AIMatch3Stream.RandHelper(MAX_int32), Match3.GetSpecialAreas());
+		Boat.MoveBudget = 0.0f;
+		Boat.BatchTimer = 0.0f;
+		Boat.PendingSkillPoints = 0;
+		Boat.PendingLockCells = 0;
+		Boat.BatchMoves = 0;
+	}
+	bAIMatch3Running = true;
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("StartAIMatch3: Policy %d, %.2f moves/s, batch every %.2f s"),
+		(int32)AIMatch3Policy, AIMovesPerSecond, AIBatchIntervalSeconds);
+}
+
+void ADatamanagement::TickAIMatch3(float DeltaTime)
+{
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_AIMatch3Tick);
+
+	for (int32 BoatIndex = 0; BoatIndex < AIMatch3Boats.Num(); ++BoatIndex)
+	{
+		FAIMatch3Boat& Boat = AIMatch3Boats[BoatIndex];
+
+		// 1. 收取已完成的一批结果
+		if (Boat.Task.IsValid() && Boat.Task.IsCompleted())
+		{
+			CollectAIMatch3Batch(BoatIndex);
+		}
+
+		// 由玩家控制的龙舟不再派发新的一批
+		if (IsAIHumanControlled(BoatIndex))
+		{
+			continue;
+		}
+
+		// 2. 从快照恢复时保存的一批还没有结果：在之后的锁定之前原样重新派发
+		if (!Boat.Task.IsValid() && Boat.BatchMoves > 0)
+		{
+			LaunchAIMatch3Batch(BoatIndex, Boat.BatchMoves);
+		}
+
+		// 3. 铁索连环：AI 棋盘只在没有进行中的任务时修改
+		if (!Boat.Task.IsValid() && Boat.PendingLockCells != 0)
+		{
+			if (Boat.PendingLockCells > 0)
+			{
+				Boat.Player->LockCells(Boat.PendingLockCells);
+			}
+			else
+			{
+				Boat.Player->UnlockAllCells();
+			}
+			Boat.PendingLockCells = 0;
+		}
+
+		// 4. 积累到一批后派发到工作线程（同一条AI同时只有一批在执行）
+		Boat.MoveBudget += DeltaTime * AIMovesPerSecond;
+		Boat.BatchTimer += DeltaTime;
+		const int32 NumMoves = FMath::FloorToInt(Boat.MoveBudget);
+		if (!Boat.Task.IsValid() && NumMoves > 0 && Boat.BatchTimer >= AIBatchIntervalSeconds)
+		{
+			Boat.MoveBudget -= NumMoves;
+			Boat.BatchTimer = 0.0f;
+			LaunchAIMatch3Batch(BoatIndex, NumMoves);
+		}
+	}
+}
+
+void ADatamanagement::LaunchAIMatch3Batch(int32 BoatIndex, int32 NumMoves)
+{
+	FAIMatch3Boat& Boat = AIMatch3Boats[BoatIndex];
+
+	// 工作线程修改棋盘期间，快照写入派发前的状态
+	Boat.Player->SaveCheckpoint(Boat.Checkpoint);
+	Boat.BatchMoves = NumMoves;
+
+	FMatch3AIConfig Config;
+	Config.Policy = (EMatch3AIPolicy)AIMatch3Policy;
+	Config.GreedyChance = AIGreedyChance;
+	Config.Morale = GetMoraleConfig();
+
+	FMatch3AIPlayer* Player = Boat.Player.Get();
+	Boat.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Player, NumMoves, Config]()
+	{
+		DRAGONBOAT_RACE_SCOPE(STAT_Race_AIMatch3Batch);
+		return Player->PlayMoves(NumMoves, Config);
+	});
+}
+
+void ADatamanagement::CollectAIMatch3Batch(int32 BoatIndex)
+{
+	FAIMatch3Boat& Boat = AIMatch3Boats[BoatIndex];
+
+	const FMatch3AIBatchResult& Batch = Boat.Task.GetResult();
+	Boat.PendingSkillPoints = (int32)FMath::Min<int64>(Boat.PendingSkillPoints + Batch.SkillPointsGained, MaxSkillPoints);
+	TRACE_COUNTER_ADD(Race_AIMatch3Moves, Batch.MovesPlayed);
+
+	UE_LOG(LogDragonBoatRace, Verbose, TEXT("TickAIMatch3: AI%d played %lld moves, cleared %lld, +%lld skill points (pending %d)"),
+		BoatIndex + 1, Batch.MovesPlayed, Batch.ClearedTiles, Batch.SkillPointsGained, Boat.PendingSkillPoints);
+
+	// 一批只有几次交换，数量都在 int32 范围内
+	OnAIMatch3Batch(BoatIndex, (int32)Batch.MovesPlayed, (int32)Batch.ClearedTiles,
+		(int32)Batch.EffectHits[(int32)EMatch3Effect::SpeedUpSelf], (int32)Batch.EffectHits[(int32)EMatch3Effect::SlowDownEnemy]);
+	OnAIMatch3BatchNative.Broadcast(BoatIndex, Batch);
+	Boat.Task = UE::Tasks::TTask<FMatch3AIBatchResult>();
+	Boat.BatchMoves = 0;
+
+	// 有技能点且不在冷却中（未调度）：立即由调度器释放，之后两次释放之间间隔 AISkillIntervalMin~Max
+	if (bEnableAISkills && Boat.PendingSkillPoints > 0 && !IsAIHumanControlled(BoatIndex)
+		&& BoatIndex < AISkillScheduler.NumCasters() && !AISkillScheduler.IsScheduled(BoatIndex))
+	{
+		AISkillScheduler.Schedule(BoatIndex, GetWorld()->GetTimeSeconds());
+		ArmAISkillTimer();
+	}
+}
+
+void ADatamanagement::WaitForAIMatch3()
+{
+	bAIMatch3Running = false;
+	for (FAIMatch3Boat& Boat : AIMatch3Boats)
+	{
+		if (Boat.Task.IsValid())
+		{
+			Boat.Task.Wait();
+			Boat.Task = UE::Tasks::TTask<FMatch3AIBatchResult>();
+		}
+		Boat.BatchMoves = 0;
+	}
+}
+
+void ADatamanagement::SetRaceSimulation(URaceSimulationComponent* InRaceSimulation)
+{
+	if (URaceSimulationComponent* Previous = RaceSimulation.Get())
+	{
+		Previous->OnStatusChangedNative.Remove(RaceStatusChangedHandle);
+	}
+	RaceSimulation = InRaceSimulation;
+
+	if (InRaceSimulation)
+	{
+		RaceStatusChangedHandle = InRaceSimulation->OnStatusChangedNative.AddUObject(this, &ADatamanagement::HandleRaceStatusChanged);
+	}
+}
+
+void ADatamanagement::UpdateRaceStandings(const FRaceBoatRegistry& Registry)
+{
+	AISkillTargeting.Observe(Registry, GetWorld()->GetTimeSeconds());
+}
+
+void ADatamanagement::HandleRaceStatusChanged(int32 BoatIndex, ERaceStatusEffect Status, bool bActive)
+{
+	const URaceSimulationComponent* Simulation = RaceSimulation.Get();
+	if (Status != ERaceStatusEffect::IronChain || !Simulation)
+	{
+		return;
+	}
+
+	// 锁定格子数为技能的 EffectValue（刷新时保持已锁定的格子）
+	const int32 NumCells = bActive
+		? FMath::Max(1, FMath::RoundToInt(Simulation->GetSimulation().GetStatusEffects().GetMagnitude(BoatIndex, ERaceStatus::IronChain)))
+		: 0;
+	if (BoatIndex == BoardBoatIndex)
+	{
+		if (bActive)
+		{
+			LockCells(NumCells);
+		}
+		else
+		{
+			UnlockAllCells();
+		}
+	}
+	else if (bAIMatch3Running && BoatIndex >= 1 && BoatIndex <= AIMatch3Boats.Num() && !IsAIHumanControlled(BoatIndex - 1))
+	{
+		AIMatch3Boats[BoatIndex - 1].PendingLockCells = bActive ? NumCells : -1;
+	}
+}
+
+int32 ADatamanagement::GetAIPendingSkillPoints(int32 AI) const
+{
+	return AIMatch3Boats.IsValidIndex(AI) ? AIMatch3Boats[AI].PendingSkillPoints : 0;
+}
+
+const FAISkillLoadout* ADatamanagement::GetAISkillLoadout(int32 CasterIndex) const
+{
+	return AIEquippedSkills.Num() > 0 ? &AIEquippedSkills[CasterIndex % AIEquippedSkills.Num()] : nullptr;
+}
+
+void ADatamanagement::MigrateDeprecatedAISkills()
+{
+	TArray<ESkillType>* const DeprecatedSkills[] = { &AI1_EquippedSkills, &AI2_EquippedSkills };
+	for (int32 CasterIndex = 0; CasterIndex < UE_ARRAY_COUNT(DeprecatedSkills); ++CasterIndex)
+	{
+		TArray<ESkillType>& Skills = *DeprecatedSkills[CasterIndex];
+		if (Skills.Num() == 0)
+		{
+			continue;
+		}
+
+		if (AIEquippedSkills.Num() <= CasterIndex)
+		{
+			AIEquippedSkills.SetNum(CasterIndex + 1);
+		}
+		AIEquippedSkills[CasterIndex].Skills = MoveTemp(Skills);
+		Skills.Reset();
+	}
+}
+
+float ADatamanagement::GetAINextSkillDelay(int32 AI) const
+{
+	const int32 Caster = AI;
+	if (Caster < 0 || Caster >= AISkillScheduler.NumCasters() || !AISkillScheduler.IsScheduled(Caster))
+	{
+		return -1.0f;
+	}
+	return FMath::Max(0.0f, (float)(AISkillScheduler.GetCastTime(Caster) - GetWorld()->GetTimeSeconds()));
+}
+
 ESkillTargetType ADatamanagement::GetSkillTargetType(ESkillType SkillType) const
 {
-	// ӳвҼĿ
+	// 从映射表中查找技能目标类型
 	const ESkillTargetType* TargetTypePtr = SkillTargetTypeMap.Find(SkillType);
 	if (TargetTypePtr)
 	{
 		return *TargetTypePtr;
 	}
 
-	// ĬϷؼ漼ܣˣ
-	UE_LOG(LogTemp, Warning, TEXT("GetSkillTargetType: Skill %d not found in map, defaulting to Enemy"), (int32)SkillType);
+	// 默认返回减益技能（攻击敌人）
+	UE_LOG(LogDragonBoatRace, Warning, TEXT("GetSkillTargetType: Skill %d not found in map, defaulting to Enemy"), (int32)SkillType);
 	return ESkillTargetType::Enemy;
 }
 
 void ADatamanagement::RandomizeAISkills()
 {
-	// пü
+	// 所有可用技能类型
 	TArray<ESkillType> AllSkills = {
 		ESkillType::EastWind,
 		ESkillType::FloodSeven,
@@ -1155,51 +2012,75 @@ void ADatamanagement::RandomizeAISkills()
 		ESkillType::EmptyCity
 	};
 
-	// Ϊ AI1 ѡ 2 ظļ
-	TArray<ESkillType> AI1_RandomSkills = AllSkills;
-	
-	int32 AI1_Slot0_Index = FMath::RandRange(0, AI1_RandomSkills.Num() - 1);
-	AI1_EquippedSkills[0] = AI1_RandomSkills[AI1_Slot0_Index];
-	AI1_RandomSkills.RemoveAt(AI1_Slot0_Index);  // Ƴѡܣظ
-	
-	int32 AI1_Slot1_Index = FMath::RandRange(0, AI1_RandomSkills.Num() - 1);
-	AI1_EquippedSkills[1] = AI1_RandomSkills[AI1_Slot1_Index];
-
-	// Ϊ AI2 ѡ 2 ظļ
-	TArray<ESkillType> AI2_RandomSkills = AllSkills;
-	
-	int32 AI2_Slot0_Index = FMath::RandRange(0, AI2_RandomSkills.Num() - 1);
-	AI2_EquippedSkills[0] = AI2_RandomSkills[AI2_Slot0_Index];
-	AI2_RandomSkills.RemoveAt(AI2_Slot0_Index);
-	
-	int32 AI2_Slot1_Index = FMath::RandRange(0, AI2_RandomSkills.Num() - 1);
-	AI2_EquippedSkills[1] = AI2_RandomSkills[AI2_Slot1_Index];
+	// 为每条 AI 随机选择 2 个不重复的技能
+	AIEquippedSkills.SetNum(FMath::Max(AISkillScheduler.NumCasters(), 1));
+	for (FAISkillLoadout& Loadout : AIEquippedSkills)
+	{
+		TArray<ESkillType> RandomSkills = AllSkills;
+		Loadout.Skills.SetNum(2);
+		for (ESkillType& Slot : Loadout.Skills)
+		{
+			const int32 PickIndex = AISkillStream.RandRange(0, RandomSkills.Num() - 1);
+			Slot = RandomSkills[PickIndex];
+			RandomSkills.RemoveAt(PickIndex);  // 移除已选技能，避免重复
+		}
+	}
 
-	UE_LOG(LogTemp, Log, TEXT("RandomizeAISkills: AI skills randomized for this race!"));
+	UE_LOG(LogDragonBoatRace, Log, TEXT("RandomizeAISkills: AI skills randomized for this race!"));
 }
 
 // ========================================
-// Ѷϵͳ
+// 难度系统
 // ========================================
 
 void ADatamanagement::ApplySpecialAreas(const TArray<int32>& Indices, const TArray<ESlotEffectType>& Types)
 {
-	// 
-	SpecialAreaGrid.Init(ESlotEffectType::None, GridSize * GridSize);
-
-	// Ӧ
+	// 忽略越界索引与缺少类型的项，重复索引以后者为准
+	FMatch3SpecialAreas SpecialAreas;
 	for (int32 i = 0; i < Indices.Num(); i++)
 	{
-		if (Types.IsValidIndex(i) && Indices[i] >= 0 && Indices[i] < SpecialAreaGrid.Num())
+		if (Types.IsValidIndex(i) && Indices[i] >= 0 && Indices[i] < FMatch3Board::NumCells)
+		{
+			SpecialAreas.SetEffect(Indices[i], static_cast<EMatch3Effect>(Types[i]));
+		}
+	}
+
+	ApplySpecialAreaMasks(SpecialAreas);
+}
+
+void ADatamanagement::ApplySpecialAreaMasks(const FMatch3SpecialAreas& SpecialAreas)
+{
+	Match3.GetSpecialAreas() = SpecialAreas;
+	ReplayRecorder.RecordSpecialAreas(GetWorld()->GetTimeSeconds(), SpecialAreas);
+	if (ShouldRecordNetDelta())
+	{
+		NetDelta.RecordSpecialAreas(SpecialAreas);
+	}
+
+	// 特殊格子不计入棋盘修订号，已有的提示排名需要重新评估
+	HintRanker.Reset();
+
+	// 镜像到 SpecialAreaGrid：数组大小固定，清零（None 为 0）后按掩码写入特殊格子
+	if (SpecialAreaGrid.Num() != FMatch3Board::NumCells)
+	{
+		SpecialAreaGrid.SetNumUninitialized(FMatch3Board::NumCells);
+	}
+	FMemory::Memzero(SpecialAreaGrid.GetData(), SpecialAreaGrid.Num() * sizeof(ESlotEffectType));
+	int32 NumSpecialAreas = 0;
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+	{
+		for (FMatch3Board::FMask Remaining = SpecialAreas.GetEffectMask((EMatch3Effect)Type); Remaining; Remaining &= Remaining - 1)
 		{
-			SpecialAreaGrid[Indices[i]] = Types[i];
+			SpecialAreaGrid[FMatch3Bits::FirstIndex(Remaining)] = static_cast<ESlotEffectType>(Type);
+			++NumSpecialAreas;
 		}
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("ApplySpecialAreas: Applied %d special areas"), Indices.Num());
+	UE_LOG(LogDragonBoatRace, Log, TEXT("ApplySpecialAreas: Applied %d special areas"), NumSpecialAreas);
 
-	// ֪ͨ UI ˢʾ
+	// 通知 UI 刷新特殊格子显示
 	OnSpecialAreasUpdated();
+	OnCellStateChangedNative.Broadcast();
 }
 
 void ADatamanagement::SetAISkillInterval(float MinInterval, float MaxInterval)
@@ -1207,6 +2088,72 @@ void ADatamanagement::SetAISkillInterval(float MinInterval, float MaxInterval)
 	AISkillIntervalMin = MinInterval;
 	AISkillIntervalMax = MaxInterval;
 
-	UE_LOG(LogTemp, Log, TEXT("SetAISkillInterval: Set to %.1f-%.1f seconds"), MinInterval, MaxInterval);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("SetAISkillInterval: Set to %.1f-%.1f seconds"), MinInterval, MaxInterval);
 }
 
+// ========================================
+// 随机流
+// ========================================
+
+void ADatamanagement::SeedRandomStreams(int32 RaceSeed)
+{
+	InitRandomStreams(RaceSeed);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("SeedRandomStreams: Race seed %d"), RaceSeed);
+
+	// 棋盘必须来自棋盘流才能复现，动画进行中则保留当前棋盘
+	if (GameState != EMatch3State::Idle)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("SeedRandomStreams: Board is busy (state %d), keeping current board"), (int32)GameState);
+		return;
+	}
+
+	SelectedTileIndex = -1;
+	GenerateBoard();
+
+	// 通知UI刷新整个棋盘
+	OnBoardReshuffle();
+	OnBoardRebuiltNative.Broadcast(true);
+}
+
+void ADatamanagement::SetRandomStreamSeed(ERandomStreamType StreamType, int32 Seed)
+{
+	GetRandomStream(StreamType).Initialize(Seed);
+}
+
+int32 ADatamanagement::GetRandomStreamSeed(ERandomStreamType StreamType) const
+{
+	return GetRandomStream(StreamType).GetInitialSeed();
+}
+
+void ADatamanagement::InitRandomStreams(int32 RaceSeed)
+{
+	// 每个随机流使用不同的派生种子，某一类随机调用次数变化不会影响其他随机流
+	BoardStream.Initialize((int32)HashCombine((uint32)RaceSeed, (uint32)ERandomStreamType::Board + 1));
+	RefillStream.Initialize((int32)HashCombine((uint32)RaceSeed, (uint32)ERandomStreamType::Refill + 1));
+	AISkillStream.Initialize((int32)HashCombine((uint32)RaceSeed, (uint32)ERandomStreamType::AISkill + 1));
+	AIIntervalStream.Initialize((int32)HashCombine((uint32)RaceSeed, (uint32)ERandomStreamType::AIInterval + 1));
+	AIMatch3Stream.Initialize((int32)HashCombine((uint32)RaceSeed, (uint32)ERandomStreamType::AIMatch3 + 1));
+}
+
+FRandomStream& ADatamanagement::GetRandomStream(ERandomStreamType StreamType)
+{
+	return const_cast<FRandomStream&>(static_cast<const ADatamanagement*>(this)->GetRandomStream(StreamType));
+}
+
+const FRandomStream& ADatamanagement::GetRandomStream(ERandomStreamType StreamType) const
+{
+	switch (StreamType)
+	{
+	case ERandomStreamType::Refill:
+		return RefillStream;
+	case ERandomStreamType::AISkill:
+		return AISkillStream;
+	case ERandomStreamType::AIInterval:
+		return AIIntervalStream;
+	case ERandomStreamType::AIMatch3:
+		return AIMatch3Stream;
+	case ERandomStreamType::Board:
+	default:
+		return BoardStream;
+	}
+}
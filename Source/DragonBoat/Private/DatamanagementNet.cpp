@@ -0,0 +1,537 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// ADatamanagement 的网络对战部分：服务器记录并发送棋盘改变，客户端按顺序应用到镜像棋盘
+
+#include "Datamanagement.h"
+#include "DragonBoat.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Match3 NetFlush"), STAT_Match3_NetFlush, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Match3 NetApply"), STAT_Match3_NetApply, STATGROUP_DragonBoat);
+
+// Insights 计数器：服务器发送的棋盘同步字节数（连消深度与 Datamanagement.cpp 共用）
+TRACE_DECLARE_INT_COUNTER(Match3_NetBytes, TEXT("DragonBoat/Match3/NetBytes"));
+TRACE_DECLARE_INT_COUNTER_EXTERN(Match3_CascadeDepth);
+
+// ========================================
+// 网络对战
+// ========================================
+
+bool ADatamanagement::IsControlledLocally() const
+{
+	// GameMode 把玩家的棋盘交给其 PlayerController；没有拥有者的棋盘属于服务器（单机、主机）
+	if (const APlayerController* OwnerController = Cast<APlayerController>(GetOwner()))
+	{
+		return OwnerController->IsLocalController();
+	}
+	return HasAuthority();
+}
+
+void ADatamanagement::SetAIBoatHumanControlled(int32 AI, bool bHumanControlled)
+{
+	const int32 AIIndex = AI;
+	if (AIIndex < 0 || AIIndex >= MaxAIBoats)
+	{
+		return;
+	}
+	if (bHumanControlled)
+	{
+		HumanControlledAIMask |= 1u << AIIndex;
+
+		// 已调度的技能与积累的技能点作废
+		if (AIIndex < AISkillScheduler.NumCasters() && AISkillScheduler.IsScheduled(AIIndex))
+		{
+			AISkillScheduler.Cancel(AIIndex);
+			ArmAISkillTimer();
+		}
+		if (AIMatch3Boats.IsValidIndex(AIIndex))
+		{
+			AIMatch3Boats[AIIndex].PendingSkillPoints = 0;
+		}
+	}
+	else
+	{
+		HumanControlledAIMask &= ~(1u << AIIndex);
+	}
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("SetAIBoatHumanControlled: AI%d human controlled: %d"), AIIndex + 1, bHumanControlled);
+}
+
+void ADatamanagement::ResetBoardReplicationStats()
+{
+	NetStats = FNetReplicationStats();
+	NetDelta.ResetStats();
+}
+
+void ADatamanagement::LogBoardReplicationStats() const
+{
+	if (!HasAuthority())
+	{
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("Board %d replication (client): %d messages, %lld bytes received, %d desyncs"),
+			BoardBoatIndex, NetStats.ReceivedMessages, NetStats.ReceivedBytes, NetStats.Desyncs);
+		return;
+	}
+
+	// 每个客户端收到的字节数（复制层的包头不计入）
+	const int64 TotalBytes = NetDelta.GetTotalBytes() + NetStats.KeyframeBytes;
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("Board %d replication: %lld bytes = %d messages (%lld bytes) + %d keyframes (%lld bytes)"),
+		BoardBoatIndex, TotalBytes, NetDelta.GetNumMessages(), NetDelta.GetTotalBytes(), NetStats.KeyframeUpdates, NetStats.KeyframeBytes);
+	UE_LOG(LogDragonBoatMatch3, Log, TEXT("  -> %d swaps, %.1f bytes/swap, %d of %d swap requests rejected"),
+		NetStats.Swaps, NetStats.Swaps > 0 ? (double)TotalBytes / NetStats.Swaps : 0.0, NetStats.RejectedSwaps, NetStats.SwapRequests);
+	if (NetStats.OversizedDeltas > 0)
+	{
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("  -> %d messages exceeded %d bytes and were replaced by keyframes"),
+			NetStats.OversizedDeltas, NetMaxDeltaBytes);
+	}
+}
+
+void ADatamanagement::RequestSwap(int32 IndexA, int32 IndexB)
+{
+	if (HasAuthority())
+	{
+		TrySwap(IndexA, IndexB);
+		return;
+	}
+
+	// 客户端：本地棋盘与服务器一致，无效交换直接在本地播放失败动画，有效交换交给服务器验证并执行
+	if (GameState != EMatch3State::Idle || bAwaitingSwapResult)
+	{
+		return;
+	}
+	if (!Match3.IsValidSwap(IndexA, IndexB))
+	{
+		RevertSwap(IndexA, IndexB);
+		return;
+	}
+	bAwaitingSwapResult = true;
+	Server_RequestSwap((uint8)IndexA, (uint8)IndexB);
+}
+
+// ========== 服务器 ==========
+
+bool ADatamanagement::ShouldRecordNetDelta() const
+{
+	const ENetMode NetMode = GetNetMode();
+	return (NetMode == NM_ListenServer || NetMode == NM_DedicatedServer) && HasAuthority();
+}
+
+void ADatamanagement::RecordNetKeyframe(bool bReshuffle)
+{
+	if (!ShouldRecordNetDelta())
+	{
+		return;
+	}
+
+	NetDelta.RecordKeyframe(Match3, bReshuffle, (uint8)GameState);
+	NetDelta.ResendMorale();
+
+	// 之后加入的客户端也从完整棋盘开始
+	bNetKeyframeRequested = true;
+}
+
+void ADatamanagement::FlushNetDelta(float DeltaTime)
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_NetFlush);
+
+	// 士气值与技能点每帧只比较一次（消除、技能、调试修改都包含在内）
+	const FMatch3MoraleState Morale(CurrentMorale, SkillPoints);
+	NetDelta.RecordMorale(Morale);
+	if (NetDelta.HasPendingOps())
+	{
+		const TArray<uint8>& Message = NetDelta.Finish(FMatch3NetDelta::ComputeChecksum(Match3, Morale));
+		++NetSequence;
+		if (Message.Num() <= NetMaxDeltaBytes)
+		{
+			TRACE_COUNTER_ADD(Match3_NetBytes, Message.Num());
+			Multicast_ApplyBoardDelta(NetSequence, Message);
+		}
+		else
+		{
+			// 跳过这个序号：客户端收到下一条消息时发现缺失，从本帧刷新的关键帧恢复
+			++NetStats.OversizedDeltas;
+			bNetKeyframeRequested = true;
+			UE_LOG(LogDragonBoatMatch3, Warning, TEXT("FlushNetDelta: Board %d message %d is %d bytes (limit %d), sending keyframe instead"),
+				BoardBoatIndex, NetSequence, Message.Num(), NetMaxDeltaBytes);
+		}
+		NetDelta.Clear();
+	}
+
+	// 关键帧：完整棋盘改变、有人请求，或者超过间隔且之后有新的改变
+	NetKeyframeTimer += DeltaTime;
+	if (bNetKeyframeRequested || (NetKeyframeTimer >= NetKeyframeIntervalSeconds && BoardKeyframe.Sequence != NetSequence))
+	{
+		RefreshNetKeyframe();
+	}
+}
+
+void ADatamanagement::RefreshNetKeyframe()
+{
+	// 包含到 NetSequence 为止的全部改变：完整棋盘与当前的流程状态、士气值、技能点
+	const FMatch3MoraleState Morale(CurrentMorale, SkillPoints);
+	NetKeyframeWriter.RecordKeyframe(Match3, false, (uint8)GameState);
+	NetKeyframeWriter.ResendMorale();
+	NetKeyframeWriter.RecordMorale(Morale);
+
+	BoardKeyframe.Sequence = NetSequence;
+	BoardKeyframe.Data = NetKeyframeWriter.Finish(FMatch3NetDelta::ComputeChecksum(Match3, Morale));
+	NetKeyframeWriter.Clear();
+
+	++NetStats.KeyframeUpdates;
+	NetStats.KeyframeBytes += BoardKeyframe.Data.Num();
+	NetKeyframeTimer = 0.0f;
+	bNetKeyframeRequested = false;
+}
+
+void ADatamanagement::Server_RequestSwap_Implementation(uint8 IndexA, uint8 IndexB)
+{
+	++NetStats.SwapRequests;
+
+	// 服务器权威：客户端的棋盘只是镜像，交换在服务器的棋盘上重新验证，拒绝时不改变服务器的状态
+	if (GameState != EMatch3State::Idle || !IsValidIndex(IndexA) || !IsValidIndex(IndexB)
+		|| !IsAdjacent(IndexA, IndexB) || !Match3.IsValidSwap(IndexA, IndexB))
+	{
+		++NetStats.RejectedSwaps;
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("Server_RequestSwap: Board %d rejected %d <-> %d in state %d"),
+			BoardBoatIndex, IndexA, IndexB, (int32)GameState);
+		Client_SwapRejected(IndexA, IndexB);
+		return;
+	}
+
+	TrySwap(IndexA, IndexB);
+}
+
+void ADatamanagement::Server_CastSkill_Implementation(uint8 SlotIndex)
+{
+	if (TryCastSkill(SlotIndex))
+	{
+		const ESkillType SkillType = EquippedSkills[SlotIndex];
+		Client_SkillCasted(SkillType, SkillConfigs.FindChecked(SkillType));
+	}
+}
+
+void ADatamanagement::Server_RequestKeyframe_Implementation()
+{
+	bNetKeyframeRequested = true;
+}
+
+// ========== 客户端 ==========
+
+void ADatamanagement::Client_SwapRejected_Implementation(uint8 IndexA, uint8 IndexB)
+{
+	bAwaitingSwapResult = false;
+	if (GameState == EMatch3State::Idle)
+	{
+		RevertSwap(IndexA, IndexB);
+	}
+}
+
+void ADatamanagement::Client_SkillCasted_Implementation(ESkillType SkillType, const FSkillConfig& Config)
+{
+	// 技能效果由服务器作用到比赛模拟，这里只通知UI
+	OnSkillCasted(SkillType, Config);
+}
+
+void ADatamanagement::Multicast_ApplyBoardDelta_Implementation(int32 Sequence, const TArray<uint8>& Delta)
+{
+	// 服务器上的棋盘已经是最新
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	++NetStats.ReceivedMessages;
+	NetStats.ReceivedBytes += Delta.Num();
+
+	// 已包含在关键帧中的消息 / 失去同步后等待关键帧
+	if (Sequence <= NetSequence || !bNetSynced)
+	{
+		return;
+	}
+	if (Sequence != NetSequence + 1)
+	{
+		HandleNetDesync(TEXT("missing message"));
+		return;
+	}
+
+	NetSequence = Sequence;
+	if (!ApplyBoardDelta(Delta))
+	{
+		HandleNetDesync(TEXT("checksum mismatch"));
+	}
+}
+
+void ADatamanagement::OnRep_BoardKeyframe()
+{
+	// BeginPlay 之前收到时，由 BeginPlay 在初始化之后应用
+	if (!HasActorBegunPlay() || BoardKeyframe.Data.Num() == 0)
+	{
+		return;
+	}
+
+	// 已同步时只应用更新的关键帧（定期刷新不打断正在播放的动画）
+	if (bNetSynced && BoardKeyframe.Sequence <= NetSequence)
+	{
+		return;
+	}
+
+	bNetTimelineOpen = false;
+	bNetSynced = ApplyBoardDelta(BoardKeyframe.Data);
+	NetSequence = BoardKeyframe.Sequence;
+	if (!bNetSynced)
+	{
+		UE_LOG(LogDragonBoatMatch3, Warning, TEXT("OnRep_BoardKeyframe: Board %d keyframe %d is corrupted"), BoardBoatIndex, BoardKeyframe.Sequence);
+	}
+}
+
+void ADatamanagement::HandleNetDesync(const TCHAR* Reason)
+{
+	++NetStats.Desyncs;
+	bNetSynced = false;
+	bNetTimelineOpen = false;
+	bAwaitingSwapResult = false;
+
+	UE_LOG(LogDragonBoatMatch3, Warning, TEXT("Board %d lost sync at message %d (%s), waiting for keyframe"), BoardBoatIndex, NetSequence, Reason);
+
+	// 拥有者立即请求；对手的棋盘等服务器的定期刷新
+	if (IsControlledLocally())
+	{
+		Server_RequestKeyframe();
+	}
+}
+
+bool ADatamanagement::ApplyBoardDelta(const TArray<uint8>& Delta)
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_NetApply);
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	// 按服务器的改变顺序应用，并播放与服务器相同的事件（消除的士气值只预测用于显示，由 Morale 操作同步）
+	NetPredictedMorale = FMatch3MoraleState(CurrentMorale, SkillPoints);
+	NetPredictedMoraleReward = 0;
+	FMatch3NetDeltaReader Reader(Delta.GetData(), Delta.Num());
+	EMatch3NetOp Op;
+	while (Reader.Next(Op))
+	{
+		switch (Op)
+		{
+		case EMatch3NetOp::Keyframe:
+			{
+				bool bReshuffle;
+				uint8 HostState;
+				Reader.ReadKeyframe(Match3, bReshuffle, HostState, (uint8)EMatch3State::PlayingTimeline);
+				if (!Reader.HasError())
+				{
+					ApplyNetKeyframe(bReshuffle, HostState);
+				}
+			}
+			break;
+
+		case EMatch3NetOp::Swap:
+			{
+				int32 IndexA, IndexB;
+				bool bWholeCascade;
+				Reader.ReadSwap(IndexA, IndexB, bWholeCascade);
+				if (Reader.HasError())
+				{
+					break;
+				}
+
+				bAwaitingSwapResult = false;
+				Match3.ApplySwap(IndexA, IndexB);
+				OrbGrid.Swap(IndexA, IndexB);
+				if (bWholeCascade)
+				{
+					// 同一条消息中接着是整条连消链，Settle 时交给UI
+					BeginTimeline(IndexA, IndexB);
+					bNetTimelineOpen = true;
+				}
+				else
+				{
+					StartSwap(IndexA, IndexB);
+				}
+			}
+			break;
+
+		case EMatch3NetOp::Clear:
+			{
+				// 消除的索引按行优先展开（服务器为先横向后纵向，格子相同）
+				const uint64 ClearedMask = Reader.ReadMask();
+				if (Reader.HasError())
+				{
+					break;
+				}
+
+				if (bNetTimelineOpen)
+				{
+					ClearMatchedCells(ClearedMask, 0, CascadeStepResult);
+					AddTimelineStep();
+				}
+				else
+				{
+					ClearMatchedCells(ClearedMask, 0, LastStepResult);
+					DispatchClearingStep();
+				}
+			}
+			break;
+
+		case EMatch3NetOp::Fill:
+			{
+				TArray<FFallMove>& FallMoves = (bNetTimelineOpen && LastCascadeTimeline.Steps.Num() > 0)
+					? LastCascadeTimeline.Steps.Last().FallMoves
+					: LastFallMoves;
+				FallMoves.Reset();
+				Reader.ReadFill(Match3, [&FallMoves](int32 FromIdx, int32 ToIdx, uint8 Color, bool bIsNewTile)
+				{
+					FallMoves.Emplace(FromIdx, ToIdx, static_cast<ETileColor>(Color), bIsNewTile);
+				});
+				SyncOrbGridFromBoard();
+
+				if (!bNetTimelineOpen && !Reader.HasError())
+				{
+					// [时机4] 通知UI播放下落动画
+					GameState = EMatch3State::Falling;
+					OnFallAnimTriggered(LastFallMoves);
+					OnFallAnimNative.Broadcast(LastFallMoves);
+				}
+			}
+			break;
+
+		case EMatch3NetOp::Settle:
+			ApplyNetSettle();
+			break;
+
+		case EMatch3NetOp::Locked:
+			{
+				const uint64 LockedMask = Reader.ReadMask();
+				if (!Reader.HasError())
+				{
+					ApplyNetLocked(LockedMask);
+				}
+			}
+			break;
+
+		case EMatch3NetOp::SpecialAreas:
+			{
+				FMatch3SpecialAreas SpecialAreas(Match3.GetSpecialAreas());
+				Reader.ReadSpecialAreas(SpecialAreas);
+				if (!Reader.HasError())
+				{
+					ApplySpecialAreaMasks(SpecialAreas);
+				}
+			}
+			break;
+
+		case EMatch3NetOp::Morale:
+			{
+				FMatch3MoraleState Morale(CurrentMorale, SkillPoints);
+				Reader.ReadMorale(Morale);
+				if (!Reader.HasError())
+				{
+					ApplyNetMorale(Morale);
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return Reader.HasEnded()
+		&& Reader.GetChecksum() == FMatch3NetDelta::ComputeChecksum(Match3, FMatch3MoraleState(CurrentMorale, SkillPoints));
+}
+
+void ADatamanagement::ApplyNetKeyframe(bool bReshuffle, uint8 HostState)
+{
+	SyncOrbGridFromBoard();
+
+	if (bReshuffle)
+	{
+		// 死锁洗牌：一次性结算模式下由时间线的 bReshuffled 通知
+		if (bNetTimelineOpen)
+		{
+			LastCascadeTimeline.bReshuffled = true;
+		}
+		else
+		{
+			// [时机5] 通知UI棋盘洗牌动画
+			OnBoardReshuffle();
+		}
+		HintRanker.Reset();
+		OnBoardRebuiltNative.Broadcast(true);
+		return;
+	}
+
+	// 完整棋盘（初始化、重新同步）：与快照恢复相同，UI按 OrbGrid 重新创建所有方块
+	ApplySpecialAreaMasks(FMatch3SpecialAreas(Match3.GetSpecialAreas()));
+	bNetTimelineOpen = false;
+	bAwaitingSwapResult = false;
+	SelectedTileIndex = -1;
+	GameState = (EMatch3State)HostState;
+
+	// [时机1]
+	OnBoardInitialized();
+	OnBoardRebuiltNative.Broadcast(false);
+
+	if (Match3.GetLockedMask())
+	{
+		OnCellsLocked((int64)Match3.GetLockedMask());
+	}
+}
+
+void ADatamanagement::ApplyNetLocked(uint64 LockedMask)
+{
+	const uint64 OldMask = Match3.GetLockedMask();
+	Match3.SetLockedMask(LockedMask);
+
+	const uint64 NewlyLocked = LockedMask & ~OldMask;
+	if (NewlyLocked)
+	{
+		OnCellsLocked((int64)NewlyLocked);
+	}
+	else if (LockedMask == 0 && OldMask != 0)
+	{
+		OnCellsUnlocked();
+	}
+	if (LockedMask != OldMask)
+	{
+		OnCellStateChangedNative.Broadcast();
+	}
+}
+
+void ADatamanagement::ApplyNetMorale(const FMatch3MoraleState& Morale)
+{
+	// 士气值与技能点只由服务器改变（消除、技能释放、调试修改），UI显示的增加量为本条消息中消除预测的士气值
+	const int32 AddedAmount = NetPredictedMoraleReward;
+	NetPredictedMorale = Morale;
+	NetPredictedMoraleReward = 0;
+
+	const bool bSkillPointsChanged = Morale.SkillPoints != SkillPoints;
+	if (Morale.CurrentMorale == CurrentMorale && !bSkillPointsChanged)
+	{
+		return;
+	}
+
+	CurrentMorale = Morale.CurrentMorale;
+	SkillPoints = Morale.SkillPoints;
+	NotifyMoraleChanged(AddedAmount);
+	if (bSkillPointsChanged)
+	{
+		NotifySkillPointChanged();
+	}
+}
+
+void ADatamanagement::ApplyNetSettle()
+{
+	Match3.Settle();
+
+	if (bNetTimelineOpen)
+	{
+		bNetTimelineOpen = false;
+		FinishTimeline();
+	}
+	else
+	{
+		TRACE_COUNTER_SET(Match3_CascadeDepth, CurrentCascadeDepth);
+		GameState = EMatch3State::Idle;
+	}
+}
@@ -0,0 +1,283 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// ADatamanagement 的比赛录像与快照部分：把棋盘、士气值、AI状态写入 / 读出录像与快照流，实际的结算仍在 Datamanagement.cpp
+
+#include "Datamanagement.h"
+#include "DragonBoat.h"
+#include "RaceSimulationComponent.h"
+#include "HAL/FileManager.h"
+
+// ========================================
+// 比赛录像
+// ========================================
+
+bool ADatamanagement::BeginReplayRecording(const FString& FilePath, int32 RaceSeed)
+{
+	EndReplayRecording();
+
+	ReplayArchive.Reset(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!ReplayArchive)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("BeginReplayRecording: Cannot create %s"), *FilePath);
+		return false;
+	}
+
+	// 随机流保存当前种子：播种后已经生成过棋盘，回放直接从文件头中的棋盘开始
+	const URaceSimulationComponent* Simulation = RaceSimulation.Get();
+	FRaceReplayHeader Header;
+	Header.RaceSeed = RaceSeed;
+	Header.BoardSeed = BoardStream.GetCurrentSeed();
+	Header.RefillSeed = RefillStream.GetCurrentSeed();
+	Header.Capture(Match3, GetMoraleConfig(), FMatch3MoraleState(CurrentMorale, SkillPoints), Simulation ? &Simulation->GetSimulation() : nullptr);
+
+	SelectedTileIndex = -1;
+	ReplayRecorder.Begin(Header, GetWorld()->GetTimeSeconds());
+	FlushReplay();
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("BeginReplayRecording: Recording race (seed %d) to %s"), RaceSeed, *FilePath);
+	return true;
+}
+
+void ADatamanagement::EndReplayRecording()
+{
+	if (!ReplayArchive)
+	{
+		return;
+	}
+
+	// 动画结算中的棋盘还没有稳定，不写校验值
+	if (GameState == EMatch3State::Idle)
+	{
+		RecordReplayChecksum();
+	}
+	const URaceSimulationComponent* Simulation = RaceSimulation.Get();
+	ReplayRecorder.End(GetWorld()->GetTimeSeconds(), Simulation ? &Simulation->GetSimulation() : nullptr);
+	FlushReplay();
+
+	ReplayArchive->Close();
+	ReplayArchive.Reset();
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("EndReplayRecording: %d events, %lld bytes"), ReplayRecorder.GetNumEvents(), ReplayRecorder.GetTotalBytes());
+}
+
+void ADatamanagement::RecordReplayChecksum()
+{
+	if (ReplayRecorder.IsRecording())
+	{
+		ReplayRecorder.RecordChecksum(GetWorld()->GetTimeSeconds(),
+			FRaceReplayPlayer::ComputeChecksum(Match3, FMatch3MoraleState(CurrentMorale, SkillPoints)));
+	}
+}
+
+void ADatamanagement::FlushReplay()
+{
+	const TArray<uint8>& Pending = ReplayRecorder.GetPendingBytes();
+	if (ReplayArchive && Pending.Num() > 0)
+	{
+		ReplayArchive->Serialize(const_cast<uint8*>(Pending.GetData()), Pending.Num());
+		ReplayRecorder.ClearPending();
+	}
+}
+
+
+// ========================================
+// 比赛快照
+// ========================================
+
+void ADatamanagement::CollectAIMatch3Batches()
+{
+	for (int32 BoatIndex = 0; BoatIndex < AIMatch3Boats.Num(); ++BoatIndex)
+	{
+		if (AIMatch3Boats[BoatIndex].Task.IsValid())
+		{
+			AIMatch3Boats[BoatIndex].Task.Wait();
+			CollectAIMatch3Batch(BoatIndex);
+		}
+	}
+}
+
+void ADatamanagement::WriteSnapshot(FRaceSnapshotWriter& Writer)
+{
+	// 玩家棋盘与结算状态（选中的格子只是UI状态，不保存）
+	FRaceSnapshot::WriteGame(Writer, Match3);
+	Writer.WriteBits((uint64)GameState, 3);
+	Writer.WritePacked(CurrentCascadeDepth);
+	FRaceSnapshot::WriteMorale(Writer, FMatch3MoraleState(CurrentMorale, SkillPoints));
+
+	for (int32 StreamType = 0; StreamType <= (int32)ERandomStreamType::AIMatch3; ++StreamType)
+	{
+		FRaceSnapshot::WriteStream(Writer, GetRandomStream((ERandomStreamType)StreamType));
+	}
+
+	// AI技能：释放间隔由难度设置，调度与目标选择的时间相对当前时间保存
+	const double Now = GetWorld()->GetTimeSeconds();
+	Writer.WriteFloat(AISkillIntervalMin);
+	Writer.WriteFloat(AISkillIntervalMax);
+	AISkillScheduler.WriteSnapshot(Writer, Now);
+	AISkillTargeting.WriteSnapshot(Writer, Now);
+
+	Writer.WriteBool(bAIMatch3Running);
+	if (bAIMatch3Running)
+	{
+		Writer.WritePacked(AIMatch3Boats.Num());
+		for (const FAIMatch3Boat& Boat : AIMatch3Boats)
+		{
+			// 进行中的一批：写入派发前的检查点与交换数（不等待工作线程，恢复后重新派发这一批）
+			const bool bBatchInFlight = Boat.Task.IsValid();
+			Writer.WriteBool(bBatchInFlight);
+			if (bBatchInFlight)
+			{
+				FMatch3AIPlayer::WriteSnapshot(Writer, Boat.Checkpoint);
+				Writer.WritePacked(Boat.BatchMoves);
+			}
+			else
+			{
+				Boat.Player->WriteSnapshot(Writer);
+			}
+			Writer.WriteFloat(Boat.MoveBudget);
+			Writer.WriteFloat(Boat.BatchTimer);
+			Writer.WritePacked(Boat.PendingSkillPoints);
+			Writer.WritePackedSigned(Boat.PendingLockCells);
+		}
+	}
+}
+
+void ADatamanagement::ReadSnapshot(FRaceSnapshotReader& Reader)
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	FSnapshotState& Saved = PendingSnapshot;
+	FRaceSnapshot::ReadGame(Reader, Saved.Match3);
+	const uint64 SavedState = Reader.ReadBits(3);
+	Saved.GameState = SavedState <= (uint64)EMatch3State::PlayingTimeline ? (EMatch3State)SavedState : EMatch3State::Idle;
+	Saved.CascadeDepth = Reader.ReadCount(FMatch3Board::NumCells);
+	FRaceSnapshot::ReadMorale(Reader, Saved.Morale);
+
+	for (FRandomStream& Stream : Saved.Streams)
+	{
+		FRaceSnapshot::ReadStream(Reader, Stream);
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	Saved.AISkillIntervalMin = Reader.ReadFloat();
+	Saved.AISkillIntervalMax = Reader.ReadFloat();
+	Saved.Scheduler.ReadSnapshot(Reader, Now);
+	Saved.Targeting.ReadSnapshot(Reader, Now);
+
+	Saved.bAIMatch3Running = Reader.ReadBool();
+	Saved.AIBoats.SetNum(Saved.bAIMatch3Running ? Reader.ReadCount(MaxAIBoats) : 0);
+	for (FSnapshotState::FAIBoat& Boat : Saved.AIBoats)
+	{
+		const bool bBatchInFlight = Reader.ReadBool();
+		FMatch3AIPlayer::ReadSnapshot(Reader, Boat.Player);
+		Boat.BatchMoves = bBatchInFlight ? Reader.ReadCount(MAX_uint16) : 0;
+		Boat.MoveBudget = Reader.ReadFloat();
+		Boat.BatchTimer = Reader.ReadFloat();
+		Boat.PendingSkillPoints = Reader.ReadCount(MaxSkillPoints);
+		Boat.PendingLockCells = (int32)FMath::Clamp<int64>(Reader.ReadPackedSigned(), -1, FMatch3Board::NumCells);
+	}
+}
+
+void ADatamanagement::ApplySnapshot()
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	// 恢复后的比赛不再与录像的时间线连续
+	EndReplayRecording();
+	WaitForAIMatch3();
+
+	const FSnapshotState& Saved = PendingSnapshot;
+	Match3 = Saved.Match3;
+	GameState = Saved.GameState;
+	CurrentCascadeDepth = Saved.CascadeDepth;
+	SelectedTileIndex = -1;
+	CurrentMorale = Saved.Morale.CurrentMorale;
+	SkillPoints = FMath::Min(Saved.Morale.SkillPoints, MaxSkillPoints);
+
+	for (int32 StreamType = 0; StreamType <= (int32)ERandomStreamType::AIMatch3; ++StreamType)
+	{
+		GetRandomStream((ERandomStreamType)StreamType) = Saved.Streams[StreamType];
+	}
+
+	AISkillIntervalMin = Saved.AISkillIntervalMin;
+	AISkillIntervalMax = Saved.AISkillIntervalMax;
+	AISkillScheduler = Saved.Scheduler;
+	AISkillTargeting = Saved.Targeting;
+
+	if (Saved.bAIMatch3Running)
+	{
+		AIMatch3Boats.SetNum(Saved.AIBoats.Num());
+		for (int32 BoatIndex = 0; BoatIndex < AIMatch3Boats.Num(); ++BoatIndex)
+		{
+			const FSnapshotState::FAIBoat& SavedBoat = Saved.AIBoats[BoatIndex];
+			FAIMatch3Boat& Boat = AIMatch3Boats[BoatIndex];
+			if (!Boat.Player)
+			{
+				Boat.Player = MakeUnique<FMatch3AIPlayer>();
+			}
+			Boat.Player->RestoreCheckpoint(SavedBoat.Player);
+			Boat.BatchMoves = SavedBoat.BatchMoves;
+			Boat.MoveBudget = SavedBoat.MoveBudget;
+			Boat.BatchTimer = SavedBoat.BatchTimer;
+			Boat.PendingSkillPoints = SavedBoat.PendingSkillPoints;
+			Boat.PendingLockCells = SavedBoat.PendingLockCells;
+		}
+	}
+	bAIMatch3Running = Saved.bAIMatch3Running;
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("ApplySnapshot: State %d, morale %d, skill points %d, AI match3 %d"),
+		(int32)GameState, CurrentMorale, SkillPoints, bAIMatch3Running);
+}
+
+void ADatamanagement::FinishSnapshotRestore()
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	// 保存时正在逐步结算：不等动画，立即按相同的规则完成剩余的消除、下落与连消
+	// 状态效果照常作用到比赛模拟；回退交换与时间线播放中的棋盘已经稳定，直接回到空闲
+	if (GameState == EMatch3State::Swapping || GameState == EMatch3State::CheckMatching
+		|| GameState == EMatch3State::Clearing || GameState == EMatch3State::Falling)
+	{
+		if (GameState == EMatch3State::Clearing)
+		{
+			FillEmptyTiles(LastFallMoves);
+		}
+		while (ResolveMatchStep(LastStepResult))
+		{
+			++CurrentCascadeDepth;
+			LastStepResult.CascadeDepth = CurrentCascadeDepth;
+			OnStepResolvedNative.Broadcast(LastStepResult);
+			FillEmptyTiles(LastFallMoves);
+		}
+		if (SettleBoard())
+		{
+			OnBoardRebuiltNative.Broadcast(true);
+		}
+		UE_LOG(LogDragonBoatMatch3, Log, TEXT("FinishSnapshotRestore: Completed pending cascade (depth %d)"), CurrentCascadeDepth);
+	}
+	GameState = EMatch3State::Idle;
+	LastFallMoves.Reset();
+	SyncOrbGridFromBoard();
+
+	// 镜像特殊格子并通知UI（恢复时录像已经停止，不会记录）
+	ApplySpecialAreaMasks(FMatch3SpecialAreas(Match3.GetSpecialAreas()));
+	ArmAISkillTimer();
+
+	// [时机1] 与初始化相同，UI按 OrbGrid 重新创建所有方块，不播放任何动画
+	OnBoardInitialized();
+	OnBoardRebuiltNative.Broadcast(false);
+
+	if (Match3.GetLockedMask())
+	{
+		OnCellsLocked((int64)Match3.GetLockedMask());
+	}
+	NotifyMoraleChanged(0);
+	NotifySkillPointChanged();
+
+	// 结算过程中记录的改变由完整棋盘代替
+	if (ShouldRecordNetDelta())
+	{
+		NetDelta.Clear();
+		RecordNetKeyframe(false);
+	}
+}
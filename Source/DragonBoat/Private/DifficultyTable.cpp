@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DifficultyTable.h"
+#include "DragonBoat.h"
+#include "UObject/ObjectSaveContext.h"
+
+namespace DifficultyTableDefaults
+{
+	// 格子索引列表 -> 掩码（编译期求值）
+	constexpr uint64 CellMask(std::initializer_list<int32> Indices)
+	{
+		uint64 Mask = 0;
+		for (int32 Index : Indices)
+		{
+			Mask |= uint64(1) << Index;
+		}
+		return Mask;
+	}
+
+	struct FDefaultDifficulty
+	{
+		EDifficultyLevel Level;
+		float AISkillIntervalMin;
+		float AISkillIntervalMax;
+		uint64 SpeedUpSelf;
+		uint64 SlowDownEnemy;
+		uint64 MoraleBoost;
+	};
+
+	// 内置的五档难度（与 7x7 棋盘的格子索引对应）
+	constexpr FDefaultDifficulty Defaults[] =
+	{
+		// 难度 1 - 简单
+		{ EDifficultyLevel::Easy, 15.0f, 25.0f,
+			CellMask({ 14,15,16,21,22,23,28,29,30 }), CellMask({ 18,19,20,25,26,27,32,33,34 }), CellMask({ 17,24,31 }) },
+		// 难度 2 - 中等
+		{ EDifficultyLevel::Normal, 12.0f, 20.0f,
+			CellMask({ 15,16,22,23,29,30 }), CellMask({ 18,19,25,26,32,33 }), CellMask({ 17,24,31 }) },
+		// 难度 3 - 困难
+		{ EDifficultyLevel::Hard, 10.0f, 18.0f,
+			CellMask({ 15,22,29 }), CellMask({ 19,26,33 }), CellMask({ 24 }) },
+		// 难度 4 - 变态
+		{ EDifficultyLevel::Insane, 8.0f, 13.0f,
+			CellMask({ 15,29 }), CellMask({ 19,31 }), CellMask({ 17 }) },
+		// 难度 5 - 地狱（0 个特殊格子）
+		{ EDifficultyLevel::Hell, 5.0f, 10.0f, 0, 0, 0 },
+	};
+}
+
+UDifficultyTable::UDifficultyTable()
+{
+	using namespace DifficultyTableDefaults;
+
+	// 只有 5 档，默认值直接写成预编译结果，资产加载时会被序列化数据覆盖
+	CompiledLevels.SetNum(UE_ARRAY_COUNT(Defaults));
+	for (const FDefaultDifficulty& Default : Defaults)
+	{
+		FCompiledDifficulty& Compiled = CompiledLevels[(int32)Default.Level];
+		Compiled.bValid = true;
+		Compiled.AISkillIntervalMin = Default.AISkillIntervalMin;
+		Compiled.AISkillIntervalMax = Default.AISkillIntervalMax;
+		Compiled.EffectMasks[(int32)EMatch3Effect::SpeedUpSelf] = Default.SpeedUpSelf;
+		Compiled.EffectMasks[(int32)EMatch3Effect::SlowDownEnemy] = Default.SlowDownEnemy;
+		Compiled.EffectMasks[(int32)EMatch3Effect::MoraleBoost] = Default.MoraleBoost;
+	}
+
+#if WITH_EDITORONLY_DATA
+	// 编辑器中由预编译结果还原出可编辑的索引/类型列表
+	for (int32 LevelIndex = 0; LevelIndex < CompiledLevels.Num(); ++LevelIndex)
+	{
+		const FCompiledDifficulty& Compiled = CompiledLevels[LevelIndex];
+		FDifficultyConfig& Config = Configs.Add((EDifficultyLevel)LevelIndex);
+		Config.AISkillIntervalMin = Compiled.AISkillIntervalMin;
+		Config.AISkillIntervalMax = Compiled.AISkillIntervalMax;
+		for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+		{
+			for (uint64 Remaining = Compiled.EffectMasks[Type]; Remaining; Remaining &= Remaining - 1)
+			{
+				Config.SpecialAreaIndices.Add(FMatch3Bits::FirstIndex(Remaining));
+				Config.SpecialAreaTypes.Add((ESlotEffectType)Type);
+			}
+		}
+	}
+#endif
+}
+
+#if WITH_EDITOR
+
+void UDifficultyTable::PostLoad()
+{
+	Super::PostLoad();
+
+	// 编辑器中以 Configs 为准（兼容修改默认值之前保存的资产）
+	CompileConfigs();
+}
+
+void UDifficultyTable::PreSave(FObjectPreSaveContext SaveContext)
+{
+	CompileConfigs();
+
+	Super::PreSave(SaveContext);
+}
+
+void UDifficultyTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompileConfigs();
+}
+
+void UDifficultyTable::CompileConfigs()
+{
+	// 最后一项是自动生成的 _MAX
+	const int32 NumLevels = StaticEnum<EDifficultyLevel>()->NumEnums() - 1;
+	CompiledLevels.Reset();
+	CompiledLevels.SetNum(NumLevels);
+
+	for (const TPair<EDifficultyLevel, FDifficultyConfig>& Pair : Configs)
+	{
+		const FDifficultyConfig& Config = Pair.Value;
+		FCompiledDifficulty& Compiled = CompiledLevels[(int32)Pair.Key];
+		Compiled.bValid = true;
+		Compiled.AISkillIntervalMin = Config.AISkillIntervalMin;
+		Compiled.AISkillIntervalMax = Config.AISkillIntervalMax;
+
+		// 与 ADatamanagement::ApplySpecialAreas 相同：忽略越界索引与缺少类型的项，重复索引以后者为准
+		FMatch3SpecialAreas SpecialAreas;
+		for (int32 Area = 0; Area < Config.SpecialAreaIndices.Num(); ++Area)
+		{
+			const int32 Index = Config.SpecialAreaIndices[Area];
+			if (Config.SpecialAreaTypes.IsValidIndex(Area) && Index >= 0 && Index < FMatch3Board::NumCells)
+			{
+				SpecialAreas.SetEffect(Index, (EMatch3Effect)Config.SpecialAreaTypes[Area]);
+			}
+			else
+			{
+				UE_LOG(LogDragonBoatRace, Warning, TEXT("%s: Difficulty %d special area %d (index %d) ignored"),
+					*GetName(), (int32)Pair.Key, Area, Index);
+			}
+		}
+
+		for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+		{
+			Compiled.EffectMasks[Type] = SpecialAreas.GetEffectMask((EMatch3Effect)Type);
+		}
+	}
+}
+
+#endif
@@ -1,128 +1,267 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DragonBoatGameMode.h"
+#include "DragonBoatGameState.h"
 #include "Datamanagement.h"
+#include "DifficultyTable.h"
+#include "RaceSimulationComponent.h"
+#include "DragonBoat.h"
+#include "RaceSnapshot.h"
 #include "TimerManager.h"
-#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Race UpdateProgress"), STAT_Race_UpdateProgress, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race UpdateRankings"), STAT_Race_UpdateRankings, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race SaveSnapshot"), STAT_Race_SaveSnapshot, STATGROUP_DragonBoat);
+DECLARE_CYCLE_STAT(TEXT("Race RestoreSnapshot"), STAT_Race_RestoreSnapshot, STATGROUP_DragonBoat);
+
+// Insights 计数器：累计的排名变化次数
+TRACE_DECLARE_INT_COUNTER(Race_RankChanges, TEXT("DragonBoat/Race/RankChanges"));
 
 ADragonBoatGameMode::ADragonBoatGameMode()
 {
 	PrimaryActorTick.bCanEverTick = true;
 
-	// Ĭ
+	// 默认配置
 	RaceTrackLength = 10000.0f;
 	StartLinePosition = FVector(0.0f, 0.0f, 0.0f);
 	FinishLinePosition = FVector(10000.0f, 0.0f, 0.0f);
 	CountdownDuration = 3.0f;
-	ProgressUpdateInterval = 0.2f;  // Ĭÿ0.2һ
+	ProgressUpdateInterval = 0.2f;  // 默认每0.2秒更新一次
 	RaceEndDelay = 5.0f;
-
-	// ʱݳʼ
+	RaceSeed = 0;  // 默认每局随机
+	bRecordReplay = false;
+	RollbackBufferFrames = 0;  // 默认不保存回滚帧
+	RollbackFrameInterval = 0.1f;
+	bSuspendOnBackground = true;
+
+	// 双人对战（进度与排名经 GameState 同步给客户端）
+	bHeadToHead = false;
+	HeadToHeadBoardClass = nullptr;
+	GameStateClass = ADragonBoatGameState::StaticClass();
+
+	// 比赛模拟（龙舟速度由C++计算）
+	bUseRaceSimulation = true;
+	RaceSimulation = CreateDefaultSubobject<URaceSimulationComponent>(TEXT("RaceSimulation"));
+
+	// 运行时数据初始化
 	CurrentGameState = ERaceGameState::PreRace;
 	CurrentRaceTime = 0.0f;
 	FinishedBoatCount = 0;
+	CurrentRaceSeed = 0;
 	CountdownRemaining = 0;
+	RollbackNewest = INDEX_NONE;
+	RollbackCount = 0;
+	RollbackTimeSinceSave = 0.0f;
 
 	PlayerBoat = nullptr;
 	AIBoat1 = nullptr;
 	AIBoat2 = nullptr;
 
-	// Ѷϵͳʼ
-	CurrentDifficulty = EDifficultyLevel::Easy;  // ĬеѶ
-
-	// ʼĬѶãڱ༭иǣ
-	InitializeDefaultDifficultyConfigs();
+	// 难度系统初始化（难度表在首次应用难度时才加载）
+	CurrentDifficulty = EDifficultyLevel::Easy;  // 默认中等难度
+	LoadedDifficultyTable = nullptr;
 }
 
 void ADragonBoatGameMode::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ʼ
-	BoatDataArray.SetNum(3);
+	LLM_SCOPE_BYTAG(DragonBoat_Race);
+
+	// 初始化龙舟登记表（比赛开始时会按当时的龙舟数重新初始化）
+	GatherRaceBoats();
+	BoatRegistry.Reset(RaceBoats.Num());
 
-	UE_LOG(LogTemp, Log, TEXT("DragonBoatGameMode: Initialized"));
+	if (RaceSimulation)
+	{
+		RaceSimulation->OnStatusChangedNative.AddUObject(this, &ADragonBoatGameMode::HandleBoatStatusChanged);
+	}
+
+	// 移动平台切到后台后进程可能被系统结束，先保存快照
+	EnterBackgroundHandle = FCoreDelegates::ApplicationWillEnterBackgroundDelegate.AddUObject(this, &ADragonBoatGameMode::HandleEnterBackground);
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("DragonBoatGameMode: Initialized with %d boats"), RaceBoats.Num());
+}
+
+void ADragonBoatGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FCoreDelegates::ApplicationWillEnterBackgroundDelegate.Remove(EnterBackgroundHandle);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ADragonBoatGameMode::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// ֻڱи¼ʱ
+	// 只在比赛进行中更新计时
 	if (CurrentGameState == ERaceGameState::Racing)
 	{
 		CurrentRaceTime += DeltaTime;
+
+		// 双人对战写不出快照，不占用回滚缓冲
+		if (RollbackBufferFrames > 0 && !HeadToHeadBoard.IsValid())
+		{
+			RollbackTimeSinceSave += DeltaTime;
+			if (RollbackTimeSinceSave >= RollbackFrameInterval)
+			{
+				RollbackTimeSinceSave = 0.0f;
+				SaveRollbackFrame();
+			}
+		}
 	}
 
-	// ߼ȫʹTimerTickִ
+	// 其他逻辑全部使用Timer，不在Tick中执行
+}
+
+void ADragonBoatGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	ADatamanagement* DataMgmt = FindDatamanagement();
+	if (!DataMgmt || !NewPlayer)
+	{
+		return;
+	}
+
+	// 第一位玩家（单机或主机自己）操作场景中的棋盘
+	if (!DataMgmt->GetOwner())
+	{
+		DataMgmt->SetOwner(NewPlayer);
+		UE_LOG(LogDragonBoatRace, Log, TEXT("PostLogin: %s controls board 0"), *NewPlayer->GetName());
+	}
+	else if (bHeadToHead && !HeadToHeadBoard.IsValid())
+	{
+		SpawnHeadToHeadBoard(NewPlayer);
+	}
+
+	// 新加入的客户端从下一条关键帧开始同步
+	DataMgmt->RequestNetKeyframe();
+	if (ADatamanagement* SecondBoard = HeadToHeadBoard.Get())
+	{
+		SecondBoard->RequestNetKeyframe();
+	}
+}
+
+void ADragonBoatGameMode::Logout(AController* Exiting)
+{
+	// 第二位玩家离开后，龙舟1交还给AI
+	ADatamanagement* SecondBoard = HeadToHeadBoard.Get();
+	if (SecondBoard && Exiting && SecondBoard->GetOwner() == Exiting)
+	{
+		SecondBoard->SetOwner(nullptr);
+		if (ADatamanagement* DataMgmt = FindDatamanagement())
+		{
+			DataMgmt->SetAIBoatHumanControlled(0, false);
+		}
+		UE_LOG(LogDragonBoatRace, Log, TEXT("Logout: %s left, boat 1 is controlled by AI again"), *Exiting->GetName());
+	}
+
+	Super::Logout(Exiting);
 }
 
 // ========================================
-// ӿ
+// 公共接口
 // ========================================
 
 void ADragonBoatGameMode::StartCountdown()
 {
 	if (CurrentGameState != ERaceGameState::PreRace)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("StartCountdown: Can only start countdown in PreRace state!"));
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("StartCountdown: Can only start countdown in PreRace state!"));
 		return;
 	}
 
 	CurrentGameState = ERaceGameState::PreRace;
 	CountdownRemaining = FMath::CeilToInt(CountdownDuration);
 
-	UE_LOG(LogTemp, Log, TEXT("StartCountdown: Starting countdown from %d seconds"), CountdownRemaining);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("StartCountdown: Starting countdown from %d seconds"), CountdownRemaining);
 
-	// ظTimerÿ봥һ
+	// 设置重复Timer，每秒触发一次
 	GetWorld()->GetTimerManager().SetTimer(
 		CountdownTimerHandle,
 		this,
 		&ADragonBoatGameMode::CountdownTick,
-		1.0f,  // ÿ봥
-		true   // ظ
+		1.0f,  // 每秒触发
+		true   // 重复
 	);
 
-	// һεʱ
+	// 立即触发第一次倒计时
 	CountdownTick();
 }
 
 void ADragonBoatGameMode::StartRace()
 {
+	LLM_SCOPE_BYTAG(DragonBoat_Race);
+
 	CurrentGameState = ERaceGameState::Racing;
 	CurrentRaceTime = 0.0f;
 	FinishedBoatCount = 0;
+	RollbackCount = 0;
+	RollbackTimeSinceSave = 0.0f;
 
-	// 
-	for (int32 i = 0; i < BoatDataArray.Num(); i++)
-	{
-		BoatDataArray[i] = FBoatRaceData();
-	}
+	// 重置龙舟数据（比赛中不再分配）
+	GatherRaceBoats();
+	BoatRegistry.Reset(RaceBoats.Num());
 
-	UE_LOG(LogTemp, Log, TEXT("StartRace: Race started!"));
+	// 确定本局种子（未指定时随机生成，并记录下来用于复现）
+	CurrentRaceSeed = (RaceSeed != 0) ? RaceSeed : FMath::Rand();
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("StartRace: Race started! Boats: %d, Seed: %d"), RaceBoats.Num(), CurrentRaceSeed);
 
 	OnRaceStarted();
 
-	// ʼݹAIϵͳ
-	ADatamanagement* DataMgmt = Cast<ADatamanagement>(
-		UGameplayStatics::GetActorOfClass(GetWorld(), ADatamanagement::StaticClass()));
+	// 初始化数据管理器，并启动AI技能系统
+	ADatamanagement* DataMgmt = FindDatamanagement();
 	if (DataMgmt)
 	{
-		DataMgmt->StartAISkillSystem();
-		UE_LOG(LogTemp, Log, TEXT("StartRace: AI Skill System activated"));
+		// 先播种随机流，棋盘与AI技能都由本局种子决定
+		DataMgmt->SeedRandomStreams(CurrentRaceSeed);
+		DataMgmt->StartAISkillSystem(BoatRegistry.Num());
+		DataMgmt->ResetBoardReplicationStats();
+		UE_LOG(LogDragonBoatRace, Log, TEXT("StartRace: AI Skill System activated"));
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("StartRace: Datamanagement not found! AI skills will not work."));
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("StartRace: Datamanagement not found! AI skills will not work."));
+	}
+
+	// 双人对战：第二位玩家的棋盘用同一个种子，两人从相同的棋盘与补充序列开始
+	ADatamanagement* SecondBoard = HeadToHeadBoard.Get();
+	if (SecondBoard)
+	{
+		SecondBoard->SeedRandomStreams(CurrentRaceSeed);
+		SecondBoard->ResetBoardReplicationStats();
 	}
 
-	// ȸTimer
+	// 启动比赛模拟：加速/减速格子与技能从数据管理器的原生事件转换为状态效果
+	if (bUseRaceSimulation && RaceSimulation)
+	{
+		RaceSimulation->StartSimulation(RaceBoats, StartLinePosition, FinishLinePosition);
+		RaceSimulation->BindToDatamanagement(DataMgmt);
+		RaceSimulation->AddPlayerBoard(SecondBoard);
+	}
+
+	// 录像从棋盘播种、比赛模拟开始之后的状态开始
+	if (bRecordReplay && DataMgmt)
+	{
+		const FString FileName = FString::Printf(TEXT("Race_%d_%s.dbreplay"), CurrentRaceSeed, *FDateTime::Now().ToString());
+		DataMgmt->BeginReplayRecording(FPaths::ProjectSavedDir() / TEXT("Replays") / FileName, CurrentRaceSeed);
+	}
+
+	// 启动进度更新Timer
 	GetWorld()->GetTimerManager().SetTimer(
 		ProgressUpdateTimerHandle,
 		this,
 		&ADragonBoatGameMode::UpdateProgress,
 		ProgressUpdateInterval,
-		true  // ظ
+		true  // 重复
 	);
 }
 
@@ -133,10 +272,15 @@ void ADragonBoatGameMode::PauseRace()
 
 	CurrentGameState = ERaceGameState::Paused;
 
-	// ͣȸ
+	// 暂停进度更新、结束倒计时与比赛模拟
 	GetWorld()->GetTimerManager().PauseTimer(ProgressUpdateTimerHandle);
+	GetWorld()->GetTimerManager().PauseTimer(RaceEndTimerHandle);
+	if (RaceSimulation)
+	{
+		RaceSimulation->SetSimulationPaused(true);
+	}
 
-	UE_LOG(LogTemp, Log, TEXT("PauseRace: Race paused"));
+	UE_LOG(LogDragonBoatRace, Log, TEXT("PauseRace: Race paused"));
 }
 
 void ADragonBoatGameMode::ResumeRace()
@@ -146,37 +290,70 @@ void ADragonBoatGameMode::ResumeRace()
 
 	CurrentGameState = ERaceGameState::Racing;
 
-	// ָȸ
+	// 恢复进度更新、结束倒计时与比赛模拟
 	GetWorld()->GetTimerManager().UnPauseTimer(ProgressUpdateTimerHandle);
+	GetWorld()->GetTimerManager().UnPauseTimer(RaceEndTimerHandle);
+	if (RaceSimulation)
+	{
+		RaceSimulation->SetSimulationPaused(false);
+	}
 
-	UE_LOG(LogTemp, Log, TEXT("ResumeRace: Race resumed"));
+	UE_LOG(LogDragonBoatRace, Log, TEXT("ResumeRace: Race resumed"));
 }
 
 int32 ADragonBoatGameMode::GetBoatRank(int32 BoatIndex) const
 {
-	if (BoatDataArray.IsValidIndex(BoatIndex))
+	if (BoatIndex >= 0 && BoatIndex < BoatRegistry.Num())
 	{
-		return BoatDataArray[BoatIndex].CurrentRank;
+		return BoatRegistry.GetRank(BoatIndex);
 	}
 	return 1;
 }
 
 float ADragonBoatGameMode::GetBoatProgress(int32 BoatIndex) const
 {
-	if (BoatDataArray.IsValidIndex(BoatIndex))
+	if (BoatIndex >= 0 && BoatIndex < BoatRegistry.Num())
 	{
-		return BoatDataArray[BoatIndex].CurrentProgress;
+		return BoatRegistry.GetProgress(BoatIndex);
 	}
 	return 0.0f;
 }
 
+int32 ADragonBoatGameMode::GetNumBoats() const
+{
+	return BoatRegistry.Num();
+}
+
+int32 ADragonBoatGameMode::GetBoatAtRank(int32 Rank) const
+{
+	if (Rank >= 1 && Rank <= BoatRegistry.Num())
+	{
+		return BoatRegistry.GetBoatAtRank(Rank);
+	}
+	return -1;
+}
+
+int32 ADragonBoatGameMode::RegisterBoat(AActor* Boat)
+{
+	if (!Boat || CurrentGameState == ERaceGameState::Racing || CurrentGameState == ERaceGameState::Paused)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("RegisterBoat: Can only register a valid boat before the race starts!"));
+		return -1;
+	}
+
+	GatherRaceBoats();
+	const int32 BoatIndex = RaceBoats.AddUnique(Boat);
+	BoatRegistry.Reset(RaceBoats.Num());
+	return BoatIndex;
+}
+
 // ========================================
-// ڲ
+// 内部函数
 // ========================================
 
 void ADragonBoatGameMode::CountdownTick()
 {
-	UE_LOG(LogTemp, Log, TEXT("CountdownTick: %d"), CountdownRemaining);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("CountdownTick: %d"), CountdownRemaining);
 
 	OnCountdownTick(CountdownRemaining);
 
@@ -184,7 +361,7 @@ void ADragonBoatGameMode::CountdownTick()
 
 	if (CountdownRemaining < 0)
 	{
-		// ʱֹͣTimerʼ
+		// 倒计时结束，停止Timer并开始比赛
 		GetWorld()->GetTimerManager().ClearTimer(CountdownTimerHandle);
 		StartRace();
 	}
@@ -195,312 +372,656 @@ void ADragonBoatGameMode::UpdateProgress()
 	if (CurrentGameState != ERaceGameState::Racing)
 		return;
 
-	TArray<AActor*> Boats = { PlayerBoat, AIBoat1, AIBoat2 };
-	TArray<int32> OldRanks;
-
-	// ڼ仯
-	for (const FBoatRaceData& Data : BoatDataArray)
-	{
-		OldRanks.Add(Data.CurrentRank);
-	}
+	LLM_SCOPE_BYTAG(DragonBoat_Race);
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_UpdateProgress);
 
-	// 1. ÿ۵Ľ
-	for (int32 i = 0; i < Boats.Num(); i++)
+	// 1. 更新每条龙舟的进度
+	if (bUseRaceSimulation && RaceSimulation && RaceSimulation->IsSimulationRunning())
 	{
-		if (!Boats[i] || BoatDataArray[i].bHasFinished)
-			continue;
-
-		// ȣXλã
-		float BoatX = Boats[i]->GetActorLocation().X;
-		float StartX = StartLinePosition.X;
-		float FinishX = FinishLinePosition.X;
-
-		float Progress = FMath::Clamp(
-			(BoatX - StartX) / (FinishX - StartX),
-			0.0f, 1.0f
-		);
-
-		BoatDataArray[i].CurrentProgress = Progress;
+		// 读取比赛模拟（完成时间为模拟中越过终点的精确时间）
+		const FRaceSimulation& Simulation = RaceSimulation->GetSimulation();
+		const int32 NumBoats = FMath::Min(Simulation.Num(), BoatRegistry.Num());
+		for (int32 i = 0; i < NumBoats; i++)
+		{
+			BoatRegistry.SetProgress(i, Simulation.GetProgress(i));
+		}
 
-		// Ƿ
-		if (Progress >= 1.0f && !BoatDataArray[i].bHasFinished)
+		// 两次更新之间完成的龙舟按完成时间先后处理
+		while (CurrentGameState == ERaceGameState::Racing)
 		{
-			OnBoatReachedFinish(i);
+			int32 NextFinisher = INDEX_NONE;
+			for (int32 i = 0; i < NumBoats; i++)
+			{
+				if (Simulation.HasFinished(i) && !BoatRegistry.HasFinished(i)
+					&& (NextFinisher == INDEX_NONE || Simulation.GetFinishTime(i) < Simulation.GetFinishTime(NextFinisher)))
+				{
+					NextFinisher = i;
+				}
+			}
+			if (NextFinisher == INDEX_NONE)
+				break;
+
+			OnBoatReachedFinish(NextFinisher, Simulation.GetFinishTime(NextFinisher));
 		}
 	}
-
-	// 2. 
-	UpdateRankings();
-
-	// 3. 仯
-	for (int32 i = 0; i < BoatDataArray.Num(); i++)
+	else
 	{
-		if (OldRanks.IsValidIndex(i) && OldRanks[i] != BoatDataArray[i].CurrentRank)
+		// 基于X坐标位置
+		const float StartX = StartLinePosition.X;
+		const float FinishX = FinishLinePosition.X;
+		const int32 NumBoats = FMath::Min(RaceBoats.Num(), BoatRegistry.Num());
+		for (int32 i = 0; i < NumBoats && CurrentGameState == ERaceGameState::Racing; i++)
 		{
-			UE_LOG(LogTemp, Log, TEXT("Rank Changed: Boat %d from rank %d to %d"), 
-				i, OldRanks[i], BoatDataArray[i].CurrentRank);
-			OnRankChanged(i, OldRanks[i], BoatDataArray[i].CurrentRank);
+			if (!RaceBoats[i] || BoatRegistry.HasFinished(i))
+				continue;
+
+			const float Progress = FMath::Clamp(
+				(RaceBoats[i]->GetActorLocation().X - StartX) / (FinishX - StartX),
+				0.0f, 1.0f
+			);
+
+			BoatRegistry.SetProgress(i, Progress);
+
+			// 检测是否完成
+			if (Progress >= 1.0f)
+			{
+				OnBoatReachedFinish(i, CurrentRaceTime);
+			}
 		}
 	}
 
-	// 4. ֪ͨUI½
-	TArray<float> Progresses;
-	TArray<int32> Ranks;
-	for (const FBoatRaceData& Data : BoatDataArray)
-	{
-		Progresses.Add(Data.CurrentProgress);
-		Ranks.Add(Data.CurrentRank);
-	}
+	// 所有龙舟完成时比赛已结束（结束时已做最终排名）
+	if (CurrentGameState != ERaceGameState::Racing)
+		return;
+
+	// 2. 计算排名
+	UpdateRankings();
 
-	OnProgressUpdated(Progresses, Ranks);
+	// 3. 通知UI更新进度（直接传登记表的数组，不复制），并同步给客户端
+	OnProgressUpdated(BoatRegistry.GetProgresses(), BoatRegistry.GetRanks());
+	ReplicateRaceStandings();
 }
 
 void ADragonBoatGameMode::UpdateRankings()
 {
-	// 򣨽ԽԽǰ
-	TArray<int32> SortedIndices = { 0, 1, 2 };
-
-	SortedIndices.Sort([this](int32 A, int32 B) {
-		// ɵ
-		if (BoatDataArray[A].bHasFinished != BoatDataArray[B].bHasFinished)
-			return BoatDataArray[A].bHasFinished;
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_UpdateRankings);
 
-		// ɵİʱ
-		if (BoatDataArray[A].bHasFinished && BoatDataArray[B].bHasFinished)
-			return BoatDataArray[A].FinishTime < BoatDataArray[B].FinishTime;
+	// 增量排名：只移动顺序变化的龙舟
+	const int32 NumChanges = BoatRegistry.UpdateRanking();
 
-		// δɵİȽ
-		return BoatDataArray[A].CurrentProgress > BoatDataArray[B].CurrentProgress;
-	});
+	// 通知排名变化
+	for (int32 ChangeIndex = 0; ChangeIndex < NumChanges; ChangeIndex++)
+	{
+		const FRaceRankChange& Change = BoatRegistry.GetRankChange(ChangeIndex);
+		UE_LOG(LogDragonBoatRace, Log, TEXT("Rank Changed: Boat %d from rank %d to %d"),
+			Change.BoatIndex, Change.OldRank, Change.NewRank);
+		TRACE_COUNTER_INCREMENT(Race_RankChanges);
+		OnRankChanged(Change.BoatIndex, Change.OldRank, Change.NewRank);
+	}
 
-	// 
-	for (int32 Rank = 0; Rank < SortedIndices.Num(); Rank++)
+	// AI技能按最新排名与超越记录选择目标
+	if (ADatamanagement* DataMgmt = FindDatamanagement())
 	{
-		int32 BoatIndex = SortedIndices[Rank];
-		BoatDataArray[BoatIndex].CurrentRank = Rank + 1;
+		DataMgmt->UpdateRaceStandings(BoatRegistry);
 	}
 }
 
-void ADragonBoatGameMode::OnBoatReachedFinish(int32 BoatIndex)
+void ADragonBoatGameMode::OnBoatReachedFinish(int32 BoatIndex, float FinishTime)
 {
-	BoatDataArray[BoatIndex].bHasFinished = true;
-	BoatDataArray[BoatIndex].FinishTime = CurrentRaceTime;
-	FinishedBoatCount++;
+	// 确定最终排名（基于完成顺序）
+	const int32 FinalRank = BoatRegistry.MarkFinished(BoatIndex, FinishTime);
+	if (FinalRank == INDEX_NONE)
+		return;
 
-	// ȷʱ䣩
-	int32 FinalRank = FinishedBoatCount;
+	FinishedBoatCount = BoatRegistry.GetNumFinished();
 
-	UE_LOG(LogTemp, Log, TEXT("Boat %d finished! Time: %.2f, Rank: %d"), 
-		BoatIndex, CurrentRaceTime, FinalRank);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("Boat %d finished! Time: %.2f, Rank: %d"), 
+		BoatIndex, FinishTime, FinalRank);
 
-	OnBoatFinished(BoatIndex, CurrentRaceTime, FinalRank);
+	OnBoatFinished(BoatIndex, FinishTime, FinalRank);
 
-	// ǵһɣʱ
+	// 如果是第一名完成，启动结束倒计时
 	if (FinishedBoatCount == 1)
 	{
-		UE_LOG(LogTemp, Log, TEXT("First boat finished! Starting end timer (%.1f seconds)"), RaceEndDelay);
+		UE_LOG(LogDragonBoatRace, Log, TEXT("First boat finished! Starting end timer (%.1f seconds)"), RaceEndDelay);
 
 		GetWorld()->GetTimerManager().SetTimer(
 			RaceEndTimerHandle,
 			this,
 			&ADragonBoatGameMode::EndRace,
-			RaceEndDelay,  // ӳX
+			RaceEndDelay,  // 延迟X秒
 			false
 		);
 	}
 
-	// ۶
-	if (FinishedBoatCount >= 3)
+	// 或者所有龙舟都完成立即结束
+	if (FinishedBoatCount >= BoatRegistry.Num())
 	{
-		UE_LOG(LogTemp, Log, TEXT("All boats finished! Ending race immediately"));
+		UE_LOG(LogDragonBoatRace, Log, TEXT("All boats finished! Ending race immediately"));
 
 		GetWorld()->GetTimerManager().ClearTimer(RaceEndTimerHandle);
 		EndRace();
 	}
 }
 
+void ADragonBoatGameMode::HandleBoatStatusChanged(int32 BoatIndex, ERaceStatusEffect Status, bool bActive)
+{
+	OnBoatStatusChanged(BoatIndex, Status, bActive);
+}
+
 void ADragonBoatGameMode::EndRace()
 {
 	CurrentGameState = ERaceGameState::Finished;
 
-	// ֹͣȸ
+	// 停止进度更新
 	GetWorld()->GetTimerManager().ClearTimer(ProgressUpdateTimerHandle);
 
-	UE_LOG(LogTemp, Log, TEXT("EndRace: Race finished!"));
+	UE_LOG(LogDragonBoatRace, Log, TEXT("EndRace: Race finished!"));
+
+	// 最终排名（包含最后一次进度更新之后完成的龙舟）
+	UpdateRankings();
+
+	// 最终进度与排名同步给客户端
+	ReplicateRaceStandings();
+
+	if (ADatamanagement* DataMgmt = FindDatamanagement())
+	{
+		DataMgmt->EndReplayRecording();
+
+		// 联网比赛：输出每块棋盘本局的同步带宽
+		if (GetNetMode() != NM_Standalone)
+		{
+			DataMgmt->LogBoardReplicationStats();
+			if (ADatamanagement* SecondBoard = HeadToHeadBoard.Get())
+			{
+				SecondBoard->LogBoardReplicationStats();
+			}
+		}
+	}
+
+	// 已经结束的比赛不能再继续
+	RollbackCount = 0;
+	IFileManager::Get().Delete(*GetSuspendedRacePath(), false, false, true);
 
-	// ս
+	// 按排名构建最终结果
 	TArray<FBoatFinalResult> FinalRankings;
-	for (int32 i = 0; i < BoatDataArray.Num(); i++)
+	FinalRankings.Reserve(BoatRegistry.Num());
+	for (int32 Rank = 1; Rank <= BoatRegistry.Num(); Rank++)
 	{
-		FBoatFinalResult Result;
-		Result.BoatIndex = i;
-		Result.FinalRank = BoatDataArray[i].CurrentRank;
-		Result.FinishTime = BoatDataArray[i].FinishTime;
-		Result.bIsPlayer = (i == 0);
+		const int32 i = BoatRegistry.GetBoatAtRank(Rank);
 
-		FinalRankings.Add(Result);
+		FBoatFinalResult& Result = FinalRankings.AddDefaulted_GetRef();
+		Result.BoatIndex = i;
+		Result.FinalRank = Rank;
+		Result.FinishTime = BoatRegistry.GetFinishTime(i);
+		Result.bIsPlayer = (i == 0) || (i == 1 && HeadToHeadBoard.IsValid());
 
-		UE_LOG(LogTemp, Log, TEXT("  Boat %d: Rank %d, Time %.2f"), 
+		UE_LOG(LogDragonBoatRace, Log, TEXT("  Boat %d: Rank %d, Time %.2f"), 
 			i, Result.FinalRank, Result.FinishTime);
 	}
 
-	// 
-	FinalRankings.Sort([](const FBoatFinalResult& A, const FBoatFinalResult& B) {
-		return A.FinalRank < B.FinalRank;
-	});
-
 	OnRaceFinished(FinalRankings);
 }
 
 // ========================================
-// Ѷϵͳ
+// 比赛快照
+// ========================================
+
+bool ADragonBoatGameMode::SaveRaceSnapshot(TArray<uint8>& OutData)
+{
+	// 明确保存（存档、切到后台）：先收取AI三消批次，结果作用到比赛模拟后再保存，恢复时不需要重新派发
+	ADatamanagement* DataMgmt = FindDatamanagement();
+	if (DataMgmt && (CurrentGameState == ERaceGameState::Racing || CurrentGameState == ERaceGameState::Paused)
+		&& !HeadToHeadBoard.IsValid())
+	{
+		DataMgmt->CollectAIMatch3Batches();
+	}
+	return WriteRaceSnapshot(OutData);
+}
+
+bool ADragonBoatGameMode::WriteRaceSnapshot(TArray<uint8>& OutData)
+{
+	if (CurrentGameState != ERaceGameState::Racing && CurrentGameState != ERaceGameState::Paused)
+	{
+		return false;
+	}
+
+	// 快照只包含场景中的棋盘，双人对战不支持保存
+	if (HeadToHeadBoard.IsValid())
+	{
+		return false;
+	}
+
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_SaveSnapshot);
+
+	// 进行中的AI三消批次由数据管理器按派发前的检查点写入，不等待工作线程
+	ADatamanagement* DataMgmt = FindDatamanagement();
+
+	// 计时器保存剩余时间（-1 表示未设置，例如第一名还未完成时的结束倒计时）
+	const FTimerManager& TimerManager = GetWorldTimerManager();
+	FRaceSnapshotWriter Writer(OutData);
+	Writer.WriteFloat(CurrentRaceTime);
+	Writer.WriteBits((uint32)CurrentRaceSeed, 32);
+	Writer.WriteBits((uint64)CurrentDifficulty, 3);
+	Writer.WriteFloat(TimerManager.GetTimerRemaining(ProgressUpdateTimerHandle));
+	Writer.WriteFloat(TimerManager.GetTimerRemaining(RaceEndTimerHandle));
+	BoatRegistry.WriteSnapshot(Writer);
+
+	const bool bSimulated = RaceSimulation && RaceSimulation->IsSimulationRunning();
+	Writer.WriteBool(bSimulated);
+	if (bSimulated)
+	{
+		RaceSimulation->WriteSnapshot(Writer);
+	}
+	Writer.WriteBool(DataMgmt != nullptr);
+	if (DataMgmt)
+	{
+		DataMgmt->WriteSnapshot(Writer);
+	}
+	Writer.Finish();
+	return true;
+}
+
+bool ADragonBoatGameMode::RestoreRaceSnapshot(const TArray<uint8>& Data)
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Race);
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_RestoreSnapshot);
+
+	FRaceSnapshotReader Reader(Data.GetData(), Data.Num());
+	if (!Reader.IsValid())
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("RestoreRaceSnapshot: Invalid or corrupted snapshot (%d bytes)"), Data.Num());
+		return false;
+	}
+
+	GatherRaceBoats();
+	ADatamanagement* DataMgmt = FindDatamanagement();
+
+	// 先完整读取所有部分（GameMode 自己的部分读到局部变量，模拟与数据管理器读到各自的暂存）：
+	// 与关卡不符（龙舟数、缺少组件）或数据不一致时在修改任何状态之前放弃
+	const float SavedRaceTime = Reader.ReadFloat();
+	const int32 SavedRaceSeed = (int32)(uint32)Reader.ReadBits(32);
+	const uint64 SavedDifficulty = Reader.ReadBits(3);
+	const float ProgressRemaining = Reader.ReadFloat();
+	const float RaceEndRemaining = Reader.ReadFloat();
+	FRaceBoatRegistry SavedRegistry;
+	SavedRegistry.ReadSnapshot(Reader);
+	const bool bSimulated = Reader.ReadBool();
+	if (Reader.HasError() || SavedRegistry.Num() != RaceBoats.Num() || SavedDifficulty > (uint64)EDifficultyLevel::Hell
+		|| (bSimulated && !RaceSimulation))
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("RestoreRaceSnapshot: Snapshot does not match this level (%d boats saved, %d in level)"),
+			SavedRegistry.Num(), RaceBoats.Num());
+		return false;
+	}
+	if (bSimulated)
+	{
+		RaceSimulation->ReadSnapshot(Reader, RaceBoats.Num());
+	}
+	const bool bSavedDatamanagement = Reader.ReadBool();
+	if (bSavedDatamanagement && DataMgmt)
+	{
+		DataMgmt->ReadSnapshot(Reader);
+	}
+	if (Reader.HasError())
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("RestoreRaceSnapshot: Snapshot is inconsistent, race state is unchanged"));
+		return false;
+	}
+
+	GetWorldTimerManager().ClearTimer(CountdownTimerHandle);
+	CurrentRaceTime = SavedRaceTime;
+	CurrentRaceSeed = SavedRaceSeed;
+	CurrentDifficulty = (EDifficultyLevel)SavedDifficulty;
+	BoatRegistry = MoveTemp(SavedRegistry);
+	FinishedBoatCount = BoatRegistry.GetNumFinished();
+
+	// 模拟先于数据管理器恢复：重新开始模拟时结束的旧效果（解除锁定）不会影响恢复后的棋盘
+	if (bSimulated)
+	{
+		RaceSimulation->ApplySnapshot(RaceBoats, StartLinePosition, FinishLinePosition);
+		RaceSimulation->BindToDatamanagement(DataMgmt);
+		RaceSimulation->AddPlayerBoard(HeadToHeadBoard.Get());
+	}
+	else if (RaceSimulation)
+	{
+		RaceSimulation->StopSimulation();
+	}
+	if (bSavedDatamanagement && DataMgmt)
+	{
+		DataMgmt->ApplySnapshot();
+	}
+
+	// 恢复为暂停状态：进度更新与结束倒计时按保存时的剩余时间重新设置并暂停，ResumeRace 继续
+	CurrentGameState = ERaceGameState::Paused;
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	TimerManager.SetTimer(ProgressUpdateTimerHandle, this, &ADragonBoatGameMode::UpdateProgress,
+		ProgressUpdateInterval, true, ProgressRemaining > 0.0f ? ProgressRemaining : ProgressUpdateInterval);
+	TimerManager.PauseTimer(ProgressUpdateTimerHandle);
+	if (RaceEndRemaining >= 0.0f)
+	{
+		TimerManager.SetTimer(RaceEndTimerHandle, this, &ADragonBoatGameMode::EndRace, FMath::Max(RaceEndRemaining, 0.001f), false);
+		TimerManager.PauseTimer(RaceEndTimerHandle);
+	}
+	else
+	{
+		TimerManager.ClearTimer(RaceEndTimerHandle);
+	}
+
+	// UI 整体刷新：难度、生效中的状态效果（只通知蓝图，不重复锁定棋盘）、棋盘、进度与排名
+	OnDifficultyChanged(CurrentDifficulty);
+	if (bSimulated)
+	{
+		for (int32 BoatIndex = 0; BoatIndex < BoatRegistry.Num(); ++BoatIndex)
+		{
+			for (int32 Status = 0; Status < (int32)ERaceStatus::Count; ++Status)
+			{
+				if (RaceSimulation->HasBoatStatus(BoatIndex, (ERaceStatusEffect)Status))
+				{
+					OnBoatStatusChanged(BoatIndex, (ERaceStatusEffect)Status, true);
+				}
+			}
+		}
+	}
+	if (bSavedDatamanagement && DataMgmt)
+	{
+		DataMgmt->FinishSnapshotRestore();
+	}
+	OnProgressUpdated(BoatRegistry.GetProgresses(), BoatRegistry.GetRanks());
+	ReplicateRaceStandings();
+	OnRaceRestored();
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("RestoreRaceSnapshot: Restored race at %.2f s (seed %d, %d bytes), paused"),
+		CurrentRaceTime, CurrentRaceSeed, Data.Num());
+	return true;
+}
+
+bool ADragonBoatGameMode::RollbackRace(int32 FramesAgo)
+{
+	if (FramesAgo < 0 || FramesAgo >= RollbackCount)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("RollbackRace: %d frames ago is not buffered (%d frames)"), FramesAgo, RollbackCount);
+		return false;
+	}
+
+	const int32 Slot = (RollbackNewest - FramesAgo + RollbackSnapshots.Num()) % RollbackSnapshots.Num();
+	if (!RestoreRaceSnapshot(RollbackSnapshots[Slot]))
+	{
+		return false;
+	}
+
+	// 丢弃回滚点之后的帧
+	RollbackNewest = Slot;
+	RollbackCount -= FramesAgo;
+	RollbackTimeSinceSave = 0.0f;
+	return true;
+}
+
+bool ADragonBoatGameMode::SuspendRace()
+{
+	PauseRace();
+
+	TArray<uint8> Data;
+	if (!SaveRaceSnapshot(Data))
+	{
+		return false;
+	}
+
+	const FString FilePath = GetSuspendedRacePath();
+	if (!FFileHelper::SaveArrayToFile(Data, *FilePath))
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("SuspendRace: Cannot write %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("SuspendRace: Saved %d bytes to %s"), Data.Num(), *FilePath);
+	return true;
+}
+
+bool ADragonBoatGameMode::HasSuspendedRace() const
+{
+	return FPaths::FileExists(GetSuspendedRacePath());
+}
+
+bool ADragonBoatGameMode::ResumeSuspendedRace()
+{
+	const FString FilePath = GetSuspendedRacePath();
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FilePath))
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("ResumeSuspendedRace: Cannot read %s"), *FilePath);
+		return false;
+	}
+
+	// 无论是否恢复成功都删除：无效的快照不应每次启动都再尝试
+	const bool bRestored = RestoreRaceSnapshot(Data);
+	IFileManager::Get().Delete(*FilePath);
+	return bRestored;
+}
+
+void ADragonBoatGameMode::Debug_BenchmarkSnapshot(int32 NumRuns)
+{
+	TArray<uint8> Data;
+	if (!SaveRaceSnapshot(Data))
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("Debug_BenchmarkSnapshot: Race is not running"));
+		return;
+	}
+
+	NumRuns = FMath::Max(NumRuns, 1);
+	const double StartSeconds = FPlatformTime::Seconds();
+	for (int32 Run = 0; Run < NumRuns; ++Run)
+	{
+		SaveRaceSnapshot(Data);
+	}
+	const double WallSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("Debug_BenchmarkSnapshot: %d bytes, %.2f us per save (%d runs)"),
+		Data.Num(), WallSeconds * 1e6 / NumRuns, NumRuns);
+}
+
+void ADragonBoatGameMode::SaveRollbackFrame()
+{
+	if (RollbackSnapshots.Num() != RollbackBufferFrames)
+	{
+		RollbackSnapshots.SetNum(RollbackBufferFrames);
+		RollbackNewest = INDEX_NONE;
+		RollbackCount = 0;
+	}
+
+	// 覆盖最旧的一帧，数组保留上次的容量
+	RollbackNewest = (RollbackNewest + 1) % RollbackSnapshots.Num();
+	TArray<uint8>& Frame = RollbackSnapshots[RollbackNewest];
+	if (!WriteRaceSnapshot(Frame))
+	{
+		return;
+	}
+	RollbackCount = FMath::Min(RollbackCount + 1, RollbackSnapshots.Num());
+
+	// 下一帧的容量不够时按本帧大小（留出余量）给所有帧预留，之后的保存不再分配
+	if (RollbackSnapshots[(RollbackNewest + 1) % RollbackSnapshots.Num()].Max() < Frame.Num())
+	{
+		const int32 Capacity = Frame.Num() + Frame.Num() / 4;
+		for (TArray<uint8>& Slot : RollbackSnapshots)
+		{
+			Slot.Reserve(Capacity);
+		}
+	}
+}
+
+void ADragonBoatGameMode::HandleEnterBackground()
+{
+	if (bSuspendOnBackground && (CurrentGameState == ERaceGameState::Racing || CurrentGameState == ERaceGameState::Paused))
+	{
+		SuspendRace();
+	}
+}
+
+FString ADragonBoatGameMode::GetSuspendedRacePath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("Snapshots") / TEXT("SuspendedRace.dbsnap");
+}
+
+// ========================================
+// 难度系统
 // ========================================
 
 void ADragonBoatGameMode::SetDifficulty(EDifficultyLevel Level)
 {
 	CurrentDifficulty = Level;
-	UE_LOG(LogTemp, Log, TEXT("SetDifficulty: Difficulty set to %d"), (int32)Level);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("SetDifficulty: Difficulty set to %d"), (int32)Level);
 
-	// ӦѶ
+	// 比赛中改变难度时记录到录像（特殊格子布局由 ApplySpecialAreaMasks 记录）
+	if (ADatamanagement* DataMgmt = FindDatamanagement())
+	{
+		if (FRaceReplayWriter* Recorder = DataMgmt->GetReplayRecorder())
+		{
+			Recorder->RecordDifficulty(GetWorld()->GetTimeSeconds(), (int32)Level);
+		}
+	}
+
+	// 应用难度配置
 	ApplyDifficultySettings();
 }
 
+const UDifficultyTable* ADragonBoatGameMode::GetDifficultyTable()
+{
+	if (!LoadedDifficultyTable)
+	{
+		LoadedDifficultyTable = DifficultyTable.IsNull() ? nullptr : DifficultyTable.LoadSynchronous();
+		if (!LoadedDifficultyTable)
+		{
+			if (!DifficultyTable.IsNull())
+			{
+				UE_LOG(LogDragonBoatRace, Warning, TEXT("GetDifficultyTable: Cannot load %s, using built-in difficulties"), *DifficultyTable.ToString());
+			}
+			LoadedDifficultyTable = GetDefault<UDifficultyTable>();
+		}
+	}
+	return LoadedDifficultyTable;
+}
+
 void ADragonBoatGameMode::ApplyDifficultySettings()
 {
-	// ҶӦѶȵ
-	FDifficultyConfig* Config = DifficultyConfigs.Find(CurrentDifficulty);
+	// 查找对应难度的预编译配置
+	const FCompiledDifficulty* Config = GetDifficultyTable()->Find(CurrentDifficulty);
 	if (!Config)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("ApplyDifficultySettings: No config found for difficulty %d!"), (int32)CurrentDifficulty);
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("ApplyDifficultySettings: No config found for difficulty %d!"), (int32)CurrentDifficulty);
 		return;
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("ApplyDifficultySettings: Applying difficulty %d"), (int32)CurrentDifficulty);
-	UE_LOG(LogTemp, Log, TEXT("  -> AI Skill Interval: %.1f-%.1f seconds"), Config->AISkillIntervalMin, Config->AISkillIntervalMax);
-	UE_LOG(LogTemp, Log, TEXT("  -> Special Areas: %d tiles"), Config->SpecialAreaIndices.Num());
+	UE_LOG(LogDragonBoatRace, Log, TEXT("ApplyDifficultySettings: Applying difficulty %d"), (int32)CurrentDifficulty);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("  -> AI Skill Interval: %.1f-%.1f seconds"), Config->AISkillIntervalMin, Config->AISkillIntervalMax);
+	UE_LOG(LogDragonBoatRace, Log, TEXT("  -> Special Areas: %d tiles"), Config->NumSpecialAreas());
 
-	// 1.  Datamanagement
-	ADatamanagement* DataMgmt = Cast<ADatamanagement>(
-		UGameplayStatics::GetActorOfClass(GetWorld(), ADatamanagement::StaticClass()));
-	
+	// 1. 配置 Datamanagement
+	ADatamanagement* DataMgmt = FindDatamanagement();
 	if (DataMgmt)
 	{
-		// Ӧ
-		DataMgmt->ApplySpecialAreas(Config->SpecialAreaIndices, Config->SpecialAreaTypes);
+		// 应用特殊格子配置（直接复制掩码）
+		DataMgmt->ApplySpecialAreaMasks(Config->GetSpecialAreas());
 
-		//  AI ͷż
+		// 设置 AI 技能释放间隔
 		DataMgmt->SetAISkillInterval(Config->AISkillIntervalMin, Config->AISkillIntervalMax);
 
-		UE_LOG(LogTemp, Log, TEXT("ApplyDifficultySettings: Datamanagement configured successfully"));
+		// 双人对战：第二位玩家的棋盘使用相同的特殊格子
+		if (ADatamanagement* SecondBoard = HeadToHeadBoard.Get())
+		{
+			SecondBoard->ApplySpecialAreaMasks(Config->GetSpecialAreas());
+		}
+
+		UE_LOG(LogDragonBoatRace, Log, TEXT("ApplyDifficultySettings: Datamanagement configured successfully"));
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("ApplyDifficultySettings: Datamanagement not found!"));
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("ApplyDifficultySettings: Datamanagement not found!"));
 	}
 
-	// 2. ֪ͨ AI ͼͨͼ¼
+	// 2. 通知 AI 龙舟蓝图（通过蓝图事件）
 	OnDifficultyChanged(CurrentDifficulty);
 }
 
-void ADragonBoatGameMode::InitializeDefaultDifficultyConfigs()
-{
-	// Ѷ 1 - 
-	FDifficultyConfig EasyConfig;
-	EasyConfig.AISkillIntervalMin = 15.0f;
-	EasyConfig.AISkillIntervalMax = 25.0f;
-	
-	EasyConfig.SpecialAreaIndices = {14,15,16,21,22,23,28,29,30,17,24,31,18,19,20,25,26,27,32,33,34};
-	EasyConfig.SpecialAreaTypes = {
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::MoraleBoost, 
-		ESlotEffectType::MoraleBoost,  
-		ESlotEffectType::MoraleBoost,  
-		ESlotEffectType::SlowDownEnemy,  
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-	};
-	DifficultyConfigs.Add(EDifficultyLevel::Easy, EasyConfig);
-
-	// Ѷ 2 - е
-	FDifficultyConfig NormalConfig;
-	NormalConfig.AISkillIntervalMin = 12.0f;
-	NormalConfig.AISkillIntervalMax = 20.0f;
-
-	NormalConfig.SpecialAreaIndices = {15,16,22,23,29,30,17,24,31,18,19,25,26,32,33};
-	NormalConfig.SpecialAreaTypes = {
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::MoraleBoost,
-		ESlotEffectType::MoraleBoost,
-		ESlotEffectType::MoraleBoost,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-	};
-	DifficultyConfigs.Add(EDifficultyLevel::Normal, NormalConfig);
-
-	// Ѷ 3 - 
-	FDifficultyConfig HardConfig;
-	HardConfig.AISkillIntervalMin = 10.0f;
-	HardConfig.AISkillIntervalMax = 18.0f;
-
-	HardConfig.SpecialAreaIndices = { 15,22,29,24,19,26,33 };
-	HardConfig.SpecialAreaTypes = {
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::MoraleBoost,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-
-	};
-	DifficultyConfigs.Add(EDifficultyLevel::Hard, HardConfig);
-
-	// Ѷ 4 - ̬
-	FDifficultyConfig InsaneConfig;
-	InsaneConfig.AISkillIntervalMin = 8.0f;
-	InsaneConfig.AISkillIntervalMax = 13.0f;
-
-	InsaneConfig.SpecialAreaIndices = { 15,29,17,31,19,33 };
-	InsaneConfig.SpecialAreaTypes = {
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::SpeedUpSelf,
-		ESlotEffectType::MoraleBoost,
-		ESlotEffectType::SlowDownEnemy,
-		ESlotEffectType::SlowDownEnemy,
-	};
-	DifficultyConfigs.Add(EDifficultyLevel::Insane, InsaneConfig);
-
-	// Ѷ 5 - 
-	FDifficultyConfig HellConfig;
-	HellConfig.AISkillIntervalMin = 5.0f;
-	HellConfig.AISkillIntervalMax = 10.0f;
-	// 0 
-	HellConfig.SpecialAreaIndices = {};
-	HellConfig.SpecialAreaTypes = {};
-	DifficultyConfigs.Add(EDifficultyLevel::Hell, HellConfig);
-
-	UE_LOG(LogTemp, Log, TEXT("InitializeDefaultDifficultyConfigs: Default difficulty configs initialized"));
+void ADragonBoatGameMode::GatherRaceBoats()
+{
+	if (RaceBoats.Num() > 0 || (!PlayerBoat && !AIBoat1 && !AIBoat2))
+		return;
+
+	// 兼容只配置了三个龙舟引用的关卡（保持 0=玩家、1=AI1、2=AI2 的索引，未配置的龙舟不参与进度更新）
+	RaceBoats = { PlayerBoat, AIBoat1, AIBoat2 };
+}
+
+ADatamanagement* ADragonBoatGameMode::FindDatamanagement()
+{
+	if (!CachedDatamanagement.IsValid())
+	{
+		// 双人对战生成的第二块棋盘不是场景中的棋盘
+		for (TActorIterator<ADatamanagement> It(GetWorld()); It; ++It)
+		{
+			if (It->BoardBoatIndex == 0)
+			{
+				CachedDatamanagement = *It;
+				break;
+			}
+		}
+	}
+	return CachedDatamanagement.Get();
+}
+
+// ========================================
+// 双人对战
+// ========================================
+
+void ADragonBoatGameMode::SpawnHeadToHeadBoard(APlayerController* SecondPlayer)
+{
+	ADatamanagement* DataMgmt = FindDatamanagement();
+	UClass* BoardClass = HeadToHeadBoardClass ? HeadToHeadBoardClass.Get() : ADatamanagement::StaticClass();
+	if (!DataMgmt || RaceBoats.Num() < 2)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("SpawnHeadToHeadBoard: Head-to-head needs the level board and at least two boats"));
+		return;
+	}
+
+	// 延迟生成：BeginPlay 之前设置好龙舟索引与拥有者
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = SecondPlayer;
+	SpawnParams.bDeferConstruction = true;
+	ADatamanagement* SecondBoard = GetWorld()->SpawnActor<ADatamanagement>(BoardClass, DataMgmt->GetActorTransform(), SpawnParams);
+	if (!SecondBoard)
+	{
+		UE_LOG(LogDragonBoatRace, Warning, TEXT("SpawnHeadToHeadBoard: Cannot spawn %s"), *GetNameSafe(BoardClass));
+		return;
+	}
+	SecondBoard->BoardBoatIndex = 1;
+	SecondBoard->FinishSpawning(DataMgmt->GetActorTransform());
+	HeadToHeadBoard = SecondBoard;
+
+	// 龙舟1不再由AI模拟
+	DataMgmt->SetAIBoatHumanControlled(0, true);
+
+	// 当前难度的特殊格子
+	if (const FCompiledDifficulty* Config = GetDifficultyTable()->Find(CurrentDifficulty))
+	{
+		SecondBoard->ApplySpecialAreaMasks(Config->GetSpecialAreas());
+	}
+
+	// 比赛中加入时立即接入比赛模拟
+	if (CurrentGameState == ERaceGameState::Racing || CurrentGameState == ERaceGameState::Paused)
+	{
+		SecondBoard->SeedRandomStreams(CurrentRaceSeed);
+		if (bUseRaceSimulation && RaceSimulation && RaceSimulation->IsSimulationRunning())
+		{
+			RaceSimulation->AddPlayerBoard(SecondBoard);
+		}
+	}
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("SpawnHeadToHeadBoard: %s controls board 1"), *SecondPlayer->GetName());
+}
+
+void ADragonBoatGameMode::ReplicateRaceStandings()
+{
+	if (ADragonBoatGameState* RaceGameState = GetGameState<ADragonBoatGameState>())
+	{
+		RaceGameState->SetRaceStandings(BoatRegistry);
+	}
 }
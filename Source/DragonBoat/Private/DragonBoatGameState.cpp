@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DragonBoatGameState.h"
+#include "RaceBoatRegistry.h"
+#include "Net/UnrealNetwork.h"
+
+ADragonBoatGameState::ADragonBoatGameState()
+{
+}
+
+void ADragonBoatGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ADragonBoatGameState, QuantizedProgress);
+	DOREPLIFETIME(ADragonBoatGameState, BoatRanks);
+}
+
+void ADragonBoatGameState::SetRaceStandings(const FRaceBoatRegistry& Registry)
+{
+	// 数组长度不变时原地写入（比赛中不分配）
+	QuantizedProgress.SetNum(Registry.Num());
+	BoatRanks.SetNum(Registry.Num());
+	for (int32 BoatIndex = 0; BoatIndex < Registry.Num(); ++BoatIndex)
+	{
+		QuantizedProgress[BoatIndex] = (uint16)FMath::RoundToInt(FMath::Clamp(Registry.GetProgress(BoatIndex), 0.0f, 1.0f) * MAX_uint16);
+		BoatRanks[BoatIndex] = (uint8)FMath::Min(Registry.GetRank(BoatIndex), (int32)MAX_uint8);
+	}
+}
+
+float ADragonBoatGameState::GetBoatProgress(int32 BoatIndex) const
+{
+	if (QuantizedProgress.IsValidIndex(BoatIndex))
+	{
+		return QuantizedProgress[BoatIndex] / (float)MAX_uint16;
+	}
+	return 0.0f;
+}
+
+int32 ADragonBoatGameState::GetBoatRank(int32 BoatIndex) const
+{
+	if (BoatRanks.IsValidIndex(BoatIndex))
+	{
+		return BoatRanks[BoatIndex];
+	}
+	return 1;
+}
+
+void ADragonBoatGameState::OnRep_RaceStandings()
+{
+	OnRaceStandingsReplicated();
+}
@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BalanceCommandlet.h"
+#include "DragonBoat.h"
+#include "DragonBoatGameMode.h"
+#include "Datamanagement.h"
+#include "DifficultyTable.h"
+#include "Match3AIPlayer.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace Match3Balance
+{
+	// 每个并行任务模拟的局数（足够大以摊薄调度开销，足够小以均衡负载）
+	constexpr int32 GamesPerChunk = 256;
+
+	// 一组模拟（难度 x 策略）
+	struct FSimulation
+	{
+		EDifficultyLevel Difficulty;
+		EAIMatch3Policy Policy;
+		FMatch3SpecialAreas SpecialAreas;
+		float AISkillIntervalMin;
+		float AISkillIntervalMax;
+	};
+
+	// 解析逗号分隔的枚举名列表，为空时返回全部取值
+	template <typename EnumType>
+	TArray<EnumType> ParseEnumList(const FString& List)
+	{
+		const UEnum* Enum = StaticEnum<EnumType>();
+		TArray<EnumType> Values;
+
+		if (List.IsEmpty())
+		{
+			// 最后一项是自动生成的 _MAX
+			for (int32 EnumIndex = 0; EnumIndex < Enum->NumEnums() - 1; ++EnumIndex)
+			{
+				Values.Add((EnumType)Enum->GetValueByIndex(EnumIndex));
+			}
+			return Values;
+		}
+
+		TArray<FString> Names;
+		List.ParseIntoArray(Names, TEXT(","));
+		for (const FString& Name : Names)
+		{
+			const int64 Value = Enum->GetValueByNameString(Name.TrimStartAndEnd());
+			if (Value == INDEX_NONE)
+			{
+				UE_LOG(LogDragonBoatMatch3, Warning, TEXT("Match3Balance: Unknown %s '%s', ignored"), *Enum->GetName(), *Name);
+				continue;
+			}
+			Values.AddUnique((EnumType)Value);
+		}
+		return Values;
+	}
+
+	// 按类路径加载类的默认对象，路径为空或加载失败时使用 C++ 基类的默认对象
+	template <typename ClassType>
+	const ClassType* LoadDefaultObject(const FString& ClassPath)
+	{
+		if (!ClassPath.IsEmpty())
+		{
+			if (UClass* Class = LoadClass<ClassType>(nullptr, *ClassPath))
+			{
+				return Class->GetDefaultObject<ClassType>();
+			}
+			UE_LOG(LogDragonBoatMatch3, Warning, TEXT("Match3Balance: Cannot load class '%s', using %s defaults"),
+				*ClassPath, *ClassType::StaticClass()->GetName());
+		}
+		return GetDefault<ClassType>();
+	}
+
+	double Ratio(int64 Numerator, int64 Denominator)
+	{
+		return Denominator > 0 ? (double)Numerator / (double)Denominator : 0.0;
+	}
+}
+
+UMatch3BalanceCommandlet::UMatch3BalanceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UMatch3BalanceCommandlet::Main(const FString& Params)
+{
+	using namespace Match3Balance;
+
+	LLM_SCOPE_BYTAG(DragonBoat_Match3);
+
+	// ========== 参数 ==========
+
+	int32 NumGames = 1000000;
+	int32 MovesPerGame = 60;
+	float MovesPerMinute = 20.0f;
+	float GreedyChance = 0.5f;
+	int32 BaseSeed = 0;
+	FString PolicyList = TEXT("Greedy,Random");
+	FString DifficultyList;
+	FString GameModePath;
+	FString DifficultyTablePath;
+	FString DatamanagementPath;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Balance") / TEXT("Match3Balance.csv");
+
+	FParse::Value(*Params, TEXT("Games="), NumGames);
+	FParse::Value(*Params, TEXT("Moves="), MovesPerGame);
+	FParse::Value(*Params, TEXT("MovesPerMinute="), MovesPerMinute);
+	FParse::Value(*Params, TEXT("GreedyChance="), GreedyChance);
+	FParse::Value(*Params, TEXT("Seed="), BaseSeed);
+	FParse::Value(*Params, TEXT("Policy="), PolicyList, false);
+	FParse::Value(*Params, TEXT("Difficulty="), DifficultyList, false);
+	FParse::Value(*Params, TEXT("GameMode="), GameModePath);
+	FParse::Value(*Params, TEXT("DifficultyTable="), DifficultyTablePath);
+	FParse::Value(*Params, TEXT("Datamanagement="), DatamanagementPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	const bool bSingleThread = FParse::Param(*Params, TEXT("SingleThread"));
+
+	NumGames = FMath::Max(1, NumGames);
+	MovesPerGame = FMath::Max(1, MovesPerGame);
+
+	// ========== 配置 ==========
+
+	// 难度表：-DifficultyTable 指定的资产 > GameMode 引用的资产 > 内置默认难度
+	const ADragonBoatGameMode* GameModeDefaults = LoadDefaultObject<ADragonBoatGameMode>(GameModePath);
+	const TSoftObjectPtr<UDifficultyTable> TablePath = DifficultyTablePath.IsEmpty()
+		? GameModeDefaults->DifficultyTable : TSoftObjectPtr<UDifficultyTable>(FSoftObjectPath(DifficultyTablePath));
+	const UDifficultyTable* DifficultyTable = TablePath.IsNull() ? nullptr : TablePath.LoadSynchronous();
+	if (!DifficultyTable)
+	{
+		if (!TablePath.IsNull())
+		{
+			UE_LOG(LogDragonBoatMatch3, Warning, TEXT("Match3Balance: Cannot load difficulty table '%s', using built-in difficulties"), *TablePath.ToString());
+		}
+		DifficultyTable = GetDefault<UDifficultyTable>();
+	}
+	const ADatamanagement* DataDefaults = LoadDefaultObject<ADatamanagement>(DatamanagementPath);
+
+	FMatch3AIConfig BaseConfig;
+	BaseConfig.GreedyChance = GreedyChance;
+	BaseConfig.Morale.MaxMorale = DataDefaults->MaxMorale;
+	BaseConfig.Morale.MoralePerTile = DataDefaults->MoralePerTile;
+	BaseConfig.Morale.SpecialMoraleBonus = DataDefaults->SpecialMoraleBonus;
+	BaseConfig.Morale.MaxSkillPoints = DataDefaults->MaxSkillPoints;
+
+	TArray<FSimulation> Simulations;
+	for (EDifficultyLevel Difficulty : ParseEnumList<EDifficultyLevel>(DifficultyList))
+	{
+		const FCompiledDifficulty* DifficultyConfig = DifficultyTable->Find(Difficulty);
+		if (!DifficultyConfig)
+		{
+			UE_LOG(LogDragonBoatMatch3, Warning, TEXT("Match3Balance: No config for difficulty %d, skipped"), (int32)Difficulty);
+			continue;
+		}
+
+		for (EAIMatch3Policy Policy : ParseEnumList<EAIMatch3Policy>(PolicyList))
+		{
+			FSimulation& Simulation = Simulations.AddDefaulted_GetRef();
+			Simulation.Difficulty = Difficulty;
+			Simulation.Policy = Policy;
+			Simulation.AISkillIntervalMin = DifficultyConfig->AISkillIntervalMin;
+			Simulation.AISkillIntervalMax = DifficultyConfig->AISkillIntervalMax;
+			Simulation.SpecialAreas = DifficultyConfig->GetSpecialAreas();
+		}
+	}
+
+	if (Simulations.Num() == 0)
+	{
+		UE_LOG(LogDragonBoatMatch3, Error, TEXT("Match3Balance: Nothing to simulate"));
+		return 1;
+	}
+
+	UE_LOG(LogDragonBoatMatch3, Display, TEXT("Match3Balance: %d simulations x %d games x %d moves, %s"),
+		Simulations.Num(), NumGames, MovesPerGame,
+		bSingleThread ? TEXT("single thread") : *FString::Printf(TEXT("%d worker threads"), FTaskGraphInterface::Get().GetNumWorkerThreads()));
+
+	// ========== 模拟 ==========
+
+	const UEnum* DifficultyEnum = StaticEnum<EDifficultyLevel>();
+	const UEnum* PolicyEnum = StaticEnum<EAIMatch3Policy>();
+	const UEnum* EffectEnum = StaticEnum<ESlotEffectType>();
+
+	FString Csv = TEXT("Difficulty,Policy,Games,Moves,MoralePerMove,SkillPointsPerMove,SkillPointsPerMinute,AIIntervalCastsPerMinute,ClearedPerMove");
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		Csv += FString::Printf(TEXT(",%sPerMove"), *EffectEnum->GetNameStringByValue(Type));
+	}
+	Csv += TEXT(",ReshuffleRate");
+	for (int32 Depth = 1; Depth <= FMatch3AIBatchResult::MaxCascadeDepth; ++Depth)
+	{
+		Csv += FString::Printf(TEXT(",Depth%d"), Depth);
+		if (Depth == FMatch3AIBatchResult::MaxCascadeDepth)
+		{
+			Csv += TEXT("+");
+		}
+	}
+	Csv += TEXT(",Seconds,GamesPerSecond\n");
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumGames, GamesPerChunk);
+	TArray<FMatch3AIBatchResult> ChunkResults;
+	ChunkResults.SetNum(NumChunks);
+
+	for (const FSimulation& Simulation : Simulations)
+	{
+		FMatch3AIConfig Config = BaseConfig;
+		Config.Policy = (EMatch3AIPolicy)Simulation.Policy;
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+
+		// 每个任务只写自己的结果槽，任务之间没有共享的可变状态
+		ParallelFor(NumChunks, [&](int32 Chunk)
+		{
+			TUniquePtr<FMatch3AIPlayer> Player = MakeUnique<FMatch3AIPlayer>();
+			FMatch3AIBatchResult ChunkResult;
+
+			const int32 FirstGame = Chunk * GamesPerChunk;
+			const int32 LastGame = FMath::Min(FirstGame + GamesPerChunk, NumGames);
+			for (int32 Game = FirstGame; Game < LastGame; ++Game)
+			{
+				// 种子只取决于难度与局号：不同策略在相同的初始棋盘上比较
+				const uint32 Seed = HashCombine(HashCombine((uint32)BaseSeed, (uint32)Simulation.Difficulty + 1), (uint32)Game);
+				Player->Initialize((int32)Seed, Simulation.SpecialAreas);
+				ChunkResult.Accumulate(Player->PlayMoves(MovesPerGame, Config));
+			}
+			ChunkResults[Chunk] = ChunkResult;
+		}, bSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::Unbalanced);
+
+		const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		FMatch3AIBatchResult Total;
+		for (const FMatch3AIBatchResult& ChunkResult : ChunkResults)
+		{
+			Total.Accumulate(ChunkResult);
+		}
+
+		const FString DifficultyName = DifficultyEnum->GetNameStringByValue((int64)Simulation.Difficulty);
+		const FString PolicyName = PolicyEnum->GetNameStringByValue((int64)Simulation.Policy);
+		const double SkillPointsPerMove = Ratio(Total.SkillPointsGained, Total.MovesPlayed);
+		const double MeanInterval = 0.5 * (Simulation.AISkillIntervalMin + Simulation.AISkillIntervalMax);
+
+		Csv += FString::Printf(TEXT("%s,%s,%d,%lld,%.4f,%.5f,%.4f,%.4f,%.4f"),
+			*DifficultyName, *PolicyName, NumGames, Total.MovesPlayed,
+			Ratio(Total.MoraleEarned, Total.MovesPlayed),
+			SkillPointsPerMove,
+			SkillPointsPerMove * MovesPerMinute,
+			MeanInterval > 0.0 ? 60.0 / MeanInterval : 0.0,
+			Ratio(Total.ClearedTiles, Total.MovesPlayed));
+		for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			Csv += FString::Printf(TEXT(",%.5f"), Ratio(Total.EffectHits[Type], Total.MovesPlayed));
+		}
+		Csv += FString::Printf(TEXT(",%.6f"), Ratio(Total.Reshuffles, Total.MovesPlayed));
+		for (int32 Depth = 1; Depth <= FMatch3AIBatchResult::MaxCascadeDepth; ++Depth)
+		{
+			Csv += FString::Printf(TEXT(",%.6f"), Ratio(Total.CascadeDepths[Depth], Total.MovesPlayed));
+		}
+		Csv += FString::Printf(TEXT(",%.2f,%.0f\n"), Seconds, Seconds > 0.0 ? NumGames / Seconds : 0.0);
+
+		UE_LOG(LogDragonBoatMatch3, Display, TEXT("  %-8s %-8s morale/move %.2f, skill points/min %.2f, reshuffle rate %.4f%%, %.1f s"),
+			*DifficultyName, *PolicyName, Ratio(Total.MoraleEarned, Total.MovesPlayed),
+			SkillPointsPerMove * MovesPerMinute, 100.0 * Ratio(Total.Reshuffles, Total.MovesPlayed), Seconds);
+	}
+
+	// ========== 输出 ==========
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogDragonBoatMatch3, Error, TEXT("Match3Balance: Failed to write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogDragonBoatMatch3, Display, TEXT("Match3Balance: Results written to %s"), *FPaths::ConvertRelativePathToFull(OutputPath));
+	return 0;
+}
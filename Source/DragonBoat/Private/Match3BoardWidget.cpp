@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BoardWidget.h"
+#include "SMatch3Board.h"
+#include "Datamanagement.h"
+#include "EngineUtils.h"
+
+#define LOCTEXT_NAMESPACE "DragonBoat"
+
+UMatch3BoardWidget::UMatch3BoardWidget()
+{
+	const FMatch3BoardStyle DefaultStyle;
+	DesiredCellSize = DefaultStyle.DesiredCellSize;
+	TilePadding = DefaultStyle.TilePadding;
+	SwapDuration = DefaultStyle.SwapDuration;
+	ClearDuration = DefaultStyle.ClearDuration;
+	FallSecondsPerRow = DefaultStyle.FallSecondsPerRow;
+	ReshuffleDuration = DefaultStyle.ReshuffleDuration;
+	bDriveGameState = true;
+	bAcceptInput = true;
+	bBindLocalBoard = true;
+}
+
+void UMatch3BoardWidget::SetBoard(ADatamanagement* InBoard)
+{
+	Board = InBoard;
+	if (MyBoard.IsValid())
+	{
+		MyBoard->SetBoard(InBoard);
+	}
+}
+
+bool UMatch3BoardWidget::IsAnimating() const
+{
+	return MyBoard.IsValid() && MyBoard->IsAnimating();
+}
+
+TSharedRef<SWidget> UMatch3BoardWidget::RebuildWidget()
+{
+	MyBoard = SNew(SMatch3Board)
+		.bDriveGameState(bDriveGameState)
+		.bAcceptInput(bAcceptInput);
+	return MyBoard.ToSharedRef();
+}
+
+void UMatch3BoardWidget::SynchronizeProperties()
+{
+	Super::SynchronizeProperties();
+
+	if (!MyBoard.IsValid())
+	{
+		return;
+	}
+
+	// 画刷按 ETileColor / ESlotEffectType 的顺序排列
+	FMatch3BoardStyle Style;
+	Style.CellBrush = CellBrush;
+	Style.TileBrushes[(int32)ETileColor::Red] = RedTileBrush;
+	Style.TileBrushes[(int32)ETileColor::Blue] = BlueTileBrush;
+	Style.TileBrushes[(int32)ETileColor::Green] = GreenTileBrush;
+	Style.TileBrushes[(int32)ETileColor::Yellow] = YellowTileBrush;
+	Style.SpecialAreaBrushes[(int32)ESlotEffectType::SpeedUpSelf] = SpeedUpAreaBrush;
+	Style.SpecialAreaBrushes[(int32)ESlotEffectType::SlowDownEnemy] = SlowDownAreaBrush;
+	Style.SpecialAreaBrushes[(int32)ESlotEffectType::MoraleBoost] = MoraleBoostAreaBrush;
+	Style.LockedBrush = LockedBrush;
+	Style.SelectedBrush = SelectedBrush;
+	Style.DesiredCellSize = DesiredCellSize;
+	Style.TilePadding = TilePadding;
+	Style.SwapDuration = SwapDuration;
+	Style.ClearDuration = ClearDuration;
+	Style.FallSecondsPerRow = FallSecondsPerRow;
+	Style.ReshuffleDuration = ReshuffleDuration;
+
+	MyBoard->SetStyle(Style);
+	MyBoard->SetDriveGameState(bDriveGameState);
+	MyBoard->SetAcceptInput(bAcceptInput);
+
+	if (!Board.IsValid() && bBindLocalBoard && !IsDesignTime())
+	{
+		Board = FindLocalBoard();
+	}
+	MyBoard->SetBoard(Board.Get());
+}
+
+ADatamanagement* UMatch3BoardWidget::FindLocalBoard() const
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	for (TActorIterator<ADatamanagement> It(World); It; ++It)
+	{
+		if (It->IsControlledLocally())
+		{
+			return *It;
+		}
+	}
+	return nullptr;
+}
+
+void UMatch3BoardWidget::ReleaseSlateResources(bool bReleaseChildren)
+{
+	Super::ReleaseSlateResources(bReleaseChildren);
+
+	MyBoard.Reset();
+}
+
+#if WITH_EDITOR
+const FText UMatch3BoardWidget::GetPaletteCategory()
+{
+	return LOCTEXT("DragonBoatPalette", "Dragon Boat");
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
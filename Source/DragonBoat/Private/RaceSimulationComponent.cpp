@@ -0,0 +1,435 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceSimulationComponent.h"
+#include "DragonBoat.h"
+#include "RaceSnapshot.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Race SimulationTick"), STAT_Race_SimulationTick, STATGROUP_DragonBoat);
+
+static_assert((int32)ERaceStatusEffect::EmptyCity + 1 == (int32)ERaceStatus::Count, "ERaceStatusEffect must mirror ERaceStatus");
+
+// Insights 计数器：累计的模拟步数
+TRACE_DECLARE_INT_COUNTER(Race_SimulationSteps, TEXT("DragonBoat/Race/SimulationSteps"));
+
+URaceSimulationComponent::URaceSimulationComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	StepsPerSecond = 60.0f;
+	BaseBoatSpeed = 150.0f;
+	TriggerEffectDuration = 3.0f;
+	bDriveBoatActors = true;
+
+	TrackStart = FVector::ZeroVector;
+	TrackDirection = FVector::ForwardVector;
+	bRunning = false;
+	bPaused = false;
+}
+
+void URaceSimulationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	BindToDatamanagement(nullptr);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// ========================================
+// 控制
+// ========================================
+
+void URaceSimulationComponent::StartSimulation(const TArray<AActor*>& Boats, FVector StartLine, FVector FinishLine)
+{
+	LLM_SCOPE_BYTAG(DragonBoat_Race);
+
+	const FVector Track = FinishLine - StartLine;
+	TrackStart = StartLine;
+	TrackDirection = Track.GetSafeNormal(UE_SMALL_NUMBER, FVector::ForwardVector);
+
+	// 上一场比赛结束时仍在生效的效果先通知结束（例如解除铁索连环的锁定）
+	for (int32 BoatIndex = 0; BoatIndex < NotifiedStatusMasks.Num(); ++BoatIndex)
+	{
+		BroadcastStatusChanges(BoatIndex, NotifiedStatusMasks[BoatIndex], 0);
+	}
+
+	FRaceSimConfig Config;
+	Config.FixedStepSeconds = 1.0f / FMath::Max(StepsPerSecond, 10.0f);
+	Config.TrackLength = FMath::Max((float)Track.Size(), 1.0f);
+	Simulation.Reset(Config, Boats.Num());
+
+	BoatActors.Reset(Boats.Num());
+	LaneOffsets.Reset(Boats.Num());
+	NotifiedStatusMasks.Reset(Boats.Num());
+	NotifiedStatusMasks.AddZeroed(Boats.Num());
+	for (int32 BoatIndex = 0; BoatIndex < Boats.Num(); ++BoatIndex)
+	{
+		const float SpeedScale = BoatSpeedScales.IsValidIndex(BoatIndex) ? BoatSpeedScales[BoatIndex] : 1.0f;
+		Simulation.SetBaseSpeed(BoatIndex, BaseBoatSpeed * SpeedScale);
+
+		// 横向偏移 = Actor 位置去掉沿赛道方向的分量
+		AActor* Boat = Boats[BoatIndex];
+		const FVector Offset = Boat ? Boat->GetActorLocation() - StartLine : FVector::ZeroVector;
+		BoatActors.Add(Boat);
+		LaneOffsets.Add(Offset - TrackDirection * FVector::DotProduct(Offset, TrackDirection));
+	}
+
+	bRunning = true;
+	bPaused = false;
+	SetComponentTickEnabled(true);
+	UpdateBoatActors();
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("StartSimulation: %d boats, track %.0f, %.0f steps/s, base speed %.1f"),
+		Boats.Num(), Config.TrackLength, StepsPerSecond, BaseBoatSpeed);
+}
+
+void URaceSimulationComponent::SetSimulationPaused(bool bShouldPause)
+{
+	bPaused = bShouldPause;
+	SetComponentTickEnabled(bRunning && !bPaused);
+}
+
+void URaceSimulationComponent::StopSimulation()
+{
+	bRunning = false;
+	SetComponentTickEnabled(false);
+}
+
+void URaceSimulationComponent::BindToDatamanagement(ADatamanagement* DataMgmt)
+{
+	if (ADatamanagement* Previous = BoundDatamanagement.Get())
+	{
+		Previous->OnStepResolvedNative.Remove(StepResolvedHandle);
+		Previous->OnSkillCastedNative.Remove(SkillCastedHandle);
+		Previous->OnAISkillCastedNative.Remove(AISkillCastedHandle);
+		Previous->OnAIMatch3BatchNative.Remove(AIMatch3BatchHandle);
+		Previous->SetRaceSimulation(nullptr);
+	}
+	for (const FPlayerBoardBinding& Binding : PlayerBoards)
+	{
+		if (ADatamanagement* Board = Binding.Board.Get())
+		{
+			Board->OnStepResolvedNative.Remove(Binding.StepResolvedHandle);
+			Board->OnSkillCastedNative.Remove(Binding.SkillCastedHandle);
+			Board->SetRaceSimulation(nullptr);
+		}
+	}
+	PlayerBoards.Reset();
+	BoundDatamanagement = DataMgmt;
+
+	if (DataMgmt)
+	{
+		StepResolvedHandle = DataMgmt->OnStepResolvedNative.AddUObject(this, &URaceSimulationComponent::HandleStepResolved, DataMgmt->BoardBoatIndex);
+		SkillCastedHandle = DataMgmt->OnSkillCastedNative.AddUObject(this, &URaceSimulationComponent::HandleSkillCasted, DataMgmt->BoardBoatIndex);
+		AISkillCastedHandle = DataMgmt->OnAISkillCastedNative.AddUObject(this, &URaceSimulationComponent::HandleAISkillCasted);
+		AIMatch3BatchHandle = DataMgmt->OnAIMatch3BatchNative.AddUObject(this, &URaceSimulationComponent::HandleAIMatch3Batch);
+		DataMgmt->SetRaceSimulation(this);
+	}
+}
+
+void URaceSimulationComponent::AddPlayerBoard(ADatamanagement* Board)
+{
+	if (!Board || Board == BoundDatamanagement.Get())
+	{
+		return;
+	}
+
+	FPlayerBoardBinding& Binding = PlayerBoards.AddDefaulted_GetRef();
+	Binding.Board = Board;
+	Binding.StepResolvedHandle = Board->OnStepResolvedNative.AddUObject(this, &URaceSimulationComponent::HandleStepResolved, Board->BoardBoatIndex);
+	Binding.SkillCastedHandle = Board->OnSkillCastedNative.AddUObject(this, &URaceSimulationComponent::HandleSkillCasted, Board->BoardBoatIndex);
+	Board->SetRaceSimulation(this);
+}
+
+// ========================================
+// 输入
+// ========================================
+
+bool URaceSimulationComponent::ApplyStatusEffect(int32 BoatIndex, ERaceStatusEffect Status, float Magnitude, float Duration, int32 SourceIndex)
+{
+	if (!bRunning || !IsValidBoat(BoatIndex))
+	{
+		return false;
+	}
+
+	// 所有状态效果都经过这里：录像按模拟步记录，回放在同一步施加
+	const bool bApplied = Simulation.ApplyStatus(BoatIndex, (ERaceStatus)Status, Magnitude, Duration, SourceIndex);
+	if (ADatamanagement* DataMgmt = BoundDatamanagement.Get())
+	{
+		if (FRaceReplayWriter* Recorder = DataMgmt->GetReplayRecorder())
+		{
+			Recorder->RecordStatus(GetWorld()->GetTimeSeconds(), Simulation.GetStepCount(), BoatIndex, (int32)Status, Magnitude, Duration, SourceIndex, bApplied);
+		}
+	}
+
+	if (!bApplied)
+	{
+		if (Simulation.GetStatusEffects().IsImmune(BoatIndex))
+		{
+			UE_LOG(LogDragonBoatRace, Log, TEXT("ApplyStatusEffect: boat %d is immune (Empty City), status %d from boat %d blocked"),
+				BoatIndex, (int32)Status, SourceIndex);
+		}
+		return false;
+	}
+
+	NotifyStatusChanges();
+	return true;
+}
+
+void URaceSimulationComponent::ApplySkill(int32 CasterIndex, ESkillType SkillType, const FSkillConfig& Config, int32 TargetIndex)
+{
+	ERaceStatusEffect Status;
+	switch (SkillType)
+	{
+	case ESkillType::EastWind:		Status = ERaceStatusEffect::EastWind; break;		// 自己加速 EffectValue
+	case ESkillType::FloodSeven:	Status = ERaceStatusEffect::FloodSeven; break;		// 目标停船
+	case ESkillType::HeavyFog:		Status = ERaceStatusEffect::HeavyFog; break;		// 目标棋盘被遮挡
+	case ESkillType::IronChain:		Status = ERaceStatusEffect::IronChain; break;		// 目标棋盘格子被锁定
+	case ESkillType::EmptyCity:		Status = ERaceStatusEffect::EmptyCity; break;		// 自己免疫敌方减益
+	default:
+		return;
+	}
+
+	if (!FRaceStatusEffects::IsDebuff((ERaceStatus)Status))
+	{
+		ApplyStatusEffect(CasterIndex, Status, Config.EffectValue, Config.Duration, CasterIndex);
+	}
+	else if (TargetIndex != INDEX_NONE)
+	{
+		ApplyStatusEffect(TargetIndex, Status, Config.EffectValue, Config.Duration, CasterIndex);
+	}
+	else
+	{
+		ForEachEnemy(CasterIndex, [this, Status, &Config, CasterIndex](int32 BoatIndex)
+		{
+			ApplyStatusEffect(BoatIndex, Status, Config.EffectValue, Config.Duration, CasterIndex);
+		});
+	}
+}
+
+void URaceSimulationComponent::NotifyStatusChanges()
+{
+	const FRaceStatusEffects& Statuses = Simulation.GetStatusEffects();
+	for (int32 BoatIndex = 0; BoatIndex < NotifiedStatusMasks.Num(); ++BoatIndex)
+	{
+		const uint32 ActiveMask = Statuses.GetActiveMask(BoatIndex);
+		if (ActiveMask != NotifiedStatusMasks[BoatIndex])
+		{
+			const uint32 OldMask = NotifiedStatusMasks[BoatIndex];
+			NotifiedStatusMasks[BoatIndex] = ActiveMask;
+			BroadcastStatusChanges(BoatIndex, OldMask, ActiveMask);
+		}
+	}
+}
+
+void URaceSimulationComponent::BroadcastStatusChanges(int32 BoatIndex, uint32 OldMask, uint32 NewMask)
+{
+	uint32 ChangedMask = OldMask ^ NewMask;
+	while (ChangedMask != 0)
+	{
+		const int32 Status = FMath::CountTrailingZeros(ChangedMask);
+		ChangedMask &= ChangedMask - 1;
+		OnStatusChangedNative.Broadcast(BoatIndex, (ERaceStatusEffect)Status, (NewMask & (1u << Status)) != 0);
+	}
+}
+
+void URaceSimulationComponent::HandleStepResolved(const FMatch3StepResult& Step, int32 BoatIndex)
+{
+	// 加速/减速数值以主数据管理器为准（所有棋盘规则相同）
+	const ADatamanagement* DataMgmt = BoundDatamanagement.Get();
+	if (!DataMgmt)
+	{
+		return;
+	}
+
+	if (Step.SpeedUpTriggers > 0)
+	{
+		ApplyStatusEffect(BoatIndex, ERaceStatusEffect::SpeedBoost, Step.SpeedUpTriggers * DataMgmt->SpeedBoostPerTrigger, TriggerEffectDuration);
+	}
+	if (Step.SlowDownTriggers > 0)
+	{
+		const float SpeedDelta = -Step.SlowDownTriggers * DataMgmt->SlowDownPerTrigger;
+		ForEachEnemy(BoatIndex, [this, SpeedDelta, BoatIndex](int32 EnemyIndex)
+		{
+			ApplyStatusEffect(EnemyIndex, ERaceStatusEffect::SlowDown, SpeedDelta, TriggerEffectDuration, BoatIndex);
+		});
+	}
+}
+
+void URaceSimulationComponent::HandleSkillCasted(ESkillType SkillType, const FSkillConfig& Config, int32 BoatIndex)
+{
+	ApplySkill(BoatIndex, SkillType, Config, INDEX_NONE);
+}
+
+void URaceSimulationComponent::HandleAISkillCasted(int32 CasterAI, ESkillType SkillType, ESkillTargetType TargetType,
+	int32 TargetAI, bool bTargetIsPlayer, const FSkillConfig& Config)
+{
+	const int32 CasterIndex = CasterAI + 1;
+	const int32 TargetIndex = TargetType == ESkillTargetType::Self ? CasterIndex : (bTargetIsPlayer ? 0 : TargetAI + 1);
+	ApplySkill(CasterIndex, SkillType, Config, TargetIndex);
+}
+
+void URaceSimulationComponent::HandleAIMatch3Batch(int32 AI, const FMatch3AIBatchResult& Batch)
+{
+	const ADatamanagement* DataMgmt = BoundDatamanagement.Get();
+	if (!DataMgmt)
+	{
+		return;
+	}
+
+	// AI 棋盘上的加速/减速格子与玩家规则相同
+	const int32 CasterIndex = AI + 1;
+	const int64 SpeedUpHits = Batch.EffectHits[(int32)EMatch3Effect::SpeedUpSelf];
+	const int64 SlowDownHits = Batch.EffectHits[(int32)EMatch3Effect::SlowDownEnemy];
+	if (SpeedUpHits > 0)
+	{
+		ApplyStatusEffect(CasterIndex, ERaceStatusEffect::SpeedBoost, SpeedUpHits * DataMgmt->SpeedBoostPerTrigger, TriggerEffectDuration);
+	}
+	if (SlowDownHits > 0)
+	{
+		const float SpeedDelta = -SlowDownHits * DataMgmt->SlowDownPerTrigger;
+		ForEachEnemy(CasterIndex, [this, SpeedDelta, CasterIndex](int32 BoatIndex)
+		{
+			ApplyStatusEffect(BoatIndex, ERaceStatusEffect::SlowDown, SpeedDelta, TriggerEffectDuration, CasterIndex);
+		});
+	}
+}
+
+// ========================================
+// 推进
+// ========================================
+
+void URaceSimulationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!bRunning || bPaused)
+	{
+		return;
+	}
+
+	DRAGONBOAT_RACE_SCOPE(STAT_Race_SimulationTick);
+
+	const int32 NumSteps = Simulation.Advance(DeltaTime);
+	TRACE_COUNTER_ADD(Race_SimulationSteps, NumSteps);
+
+	if (NumSteps > 0)
+	{
+		NotifyStatusChanges();
+	}
+	UpdateBoatActors();
+}
+
+void URaceSimulationComponent::UpdateBoatActors()
+{
+	if (!bDriveBoatActors)
+	{
+		return;
+	}
+
+	for (int32 BoatIndex = 0; BoatIndex < BoatActors.Num(); ++BoatIndex)
+	{
+		if (AActor* Boat = BoatActors[BoatIndex])
+		{
+			const FVector Location = TrackStart + TrackDirection * Simulation.GetInterpolatedDistance(BoatIndex) + LaneOffsets[BoatIndex];
+			Boat->SetActorLocation(Location);
+		}
+	}
+}
+
+// ========================================
+// 快照
+// ========================================
+
+void URaceSimulationComponent::WriteSnapshot(FRaceSnapshotWriter& Writer) const
+{
+	Simulation.WriteSnapshot(Writer);
+	for (uint32 Mask : NotifiedStatusMasks)
+	{
+		Writer.WriteBits(Mask, (int32)ERaceStatus::Count);
+	}
+}
+
+void URaceSimulationComponent::ReadSnapshot(FRaceSnapshotReader& Reader, int32 NumBoats)
+{
+	PendingSimulation.ReadSnapshot(Reader);
+	if (PendingSimulation.Num() != NumBoats)
+	{
+		Reader.SetError();
+		return;
+	}
+	PendingStatusMasks.SetNumUninitialized(NumBoats);
+	for (uint32& Mask : PendingStatusMasks)
+	{
+		Mask = (uint32)Reader.ReadBits((int32)ERaceStatus::Count);
+	}
+}
+
+void URaceSimulationComponent::ApplySnapshot(const TArray<AActor*>& Boats, FVector StartLine, FVector FinishLine)
+{
+	// 先结束上一场仍在生效的效果并重新计算横向偏移，再覆盖配置、龙舟数据与状态效果
+	StartSimulation(Boats, StartLine, FinishLine);
+	Simulation = PendingSimulation;
+	NotifiedStatusMasks = PendingStatusMasks;
+
+	SetSimulationPaused(true);
+	UpdateBoatActors();
+
+	UE_LOG(LogDragonBoatRace, Log, TEXT("ApplySnapshot: %d boats at %.2f s"), Simulation.Num(), Simulation.GetSimTime());
+}
+
+// ========================================
+// 查询
+// ========================================
+
+float URaceSimulationComponent::GetBoatProgress(int32 BoatIndex) const
+{
+	return IsValidBoat(BoatIndex) ? Simulation.GetProgress(BoatIndex) : 0.0f;
+}
+
+float URaceSimulationComponent::GetBoatSpeed(int32 BoatIndex) const
+{
+	return IsValidBoat(BoatIndex) ? Simulation.GetSpeed(BoatIndex) : 0.0f;
+}
+
+float URaceSimulationComponent::GetBoatFinishTime(int32 BoatIndex) const
+{
+	return IsValidBoat(BoatIndex) ? Simulation.GetFinishTime(BoatIndex) : -1.0f;
+}
+
+bool URaceSimulationComponent::HasBoatStatus(int32 BoatIndex, ERaceStatusEffect Status) const
+{
+	return IsValidBoat(BoatIndex) && Simulation.GetStatusEffects().Has(BoatIndex, (ERaceStatus)Status);
+}
+
+float URaceSimulationComponent::GetBoatStatusRemaining(int32 BoatIndex, ERaceStatusEffect Status) const
+{
+	if (!HasBoatStatus(BoatIndex, Status))
+	{
+		return 0.0f;
+	}
+	const int64 RemainingSteps = Simulation.GetStatusEffects().GetExpireStep(BoatIndex, (ERaceStatus)Status) - Simulation.GetStepCount();
+	return RemainingSteps * Simulation.GetConfig().FixedStepSeconds;
+}
+
+// ========================================
+// 调试
+// ========================================
+
+void URaceSimulationComponent::Debug_FastForwardRace(float MaxSeconds)
+{
+	FRaceSimulation Copy = Simulation;
+	const float StartTime = Copy.GetSimTime();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	const int32 NumSteps = Copy.RunToFinish(MaxSeconds);
+	const double WallSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	const float SimulatedSeconds = Copy.GetSimTime() - StartTime;
+	UE_LOG(LogDragonBoatRace, Log, TEXT("Debug_FastForwardRace: %d steps, %.2f s simulated in %.3f ms (%.0fx real time)"),
+		NumSteps, SimulatedSeconds, WallSeconds * 1000.0, SimulatedSeconds / FMath::Max(WallSeconds, 1e-9));
+	for (int32 BoatIndex = 0; BoatIndex < Copy.Num(); ++BoatIndex)
+	{
+		UE_LOG(LogDragonBoatRace, Log, TEXT("  Boat %d: finish time %.3f"), BoatIndex, Copy.GetFinishTime(BoatIndex));
+	}
+}
@@ -0,0 +1,607 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SMatch3Board.h"
+#include "DragonBoat.h"
+#include "Rendering/DrawElements.h"
+
+DECLARE_CYCLE_STAT(TEXT("Match3 BoardPaint"), STAT_Match3_BoardPaint, STATGROUP_DragonBoat);
+
+SMatch3Board::SMatch3Board()
+	: bDriveGameState(true)
+	, bAcceptInput(true)
+	, AnimHead(0)
+	, AnimElapsed(0.0f)
+	, bAnimStarted(false)
+	, bTimerActive(false)
+	, PressedCell(INDEX_NONE)
+	, bDeselectOnRelease(false)
+{
+	SetCanTick(false);
+	FMemory::Memset(DisplayColors, FMatch3Board::EmptyColor, sizeof(DisplayColors));
+	for (float& FromRow : FallFromRows)
+	{
+		FromRow = FallNone;
+	}
+}
+
+SMatch3Board::~SMatch3Board()
+{
+	UnbindBoard();
+}
+
+void SMatch3Board::Construct(const FArguments& InArgs)
+{
+	bDriveGameState = InArgs._bDriveGameState;
+	bAcceptInput = InArgs._bAcceptInput;
+
+	// 新方块从棋盘上方落入，超出控件的部分裁掉
+	SetClipping(EWidgetClipping::ClipToBounds);
+}
+
+void SMatch3Board::SetBoard(ADatamanagement* InBoard)
+{
+	if (Board.Get() == InBoard)
+	{
+		return;
+	}
+
+	UnbindBoard();
+	Board = InBoard;
+	if (InBoard)
+	{
+		SwapAnimHandle = InBoard->OnSwapAnimNative.AddSP(this, &SMatch3Board::HandleSwapAnim);
+		ClearAnimHandle = InBoard->OnClearAnimNative.AddSP(this, &SMatch3Board::HandleClearAnim);
+		FallAnimHandle = InBoard->OnFallAnimNative.AddSP(this, &SMatch3Board::HandleFallAnim);
+		CascadeResolvedHandle = InBoard->OnCascadeResolvedNative.AddSP(this, &SMatch3Board::HandleCascadeResolved);
+		BoardRebuiltHandle = InBoard->OnBoardRebuiltNative.AddSP(this, &SMatch3Board::HandleBoardRebuilt);
+		CellStateChangedHandle = InBoard->OnCellStateChangedNative.AddSP(this, &SMatch3Board::HandleCellStateChanged);
+	}
+	SnapToBoard();
+}
+
+void SMatch3Board::SetStyle(const FMatch3BoardStyle& InStyle)
+{
+	Style = InStyle;
+	Invalidate(EInvalidateWidgetReason::Layout);
+}
+
+void SMatch3Board::UnbindBoard()
+{
+	if (ADatamanagement* OldBoard = Board.Get())
+	{
+		OldBoard->OnSwapAnimNative.Remove(SwapAnimHandle);
+		OldBoard->OnClearAnimNative.Remove(ClearAnimHandle);
+		OldBoard->OnFallAnimNative.Remove(FallAnimHandle);
+		OldBoard->OnCascadeResolvedNative.Remove(CascadeResolvedHandle);
+		OldBoard->OnBoardRebuiltNative.Remove(BoardRebuiltHandle);
+		OldBoard->OnCellStateChangedNative.Remove(CellStateChangedHandle);
+	}
+	Board.Reset();
+}
+
+// ========================================
+// 棋盘事件
+// ========================================
+
+void SMatch3Board::HandleSwapAnim(int32 IndexA, int32 IndexB, bool bIsSuccessful)
+{
+	AddSwapAnim(IndexA, IndexB, bIsSuccessful);
+	AddAdvance();
+}
+
+void SMatch3Board::HandleClearAnim(const FMatch3StepResult& Step)
+{
+	AddClearAnim(Step.ClearedMask);
+	AddAdvance();
+}
+
+void SMatch3Board::HandleFallAnim(const TArray<FFallMove>& FallMoves)
+{
+	AddFallAnim(FallMoves);
+	AddAdvance();
+}
+
+void SMatch3Board::HandleCascadeResolved(const FCascadeTimeline& Timeline)
+{
+	// 整条时间线连续播放，全部播放完后推进一次
+	AddSwapAnim(Timeline.SwapIndexA, Timeline.SwapIndexB, true);
+	for (const FCascadeStep& Step : Timeline.Steps)
+	{
+		uint64 ClearedMask = 0;
+		for (int32 Index : Step.ClearedIndices)
+		{
+			ClearedMask |= FMatch3Board::CellBit(Index);
+		}
+		AddClearAnim(ClearedMask);
+		AddFallAnim(Step.FallMoves);
+	}
+	if (Timeline.bReshuffled)
+	{
+		AddReshuffleAnim();
+	}
+	AddAdvance();
+}
+
+void SMatch3Board::HandleBoardRebuilt(bool bReshuffled)
+{
+	// 初始化、快照恢复与重新同步：不播放动画，直接显示
+	if (!bReshuffled)
+	{
+		SnapToBoard();
+		return;
+	}
+
+	// 一次性结算中的洗牌在时间线末尾播放（OnCascadeResolvedNative 随后派发）
+	const ADatamanagement* CurrentBoard = Board.Get();
+	if (CurrentBoard && CurrentBoard->GameState != EMatch3State::PlayingTimeline)
+	{
+		AddReshuffleAnim();
+	}
+}
+
+void SMatch3Board::HandleCellStateChanged()
+{
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+// ========================================
+// 动画队列
+// ========================================
+
+SMatch3Board::FBoardAnim& SMatch3Board::AddAnim(EAnimType Type, float Duration)
+{
+	FBoardAnim& Anim = Anims.AddZeroed_GetRef();
+	Anim.Type = Type;
+	Anim.Duration = FMath::Max(Duration, 0.0f);
+
+	if (!bTimerActive)
+	{
+		bTimerActive = true;
+		RegisterActiveTimer(0.0f, FWidgetActiveTimerDelegate::CreateSP(this, &SMatch3Board::UpdateAnimations));
+	}
+	return Anim;
+}
+
+void SMatch3Board::AddSwapAnim(int32 IndexA, int32 IndexB, bool bIsSuccessful)
+{
+	if (IndexA < 0 || IndexA >= FMatch3Board::NumCells || IndexB < 0 || IndexB >= FMatch3Board::NumCells)
+	{
+		return;
+	}
+
+	FBoardAnim& Anim = AddAnim(EAnimType::Swap, Style.SwapDuration);
+	Anim.IndexA = IndexA;
+	Anim.IndexB = IndexB;
+	Anim.bSuccessful = bIsSuccessful;
+}
+
+void SMatch3Board::AddClearAnim(uint64 ClearedMask)
+{
+	FBoardAnim& Anim = AddAnim(EAnimType::Clear, Style.ClearDuration);
+	Anim.Mask = ClearedMask;
+}
+
+void SMatch3Board::AddFallAnim(const TArray<FFallMove>& FallMoves)
+{
+	// 时长按落得最远的方块计算（新方块的起点为棋盘上方的负数行）
+	int32 MaxDrop = 0;
+	for (const FFallMove& Move : FallMoves)
+	{
+		const int32 FromRow = Move.bIsNewTile ? Move.FromIndex : Move.FromIndex / FMatch3Board::Cols;
+		MaxDrop = FMath::Max(MaxDrop, Move.ToIndex / FMatch3Board::Cols - FromRow);
+	}
+
+	const int32 FirstMove = FallMoveBuffer.Num();
+	FallMoveBuffer.Append(FallMoves);
+
+	FBoardAnim& Anim = AddAnim(EAnimType::Fall, MaxDrop * Style.FallSecondsPerRow);
+	Anim.FirstMove = FirstMove;
+	Anim.NumMoves = FallMoves.Num();
+}
+
+void SMatch3Board::AddReshuffleAnim()
+{
+	const ADatamanagement* CurrentBoard = Board.Get();
+	if (!CurrentBoard)
+	{
+		return;
+	}
+
+	// 洗牌后的方块在加入队列时取出（之后的改变由后面的动画带来）
+	const int32 FirstColor = ColorBuffer.Num();
+	ColorBuffer.AddUninitialized(FMatch3Board::NumCells);
+	const FMatch3Board& Cells = CurrentBoard->GetMatch3().GetBoard();
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		ColorBuffer[FirstColor + Index] = Cells.GetColor(Index);
+	}
+
+	FBoardAnim& Anim = AddAnim(EAnimType::Reshuffle, Style.ReshuffleDuration);
+	Anim.FirstColor = FirstColor;
+}
+
+void SMatch3Board::AddAdvance()
+{
+	// 棋盘仍使用蓝图控件的旧流程时由蓝图推进
+	const ADatamanagement* CurrentBoard = Board.Get();
+	if (bDriveGameState && CurrentBoard && CurrentBoard->bUseNativeBoardWidget)
+	{
+		AddAnim(EAnimType::Advance, 0.0f);
+	}
+}
+
+void SMatch3Board::BeginAnim(const FBoardAnim& Anim)
+{
+	if (Anim.Type != EAnimType::Fall)
+	{
+		return;
+	}
+
+	// 下落：终点格子立即换成新的方块，绘制时从起点插值到终点（被让出的格子都是其它方块的终点）
+	for (int32 MoveIndex = Anim.FirstMove; MoveIndex < Anim.FirstMove + Anim.NumMoves; ++MoveIndex)
+	{
+		const FFallMove& Move = FallMoveBuffer[MoveIndex];
+		if (Move.ToIndex < 0 || Move.ToIndex >= FMatch3Board::NumCells)
+		{
+			continue;
+		}
+		DisplayColors[Move.ToIndex] = (uint8)Move.Color;
+		FallFromRows[Move.ToIndex] = Move.bIsNewTile ? (float)Move.FromIndex : (float)(Move.FromIndex / FMatch3Board::Cols);
+	}
+}
+
+void SMatch3Board::EndAnim(const FBoardAnim& Anim)
+{
+	switch (Anim.Type)
+	{
+	case EAnimType::Swap:
+		if (Anim.bSuccessful)
+		{
+			Swap(DisplayColors[Anim.IndexA], DisplayColors[Anim.IndexB]);
+		}
+		break;
+
+	case EAnimType::Clear:
+		FMatch3Bits::ForEach(Anim.Mask, [this](int32 Index) { DisplayColors[Index] = FMatch3Board::EmptyColor; });
+		break;
+
+	case EAnimType::Fall:
+		for (int32 MoveIndex = Anim.FirstMove; MoveIndex < Anim.FirstMove + Anim.NumMoves; ++MoveIndex)
+		{
+			const int32 ToIndex = FallMoveBuffer[MoveIndex].ToIndex;
+			if (ToIndex >= 0 && ToIndex < FMatch3Board::NumCells)
+			{
+				FallFromRows[ToIndex] = FallNone;
+			}
+		}
+		break;
+
+	case EAnimType::Reshuffle:
+		FMemory::Memcpy(DisplayColors, &ColorBuffer[Anim.FirstColor], FMatch3Board::NumCells);
+		break;
+
+	case EAnimType::Advance:
+		// 推进可能立即派发下一段动画（加入队列末尾）或重建棋盘（清空队列）
+		if (ADatamanagement* CurrentBoard = Board.Get())
+		{
+			CurrentBoard->AdvanceGameState();
+		}
+		break;
+	}
+}
+
+void SMatch3Board::SnapToBoard()
+{
+	Anims.Reset();
+	FallMoveBuffer.Reset();
+	ColorBuffer.Reset();
+	AnimHead = 0;
+	AnimElapsed = 0.0f;
+	bAnimStarted = false;
+
+	const ADatamanagement* CurrentBoard = Board.Get();
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		DisplayColors[Index] = CurrentBoard ? CurrentBoard->GetMatch3().GetBoard().GetColor(Index) : FMatch3Board::EmptyColor;
+		FallFromRows[Index] = FallNone;
+	}
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+EActiveTimerReturnType SMatch3Board::UpdateAnimations(double InCurrentTime, float InDeltaTime)
+{
+	// 一帧内可能播放完多段动画：剩余的时间接着用于下一段，连续的动画之间没有停顿
+	float RemainingTime = InDeltaTime;
+	while (AnimHead < Anims.Num())
+	{
+		if (!bAnimStarted)
+		{
+			bAnimStarted = true;
+			AnimElapsed = 0.0f;
+			BeginAnim(Anims[AnimHead]);
+		}
+
+		const float Duration = Anims[AnimHead].Duration;
+		if (AnimElapsed + RemainingTime < Duration)
+		{
+			AnimElapsed += RemainingTime;
+			break;
+		}
+		RemainingTime -= FMath::Max(Duration - AnimElapsed, 0.0f);
+
+		// 复制一份：结束时的推进可能加入新的动画，使数组重新分配
+		const FBoardAnim Finished = Anims[AnimHead];
+		++AnimHead;
+		bAnimStarted = false;
+		EndAnim(Finished);
+	}
+
+	Invalidate(EInvalidateWidgetReason::Paint);
+	if (AnimHead < Anims.Num())
+	{
+		return EActiveTimerReturnType::Continue;
+	}
+
+	// 全部播放完：棋盘空闲时与棋盘数据对齐（中途加入的关键帧等没有对应动画的改变）
+	const ADatamanagement* CurrentBoard = Board.Get();
+	if (CurrentBoard && CurrentBoard->GameState == EMatch3State::Idle)
+	{
+		SnapToBoard();
+	}
+	else
+	{
+		Anims.Reset();
+		FallMoveBuffer.Reset();
+		ColorBuffer.Reset();
+		AnimHead = 0;
+	}
+	bTimerActive = false;
+	return EActiveTimerReturnType::Stop;
+}
+
+// ========================================
+// 绘制
+// ========================================
+
+void SMatch3Board::GetLayout(const FVector2f& LocalSize, FVector2f& OutOrigin, float& OutCellSize) const
+{
+	OutCellSize = FMath::Max(FMath::Min(LocalSize.X / FMatch3Board::Cols, LocalSize.Y / FMatch3Board::Rows), 0.0f);
+	OutOrigin = (LocalSize - FVector2f(FMatch3Board::Cols, FMatch3Board::Rows) * OutCellSize) * 0.5f;
+}
+
+FVector2D SMatch3Board::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D(FMatch3Board::Cols, FMatch3Board::Rows) * Style.DesiredCellSize;
+}
+
+int32 SMatch3Board::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	DRAGONBOAT_MATCH3_SCOPE(STAT_Match3_BoardPaint);
+
+	const ADatamanagement* CurrentBoard = Board.Get();
+	if (!CurrentBoard)
+	{
+		return LayerId;
+	}
+
+	FVector2f Origin;
+	float CellSize;
+	GetLayout(FVector2f(AllottedGeometry.GetLocalSize()), Origin, CellSize);
+	if (CellSize <= 0.0f)
+	{
+		return LayerId;
+	}
+
+	const ESlateDrawEffect DrawEffects = ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	const FLinearColor WidgetTint = InWidgetStyle.GetColorAndOpacityTint();
+
+	// 每层（底板、特殊格子、方块、锁定、选中）的元素使用相同的画刷与层级，合批为少量绘制调用
+	auto DrawBrush = [&](int32 Layer, const FSlateBrush& Brush, const FVector2f& Position, float Size)
+	{
+		if (Brush.DrawAs == ESlateBrushDrawType::NoDrawType || Size <= 0.0f)
+		{
+			return;
+		}
+		FSlateDrawElement::MakeBox(OutDrawElements, Layer,
+			AllottedGeometry.ToPaintGeometry(FVector2f(Size, Size), FSlateLayoutTransform(Position)),
+			&Brush, DrawEffects, Brush.GetTint(InWidgetStyle) * WidgetTint);
+	};
+
+	// 队首正在播放的动画
+	const FBoardAnim* Anim = (bAnimStarted && AnimHead < Anims.Num()) ? &Anims[AnimHead] : nullptr;
+	const float Alpha = (Anim && Anim->Duration > 0.0f) ? FMath::Clamp(AnimElapsed / Anim->Duration, 0.0f, 1.0f) : 0.0f;
+
+	const FMatch3Game& Match3 = CurrentBoard->GetMatch3();
+	const FMatch3Board& Cells = Match3.GetBoard();
+	const uint64 PlayableMask = Cells.GetPlayableMask();
+	const uint64 LockedMask = Cells.GetLockedMask();
+	const int32 SelectedIndex = CurrentBoard->SelectedTileIndex;
+	const float TileInset = CellSize * Style.TilePadding;
+	const float TileSize = CellSize - 2.0f * TileInset;
+
+	FMatch3Bits::ForEach(PlayableMask, [&](int32 Index)
+	{
+		const int32 Row = Index / FMatch3Board::Cols;
+		const int32 Col = Index % FMatch3Board::Cols;
+		const FVector2f CellPosition = Origin + FVector2f(Col, Row) * CellSize;
+
+		DrawBrush(LayerId, Style.CellBrush, CellPosition, CellSize);
+
+		const EMatch3Effect Effect = Match3.GetSpecialAreas().GetEffect(Index);
+		if (Effect != EMatch3Effect::None)
+		{
+			DrawBrush(LayerId + 1, Style.SpecialAreaBrushes[(int32)Effect], CellPosition, CellSize);
+		}
+
+		// 方块：按队首动画偏移或缩放
+		uint8 Color = DisplayColors[Index];
+		FVector2f TilePosition = CellPosition;
+		float Scale = 1.0f;
+		if (FallFromRows[Index] != FallNone)
+		{
+			TilePosition.Y = Origin.Y + FMath::Lerp(FallFromRows[Index], (float)Row, Alpha * Alpha) * CellSize;
+		}
+		if (Anim)
+		{
+			switch (Anim->Type)
+			{
+			case EAnimType::Swap:
+				if (Index == Anim->IndexA || Index == Anim->IndexB)
+				{
+					// 成功时移到对方的位置；失败时移到一半再回来
+					const int32 Other = (Index == Anim->IndexA) ? Anim->IndexB : Anim->IndexA;
+					const FVector2f Delta = FVector2f(Other % FMatch3Board::Cols - Col, Other / FMatch3Board::Cols - Row) * CellSize;
+					const float Move = Anim->bSuccessful
+						? FMath::InterpEaseInOut(0.0f, 1.0f, Alpha, 2.0f)
+						: 0.5f * (1.0f - FMath::Abs(1.0f - 2.0f * Alpha));
+					TilePosition += Delta * Move;
+				}
+				break;
+
+			case EAnimType::Clear:
+				if (Anim->Mask & FMatch3Board::CellBit(Index))
+				{
+					Scale = 1.0f - Alpha;
+				}
+				break;
+
+			case EAnimType::Reshuffle:
+				// 缩小后换成洗牌后的方块再放大
+				Scale = FMath::Abs(1.0f - 2.0f * Alpha);
+				if (Alpha >= 0.5f)
+				{
+					Color = ColorBuffer[Anim->FirstColor + Index];
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+		if (Color < FMatch3Board::NumColors)
+		{
+			const float Size = TileSize * Scale;
+			const FVector2f Centered = TilePosition + FVector2f(TileInset + 0.5f * (TileSize - Size));
+			DrawBrush(LayerId + 2, Style.TileBrushes[Color], Centered, Size);
+		}
+
+		if (LockedMask & FMatch3Board::CellBit(Index))
+		{
+			DrawBrush(LayerId + 3, Style.LockedBrush, CellPosition, CellSize);
+		}
+		if (Index == SelectedIndex)
+		{
+			DrawBrush(LayerId + 4, Style.SelectedBrush, CellPosition, CellSize);
+		}
+	});
+
+	return LayerId + 4;
+}
+
+// ========================================
+// 输入
+// ========================================
+
+int32 SMatch3Board::GetCellAt(const FGeometry& MyGeometry, const FVector2D& ScreenPosition) const
+{
+	const ADatamanagement* CurrentBoard = Board.Get();
+	if (!CurrentBoard)
+	{
+		return INDEX_NONE;
+	}
+
+	FVector2f Origin;
+	float CellSize;
+	GetLayout(FVector2f(MyGeometry.GetLocalSize()), Origin, CellSize);
+	if (CellSize <= 0.0f)
+	{
+		return INDEX_NONE;
+	}
+
+	const FVector2f Local = (FVector2f(MyGeometry.AbsoluteToLocal(ScreenPosition)) - Origin) / CellSize;
+	const int32 Col = FMath::FloorToInt(Local.X);
+	const int32 Row = FMath::FloorToInt(Local.Y);
+	if (Col < 0 || Col >= FMatch3Board::Cols || Row < 0 || Row >= FMatch3Board::Rows)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Index = Row * FMatch3Board::Cols + Col;
+	return (CurrentBoard->GetMatch3().GetBoard().GetPlayableMask() & FMatch3Board::CellBit(Index)) ? Index : INDEX_NONE;
+}
+
+FReply SMatch3Board::OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	ADatamanagement* CurrentBoard = Board.Get();
+	if (!bAcceptInput || !CurrentBoard || MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton)
+	{
+		return FReply::Unhandled();
+	}
+
+	const int32 Cell = GetCellAt(MyGeometry, MouseEvent.GetScreenSpacePosition());
+	if (Cell == INDEX_NONE)
+	{
+		return FReply::Unhandled();
+	}
+
+	// 按在已选中的格子上：松开时取消选中，拖到相邻格子则交换
+	bDeselectOnRelease = CurrentBoard->SelectedTileIndex == Cell;
+	if (!bDeselectOnRelease)
+	{
+		CurrentBoard->HandleTileInput(Cell);
+	}
+	PressedCell = CurrentBoard->SelectedTileIndex == Cell ? Cell : INDEX_NONE;
+	Invalidate(EInvalidateWidgetReason::Paint);
+
+	return FReply::Handled().CaptureMouse(SharedThis(this));
+}
+
+FReply SMatch3Board::OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	ADatamanagement* CurrentBoard = Board.Get();
+	if (!HasMouseCapture() || PressedCell == INDEX_NONE || !CurrentBoard)
+	{
+		return FReply::Unhandled();
+	}
+
+	// 拖进相邻格子即交换（斜向经过的格子忽略）
+	const int32 Cell = GetCellAt(MyGeometry, MouseEvent.GetScreenSpacePosition());
+	if (Cell != INDEX_NONE && Cell != PressedCell && CurrentBoard->SelectedTileIndex == PressedCell)
+	{
+		const int32 RowDistance = FMath::Abs(Cell / FMatch3Board::Cols - PressedCell / FMatch3Board::Cols);
+		const int32 ColDistance = FMath::Abs(Cell % FMatch3Board::Cols - PressedCell % FMatch3Board::Cols);
+		if (RowDistance + ColDistance == 1)
+		{
+			CurrentBoard->HandleTileInput(Cell);
+			PressedCell = INDEX_NONE;
+			bDeselectOnRelease = false;
+			Invalidate(EInvalidateWidgetReason::Paint);
+		}
+	}
+	return FReply::Handled();
+}
+
+FReply SMatch3Board::OnMouseButtonUp(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
+{
+	if (!HasMouseCapture())
+	{
+		return FReply::Unhandled();
+	}
+
+	ADatamanagement* CurrentBoard = Board.Get();
+	if (bDeselectOnRelease && PressedCell != INDEX_NONE && CurrentBoard && CurrentBoard->SelectedTileIndex == PressedCell)
+	{
+		CurrentBoard->HandleTileInput(PressedCell);
+		Invalidate(EInvalidateWidgetReason::Paint);
+	}
+	PressedCell = INDEX_NONE;
+	bDeselectOnRelease = false;
+	return FReply::Handled().ReleaseMouseCapture();
+}
+
+void SMatch3Board::OnMouseCaptureLost(const FCaptureLostEvent& CaptureLostEvent)
+{
+	PressedCell = INDEX_NONE;
+	bDeselectOnRelease = false;
+}
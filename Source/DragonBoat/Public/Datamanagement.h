@@ -4,9 +4,18 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Match3Game.h"
+#include "Match3Morale.h"
+#include "Match3MoveRanker.h"
+#include "Match3AIPlayer.h"
+#include "Match3NetDelta.h"
+#include "RaceSkillScheduler.h"
+#include "RaceReplay.h"
+#include "RaceSnapshot.h"
+#include "Tasks/Task.h"
 #include "Datamanagement.generated.h"
 
-// ɫ
+// 方块颜色
 UENUM(BlueprintType)
 enum class ETileColor : uint8
 {
@@ -17,7 +26,7 @@ enum class ETileColor : uint8
 	Empty	UMETA(DisplayName = "Empty")
 };
 
-// Ч
+// 特殊区域效果类型
 UENUM(BlueprintType)
 enum class ESlotEffectType : uint8
 {
@@ -27,7 +36,7 @@ enum class ESlotEffectType : uint8
 	MoraleBoost		UMETA(DisplayName = "Morale Boost")
 };
 
-// Ϸ״̬
+// 游戏流程状态
 UENUM(BlueprintType)
 enum class EMatch3State : uint8
 {
@@ -36,37 +45,68 @@ enum class EMatch3State : uint8
 	CheckMatching	UMETA(DisplayName = "Checking Matches"),
 	Clearing		UMETA(DisplayName = "Clearing (Anim)"),
 	Falling			UMETA(DisplayName = "Falling (Anim)"),
-	RevertingSwap	UMETA(DisplayName = "Reverting Swap (Anim)")
+	RevertingSwap	UMETA(DisplayName = "Reverting Swap (Anim)"),
+	PlayingTimeline	UMETA(DisplayName = "Playing Timeline (Anim)")
 };
 
-// м
+// 大招技能类型
 UENUM(BlueprintType)
 enum class ESkillType : uint8
 {
-	EastWind		UMETA(DisplayName = "East Wind"),		// ɽ趫
-	FloodSeven		UMETA(DisplayName = "Flood Seven"),		// ˮ߾
-	HeavyFog		UMETA(DisplayName = "Heavy Fog"),		// 
-	IronChain		UMETA(DisplayName = "Iron Chain"),		// 
-	EmptyCity		UMETA(DisplayName = "Empty City")		// ճǼ
+	EastWind		UMETA(DisplayName = "East Wind"),		// 巧借东风
+	FloodSeven		UMETA(DisplayName = "Flood Seven"),		// 水淹七军
+	HeavyFog		UMETA(DisplayName = "Heavy Fog"),		// 大雾
+	IronChain		UMETA(DisplayName = "Iron Chain"),		// 铁索连环
+	EmptyCity		UMETA(DisplayName = "Empty City")		// 空城计
 };
 
-// ĿͣAIѡĿ꣩
+// 技能目标类型（用于AI选择目标）
 UENUM(BlueprintType)
 enum class ESkillTargetType : uint8
 {
-	Self		UMETA(DisplayName = "Self"),		// 漼ܣԼ
-	Enemy		UMETA(DisplayName = "Enemy")		// 漼ܣԵˣ
+	Self		UMETA(DisplayName = "Self"),		// 增益技能（对自己）
+	Enemy		UMETA(DisplayName = "Enemy")		// 减益技能（对敌人）
 };
 
-// AIֲͬAI
+// AI龙舟索引（只用于已弃用的 OnAISkillCasted；其它接口按 int32 AI 编号区分，AI i 为龙舟 i + 1）
 UENUM(BlueprintType)
 enum class EAIBoatIndex : uint8
 {
-	AI1		UMETA(DisplayName = "AI Boat 1"),		// AI1
-	AI2		UMETA(DisplayName = "AI Boat 2")		// AI2
+	AI1		UMETA(DisplayName = "AI Boat 1"),		// AI龙舟1
+	AI2		UMETA(DisplayName = "AI Boat 2")		// AI龙舟2
 };
 
-// ƶϢ
+// AI三消策略（数值与 EMatch3AIPolicy 一致）
+UENUM(BlueprintType)
+enum class EAIMatch3Policy : uint8
+{
+	Random		UMETA(DisplayName = "Random"),		// 随机选择有效交换
+	Greedy		UMETA(DisplayName = "Greedy"),		// 选择士气值最高的交换
+	Mixed		UMETA(DisplayName = "Mixed")		// 按概率贪心，否则随机
+};
+
+// AI减益技能的目标选择（数值与 ERaceTargetPolicy 一致）
+UENUM(BlueprintType)
+enum class EAISkillTargetPolicy : uint8
+{
+	Random		UMETA(DisplayName = "Random"),		// 在对手中随机
+	Leader		UMETA(DisplayName = "Leader"),		// 排名最靠前的对手
+	BoatAhead	UMETA(DisplayName = "Boat Ahead"),	// 紧挨在自己前面的龙舟（自己领先时为紧随其后的龙舟）
+	Adaptive	UMETA(DisplayName = "Adaptive")		// 最近超过自己的龙舟，没有时攻击领先者
+};
+
+// 随机流类型（每类随机决策使用独立的随机流，互不影响）
+UENUM(BlueprintType)
+enum class ERandomStreamType : uint8
+{
+	Board		UMETA(DisplayName = "Board"),			// 棋盘生成与洗牌
+	Refill		UMETA(DisplayName = "Refill"),			// 下落补充的新方块
+	AISkill		UMETA(DisplayName = "AI Skill"),		// AI施法者、技能与目标选择
+	AIInterval	UMETA(DisplayName = "AI Interval"),		// AI技能释放间隔
+	AIMatch3	UMETA(DisplayName = "AI Match3")		// AI三消棋盘的种子
+};
+
+// 方块下落移动信息
 USTRUCT(BlueprintType)
 struct FFallMove
 {
@@ -93,7 +133,7 @@ struct FFallMove
 	{}
 };
 
-// Ч
+// 特殊效果数据（同一步中按效果类型顺序排列，每种类型最多一项）
 USTRUCT(BlueprintType)
 struct FSpecialEffectData
 {
@@ -103,38 +143,220 @@ struct FSpecialEffectData
 	ESlotEffectType EffectType;
 
 	UPROPERTY(BlueprintReadOnly, Category = "Match3 Special")
-	TArray<int32> TriggerIndices;  // Чи
+	int32 TriggerCount;  // 触发该效果的格子数
+
+	// 触发该效果的所有格子索引（升序），仅在 bExpandEffectTriggerIndices 时填充，
+	// 否则按需调用 ADatamanagement::GetEffectTriggerIndices 展开
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Special")
+	TArray<int32> TriggerIndices;
+
+	// 触发该效果的格子掩码（索引的原始数据）
+	uint64 TriggerMask;
 
 	FSpecialEffectData()
-		: EffectType(ESlotEffectType::None)
+		: EffectType(ESlotEffectType::None), TriggerCount(0), TriggerMask(0)
 	{}
 
 	FSpecialEffectData(ESlotEffectType InType)
-		: EffectType(InType)
+		: EffectType(InType), TriggerCount(0), TriggerMask(0)
 	{}
 
 	FSpecialEffectData(ESlotEffectType InType, const TArray<int32>& InIndices)
-		: EffectType(InType), TriggerIndices(InIndices)
+		: EffectType(InType), TriggerCount(InIndices.Num()), TriggerIndices(InIndices), TriggerMask(0)
+	{
+		for (int32 Index : InIndices)
+		{
+			TriggerMask |= FMatch3Board::CellBit(Index);
+		}
+	}
+};
+
+// 连消时间线中的一步（播放顺序：消除 -> 效果/士气 -> 下落）
+USTRUCT(BlueprintType)
+struct FCascadeStep
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	TArray<int32> ClearedIndices;  // 本步被消除的方块索引
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	TArray<FSpecialEffectData> TriggeredEffects;  // 本步触发的特殊效果
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	int32 MoraleReward;  // 本步获得的士气值
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	int32 MoraleAfterStep;  // 本步结算后的士气值
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	int32 SkillPointsAfterStep;  // 本步结算后的技能点
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	TArray<FFallMove> FallMoves;  // 本步消除后的下落移动
+
+	FCascadeStep()
+		: MoraleReward(0), MoraleAfterStep(0), SkillPointsAfterStep(0)
+	{}
+};
+
+// 一次有效交换的完整连消时间线
+USTRUCT(BlueprintType)
+struct FCascadeTimeline
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	int32 SwapIndexA;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	int32 SwapIndexB;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	TArray<FCascadeStep> Steps;  // 按顺序排列的连消步骤（第一步为交换产生的消除）
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Timeline")
+	bool bReshuffled;  // 结算后出现死锁并已洗牌（最终棋盘以 OrbGrid 为准）
+
+	FCascadeTimeline()
+		: SwapIndexA(-1), SwapIndexB(-1), bReshuffled(false)
+	{}
+};
+
+// 提示用的交换排名项（只计算交换产生的首次消除）
+USTRUCT(BlueprintType)
+struct FMoveHint
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Hint")
+	int32 IndexA;  // 交换的两个格子
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Hint")
+	int32 IndexB;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Hint")
+	float Score;  // 综合得分（越高越好）
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Hint")
+	int32 ClearedTiles;  // 消除的方块数
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Hint")
+	int32 SpecialAreaHits;  // 消除中包含的特殊格子数（所有效果类型）
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Hint")
+	int32 MoraleReward;  // 预计获得的士气值
+
+	FMoveHint()
+		: IndexA(-1), IndexB(-1), Score(0.0f), ClearedTiles(0), SpecialAreaHits(0), MoraleReward(0)
+	{}
+};
+
+// 一步消除的汇总结果（合并事件模式下每步只派发这一个事件）
+USTRUCT(BlueprintType)
+struct FMatch3StepResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 CascadeDepth;  // 本次交换的第几步消除（1 = 交换产生的消除）
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	TArray<int32> ClearedIndices;  // 本步被消除的方块索引
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	TArray<FSpecialEffectData> TriggeredEffects;  // 本步触发的特殊效果
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 SpeedUpTriggers;  // 本步触发的加速格子数
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 SlowDownTriggers;  // 本步触发的减速格子数
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 MoraleReward;  // 本步获得的士气值
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 MoraleAfterStep;  // 本步结算后的士气值
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 SkillPointsGained;  // 本步转换得到的技能点
+
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 Step")
+	int32 SkillPointsAfterStep;  // 本步结算后的技能点
+
+	// 本步被消除的格子掩码
+	uint64 ClearedMask;
+
+	FMatch3StepResult()
+		: CascadeDepth(0), SpeedUpTriggers(0), SlowDownTriggers(0), MoraleReward(0)
+		, MoraleAfterStep(0), SkillPointsGained(0), SkillPointsAfterStep(0), ClearedMask(0)
 	{}
 };
 
-// 
+// 技能配置数据
 USTRUCT(BlueprintType)
 struct FSkillConfig
 {
 	GENERATED_BODY()
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skill")
-	float Duration;  // ʱ䣨룩
+	float Duration;  // 持续时间（秒）
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skill")
-	float EffectValue;  // Чֵ
+	float EffectValue;  // 效果数值
 
 	FSkillConfig()
 		: Duration(5.0f), EffectValue(100.0f)
 	{}
 };
 
+// 一条AI装备的技能
+USTRUCT(BlueprintType)
+struct FAISkillLoadout
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skill")
+	TArray<ESkillType> Skills;
+};
+
+// 棋盘同步的关键帧（属性复制）：中途加入与失去同步的客户端从这里恢复，之后接着应用序号更大的增量消息
+USTRUCT()
+struct FBoardNetKeyframe
+{
+	GENERATED_BODY()
+
+	// 关键帧包含到第几条增量消息为止的改变（之后的消息从 Sequence + 1 开始）
+	UPROPERTY()
+	int32 Sequence;
+
+	// 只含 Keyframe 与 Morale 操作的同步消息（FMatch3NetDeltaWriter 格式）
+	UPROPERTY()
+	TArray<uint8> Data;
+
+	FBoardNetKeyframe()
+		: Sequence(0)
+	{}
+};
+
+// 原生多播委托：C++ 监听者（龙舟、音效、遥测）直接订阅，不经过蓝图虚拟机
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMatch3StepResolvedNative, const FMatch3StepResult& /*Step*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMatch3BoardRebuiltNative, bool /*bReshuffled*/);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnMoraleChangedNative, int32 /*NewMorale*/, int32 /*MaxMorale*/, int32 /*AddedAmount*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSkillPointChangedNative, int32 /*NewSkillPoints*/, int32 /*MaxSkillPoints*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSkillCastedNative, ESkillType /*SkillType*/, const FSkillConfig& /*Config*/);
+DECLARE_MULTICAST_DELEGATE_SixParams(FOnAISkillCastedNative, int32 /*CasterAI*/, ESkillType /*SkillType*/, ESkillTargetType /*TargetType*/,
+	int32 /*TargetAI*/, bool /*bTargetIsPlayer*/, const FSkillConfig& /*Config*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnAIMatch3BatchNative, int32 /*AI*/, const FMatch3AIBatchResult& /*Batch*/);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnMatch3SwapAnimNative, int32 /*IndexA*/, int32 /*IndexB*/, bool /*bIsSuccessful*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMatch3ClearAnimNative, const FMatch3StepResult& /*Step*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMatch3FallAnimNative, const TArray<FFallMove>& /*FallMoves*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMatch3CascadeResolvedNative, const FCascadeTimeline& /*Timeline*/);
+
+class URaceSimulationComponent;
+enum class ERaceStatusEffect : uint8;
+
 UCLASS()
 class DRAGONBOAT_API ADatamanagement : public AActor
 {
@@ -145,335 +367,978 @@ public:
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
+	virtual void PostLoad() override;
 	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-	// ̴С
-	const int32 GridSize = 7;
+	// 棋盘大小（由三消核心的棋盘规格在编译期确定）
+	static constexpr int32 BoardRows = FMatch3Board::Rows;
+	static constexpr int32 BoardCols = FMatch3Board::Cols;
 
-	//  (7x7 = 49)
+	// 方块网格数据 (7x7 = 49个方块)，由三消核心 Match3 同步，供蓝图读取
 	UPROPERTY(BlueprintReadOnly, Category = "Match3 Data")
 	TArray<ETileColor> OrbGrid;
 
-	//  - ڱ༭ֶ
-	// 㣺к * 7 + к
-	// 磺2е3 = 2*7+3 = 17
+	// 特殊区域网格配置 - 在编辑器中手动配置
+	// 索引计算：行号 * 7 + 列号
+	// 例如：第2行第3列 = 2*7+3 = 17
+	// 在 InitializeGame 时同步到三消核心，运行时修改请调用 ApplySpecialAreas（之后作为核心布局的镜像供蓝图读取）
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Config")
 	TArray<ESlotEffectType> SpecialAreaGrid;
 
-	// ǰѡеķ (-1ʾδѡ)
+	// 当前选中的方块索引 (-1表示未选中)
 	UPROPERTY(BlueprintReadOnly, Category = "Match3 State")
 	int32 SelectedTileIndex;
 
-	// ǰϷ״̬
+	// 当前游戏状态
 	UPROPERTY(BlueprintReadOnly, Category = "Match3 State")
 	EMatch3State GameState;
 
-	// һƶ¼
+	// 最后一次下落移动记录
 	UPROPERTY(BlueprintReadOnly, Category = "Match3 State")
 	TArray<FFallMove> LastFallMoves;
 
-	// ========== ʿֵϵͳ ==========
+	// 最后一次一次性结算的连消时间线
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 State")
+	FCascadeTimeline LastCascadeTimeline;
+
+	// 一次性结算模式：有效交换后同步结算整条连消链，通过 OnCascadeResolved 一次交给UI，
+	// UI按时间线连续播放动画，全部播放完后调用一次 AdvanceGameState（中间不需要回调）；
+	// 结算过程中不派发每步的士气/技能点/效果蓝图事件（时间线的步骤带有这些结果），与 bCoalesceStepEvents 无关；
+	// 联机时客户端玩家的棋盘总是由服务器一次性结算（客户端按时间线播放）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Match3 Config")
+	bool bResolveCascadeInOneCall;
+
+	// 消除时是否为每个触发的效果展开 TriggerIndices；关闭后只填写 TriggerCount，
+	// UI 需要格子位置时调用 GetEffectTriggerIndices（消除路径只做掩码运算）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Config")
+	bool bExpandEffectTriggerIndices;
+
+	// 合并事件模式：每步消除只派发一次 OnMatchStepResolved（含士气、技能点、效果触发数），
+	// 代替 OnMatchesCleared / OnMoraleChanged / OnSkillPointChanged / OnPlayerSpeedUpTriggered / OnPlayerSlowDownEnemyTriggered；
+	// 一次性结算模式下由 OnCascadeResolved 代替，消除步骤内不再派发上述蓝图事件
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Config")
+	bool bCoalesceStepEvents;
+
+	// 棋盘UI切换：开启后由原生棋盘控件 UMatch3BoardWidget（放在 WBP_HUD 中，自动绑定本机操作的棋盘）播放动画并调用 AdvanceGameState；
+	// 关闭（默认）时沿用 WBP_OneBoard 等逐格子蓝图控件的旧流程，原生控件只显示、不推进，两条路径不会重复推进状态
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Match3 Config")
+	bool bUseNativeBoardWidget;
+
+	// 逐步模式下最后一步消除的汇总结果
+	UPROPERTY(BlueprintReadOnly, Category = "Match3 State")
+	FMatch3StepResult LastStepResult;
+
+	// ========== 原生委托（C++ 订阅，与蓝图事件模式无关）==========
+
+	// 每步消除结算后（逐步模式与一次性结算模式都会派发）
+	FOnMatch3StepResolvedNative OnStepResolvedNative;
+
+	// 棋盘初始化或死锁洗牌后
+	FOnMatch3BoardRebuiltNative OnBoardRebuiltNative;
+
+	// 士气值 / 技能点变化（合并事件模式下，消除步骤内的变化只通过 OnStepResolvedNative 通知）
+	FOnMoraleChangedNative OnMoraleChangedNative;
+	FOnSkillPointChangedNative OnSkillPointChangedNative;
+
+	// 玩家释放技能
+	FOnSkillCastedNative OnSkillCastedNative;
+
+	// AI释放技能 / AI三消模拟的一批结果交回游戏线程（参数与对应的蓝图事件相同）
+	FOnAISkillCastedNative OnAISkillCastedNative;
+	FOnAIMatch3BatchNative OnAIMatch3BatchNative;
+
+	// 动画时机（与时机2-4、6的蓝图事件同时派发）：原生棋盘控件 UMatch3BoardWidget 据此播放动画，播放完后调用 AdvanceGameState
+	FOnMatch3SwapAnimNative OnSwapAnimNative;
+	FOnMatch3ClearAnimNative OnClearAnimNative;
+	FOnMatch3FallAnimNative OnFallAnimNative;
+	FOnMatch3CascadeResolvedNative OnCascadeResolvedNative;
+
+	// 锁定格子或特殊格子改变（方块不变，原生棋盘控件只需重绘）
+	FSimpleMulticastDelegate OnCellStateChangedNative;
+
+	// 三消核心（原生棋盘控件直接读取格子、特殊格子与锁定的掩码）
+	const FMatch3Game& GetMatch3() const { return Match3; }
 
-	// ǰʿֵ
+	// 比赛模拟（URaceSimulationComponent::BindToDatamanagement 时设置）：AI 减益命中前检查目标的空城计免疫，
+	// 铁索连环开始 / 结束时锁定 / 解锁对应棋盘的格子
+	void SetRaceSimulation(URaceSimulationComponent* InRaceSimulation);
+
+	// GameMode 每次更新排名后调用：AI 减益按最新排名与超越记录选择目标
+	void UpdateRaceStandings(const FRaceBoatRegistry& Registry);
+
+	// 调试：局部匹配检查同时执行全盘扫描交叉验证，并统计两者的开销
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Debug")
+	bool bDebugVerifyLocalMatchCheck;
+
+	// ========== 交换提示 ==========
+
+	// GetBestMoves 每次调用的时间预算（微秒），超出后下次调用从中断处继续评估
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Hint", meta = (ClampMin = "1.0"))
+	float HintBudgetMicroseconds;
+
+	// 评分权重：每个消除的方块
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Hint")
+	float HintWeightPerTile;
+
+	// 评分权重：每个被消除的特殊格子（加速/减速/士气提升）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Hint")
+	float HintWeightPerSpecialArea;
+
+	// 评分权重：每点预计士气值
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Match3 Hint")
+	float HintWeightPerMorale;
+
+	// ========== 士气值系统 ==========
+
+	// 当前士气值
 	UPROPERTY(BlueprintReadOnly, Category = "Morale System")
 	int32 CurrentMorale;
 
-	// ʿֵޣʱתΪܵ㣩
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Morale System")
+	// 士气值上限（满时转换为技能点）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Morale System")
 	int32 MaxMorale;
 
-	// ÿ鹱׵ʿֵ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Morale System")
+	// 每个消除方块贡献的士气值
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Morale System")
 	int32 MoralePerTile;
 
-	// ӣʿʿֵ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Morale System")
+	// 特殊格子（士气提升）额外的士气值
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Morale System")
 	int32 SpecialMoraleBonus;
 
-	// ǰܵ㣨3
+	// 当前技能点（最多3个）
 	UPROPERTY(BlueprintReadOnly, Category = "Morale System")
 	int32 SkillPoints;
 
-	// ܵ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Morale System")
+	// 最大技能点数量
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Morale System")
 	int32 MaxSkillPoints;
 
-	// ========== ۾Ч ==========
+	// ========== 龙舟竞速效果配置 ==========
 
-	// Чֵÿδļ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Effects")
+	// 加速效果数值（每次触发的加速量）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Race Effects")
 	float SpeedBoostPerTrigger;
 
-	// Чֵÿδļ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Effects")
+	// 减速效果数值（每次触发的减速量）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Race Effects")
 	float SlowDownPerTrigger;
 
-	// ========== ϵͳ ==========
+	// ========== 技能系统 ==========
 
-	// װļܣ2λ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skill System")
+	// 玩家装备的技能（2个槽位）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "Skill System")
 	TArray<ESkillType> EquippedSkills;
 
-	// ñ
+	// 技能配置表
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Skill System")
 	TMap<ESkillType, FSkillConfig> SkillConfigs;
 
-	// ========== AIϵͳ ==========
+	// ========== AI技能系统 ==========
 
-	// AIǷԶͷż
+	// AI是否启用自动释放技能
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
 	bool bEnableAISkills;
 
-	// AIͷżܵС룩
+	// AI释放技能的最小间隔（秒）
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
 	float AISkillIntervalMin;
 
-	// AIͷżܵ룩
+	// AI释放技能的最大间隔（秒）
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
 	float AISkillIntervalMax;
 
-	// AIǷÿܣúAIܻÿαʼʱ
+	// AI减益技能的目标选择（优先选择不处于空城计的对手）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
+	EAISkillTargetPolicy AISkillTargetPolicy;
+
+	// Adaptive 目标选择中"最近被超过"的时间范围（秒）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System", meta = (ClampMin = "0.0"))
+	float AIOvertakeMemorySeconds;
+
+	// AI是否每局随机技能（启用后AI技能会在每次比赛开始时重新随机）
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
 	bool bRandomizeAISkillsEachRace;
 
-	// AI1 װļܣ2λ
+	// 每条AI装备的技能（按AI编号索引，每条2个槽位）；AI 比配置多时循环使用
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
+	TArray<FAISkillLoadout> AIEquippedSkills;
+
+	// 已弃用：旧版 AI1/AI2 的装备技能，非空时迁移到 AIEquippedSkills[0]/[1] 后清空（加载后与 StartAISkillSystem 时）
+	UPROPERTY(BlueprintReadWrite, Category = "AI Skill System", meta = (DeprecatedProperty, DeprecationMessage = "Use AIEquippedSkills[0] instead."))
 	TArray<ESkillType> AI1_EquippedSkills;
 
-	// AI2 װļܣ2λ
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
+	UPROPERTY(BlueprintReadWrite, Category = "AI Skill System", meta = (DeprecatedProperty, DeprecationMessage = "Use AIEquippedSkills[1] instead."))
 	TArray<ESkillType> AI2_EquippedSkills;
 
-	// AIĿӳ䣨жϼ滹Ǽ棩
+	// AI是否在自己的无头棋盘上玩三消（工作线程模拟），用与玩家相同的士气值规则积累技能点后释放技能
+	// 关闭时退回为每条AI各自每隔 AISkillIntervalMin~Max 秒释放技能
+	// 开启时 AISkillIntervalMin~Max 作为同一条AI两次释放之间的冷却
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
+	bool bAIPlaysMatch3;
+
+	// AI选择交换的策略
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
+	EAIMatch3Policy AIMatch3Policy;
+
+	// Mixed 策略下贪心选择的概率
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float AIGreedyChance;
+
+	// 每条AI每秒执行的交换次数
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System", meta = (ClampMin = "0.0"))
+	float AIMovesPerSecond;
+
+	// AI模拟结果交回游戏线程的间隔（秒），每批包含这段时间内应执行的全部交换
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System", meta = (ClampMin = "0.0"))
+	float AIBatchIntervalSeconds;
+
+	// AI技能目标类型映射（用于判断技能是增益还是减益）
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Skill System")
 	TMap<ESkillType, ESkillTargetType> SkillTargetTypeMap;
 
-	// ========== ӿ ==========
+	// ========== 公共接口 ==========
 
-	// ʼϷɳʼ̣
+	// 初始化游戏（生成初始棋盘）
 	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
 	void InitializeGame();
 
-	// 루ʹ
+	// 处理方块点击输入（使用索引）
 	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
 	bool HandleTileInput(int32 TileIndex);
 
-	// ȡָλõķɫʹ
+	// 获取指定位置的方块颜色（使用索引）
 	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
 	ETileColor GetColorAt(int32 TileIndex) const;
 
-	// ȡָλõ
+	// 获取指定位置的特殊格子类型
 	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
 	ESlotEffectType GetSpecialTileType(int32 Index) const;
 
-	// ƽϷ״̬ (UIɺ)
+	// 展开触发效果的格子索引（升序），用于 bExpandEffectTriggerIndices 关闭时按需读取
+	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
+	static void GetEffectTriggerIndices(const FSpecialEffectData& Effect, TArray<int32>& OutIndices);
+
+	// 展开格子掩码中的格子索引（升序），用于 OnCellsLocked 等按掩码交付的事件
+	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
+	static void GetMaskCellIndices(int64 Mask, TArray<int32>& OutIndices);
+
+	// 判断两个格子的交换是否有效（O(1) 查询可交换索引，空闲状态下有效）
+	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
+	bool IsValidSwap(int32 IndexA, int32 IndexB) const;
+
+	// 获取当前所有有效交换（X = IndexA, Y = IndexB），可用于提示
+	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
+	void GetValidSwaps(TArray<FIntPoint>& OutSwaps) const;
+
+	// 获取当前有效交换的数量
+	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
+	int32 GetValidSwapCount() const;
+
+	/**
+	 * 获取得分最高的 N 个有效交换（按得分降序），可每个空闲帧调用以驱动提示高亮
+	 * 每次调用最多花费 HintBudgetMicroseconds，棋盘不变时从上次中断处继续，评估完成后直接返回缓存的排名
+	 * 非空闲状态（动画播放中）返回空数组
+	 * @return 所有有效交换是否都已评估（false 时 OutMoves 只是已评估部分中的最优）
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
+	bool GetBestMoves(int32 N, TArray<FMoveHint>& OutMoves);
+
+	// 推进游戏状态 (UI动画完成后调用)
 	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
 	void AdvanceGameState();
 
-	// ========== ͼã==========
+	/**
+	 * 铁索连环：锁定 NumCells 个格子（锁定的格子不能交换），按去掉的有效交换数贪心选择，不会锁到没有有效交换
+	 * 棋盘空闲时如果因此死锁则立即洗牌（洗牌不移动锁定格子的可交换性），否则留到结算完成后检查
+	 * @return 实际锁定的格子数
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
+	int32 LockCells(int32 NumCells);
+
+	// 解除所有锁定
+	UFUNCTION(BlueprintCallable, Category = "Match3 Logic")
+	void UnlockAllCells();
+
+	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
+	bool IsCellLocked(int32 TileIndex) const;
+
+	// ========== 辅助函数（蓝图可用）==========
 
-	// תΪ
+	// 将索引转换为行列坐标
 	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
 	void IndexToRowCol(int32 Index, int32& OutRow, int32& OutCol) const;
 
-	// תΪ
+	// 将行列坐标转换为索引
 	UFUNCTION(BlueprintPure, Category = "Match3 Logic")
 	int32 RowColToIndex(int32 Row, int32 Col) const;
 
-	// ========== ʿֵϵͳӿ ==========
+	// ========== 士气值系统接口 ==========
 
-	// ʿֵ
+	// 添加士气值
 	UFUNCTION(BlueprintCallable, Category = "Morale System")
 	void AddMorale(int32 Amount);
 
-	// ȡǰʿֵٷֱȣ0.0-1.0
+	// 获取当前士气值百分比（0.0-1.0）
 	UFUNCTION(BlueprintPure, Category = "Morale System")
 	float GetMoraleProgress() const;
 
-	// ļܵ
+	// 消耗技能点
 	UFUNCTION(BlueprintCallable, Category = "Morale System")
 	bool ConsumeSkillPoint(int32 Amount = 1);
 
-	// ========== ϵͳӿ ==========
+	// ========== 技能系统接口 ==========
 
-	// UIãͷָλļܣSlotIndex: 0  1
+	// UI调用：释放指定槽位的技能（SlotIndex: 0 或 1）
 	UFUNCTION(BlueprintCallable, Category = "Skill System")
 	bool TryCastSkill(int32 SlotIndex);
 
-	// ָλļǷ
+	// 检查指定槽位的技能是否可用
 	UFUNCTION(BlueprintPure, Category = "Skill System")
 	bool IsSkillAvailable(int32 SlotIndex) const;
 
-	// ȡָλװļ
+	// 获取指定槽位装备的技能类型
 	UFUNCTION(BlueprintPure, Category = "Skill System")
 	ESkillType GetEquippedSkill(int32 SlotIndex) const;
 
-	// UIãָλļ
+	// UI调用：设置指定槽位的技能
 	UFUNCTION(BlueprintCallable, Category = "Skill System")
 	void SetEquippedSkill(int32 SlotIndex, ESkillType NewSkill);
 
-	// ========== AIϵͳӿ ==========
+	// ========== AI技能系统接口 ==========
 
-	// GameModeãAIϵͳʼã
+	// GameMode调用：启动AI技能系统（比赛开始后调用）
+	// NumRaceBoats 为登记表的龙舟数（含玩家），龙舟 1 到 NumRaceBoats - 1 各是一条AI施法者
 	UFUNCTION(BlueprintCallable, Category = "AI Skill System")
-	void StartAISkillSystem();
+	void StartAISkillSystem(int32 NumRaceBoats = 3);
+
+	// 获取AI尚未释放的技能点（AI三消模式下有效；AI 为从 0 开始的AI编号）
+	UFUNCTION(BlueprintPure, Category = "AI Skill System")
+	int32 GetAIPendingSkillPoints(int32 AI) const;
 
-	// ========== Ѷϵͳӿ ==========
+	// 获取AI距下次释放技能的时间（秒；AI三消模式下为冷却剩余时间），未调度时返回 -1
+	UFUNCTION(BlueprintPure, Category = "AI Skill System")
+	float GetAINextSkillDelay(int32 AI) const;
 
-	// GameModeãӦ
+	// ========== 难度系统接口 ==========
+
+	// GameMode调用：应用特殊格子配置
 	UFUNCTION(BlueprintCallable, Category = "Difficulty")
 	void ApplySpecialAreas(const TArray<int32>& Indices, const TArray<ESlotEffectType>& Types);
 
-	// GameModeãAIͷż
+	// GameMode调用：直接应用预编译的特殊格子掩码（只复制掩码，不解析列表）
+	void ApplySpecialAreaMasks(const FMatch3SpecialAreas& SpecialAreas);
+
+	// GameMode调用：设置AI技能释放间隔
 	UFUNCTION(BlueprintCallable, Category = "Difficulty")
 	void SetAISkillInterval(float MinInterval, float MaxInterval);
 
-	// ========== Ժڵԣ==========
+	// ========== 随机流接口 ==========
+
+	// GameMode调用（StartRace）：用比赛种子为所有随机流播种，空闲状态下用棋盘流重新生成棋盘
+	// 同一种子 + 同样的输入可以完整复现一局（性能测试、问题复现）
+	UFUNCTION(BlueprintCallable, Category = "Random Streams")
+	void SeedRandomStreams(int32 RaceSeed);
 
-	// ԣֱʿֵ
+	// 单独为某个随机流播种（例如只固定棋盘，AI保持随机）
+	UFUNCTION(BlueprintCallable, Category = "Random Streams")
+	void SetRandomStreamSeed(ERandomStreamType StreamType, int32 Seed);
+
+	// 获取某个随机流的初始种子
+	UFUNCTION(BlueprintPure, Category = "Random Streams")
+	int32 GetRandomStreamSeed(ERandomStreamType StreamType) const;
+
+	// ========== 比赛录像 ==========
+
+	/**
+	 * GameMode调用（StartRace）：开始把本局录制到 FilePath，边录边写
+	 * 文件头保存当前棋盘、随机流、士气值与比赛模拟的初始状态，之后记录玩家点击、技能、难度、锁定、AI施法与状态效果
+	 * 录制从没有选中的格子开始
+	 */
+	bool BeginReplayRecording(const FString& FilePath, int32 RaceSeed);
+
+	// GameMode调用（EndRace）：写入结束事件（模拟步数与完成时间）并关闭文件
+	void EndReplayRecording();
+
+	// 录制中返回录像写入器，否则返回 nullptr（比赛模拟组件用来记录状态效果）
+	FRaceReplayWriter* GetReplayRecorder() { return ReplayRecorder.IsRecording() ? &ReplayRecorder : nullptr; }
+
+	UFUNCTION(BlueprintPure, Category = "Replay")
+	bool IsRecordingReplay() const { return ReplayRecorder.IsRecording(); }
+
+	// ========== 比赛快照 ==========
+
+	// 等待进行中的AI三消批次并立即收取结果（结果作用到比赛模拟），之后没有工作线程在访问AI棋盘
+	void CollectAIMatch3Batches();
+
+	/**
+	 * GameMode调用（SaveRaceSnapshot / 回滚缓冲）：写入玩家棋盘（每格3位）、结算状态、士气值、技能点、
+	 * 随机流、AI技能释放间隔 / 调度 / 目标选择，以及AI三消棋盘
+	 * 不等待工作线程：进行中的一批写入派发前的检查点与交换数，恢复后重新派发（明确保存时先调用 CollectAIMatch3Batches）
+	 */
+	void WriteSnapshot(FRaceSnapshotWriter& Writer);
+
+	// GameMode调用（RestoreRaceSnapshot）：只读入暂存，不修改当前状态（读取出错时放弃整个快照）
+	void ReadSnapshot(FRaceSnapshotReader& Reader);
+
+	// 整个快照读取成功后：应用暂存的状态但不派发事件，停止正在进行的录像；之后调用 FinishSnapshotRestore
+	void ApplySnapshot();
+
+	// 所有快照部分恢复后：结算中的棋盘立即完成剩余连消（不等动画），重新对准AI技能计时器，通知UI整体重建棋盘
+	void FinishSnapshotRestore();
+
+	// ========== 网络对战 ==========
+
+	// 本棋盘对应的龙舟索引（0 = 主机玩家；双人对战时第二位玩家的棋盘为 1），比赛模拟按此施加格子效果与技能
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated, Category = "Network")
+	int32 BoardBoatIndex;
+
+	// 服务器刷新关键帧的最长间隔（秒）：不拥有棋盘的客户端丢失同步后最迟在这段时间后恢复
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network", meta = (ClampMin = "0.1"))
+	float NetKeyframeIntervalSeconds;
+
+	// 一条增量消息的最大字节数（不可靠 RPC 须放进一个数据包）：超过时不发送，改为立即刷新关键帧
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network", meta = (ClampMin = "64"))
+	int32 NetMaxDeltaBytes;
+
+	// 本机是否操作这块棋盘（单机、主机自己的棋盘、客户端拥有的棋盘）；其它棋盘只显示服务器同步的结果
+	UFUNCTION(BlueprintPure, Category = "Network")
+	bool IsControlledLocally() const;
+
+	// GameMode调用：AI龙舟改由玩家控制（双人对战），不再模拟它的三消与技能，也不处理它的铁索连环
+	void SetAIBoatHumanControlled(int32 AI, bool bHumanControlled);
+
+	// GameMode调用：新玩家加入时，服务器在下一帧刷新关键帧
+	void RequestNetKeyframe() { bNetKeyframeRequested = true; }
+
+	// GameMode调用（StartRace）：清零本局的同步统计
+	void ResetBoardReplicationStats();
+
+	// GameMode调用（EndRace）：输出本局棋盘同步的消息数、字节数、每次交换的字节数、拒绝的交换与失去同步的次数
+	UFUNCTION(BlueprintCallable, Category = "Network|Debug")
+	void LogBoardReplicationStats() const;
+
+	// ========== 测试函数（仅用于调试）==========
+
+	// 测试：直接设置士气值
 	UFUNCTION(BlueprintCallable, Category = "Morale System|Debug")
 	void Debug_SetMorale(int32 NewMorale);
 
-	// ԣֱüܵ
+	// 测试：直接设置技能点
 	UFUNCTION(BlueprintCallable, Category = "Morale System|Debug")
 	void Debug_SetSkillPoints(int32 NewSkillPoints);
 
-	// ԣģN
+	// 测试：模拟消除N个方块
 	UFUNCTION(BlueprintCallable, Category = "Morale System|Debug")
 	void Debug_SimulateMatch(int32 TileCount, bool bIncludeSpecialBonus = false);
 
-	// ========== UI֪ͨ¼ ==========
+	// 调试：输出局部匹配检查与全盘扫描的对比统计（需开启 bDebugVerifyLocalMatchCheck）
+	UFUNCTION(BlueprintCallable, Category = "Match3 Logic|Debug")
+	void Debug_LogMatchCheckStats(bool bResetAfterLog = false);
+
+	// 调试：无头回放录像 NumRuns 次（不影响当前棋盘与比赛），输出与录制结果是否一致以及回放耗时
+	UFUNCTION(BlueprintCallable, Category = "Replay|Debug")
+	void Debug_PlayReplay(const FString& FilePath, int32 NumRuns = 1);
 
-	// [ʱ1] ̳ʼ - UIҪзӱʶ
+	// ========== UI通知事件 ==========
+
+	// [时机1] 棋盘初始化完成 - UI需要创建所有方块和特殊格子标识
 	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
 	void OnBoardInitialized();
 
-	// [ʱ2] 
+	// [时机2] 交换动画触发
 	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
 	void OnSwapAnimTriggered(int32 IndexA, int32 IndexB, bool bIsSuccessful);
 
-	// [ʱ3] 
-	// ClearedIndices: ķ
-	// TriggeredEffects: ЧûдΪգ
+	// [时机3] 消除动画触发
+	// ClearedIndices: 被消除的方块索引
+	// TriggeredEffects: 被触发的特殊效果（如果没有触发则数组为空）
 	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
 	void OnMatchesCleared(const TArray<int32>& ClearedIndices, const TArray<FSpecialEffectData>& TriggeredEffects);
 
-	// [ʱ4] 䶯
+	// [时机4] 下落动画触发
 	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
 	void OnFallAnimTriggered(const TArray<FFallMove>& FallMoves);
 
-	// [ʱ5] ϴ
+	// [时机5] 棋盘重新洗牌
 	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
 	void OnBoardReshuffle();
 
-	// ========== ʿֵϵͳ¼ ==========
+	// [事件] 格子被锁定（铁索连环）/ 所有锁定解除，UI 显示或移除锁链
+	// LockedMask 为本次新锁定的格子（位 i 为格子 i），需要格子索引时调用 GetMaskCellIndices 展开
+	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
+	void OnCellsLocked(int64 LockedMask);
 
-	// [¼] ʿֵ仯
+	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
+	void OnCellsUnlocked();
+
+	// [时机3'] 合并事件模式：一步消除的汇总结果（代替时机3与本步的士气/技能点/竞速效果事件）
+	// UI播放消除动画后照常调用 AdvanceGameState
+	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
+	void OnMatchStepResolved(const FMatch3StepResult& StepResult);
+
+	// [时机6] 一次性结算模式：整条连消链已结算（代替时机2-5中成功交换之后的所有事件）
+	// Timeline.bReshuffled 为 true 时，播放完时间线后按 OrbGrid 刷新棋盘
+	UFUNCTION(BlueprintImplementableEvent, Category = "Match3 Events")
+	void OnCascadeResolved(const FCascadeTimeline& Timeline);
+
+	// ========== 士气值系统事件 ==========
+
+	// [事件] 士气值变化
 	UFUNCTION(BlueprintImplementableEvent, Category = "Morale Events")
 	void OnMoraleChanged(int32 NewMorale, int32 InMaxMorale, int32 AddedAmount);
 
-	// [¼] ܵ仯
+	// [事件] 技能点变化
 	UFUNCTION(BlueprintImplementableEvent, Category = "Morale Events")
 	void OnSkillPointChanged(int32 NewSkillPoints, int32 InMaxSkillPoints);
 
-	// ========== ۾Ч¼ ==========
+	// ========== 龙舟竞速效果事件 ==========
 
-	// [¼] ҴЧۼ٣
-	// TriggerCount: ˼ӣ
-	// SpeedBoostAmount: ֵ
+	// [事件] 玩家触发加速效果（给玩家龙舟加速）
+	// TriggerCount: 触发次数（消除了几个特殊格子）
+	// SpeedBoostAmount: 加速数值
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnPlayerSpeedUpTriggered(int32 TriggerCount, float SpeedBoostAmount);
 
-	// [¼] ҴЧзۼ٣
-	// TriggerCount: 
-	// SlowDownAmount: ֵ
+	// [事件] 玩家触发减速效果（给敌方龙舟减速）
+	// TriggerCount: 触发次数
+	// SlowDownAmount: 减速数值
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnPlayerSlowDownEnemyTriggered(int32 TriggerCount, float SlowDownAmount);
 
-	// ========== ϵͳ¼ ==========
+	// ========== 技能系统事件 ==========
 
-	// [¼] Ҽͷųɹ
+	// [事件] 玩家技能释放成功
 	UFUNCTION(BlueprintImplementableEvent, Category = "Skill Events")
 	void OnSkillCasted(ESkillType SkillType, const FSkillConfig& Config);
 
-	// [¼] AIͷż
-	// CasterAI: ʩAIAI1AI2
-	// SkillType: 
-	// TargetType: ĿͣSelf=Լ, Enemy=ˣ
-	// TargetAI: Ǽ漼ܣĿAI˭AI1AI2Ŀ˲Ч
-	// bTargetIsPlayer: Ǽ漼ܣĿǷңtrue=, false=һAI
+	// [事件] AI释放技能
+	// CasterAI: 施法的AI编号（从 0 开始，AI i 为龙舟 i + 1）
+	// SkillType: 技能类型
+	// TargetType: 目标类型（Self=增益给自己, Enemy=减益给敌人）
+	// TargetAI: 目标AI编号（增益为施法者自己；目标是玩家时为 -1）
+	// bTargetIsPlayer: 如果是减益技能，目标是否是玩家（true=玩家, false=另一个AI）
 	UFUNCTION(BlueprintImplementableEvent, Category = "Skill Events")
+	void OnAIBoatSkillCasted(int32 CasterAI, ESkillType SkillType, ESkillTargetType TargetType,
+		int32 TargetAI, bool bTargetIsPlayer, const FSkillConfig& Config);
+
+	// [事件] 已弃用：只能表示 AI1/AI2，之后的AI施法时不触发，改用 OnAIBoatSkillCasted
+	UFUNCTION(BlueprintImplementableEvent, Category = "Skill Events", meta = (DeprecatedFunction, DeprecationMessage = "Use OnAIBoatSkillCasted, which reports AI boats by index."))
 	void OnAISkillCasted(EAIBoatIndex CasterAI, ESkillType SkillType, ESkillTargetType TargetType, 
 		EAIBoatIndex TargetAI, bool bTargetIsPlayer, const FSkillConfig& Config);
 
-	// ========== Ѷϵͳ¼ ==========
+	// [事件] AI减益被目标的空城计免疫（不触发 OnAIBoatSkillCasted，参数含义相同）
+	UFUNCTION(BlueprintImplementableEvent, Category = "Skill Events")
+	void OnAISkillBlocked(int32 CasterAI, ESkillType SkillType, int32 TargetAI, bool bTargetIsPlayer);
+
+	// [事件] AI三消模拟的一批结果交回游戏线程（AI三消模式下；AI 为AI编号）
+	// SpeedUpHits / SlowDownHits: 这批交换中AI消除的加速/减速格子数
+	UFUNCTION(BlueprintImplementableEvent, Category = "Skill Events")
+	void OnAIMatch3Batch(int32 AI, int32 MovesPlayed, int32 ClearedTiles, int32 SpeedUpHits, int32 SlowDownHits);
 
-	// [¼] Ѹ£UIҪˢʾ
+	// ========== 难度系统事件 ==========
+
+	// [事件] 特殊格子配置已更新（UI需要刷新特殊格子显示）
 	UFUNCTION(BlueprintImplementableEvent, Category = "Difficulty Events")
 	void OnSpecialAreasUpdated();
 
+protected:
+	// ========== 网络 RPC ==========
+
+	// 客户端请求交换：服务器只接受空闲状态下相邻且有效的交换，否则通知客户端播放失败动画
+	UFUNCTION(Server, Reliable)
+	void Server_RequestSwap(uint8 IndexA, uint8 IndexB);
+
+	UFUNCTION(Server, Reliable)
+	void Server_CastSkill(uint8 SlotIndex);
+
+	// 客户端失去同步：服务器在下一帧刷新关键帧
+	UFUNCTION(Server, Reliable)
+	void Server_RequestKeyframe();
+
+	// 服务器每帧把这一帧内棋盘的全部改变合并为一条消息发给所有客户端（序号连续）
+	// 不可靠发送：丢失的消息由序号检测，客户端从关键帧重新同步，不阻塞之后的消息
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multicast_ApplyBoardDelta(int32 Sequence, const TArray<uint8>& Delta);
+
+	UFUNCTION(Client, Reliable)
+	void Client_SwapRejected(uint8 IndexA, uint8 IndexB);
+
+	UFUNCTION(Client, Reliable)
+	void Client_SkillCasted(ESkillType SkillType, const FSkillConfig& Config);
+
+	UFUNCTION()
+	void OnRep_BoardKeyframe();
+
 private:
-	// Խ
+	// 尝试交换两个方块
 	bool TrySwap(int32 IndexA, int32 IndexB);
+
+	// 点击选中两个相邻格子后：服务器直接交换，客户端先在本地棋盘上判断，有效时请求服务器交换
+	void RequestSwap(int32 IndexA, int32 IndexB);
+
+	// 推进棋盘流程（服务器与单机；客户端的 AdvanceGameState 只结束本地播放的动画）
+	void AdvanceBoardState();
 	
-	// ʼ
+	// 开始交换
 	void StartSwap(int32 IndexA, int32 IndexB);
 	
-	// ƥ
+	// 检查匹配
 	void ProcessMatchCheck();
+
+	// 执行一步消除：查找匹配、结算效果与士气、清空方块，结果写入 OutStep（复用其数组容量）；没有匹配时返回 false
+	bool ResolveMatchStep(FMatch3StepResult& OutStep);
+
+	// 结算并清空匹配的格子（先横向匹配行优先，再仅属纵向匹配的格子列优先展开索引）
+	void ClearMatchedCells(uint64 HorizontalMatches, uint64 VerticalMatches, FMatch3StepResult& OutStep);
+
+	// 服务器（单机）：把本步的士气值加到棋盘并触发龙舟竞速效果
+	void ApplyStepRewards(FMatch3StepResult& Step);
+
+	// 客户端：只预测本步之后的士气值与技能点（填入结果供UI显示），不改变状态、不触发效果
+	void PredictStepRewards(FMatch3StepResult& Step);
+
+	// 逐步模式：进入消除动画状态并派发本步的事件（结果在 LastStepResult 中）
+	void DispatchClearingStep();
+
+	// 一次性结算模式：把 CascadeStepResult 移入时间线的新步骤并派发原生事件，返回该步骤（随后写入下落）
+	FCascadeStep& AddTimelineStep();
+
+	// 一次性结算模式：开始一条新的时间线（回收上一条的步骤）/ 棋盘稳定后交给UI
+	void BeginTimeline(int32 IndexA, int32 IndexB);
+	void FinishTimeline();
+
+	// 通知士气值 / 技能点变化（合并事件模式下消除步骤内不通知）
+	void NotifyMoraleChanged(int32 AddedAmount);
+	void NotifySkillPointChanged();
+
+	// 棋盘稳定后更新可交换索引，死锁时洗牌；返回是否洗牌
+	bool SettleBoard();
+
+	// 一次性结算模式：同步结算整条连消链并生成时间线
+	void ResolveCascade(int32 IndexA, int32 IndexB);
 	
-	// ԭ
+	// 还原交换
 	void RevertSwap(int32 IndexA, int32 IndexB);
 	
-	// жǷ
+	// 判断两个索引是否相邻
 	bool IsAdjacent(int32 IndexA, int32 IndexB) const;
 	
-	// жǷЧ
+	// 判断索引是否有效
 	bool IsValidIndex(int32 Index) const;
 	
-	// Ƿƥ
+	// 检查是否有匹配
 	bool HasMatch();
+
+	// 局部检查：只扫描经过脏格子的行与列
+	bool HasLocalMatch(const FMatch3Board& InBoard, uint64 DirtyMask);
+
+	// 局部查找匹配：只扫描经过脏格子的行与列
+	void FindLocalMatches(uint64 DirtyMask, uint64& OutHorizontal, uint64& OutVertical);
 	
-	// ո
-	TArray<FFallMove> FillEmptyTiles();
+	// 填充空格子，下落移动写入 OutFallMoves（复用其容量）
+	void FillEmptyTiles(TArray<FFallMove>& OutFallMoves);
 	
-	// ռЧ
-	TArray<FSpecialEffectData> CollectSpecialEffects(const TArray<int32>& ClearedIndices);
+	// 收集特殊效果，写入 OutEffects（按效果类型顺序，每种效果一次 与运算 + popcount，复用回收的索引数组）
+	void CollectSpecialEffects(uint64 ClearedMask, TArray<FSpecialEffectData>& OutEffects);
+
+	// 将效果数据放回回收池（保留 TriggerIndices 的容量）并清空数组
+	void RecycleSpecialEffects(TArray<FSpecialEffectData>& Effects);
+
+	// 预分配消除路径的缓冲区，之后的交换 -> 消除 -> 下落 -> 连消检查不再分配堆内存
+	void ReserveMatchBuffers();
 	
-	// ʿֵ
-	int32 CalculateMoraleReward(int32 TileCount, const TArray<FSpecialEffectData>& TriggeredEffects);
+	// 计算士气值奖励（特殊格子数直接由消除掩码统计）
+	int32 CalculateMoraleReward(uint64 ClearedMask);
 
-	// 鲢תʿֵΪܵ
-	void CheckMoraleToSkillPoint();
+	// 当前士气值配置（由蓝图可编辑的属性组成）
+	FMatch3MoraleConfig GetMoraleConfig() const;
 
-	// 
+	// 生成棋盘
 	void GenerateBoard();
+
+	// 死锁洗牌：重新排列现有方块
+	void ReshuffleBoard();
 	
-	// Ƿпƶ
+	// 检查是否有可用移动
 	bool HasAnyValidMove();
 
-	// ۾Чڲʹã
-	void TriggerRaceEffects(const TArray<FSpecialEffectData>& TriggeredEffects);
+	// 触发龙舟竞速效果（内部使用，触发次数已由消除掩码统计）
+	void TriggerRaceEffects(const FMatch3StepResult& Step);
 
-	// AIͷTimer
+	// AI技能释放Timer：释放所有到期的AI并各自重新调度
 	void TriggerAISkill();
 
-	// һAIͷ
-	void ScheduleNextAISkill();
+	// 指定AI释放一个随机装备的技能，没有可用技能时返回 false
+	bool CastAISkill(int32 CasterIndex);
+
+	// AI三消：开始模拟 / 每帧收取结果、释放技能并派发下一批 / 等待工作线程结束
+	void StartAIMatch3();
+	void TickAIMatch3(float DeltaTime);
+	void WaitForAIMatch3();
 
-	// ȡܵĿ
+	// 收取一条AI已完成的一批结果并通知
+	void CollectAIMatch3Batch(int32 BoatIndex);
+
+	// 保存检查点后把一批交换派发到工作线程
+	void LaunchAIMatch3Batch(int32 BoatIndex, int32 NumMoves);
+
+	// 按随机间隔调度指定AI的下一次技能释放 / 把计时器对准最早的一次释放
+	void ScheduleNextAISkill(int32 CasterIndex, double Now);
+	void ArmAISkillTimer();
+
+	// 获取技能的目标类型
 	ESkillTargetType GetSkillTargetType(ESkillType SkillType) const;
 
-	// AIܣÿʱã
+	// 随机配置AI技能（当启用每局随机时调用）
 	void RandomizeAISkills();
-	
-	// 
+
+	// 施法者装备的技能（AI 比 AIEquippedSkills 多时循环使用），没有配置时返回 nullptr
+	const FAISkillLoadout* GetAISkillLoadout(int32 CasterIndex) const;
+
+	// 把已弃用的 AI1_/AI2_EquippedSkills 移入 AIEquippedSkills
+	void MigrateDeprecatedAISkills();
+
+	// 将位棋盘同步到 OrbGrid（供蓝图读取）
+	void SyncOrbGridFromBoard();
+
+	// 将 SpecialAreaGrid 同步到三消核心
+	void SyncSpecialAreasToCore();
+
+	// 由比赛种子为每个随机流派生种子（不重新生成棋盘）
+	void InitRandomStreams(int32 RaceSeed);
+
+	// 获取随机流
+	FRandomStream& GetRandomStream(ERandomStreamType StreamType);
+	const FRandomStream& GetRandomStream(ERandomStreamType StreamType) const;
+
+	// 三消核心：位棋盘 + 可交换索引 + 特殊格子（逻辑数据源，OrbGrid 为其镜像）
+	FMatch3Game Match3;
+
+	// ========== 消除路径复用的缓冲区 ==========
+
+	// 正在结算的消除步骤内（合并事件模式与一次性结算下推迟士气/技能点/效果事件）
+	bool bResolvingStep;
+
+	// 本步的士气/技能点/效果事件由汇总事件交付：合并事件模式为 OnMatchStepResolved，一次性结算为 OnCascadeResolved
+	bool ShouldDeferStepEvents() const
+	{
+		return bResolvingStep && (bCoalesceStepEvents || GameState == EMatch3State::PlayingTimeline);
+	}
+
+	// 一次性结算模式下每步的结算缓冲（数组与时间线步骤交换，不复制）
+	FMatch3StepResult CascadeStepResult;
+
+	// 回收的效果数据（TriggerIndices 保留容量，下次分组时直接复用）
+	TArray<FSpecialEffectData, TInlineAllocator<FMatch3SpecialAreas::NumEffectTypes>> EffectDataPool;
+
+	// 回收的时间线步骤（各数组保留容量，下次一次性结算时直接复用）
+	TArray<FCascadeStep> CascadeStepPool;
+
+	// 待交换的索引
 	int32 PendingSwapIndexA;
 	int32 PendingSwapIndexB;
 
-	// AITimer
+	// 交换提示的排名（可分帧评估，棋盘改变后自动重新开始）
+	TMatch3MoveRanker<FMatch3Game> HintRanker;
+
+	// 逐步模式下当前交换已结算的连消步数（棋盘稳定时写入 Insights 计数器）
+	int32 CurrentCascadeDepth;
+
+	// AI技能Timer句柄（总是对准 AISkillScheduler 中最早的一次释放）
 	FTimerHandle AISkillTimerHandle;
+
+	// 每条AI的下次释放时间（世界时间，按AI编号索引）；AI三消模式下为冷却结束的时间，有技能点时才调度
+	FRaceSkillScheduler AISkillScheduler;
+
+	// 最近一次排名与超越记录（龙舟索引：0 为玩家，AI i 为龙舟 i + 1）
+	FRaceSkillTargeting AISkillTargeting;
+
+	// 一条AI龙舟的三消模拟
+	struct FAIMatch3Boat
+	{
+		TUniquePtr<FMatch3AIPlayer> Player;				// 只在没有进行中的任务时由游戏线程访问
+		UE::Tasks::TTask<FMatch3AIBatchResult> Task;	// 进行中的一批模拟
+		float MoveBudget;		// 累积的应执行交换数
+		float BatchTimer;		// 距上次派发的时间
+		int32 PendingSkillPoints;
+		int32 PendingLockCells;	// 等到没有进行中的任务时执行：>0 锁定格子数，<0 解除锁定
+		int32 BatchMoves;		// 进行中的一批的交换数；从快照恢复时为待重新派发的一批
+		FMatch3AIPlayer::FCheckpoint Checkpoint;	// 进行中的一批派发前的AI棋盘（快照不等待工作线程）
+
+		FAIMatch3Boat()
+			: MoveBudget(0.0f), BatchTimer(0.0f), PendingSkillPoints(0), PendingLockCells(0), BatchMoves(0)
+		{}
+	};
+
+	// 快照中本Actor的部分：ReadSnapshot 读入，ApplySnapshot 应用（恢复失败时当前状态不变）
+	struct FSnapshotState
+	{
+		struct FAIBoat
+		{
+			FMatch3AIPlayer::FCheckpoint Player;
+			int32 BatchMoves;
+			float MoveBudget;
+			float BatchTimer;
+			int32 PendingSkillPoints;
+			int32 PendingLockCells;
+		};
+
+		FMatch3Game Match3;
+		EMatch3State GameState;
+		int32 CascadeDepth;
+		FMatch3MoraleState Morale;
+		FRandomStream Streams[(int32)ERandomStreamType::AIMatch3 + 1];
+		float AISkillIntervalMin;
+		float AISkillIntervalMax;
+		FRaceSkillScheduler Scheduler;
+		FRaceSkillTargeting Targeting;
+		bool bAIMatch3Running;
+		TArray<FAIBoat> AIBoats;
+	};
+	FSnapshotState PendingSnapshot;
+
+	// AI施法者数上限（HumanControlledAIMask 的位数）
+	static constexpr int32 MaxAIBoats = 32;
+
+	// 每条AI的三消模拟（按AI编号索引，StartAISkillSystem 时按龙舟数分配）
+	TArray<FAIMatch3Boat> AIMatch3Boats;
+	bool bAIMatch3Running;
+
+	// 随机流：棋盘生成与洗牌 / 下落补充 / AI施法与目标选择 / AI释放间隔 / AI棋盘种子
+	FRandomStream BoardStream;
+	FRandomStream RefillStream;
+	FRandomStream AISkillStream;
+	FRandomStream AIIntervalStream;
+	FRandomStream AIMatch3Stream;
+
+	// 比赛模拟（检查空城计免疫；未设置时不检查）
+	TWeakObjectPtr<URaceSimulationComponent> RaceSimulation;
+	FDelegateHandle RaceStatusChangedHandle;
+
+	// 比赛模拟的状态效果变化（铁索连环 -> 锁定格子）
+	void HandleRaceStatusChanged(int32 BoatIndex, ERaceStatusEffect Status, bool bActive);
+
+	// 比赛录像：待写数据超过 ReplayFlushBytes 时在 Tick 中追加到文件
+	static constexpr int32 ReplayFlushBytes = 1024;
+	FRaceReplayWriter ReplayRecorder;
+	TUniquePtr<FArchive> ReplayArchive;
+
+	// 棋盘稳定时写入玩家棋盘的校验值（回放据此检查是否复现）
+	void RecordReplayChecksum();
+
+	// 把待写数据追加到录像文件
+	void FlushReplay();
+
+	// ========== 棋盘同步 ==========
+
+	// 服务器（有客户端连接的网络模式）记录棋盘改变
+	bool ShouldRecordNetDelta() const;
+
+	// 记录完整棋盘（初始化、洗牌、快照恢复），并在本帧结束时刷新关键帧属性
+	void RecordNetKeyframe(bool bReshuffle);
+
+	// 服务器每帧：发送本帧的改变，需要时刷新关键帧属性
+	void FlushNetDelta(float DeltaTime);
+	void RefreshNetKeyframe();
+
+	// 客户端：按顺序应用一条消息中的操作并播放对应的事件，返回校验值是否一致
+	bool ApplyBoardDelta(const TArray<uint8>& Delta);
+	void ApplyNetKeyframe(bool bReshuffle, uint8 HostState);
+	void ApplyNetLocked(uint64 LockedMask);
+	void ApplyNetMorale(const FMatch3MoraleState& Morale);
+	void ApplyNetSettle();
+
+	// 客户端失去同步：停止应用增量消息，拥有者请求关键帧
+	void HandleNetDesync(const TCHAR* Reason);
+
+	// 关键帧（服务器写，客户端在 OnRep 中应用）
+	UPROPERTY(ReplicatedUsing = OnRep_BoardKeyframe)
+	FBoardNetKeyframe BoardKeyframe;
+
+	// 服务器：待发送的改变 / 关键帧消息的写入器
+	FMatch3NetDeltaWriter NetDelta;
+	FMatch3NetDeltaWriter NetKeyframeWriter;
+
+	// 服务器：最后发送的消息序号；客户端：最后应用的消息序号
+	int32 NetSequence;
+
+	// 服务器：距上次刷新关键帧的时间 / 下一帧刷新关键帧
+	float NetKeyframeTimer;
+	bool bNetKeyframeRequested;
+
+	// 客户端：已经从关键帧开始同步 / 正在接收一次性结算的时间线 / 已发送交换请求，等待结果
+	bool bNetSynced;
+	bool bNetTimelineOpen;
+	bool bAwaitingSwapResult;
+
+	// 客户端：本条消息中消除预测的士气值与技能点，以及累计的士气值奖励（收到 Morale 操作时以服务器的值为准）
+	FMatch3MoraleState NetPredictedMorale;
+	int32 NetPredictedMoraleReward;
+
+	// 由玩家控制的AI龙舟（按AI编号的位）
+	uint32 HumanControlledAIMask;
+
+	bool IsAIHumanControlled(int32 AIIndex) const { return (HumanControlledAIMask & (1u << AIIndex)) != 0; }
+
+	// 本局棋盘同步统计
+	struct FNetReplicationStats
+	{
+		int32 SwapRequests;			// 服务器收到的交换请求
+		int32 RejectedSwaps;		// 服务器拒绝的交换请求
+		int32 Swaps;				// 服务器执行的有效交换
+		int32 KeyframeUpdates;		// 关键帧属性刷新次数
+		int64 KeyframeBytes;		// 关键帧属性的字节数
+		int32 OversizedDeltas;		// 超过大小上限、由关键帧代替的增量消息
+		int32 ReceivedMessages;		// 客户端收到的增量消息
+		int64 ReceivedBytes;		// 客户端收到的字节数
+		int32 Desyncs;				// 客户端失去同步的次数
+
+		FNetReplicationStats()
+			: SwapRequests(0)
+			, RejectedSwaps(0)
+			, Swaps(0)
+			, KeyframeUpdates(0)
+			, KeyframeBytes(0)
+			, OversizedDeltas(0)
+			, ReceivedMessages(0)
+			, ReceivedBytes(0)
+			, Desyncs(0)
+		{}
+	};
+	FNetReplicationStats NetStats;
+
+	// 局部匹配检查统计（调试模式下与全盘扫描对比）
+	struct FMatchCheckStats
+	{
+		int32 NumChecks;			// 检查次数
+		int32 NumMismatches;		// 局部结果与全盘结果不一致的次数
+		int64 LocalRunStarts;		// 局部检查的3连起点总数
+		int64 FullRunStarts;		// 全盘扫描的3连起点总数
+		uint64 LocalCycles;			// 局部检查耗时
+		uint64 FullCycles;			// 全盘扫描耗时
+
+		FMatchCheckStats()
+			: NumChecks(0)
+			, NumMismatches(0)
+			, LocalRunStarts(0)
+			, FullRunStarts(0)
+			, LocalCycles(0)
+			, FullCycles(0)
+		{}
+
+		void Record(uint64 DirtyMask, uint64 InLocalCycles, uint64 InFullCycles, bool bMatchesFullScan);
+		void Log(const TCHAR* Label) const;
+	};
+
+	// 交换验证（TrySwap）的统计
+	FMatchCheckStats SwapCheckStats;
+
+	// 每一步消除检查（ProcessMatchCheck，含连消）的统计
+	FMatchCheckStats CascadeCheckStats;
 };
 
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DragonBoatGameMode.h"
+#include "Match3SpecialAreas.h"
+#include "DifficultyTable.generated.h"
+
+// 预编译的掩码直接对应 7x7 棋盘的 64 位掩码
+static_assert(std::is_same_v<FMatch3Board::FMask, uint64>, "FCompiledDifficulty stores FMatch3Board masks as uint64");
+
+// 预编译的难度配置：特殊格子布局已转换为每种效果一个掩码，应用时直接复制
+USTRUCT()
+struct FCompiledDifficulty
+{
+	GENERATED_BODY()
+
+	// 该难度是否已配置
+	UPROPERTY()
+	bool bValid;
+
+	UPROPERTY()
+	float AISkillIntervalMin;
+
+	UPROPERTY()
+	float AISkillIntervalMax;
+
+	// 每种效果所在的格子（下标与 EMatch3Effect 一致，下标0即 None 不使用）
+	UPROPERTY()
+	uint64 EffectMasks[4];
+
+	FCompiledDifficulty()
+		: bValid(false)
+		, AISkillIntervalMin(10.0f)
+		, AISkillIntervalMax(20.0f)
+	{
+		static_assert(UE_ARRAY_COUNT(EffectMasks) == FMatch3SpecialAreas::NumEffectTypes, "EffectMasks must cover every EMatch3Effect");
+		for (uint64& Mask : EffectMasks)
+		{
+			Mask = 0;
+		}
+	}
+
+	// 展开为三消核心的特殊格子布局（只复制掩码）
+	FMatch3SpecialAreas GetSpecialAreas() const
+	{
+		FMatch3SpecialAreas SpecialAreas;
+		for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+		{
+			SpecialAreas.SetEffectMask((EMatch3Effect)Type, EffectMasks[Type]);
+		}
+		return SpecialAreas;
+	}
+
+	// 特殊格子总数
+	int32 NumSpecialAreas() const
+	{
+		int32 Count = 0;
+		for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+		{
+			Count += FMatch3Bits::Count(EffectMasks[Type]);
+		}
+		return Count;
+	}
+};
+
+/**
+ * 难度表 - 编辑器中按难度填写 FDifficultyConfig（索引/类型列表），保存时预编译为掩码
+ * 烘焙后只保留预编译结果：运行时按难度下标直接取用，切换难度不做任何解析或容器重建
+ * 未指定资产时使用类默认对象（内置的五档默认难度）
+ */
+UCLASS(BlueprintType)
+class DRAGONBOAT_API UDifficultyTable : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UDifficultyTable();
+
+#if WITH_EDITORONLY_DATA
+	// 难度配置（仅编辑器，保存时编译到 CompiledLevels）
+	UPROPERTY(EditAnywhere, Category = "Difficulty")
+	TMap<EDifficultyLevel, FDifficultyConfig> Configs;
+#endif
+
+	// 查找某个难度的预编译配置（未配置时返回 nullptr）
+	const FCompiledDifficulty* Find(EDifficultyLevel Level) const
+	{
+		const int32 LevelIndex = (int32)Level;
+		return CompiledLevels.IsValidIndex(LevelIndex) && CompiledLevels[LevelIndex].bValid ? &CompiledLevels[LevelIndex] : nullptr;
+	}
+
+#if WITH_EDITOR
+	virtual void PostLoad() override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+#if WITH_EDITOR
+	// 将 Configs 编译为 CompiledLevels
+	void CompileConfigs();
+#endif
+
+	// 按 EDifficultyLevel 下标存放的预编译配置
+	UPROPERTY()
+	TArray<FCompiledDifficulty> CompiledLevels;
+};
@@ -4,21 +4,25 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
-#include "Datamanagement.h"  // Ҫʹ ESlotEffectType
+#include "Datamanagement.h"  // 需要引用完整定义以使用 ESlotEffectType
+#include "RaceBoatRegistry.h"
+#include "RaceSimulationComponent.h"  // ERaceStatusEffect
 #include "DragonBoatGameMode.generated.h"
 
-// Ϸ״̬ö
+class UDifficultyTable;
+
+// 游戏状态枚举
 UENUM(BlueprintType)
 enum class ERaceGameState : uint8
 {
-	PreRace		UMETA(DisplayName = "Pre-Race"),		// ׼׶Σʱ
-	Racing		UMETA(DisplayName = "Racing"),			// 
-	Paused		UMETA(DisplayName = "Paused"),			// ͣ
-	Finished	UMETA(DisplayName = "Finished"),		// 
-	PostRace	UMETA(DisplayName = "Post-Race")		// ׶
+	PreRace		UMETA(DisplayName = "Pre-Race"),		// 准备阶段（倒计时）
+	Racing		UMETA(DisplayName = "Racing"),			// 比赛进行中
+	Paused		UMETA(DisplayName = "Paused"),			// 暂停
+	Finished	UMETA(DisplayName = "Finished"),		// 比赛结束
+	PostRace	UMETA(DisplayName = "Post-Race")		// 结算阶段
 };
 
-// Ѷȵȼö
+// 难度等级枚举
 UENUM(BlueprintType)
 enum class EDifficultyLevel : uint8
 {
@@ -29,25 +33,25 @@ enum class EDifficultyLevel : uint8
 	Hell		UMETA(DisplayName = "Hell")
 };
 
-// Ѷ
+// 难度配置数据（在 UDifficultyTable 中编辑，保存时预编译为掩码）
 USTRUCT(BlueprintType)
 struct FDifficultyConfig
 {
 	GENERATED_BODY()
 
-	// AI ͷż
+	// AI 技能释放间隔
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Behavior")
 	float AISkillIntervalMin;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI Behavior")
 	float AISkillIntervalMax;
 
-	// 
+	// 特殊格子配置
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Special Areas")
-	TArray<int32> SpecialAreaIndices;  // ӵб
+	TArray<int32> SpecialAreaIndices;  // 特殊格子的索引列表
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Special Areas")
-	TArray<ESlotEffectType> SpecialAreaTypes;  // ӦЧ
+	TArray<ESlotEffectType> SpecialAreaTypes;  // 对应的效果类型
 
 	FDifficultyConfig()
 		: AISkillIntervalMin(10.0f)
@@ -55,23 +59,23 @@ struct FDifficultyConfig
 	{}
 };
 
-// սͼã
+// 最终结果（蓝图可用）
 USTRUCT(BlueprintType)
 struct FBoatFinalResult
 {
 	GENERATED_BODY()
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race Result")
-	int32 BoatIndex;  // 0=, 1=AI1, 2=AI2
+	int32 BoatIndex;  // RaceBoats 中的索引（0=玩家）
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race Result")
-	int32 FinalRank;  // 
+	int32 FinalRank;  // 最终排名
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race Result")
-	float FinishTime;  // ʱ
+	float FinishTime;  // 完成时间
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race Result")
-	bool bIsPlayer;  // Ƿ
+	bool bIsPlayer;  // 是否是玩家
 
 	FBoatFinalResult()
 		: BoatIndex(0), FinalRank(1), FinishTime(0.0f), bIsPlayer(false)
@@ -79,7 +83,7 @@ struct FBoatFinalResult
 };
 
 /**
- * ۾GameMode - Ϸ״̬ȼ㡢ͳ
+ * 龙舟竞速GameMode - 负责游戏状态管理、进度计算、排名统计
  */
 UCLASS()
 class DRAGONBOAT_API ADragonBoatGameMode : public AGameModeBase
@@ -91,63 +95,119 @@ public:
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	virtual void Tick(float DeltaTime) override;
 
-	// ========== ò ==========
+	// 第一位玩家拥有场景中的棋盘，双人对战时第二位玩家拥有新生成的棋盘
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+
+	// 第二位玩家离开后，龙舟1交还给AI
+	virtual void Logout(AController* Exiting) override;
+
+	// ========== 配置参数 ==========
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
+	float RaceTrackLength;  // 赛道总长度（UE单位）
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
+	FVector StartLinePosition;  // 起点位置
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
-	float RaceTrackLength;  // ܳȣUEλ
+	FVector FinishLinePosition;  // 终点位置
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
-	FVector StartLinePosition;  // λ
+	float CountdownDuration;  // 倒计时时长（秒）
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
-	FVector FinishLinePosition;  // յλ
+	float ProgressUpdateInterval;  // 进度更新间隔（秒，如0.1或0.2）
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
-	float CountdownDuration;  // ʱʱ룩
+	float RaceEndDelay;  // 第一名完成后延迟X秒结束比赛
 
+	// 比赛随机种子（0表示每局随机）；固定种子 + 相同输入可完整复现一局，用于性能测试与问题复现
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
-	float ProgressUpdateInterval;  // ȸ¼룬0.10.2
+	int32 RaceSeed;
 
+	// 录制每局比赛到 Saved/Replays（几KB的二进制录像），可用 ADatamanagement::Debug_PlayReplay 或 DragonBoatBench -Replay= 无头回放
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Config")
-	float RaceEndDelay;  // һɺӳX
+	bool bRecordReplay;
+
+	// ========== 双人对战 ==========
+
+	// 第二位加入的玩家控制一块新棋盘，驾驶 AI1 的龙舟（索引1）；棋盘由服务器模拟，按操作增量同步给客户端
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Head To Head")
+	bool bHeadToHead;
+
+	// 第二位玩家的棋盘类（为空时使用 ADatamanagement）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Head To Head")
+	TSubclassOf<ADatamanagement> HeadToHeadBoardClass;
+
+	// ========== 比赛快照 ==========
+
+	// 回滚缓冲保存的快照数（0表示关闭）；各帧复用已分配的数组，进行中的AI三消批次在保存时同步完成
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Snapshot", meta = (ClampMin = "0"))
+	int32 RollbackBufferFrames;
+
+	// 两次保存回滚帧的最小间隔（秒，0表示每帧保存）；双人对战不支持快照，不保存
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Snapshot", meta = (ClampMin = "0.0"))
+	float RollbackFrameInterval;
+
+	// 应用切到后台时暂停比赛并保存快照到 Saved/Snapshots（进程被系统结束后可调用 ResumeSuspendedRace 继续）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Snapshot")
+	bool bSuspendOnBackground;
 
-	// ========== ãͼã==========
+	// ========== 龙舟引用（蓝图配置）==========
 
+	// 参赛龙舟（索引0为玩家，数量不限）；为空时比赛开始时由下面三个引用组成
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Setup")
-	AActor* PlayerBoat;  // 
+	TArray<AActor*> RaceBoats;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Setup")
-	AActor* AIBoat1;  // AI1
+	AActor* PlayerBoat;  // 玩家龙舟
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Setup")
-	AActor* AIBoat2;  // AI2
+	AActor* AIBoat1;  // AI龙舟1
 
-	// ========== ʱ ==========
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Setup")
+	AActor* AIBoat2;  // AI龙舟2
+
+	// ========== 比赛模拟 ==========
+
+	// 龙舟速度由比赛模拟组件计算（固定步长），龙舟 Actor 跟随模拟位置；
+	// 关闭时退回为由龙舟蓝图自行移动，进度按 Actor 的X坐标计算
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Simulation")
+	bool bUseRaceSimulation;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Race Simulation")
+	TObjectPtr<URaceSimulationComponent> RaceSimulation;
+
+	// ========== 运行时数据 ==========
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race State")
 	ERaceGameState CurrentGameState;
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race State")
-	float CurrentRaceTime;  // ǰʱ
+	float CurrentRaceTime;  // 当前比赛时间
+
+	UPROPERTY(BlueprintReadOnly, Category = "Race State")
+	int32 FinishedBoatCount;  // 已完成的龙舟数量
 
 	UPROPERTY(BlueprintReadOnly, Category = "Race State")
-	int32 FinishedBoatCount;  // ɵ
+	int32 CurrentRaceSeed;  // 本局实际使用的随机种子（填入 RaceSeed 即可复现）
 
-	// ========== Ѷϵͳ ==========
+	// ========== 难度系统 ==========
 
-	// ǰѶȵȼ
+	// 当前难度等级
 	UPROPERTY(BlueprintReadOnly, Category = "Difficulty")
 	EDifficultyLevel CurrentDifficulty;
 
-	// Ѷñڱ༭ã
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Difficulty")
-	TMap<EDifficultyLevel, FDifficultyConfig> DifficultyConfigs;
+	// 难度表资产（首次应用难度时加载，为空时使用内置默认难度）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Difficulty")
+	TSoftObjectPtr<UDifficultyTable> DifficultyTable;
 
-	// ========== ӿ ==========
+	// ========== 公共接口 ==========
 
 	UFUNCTION(BlueprintCallable, Category = "Race Control")
 	void StartCountdown();
@@ -161,104 +221,185 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Race Control")
 	void ResumeRace();
 
-	// ȡ۵ǰ
+	// 获取龙舟当前排名
 	UFUNCTION(BlueprintPure, Category = "Race Query")
 	int32 GetBoatRank(int32 BoatIndex) const;
 
-	// ȡ۵ǰȣ0.0-1.0
+	// 获取龙舟当前进度（0.0-1.0）
 	UFUNCTION(BlueprintPure, Category = "Race Query")
 	float GetBoatProgress(int32 BoatIndex) const;
 
-	// ========== Ѷϵͳӿ ==========
+	// 参赛龙舟数量
+	UFUNCTION(BlueprintPure, Category = "Race Query")
+	int32 GetNumBoats() const;
+
+	// 获取排名第 Rank（从1开始）的龙舟索引，无效排名返回 -1
+	UFUNCTION(BlueprintPure, Category = "Race Query")
+	int32 GetBoatAtRank(int32 Rank) const;
+
+	// 比赛开始前登记一条龙舟，返回其索引（比赛进行中返回 -1）
+	UFUNCTION(BlueprintCallable, Category = "Race Setup")
+	int32 RegisterBoat(AActor* Boat);
 
-	// UIãϷѶ
+	// ========== 难度系统接口 ==========
+
+	// UI调用：设置游戏难度
 	UFUNCTION(BlueprintCallable, Category = "Difficulty")
 	void SetDifficulty(EDifficultyLevel Level);
 
-	// ========== ͼ¼ ==========
+	// 获取难度表（首次调用时同步加载）
+	const UDifficultyTable* GetDifficultyTable();
+
+	// ========== 比赛快照接口 ==========
+
+	/**
+	 * 保存整场比赛的快照（比赛进行中或暂停时）：计时、难度、登记表、比赛模拟与数据管理器（棋盘每格3位、士气、AI）
+	 * 写入 OutData 并保留其容量，同一个数组反复保存不分配堆内存；先等待并收取进行中的AI三消批次
+	 */
+	bool SaveRaceSnapshot(TArray<uint8>& OutData);
 
-	// [¼] ʱ£ÿ봥һΣ
+	// 恢复快照：比赛恢复为暂停状态，UI 整体重建（不播放动画），之后调用 ResumeRace 继续
+	// 数据无效或与关卡不符时返回 false，当前比赛不受影响
+	bool RestoreRaceSnapshot(const TArray<uint8>& Data);
+
+	// 回到 FramesAgo 帧之前的快照（0为最近一帧，帧间隔为 RollbackFrameInterval），之后的帧被丢弃；恢复为暂停状态
+	UFUNCTION(BlueprintCallable, Category = "Race Snapshot")
+	bool RollbackRace(int32 FramesAgo);
+
+	// 暂停比赛并把快照保存到 Saved/Snapshots
+	UFUNCTION(BlueprintCallable, Category = "Race Snapshot")
+	bool SuspendRace();
+
+	UFUNCTION(BlueprintPure, Category = "Race Snapshot")
+	bool HasSuspendedRace() const;
+
+	// 从保存的快照恢复比赛（恢复为暂停状态）并删除快照文件
+	UFUNCTION(BlueprintCallable, Category = "Race Snapshot")
+	bool ResumeSuspendedRace();
+
+	// 调试：连续保存 NumRuns 次快照，输出大小与每次的平均耗时
+	UFUNCTION(BlueprintCallable, Category = "Race Snapshot|Debug")
+	void Debug_BenchmarkSnapshot(int32 NumRuns = 1000);
+
+	// ========== 蓝图事件 ==========
+
+	// [事件] 倒计时更新（每秒触发一次）
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnCountdownTick(int32 RemainingSeconds);
 
-	// [¼] ʼ
+	// [事件] 比赛开始
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnRaceStarted();
 
-	// [¼] ȸ£ʱÿ֡
-	// BoatProgresses: [ҽ, AI1, AI2]
-	// BoatRanks: [, AI1, AI2]
+	// [事件] 进度更新（定时触发，不是每帧）
+	// BoatProgresses / BoatRanks: 按龙舟索引排列（0=玩家），直接引用登记表的数组
+	// 排名变化由 OnRankChanged 逐条通知
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnProgressUpdated(const TArray<float>& BoatProgresses, const TArray<int32>& BoatRanks);
 
-	// [¼] 仯ֻıʱ
+	// [事件] 排名变化（只在排名改变时触发）
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnRankChanged(int32 BoatIndex, int32 OldRank, int32 NewRank);
 
-	// [¼] ɱ
+	// [事件] 龙舟完成比赛
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnBoatFinished(int32 BoatIndex, float FinishTime, int32 FinalRank);
 
-	// [¼] 
+	// [事件] 比赛结束
 	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
 	void OnRaceFinished(const TArray<FBoatFinalResult>& FinalRankings);
 
-	// ========== Ѷϵͳ¼ ==========
+	// [事件] 龙舟状态效果开始 / 结束（技能与格子效果的持续时间由比赛模拟统一计时，蓝图只切换表现）
+	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
+	void OnBoatStatusChanged(int32 BoatIndex, ERaceStatusEffect Status, bool bActive);
+
+	// [事件] 比赛从快照恢复（棋盘、生效中的状态效果、进度与排名已重新通知，蓝图刷新计时等其余显示）
+	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
+	void OnRaceRestored();
+
+	// ========== 难度系统事件 ==========
 
-	// [¼] Ѷȱ仯֪֪ͨͨAIͼΪ
+	// [事件] 难度变化通知（通知AI龙舟蓝图调整行为）
 	UFUNCTION(BlueprintImplementableEvent, Category = "Difficulty Events")
 	void OnDifficultyChanged(EDifficultyLevel NewDifficulty);
 
 private:
-	// ʱݣڲʹã
-	struct FBoatRaceData
-	{
-		float CurrentProgress;		// ǰȣ0.0-1.0
-		int32 CurrentRank;			// ǰ1-3
-		float FinishTime;			// ʱ䣨-1ʾδɣ
-		bool bHasFinished;			// Ƿ
-
-		FBoatRaceData()
-			: CurrentProgress(0.0f)
-			, CurrentRank(1)
-			, FinishTime(-1.0f)
-			, bHasFinished(false)
-		{}
-	};
-
-	// ÿ۵
-	TArray<FBoatRaceData> BoatDataArray;
-
-	// Timer
+	// 每条龙舟的进度、排名与完成数据（结构数组，增量排名）
+	FRaceBoatRegistry BoatRegistry;
+
+	// Timer句柄
 	FTimerHandle CountdownTimerHandle;
 	FTimerHandle ProgressUpdateTimerHandle;
 	FTimerHandle RaceEndTimerHandle;
 
-	// ʱʣ
+	// 倒计时剩余秒数
 	int32 CountdownRemaining;
 
-	// ========== ڲ ==========
+	// 已加载的难度表（持有引用防止被回收）
+	UPROPERTY(Transient)
+	TObjectPtr<const UDifficultyTable> LoadedDifficultyTable;
+
+	// 场景中的数据管理器（首次查找后缓存）
+	TWeakObjectPtr<ADatamanagement> CachedDatamanagement;
+
+	// 双人对战中第二位玩家的棋盘（龙舟索引1）
+	TWeakObjectPtr<ADatamanagement> HeadToHeadBoard;
 
-	// ʱTick
+	// 回滚缓冲：环形数组，RollbackNewest 为最近一帧的位置
+	TArray<TArray<uint8>> RollbackSnapshots;
+	int32 RollbackNewest;
+	int32 RollbackCount;
+	float RollbackTimeSinceSave;
+
+	FDelegateHandle EnterBackgroundHandle;
+
+	// ========== 内部函数 ==========
+
+	// 倒计时Tick
 	void CountdownTick();
 
-	// ʱ½
+	// 定时更新进度
 	void UpdateProgress();
 
-	// 
+	// 更新排名
 	void UpdateRankings();
 
-	// ۵յ
-	void OnBoatReachedFinish(int32 BoatIndex);
+	// 龙舟到达终点
+	void OnBoatReachedFinish(int32 BoatIndex, float FinishTime);
+
+	// 比赛模拟的状态效果变化，转发为蓝图事件
+	void HandleBoatStatusChanged(int32 BoatIndex, ERaceStatusEffect Status, bool bActive);
 
-	// 
+	// 结束比赛
 	void EndRace();
 
-	// ========== Ѷϵͳڲ ==========
+	// RaceBoats 为空时由 PlayerBoat/AIBoat1/AIBoat2 组成
+	void GatherRaceBoats();
 
-	// ӦѶ
-	void ApplyDifficultySettings();
+	// 查找场景中的数据管理器（首次查找后缓存）
+	ADatamanagement* FindDatamanagement();
+
+	// 生成第二位玩家的棋盘并交给其 PlayerController
+	void SpawnHeadToHeadBoard(APlayerController* SecondPlayer);
+
+	// 把进度与排名写入 GameState（同步给客户端）
+	void ReplicateRaceStandings();
 
-	// ʼĬѶ
-	void InitializeDefaultDifficultyConfigs();
+	// ========== 比赛快照内部函数 ==========
+
+	// 把当前帧保存到回滚缓冲中最旧的位置（不等待AI三消批次）
+	void SaveRollbackFrame();
+
+	// 写入快照：进行中的AI三消批次记录为待重新派发（不等待工作线程）
+	bool WriteRaceSnapshot(TArray<uint8>& OutData);
+
+	// 应用切到后台
+	void HandleEnterBackground();
+
+	FString GetSuspendedRacePath() const;
+
+	// ========== 难度系统内部函数 ==========
+
+	// 应用难度配置
+	void ApplyDifficultySettings();
 };
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "DragonBoatGameState.generated.h"
+
+class FRaceBoatRegistry;
+
+/**
+ * 龙舟竞速GameState - 把比赛进度与排名同步给客户端（双人对战）
+ * GameMode 只存在于服务器，客户端的 UI 从这里读取进度与排名
+ * 进度按16位定点数同步（精度约为赛道长度的 1/65535），排名每条龙舟1字节；数组只在改变时由复制系统发送
+ */
+UCLASS()
+class DRAGONBOAT_API ADragonBoatGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	ADragonBoatGameState();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// GameMode调用（服务器，更新进度时）：从登记表复制进度与排名
+	void SetRaceStandings(const FRaceBoatRegistry& Registry);
+
+	// 获取龙舟当前进度（0.0-1.0）
+	UFUNCTION(BlueprintPure, Category = "Race Query")
+	float GetBoatProgress(int32 BoatIndex) const;
+
+	// 获取龙舟当前排名
+	UFUNCTION(BlueprintPure, Category = "Race Query")
+	int32 GetBoatRank(int32 BoatIndex) const;
+
+	// 参赛龙舟数量
+	UFUNCTION(BlueprintPure, Category = "Race Query")
+	int32 GetNumBoats() const { return BoatRanks.Num(); }
+
+	// [事件] 客户端收到新的进度与排名（服务器上由 GameMode 的 OnProgressUpdated 通知）
+	UFUNCTION(BlueprintImplementableEvent, Category = "Race Events")
+	void OnRaceStandingsReplicated();
+
+protected:
+	UFUNCTION()
+	void OnRep_RaceStandings();
+
+private:
+	// 按龙舟索引排列：进度 * 65535
+	UPROPERTY(ReplicatedUsing = OnRep_RaceStandings)
+	TArray<uint16> QuantizedProgress;
+
+	UPROPERTY(ReplicatedUsing = OnRep_RaceStandings)
+	TArray<uint8> BoatRanks;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Match3BalanceCommandlet.generated.h"
+
+/**
+ * 三消经济平衡模拟 - 按难度表（特殊格子布局、AI释放间隔）无头对局数百万局，结果写入 CSV
+ * 每局使用一块独立棋盘，按策略（与AI三消相同的 EMatch3AIPolicy）连续交换，多核并行且互不共享状态
+ *
+ * UnrealEditor-Cmd DragonBoat.uproject -run=Match3Balance [参数]
+ *   -Games=1000000					每个难度 x 策略的局数
+ *   -Moves=60						每局交换次数
+ *   -MovesPerMinute=20				玩家每分钟交换次数（换算技能点/分钟）
+ *   -Policy=Greedy,Random			交换策略（Random / Greedy / Mixed）
+ *   -GreedyChance=0.5				Mixed 策略下贪心选择的概率
+ *   -Difficulty=Easy,Hard			只模拟这些难度（默认全部）
+ *   -Seed=0						基础种子，同一种子下不同策略使用相同的棋盘
+ *   -DifficultyTable=<资产路径>		读取该难度表（默认为 GameMode 引用的难度表）
+ *   -GameMode=<类路径>				读取该 GameMode 蓝图引用的难度表（默认 ADragonBoatGameMode）
+ *   -Datamanagement=<类路径>		读取该蓝图的士气值配置（默认 ADatamanagement）
+ *   -Output=<文件>					CSV 路径（默认 Saved/Balance/Match3Balance.csv）
+ *   -SingleThread					单线程运行（对比多核加速比）
+ */
+UCLASS()
+class DRAGONBOAT_API UMatch3BalanceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMatch3BalanceCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/Widget.h"
+#include "Match3BoardWidget.generated.h"
+
+class ADatamanagement;
+class SMatch3Board;
+
+/**
+ * 三消棋盘控件 - UMG 包装 SMatch3Board，整块棋盘只有一个控件
+ * 代替 WBP_OneBoard / WBP_OnePlot / WBP_BoardAndSkill 中每个格子一个控件的做法：
+ * 不需要在 OnBoardInitialized / OnBoardReshuffle 中重建格子，也不需要蓝图播放下落动画后调用 AdvanceGameState
+ */
+UCLASS()
+class DRAGONBOAT_API UMatch3BoardWidget : public UWidget
+{
+	GENERATED_BODY()
+
+public:
+	UMatch3BoardWidget();
+
+	// 显示的棋盘（切换时直接显示当前棋盘，不播放动画）
+	UFUNCTION(BlueprintCallable, Category = "Match3 Board")
+	void SetBoard(ADatamanagement* InBoard);
+
+	UFUNCTION(BlueprintPure, Category = "Match3 Board")
+	ADatamanagement* GetBoard() const { return Board.Get(); }
+
+	// 是否还有动画在播放或排队
+	UFUNCTION(BlueprintPure, Category = "Match3 Board")
+	bool IsAnimating() const;
+
+	// ========== 外观 ==========
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush CellBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush RedTileBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush BlueTileBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush GreenTileBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush YellowTileBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush SpeedUpAreaBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush SlowDownAreaBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush MoraleBoostAreaBrush;
+
+	// 铁索连环锁定的格子（绘制在方块上面）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush LockedBrush;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateBrush SelectedBrush;
+
+	// 期望的格子边长（实际按控件大小缩放为正方形格子）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance", meta = (ClampMin = "1.0"))
+	float DesiredCellSize;
+
+	// 方块相对格子的内边距（格子边长的比例）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance", meta = (ClampMin = "0.0", ClampMax = "0.45"))
+	float TilePadding;
+
+	// ========== 动画 ==========
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "0.0"))
+	float SwapDuration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "0.0"))
+	float ClearDuration;
+
+	// 下落每一行的时长，一步下落的时长按落得最远的方块计算
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "0.0"))
+	float FallSecondsPerRow;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "0.0"))
+	float ReshuffleDuration;
+
+	// 每段动画播放完后调用 AdvanceGameState（只对开启 bUseNativeBoardWidget 的棋盘生效）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Behavior")
+	bool bDriveGameState;
+
+	// 没有调用 SetBoard 时自动显示本机操作的棋盘（放进 WBP_HUD 即可，不需要蓝图连线）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Behavior")
+	bool bBindLocalBoard;
+
+	// 点击与拖动交换方块（只显示对手的棋盘时关闭）
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Behavior")
+	bool bAcceptInput;
+
+	// ========== UWidget ==========
+
+	virtual void SynchronizeProperties() override;
+	virtual void ReleaseSlateResources(bool bReleaseChildren) override;
+
+#if WITH_EDITOR
+	virtual const FText GetPaletteCategory() override;
+#endif
+
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+
+private:
+	// 场景中本机操作的棋盘（单机为唯一的棋盘，双人对战为自己的棋盘）
+	ADatamanagement* FindLocalBoard() const;
+
+	TSharedPtr<SMatch3Board> MyBoard;
+	TWeakObjectPtr<ADatamanagement> Board;
+};
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Datamanagement.h"
+#include "RaceSimulation.h"
+#include "RaceSimulationComponent.generated.h"
+
+// 状态效果（与 ERaceStatus 一一对应）
+UENUM(BlueprintType)
+enum class ERaceStatusEffect : uint8
+{
+	SpeedBoost		UMETA(DisplayName = "Speed Boost"),		// 加速格子
+	SlowDown		UMETA(DisplayName = "Slow Down"),		// 减速格子
+	EastWind		UMETA(DisplayName = "East Wind"),		// 巧借东风
+	FloodSeven		UMETA(DisplayName = "Flood Seven"),		// 水淹七军（停船）
+	HeavyFog		UMETA(DisplayName = "Heavy Fog"),		// 大雾（棋盘）
+	IronChain		UMETA(DisplayName = "Iron Chain"),		// 铁索连环（棋盘）
+	EmptyCity		UMETA(DisplayName = "Empty City")		// 空城计（免疫）
+};
+
+// 状态效果开始 / 结束（每条龙舟每种效果只在状态变化时通知一次，刷新与叠加不重复通知）
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnRaceStatusChangedNative, int32 /*BoatIndex*/, ERaceStatusEffect /*Status*/, bool /*bActive*/);
+
+/**
+ * 比赛模拟组件 - 龙舟速度只在这里计算（固定步长的 FRaceSimulation），龙舟 Actor 每帧跟随模拟位置
+ * 订阅 ADatamanagement 的原生委托，把加速/减速格子与技能转换为状态效果（FRaceStatusEffects，由一个时间轮统一到期）；
+ * 空城计期间敌方减益被拒绝；龙舟与棋盘蓝图不再各自计时，只在 OnStatusChangedNative 时切换表现（特效、大雾遮挡）
+ *
+ * 龙舟索引与 ADragonBoatGameMode::RaceBoats 一致：0=玩家，1=AI1，2=AI2（双人对战时1为第二位玩家）
+ */
+UCLASS(ClassGroup = (DragonBoat), meta = (BlueprintSpawnableComponent))
+class DRAGONBOAT_API URaceSimulationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	URaceSimulationComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// ========== 配置 ==========
+
+	// 每秒模拟步数（固定步长 = 1 / StepsPerSecond）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Simulation", meta = (ClampMin = "10.0"))
+	float StepsPerSecond;
+
+	// 龙舟基础速度（UE单位/秒）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Simulation", meta = (ClampMin = "0.0"))
+	float BaseBoatSpeed;
+
+	// 每条龙舟基础速度的倍率（下标为龙舟索引，缺少时为1）
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Simulation")
+	TArray<float> BoatSpeedScales;
+
+	// 加速/减速格子效果的持续时间（秒），速度变化量为 ADatamanagement 的 SpeedBoostPerTrigger / SlowDownPerTrigger
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Simulation", meta = (ClampMin = "0.0"))
+	float TriggerEffectDuration;
+
+	// 每帧把龙舟 Actor 移动到模拟位置（两步之间插值）；关闭时只模拟，用于无头运行
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Race Simulation")
+	bool bDriveBoatActors;
+
+	// ========== 控制 ==========
+
+	// 开始模拟：赛道为起点到终点的线段，龙舟保持与赛道的横向偏移
+	UFUNCTION(BlueprintCallable, Category = "Race Simulation")
+	void StartSimulation(const TArray<AActor*>& Boats, FVector StartLine, FVector FinishLine);
+
+	UFUNCTION(BlueprintCallable, Category = "Race Simulation")
+	void SetSimulationPaused(bool bShouldPause);
+
+	UFUNCTION(BlueprintCallable, Category = "Race Simulation")
+	void StopSimulation();
+
+	// 订阅数据管理器的三消与技能事件（传入 nullptr 只取消订阅，同时取消所有玩家棋盘）
+	void BindToDatamanagement(ADatamanagement* DataMgmt);
+
+	// 双人对战：再订阅一块玩家棋盘，其消除与技能作用于它的 BoardBoatIndex（AI事件仍只来自主数据管理器）
+	void AddPlayerBoard(ADatamanagement* Board);
+
+	// ========== 输入（从下一步开始生效）==========
+
+	/**
+	 * 给龙舟施加状态效果 Duration 秒（加速/减速/东风的 Magnitude 为速度变化量）
+	 * @param SourceIndex 施加者龙舟（-1 表示非敌方来源，不检查空城计）
+	 * @return false 表示被空城计免疫（或比赛未开始、龙舟已完成）
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Race Simulation")
+	bool ApplyStatusEffect(int32 BoatIndex, ERaceStatusEffect Status, float Magnitude, float Duration, int32 SourceIndex = -1);
+
+	FOnRaceStatusChangedNative OnStatusChangedNative;
+
+	// ========== 查询 ==========
+
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	bool IsSimulationRunning() const { return bRunning; }
+
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	float GetSimTime() const { return Simulation.GetSimTime(); }
+
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	float GetBoatProgress(int32 BoatIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	float GetBoatSpeed(int32 BoatIndex) const;
+
+	// 完成时间（秒，-1 表示未完成）
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	float GetBoatFinishTime(int32 BoatIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	bool HasBoatStatus(int32 BoatIndex, ERaceStatusEffect Status) const;
+
+	// 剩余时间（秒，未生效时为0）
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	float GetBoatStatusRemaining(int32 BoatIndex, ERaceStatusEffect Status) const;
+
+	// 空城计生效中（敌方减益无效）
+	UFUNCTION(BlueprintPure, Category = "Race Simulation")
+	bool IsBoatImmune(int32 BoatIndex) const { return HasBoatStatus(BoatIndex, ERaceStatusEffect::EmptyCity); }
+
+	const FRaceSimulation& GetSimulation() const { return Simulation; }
+
+	// ========== 快照 ==========
+
+	// 写入模拟与每条龙舟已通知的效果掩码（只在模拟运行中调用）
+	void WriteSnapshot(FRaceSnapshotWriter& Writer) const;
+
+	// 读入模拟与已通知掩码的暂存，不修改正在进行的比赛；龙舟数与 NumBoats 不符时记录读取错误
+	void ReadSnapshot(FRaceSnapshotReader& Reader, int32 NumBoats);
+
+	/**
+	 * 整个快照读取成功后：按关卡中的龙舟重新开始（赛道与横向偏移），再用暂存的快照覆盖模拟；恢复后为暂停状态
+	 * 已通知掩码一并恢复，不广播效果开始（表现由调用方直接刷新）
+	 */
+	void ApplySnapshot(const TArray<AActor*>& Boats, FVector StartLine, FVector FinishLine);
+
+	// ========== 调试 ==========
+
+	// 调试：复制当前模拟并无头快进到比赛结束（不影响正在进行的比赛），输出完成时间与快进倍率
+	UFUNCTION(BlueprintCallable, Category = "Race Simulation|Debug")
+	void Debug_FastForwardRace(float MaxSeconds = 600.0f);
+
+private:
+	bool IsValidBoat(int32 BoatIndex) const { return BoatIndex >= 0 && BoatIndex < Simulation.Num(); }
+
+	// 对除 CasterIndex 以外的所有龙舟
+	template <typename FuncType>
+	void ForEachEnemy(int32 CasterIndex, FuncType&& Func)
+	{
+		for (int32 BoatIndex = 0; BoatIndex < Simulation.Num(); ++BoatIndex)
+		{
+			if (BoatIndex != CasterIndex)
+			{
+				Func(BoatIndex);
+			}
+		}
+	}
+
+	// 技能转换为状态效果（TargetIndex 为 INDEX_NONE 时减益作用于所有敌方龙舟）
+	void ApplySkill(int32 CasterIndex, ESkillType SkillType, const FSkillConfig& Config, int32 TargetIndex);
+
+	// 与上次通知时的生效掩码比较，广播开始 / 结束的效果
+	void NotifyStatusChanges();
+	void BroadcastStatusChanges(int32 BoatIndex, uint32 OldMask, uint32 NewMask);
+
+	// 数据管理器事件
+	void HandleStepResolved(const FMatch3StepResult& Step, int32 BoatIndex);
+	void HandleSkillCasted(ESkillType SkillType, const FSkillConfig& Config, int32 BoatIndex);
+	void HandleAISkillCasted(int32 CasterAI, ESkillType SkillType, ESkillTargetType TargetType,
+		int32 TargetAI, bool bTargetIsPlayer, const FSkillConfig& Config);
+	void HandleAIMatch3Batch(int32 AI, const FMatch3AIBatchResult& Batch);
+
+	// 把龙舟 Actor 移动到插值后的模拟位置
+	void UpdateBoatActors();
+
+	// 固定步长的速度模型
+	FRaceSimulation Simulation;
+
+	// 跟随模拟的龙舟 Actor 与各自相对赛道的横向偏移
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AActor>> BoatActors;
+	TArray<FVector> LaneOffsets;
+
+	// 每条龙舟上次通知时的生效掩码
+	TArray<uint32> NotifiedStatusMasks;
+
+	// ReadSnapshot 读入、ApplySnapshot 应用的快照
+	FRaceSimulation PendingSimulation;
+	TArray<uint32> PendingStatusMasks;
+
+	// 赛道起点与方向
+	FVector TrackStart;
+	FVector TrackDirection;
+
+	bool bRunning;
+	bool bPaused;
+
+	// 订阅的数据管理器（加速/减速数值在事件发生时读取）
+	TWeakObjectPtr<ADatamanagement> BoundDatamanagement;
+	FDelegateHandle StepResolvedHandle;
+	FDelegateHandle SkillCastedHandle;
+	FDelegateHandle AISkillCastedHandle;
+	FDelegateHandle AIMatch3BatchHandle;
+
+	// 双人对战时另外订阅的玩家棋盘
+	struct FPlayerBoardBinding
+	{
+		TWeakObjectPtr<ADatamanagement> Board;
+		FDelegateHandle StepResolvedHandle;
+		FDelegateHandle SkillCastedHandle;
+	};
+	TArray<FPlayerBoardBinding> PlayerBoards;
+};
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+#include "Styling/SlateBrush.h"
+#include "Datamanagement.h"
+
+// 棋盘的外观与动画时长（由 UMatch3BoardWidget 的属性复制而来）
+struct FMatch3BoardStyle
+{
+	FSlateBrush CellBrush;											// 格子底板
+	FSlateBrush TileBrushes[FMatch3Board::NumColors];				// 方块（按 ETileColor 顺序）
+	FSlateBrush SpecialAreaBrushes[FMatch3SpecialAreas::NumEffectTypes];	// 特殊格子标识（按 ESlotEffectType 顺序，None 不绘制）
+	FSlateBrush LockedBrush;										// 铁索连环锁定的格子
+	FSlateBrush SelectedBrush;										// 选中的格子
+
+	float DesiredCellSize;		// 期望的格子边长（实际按控件大小缩放为正方形格子）
+	float TilePadding;			// 方块相对格子的内边距（格子边长的比例）
+	float SwapDuration;			// 交换（失败时为来回）动画时长（秒）
+	float ClearDuration;		// 消除动画时长（秒）
+	float FallSecondsPerRow;	// 下落每一行的时长（秒），一步下落的时长按落得最远的方块计算
+	float ReshuffleDuration;	// 洗牌动画时长（秒）
+
+	FMatch3BoardStyle()
+		: DesiredCellSize(96.0f)
+		, TilePadding(0.06f)
+		, SwapDuration(0.15f)
+		, ClearDuration(0.2f)
+		, FallSecondsPerRow(0.06f)
+		, ReshuffleDuration(0.3f)
+	{}
+};
+
+/**
+ * 原生三消棋盘 - 一个叶子控件绘制整块棋盘：格子底板、特殊格子标识、方块、锁定与选中标记
+ * 每层使用同一个画刷，所有格子同一层的元素合批绘制（代替每个格子一个 UMG 控件）
+ *
+ * 直接读取 ADatamanagement 的数据并订阅其原生动画事件，按事件顺序排队播放交换、消除、下落与洗牌动画
+ * 显示中的方块颜色单独保存（动画播放时棋盘数据已经是结算后的状态），动画全部播放完且棋盘空闲时与棋盘数据对齐
+ * 动画队列与下落移动缓冲保留容量，预热后播放动画不分配堆内存；没有动画时不注册计时器，棋盘不变时不重绘
+ */
+class DRAGONBOAT_API SMatch3Board : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SMatch3Board)
+		: _bDriveGameState(true)
+		, _bAcceptInput(true)
+	{}
+		// 每段动画播放完后调用 AdvanceGameState（代替蓝图在动画结束时的回调）
+		SLATE_ARGUMENT(bool, bDriveGameState)
+
+		// 点击与拖动交换方块（对手的棋盘只显示时关闭）
+		SLATE_ARGUMENT(bool, bAcceptInput)
+	SLATE_END_ARGS()
+
+	SMatch3Board();
+	virtual ~SMatch3Board();
+
+	void Construct(const FArguments& InArgs);
+
+	// 显示的棋盘（为空时只绘制空白）；切换时取消未播放的动画，直接显示当前棋盘
+	void SetBoard(ADatamanagement* InBoard);
+
+	void SetStyle(const FMatch3BoardStyle& InStyle);
+	void SetDriveGameState(bool bInDriveGameState) { bDriveGameState = bInDriveGameState; }
+	void SetAcceptInput(bool bInAcceptInput) { bAcceptInput = bInAcceptInput; }
+
+	// 是否还有动画在播放或排队
+	bool IsAnimating() const { return AnimHead < Anims.Num(); }
+
+	// ========== SWidget ==========
+
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FReply OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual FReply OnMouseButtonUp(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+	virtual void OnMouseCaptureLost(const FCaptureLostEvent& CaptureLostEvent) override;
+
+protected:
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+	enum class EAnimType : uint8
+	{
+		Swap,		// IndexA / IndexB 互换位置（失败时来回）
+		Clear,		// Mask 中的方块缩小消失
+		Fall,		// FallMoves[FirstMove, FirstMove + NumMoves) 从起点落到终点
+		Reshuffle,	// 方块缩小后换成 Colors[FirstColor, FirstColor + NumCells) 再放大
+		Advance		// 不播放：调用 AdvanceGameState
+	};
+
+	struct FBoardAnim
+	{
+		EAnimType Type;
+		bool bSuccessful;
+		int32 IndexA;
+		int32 IndexB;
+		uint64 Mask;
+		int32 FirstMove;
+		int32 NumMoves;
+		int32 FirstColor;
+		float Duration;
+	};
+
+	// ========== 棋盘事件 ==========
+
+	void HandleSwapAnim(int32 IndexA, int32 IndexB, bool bIsSuccessful);
+	void HandleClearAnim(const FMatch3StepResult& Step);
+	void HandleFallAnim(const TArray<FFallMove>& FallMoves);
+	void HandleCascadeResolved(const FCascadeTimeline& Timeline);
+	void HandleBoardRebuilt(bool bReshuffled);
+	void HandleCellStateChanged();
+
+	void UnbindBoard();
+
+	// ========== 动画队列 ==========
+
+	FBoardAnim& AddAnim(EAnimType Type, float Duration);
+	void AddSwapAnim(int32 IndexA, int32 IndexB, bool bIsSuccessful);
+	void AddClearAnim(uint64 ClearedMask);
+	void AddFallAnim(const TArray<FFallMove>& FallMoves);
+	void AddReshuffleAnim();
+	void AddAdvance();
+
+	// 队首动画开始 / 结束时修改显示中的方块
+	void BeginAnim(const FBoardAnim& Anim);
+	void EndAnim(const FBoardAnim& Anim);
+
+	// 清空队列，显示中的方块直接取棋盘数据
+	void SnapToBoard();
+
+	EActiveTimerReturnType UpdateAnimations(double InCurrentTime, float InDeltaTime);
+
+	// ========== 布局 ==========
+
+	// 正方形格子居中排列：左上角与格子边长
+	void GetLayout(const FVector2f& LocalSize, FVector2f& OutOrigin, float& OutCellSize) const;
+
+	// 本地坐标下的格子索引（棋盘外或不可用的格子返回 INDEX_NONE）
+	int32 GetCellAt(const FGeometry& MyGeometry, const FVector2D& ScreenPosition) const;
+
+	TWeakObjectPtr<ADatamanagement> Board;
+	FMatch3BoardStyle Style;
+	bool bDriveGameState;
+	bool bAcceptInput;
+
+	FDelegateHandle SwapAnimHandle;
+	FDelegateHandle ClearAnimHandle;
+	FDelegateHandle FallAnimHandle;
+	FDelegateHandle CascadeResolvedHandle;
+	FDelegateHandle BoardRebuiltHandle;
+	FDelegateHandle CellStateChangedHandle;
+
+	// 显示中的方块颜色（FMatch3Board::EmptyColor 为空）
+	uint8 DisplayColors[FMatch3Board::NumCells];
+
+	// 正在下落的方块的起始行（新方块为棋盘上方的负数行），不下落的格子为 FallNone
+	static constexpr float FallNone = -1000.0f;
+	float FallFromRows[FMatch3Board::NumCells];
+
+	// 动画队列：[AnimHead, Num) 为未播放完的动画，全部播放完后清空（保留容量）
+	TArray<FBoardAnim> Anims;
+	TArray<FFallMove> FallMoveBuffer;
+	TArray<uint8> ColorBuffer;
+	int32 AnimHead;
+	float AnimElapsed;
+	bool bAnimStarted;
+	bool bTimerActive;
+
+	// 按下时的格子：拖到相邻格子即交换
+	int32 PressedCell;
+
+	// 按在已选中的格子上：没有拖动交换时松开即取消选中
+	bool bDeselectOnRelease;
+};
@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+// 三消核心基准测试：独立的命令行程序，不依赖引擎与 UObject，可以在没有编辑器的 CI 机器上编译运行
+// RunUBT DragonBoatBench <Platform> Development -Project=<Path>/DragonBoat.uproject
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class DragonBoatBenchTarget : TargetRules
+{
+	public DragonBoatBenchTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
+		LaunchModuleName = "DragonBoatBench";
+
+		bBuildDeveloperTools = false;
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+		bCompileICU = false;
+		bUseLoggingInShipping = true;
+
+		// 控制台程序，结果输出到标准输出
+		bIsBuildingConsoleApplication = true;
+	}
+}
@@ -0,0 +1,16 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class DragonBoatBench : ModuleRules
+{
+	public DragonBoatBench(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// RequiredProgramMainCPPInclude.h
+		PrivateIncludePathModuleNames.Add("Launch");
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "Projects", "DragonBoatCore" });
+	}
+}
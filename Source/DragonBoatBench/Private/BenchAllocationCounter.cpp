@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BenchAllocationCounter.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include <atomic>
+
+namespace
+{
+	// 计数代理：转发给原分配器，统计被跟踪线程的分配次数
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{}
+
+		void Begin()
+		{
+			NumAllocations.store(0, std::memory_order_relaxed);
+			TrackedThreadId.store(FPlatformTLS::GetCurrentThreadId(), std::memory_order_release);
+		}
+
+		int64 End()
+		{
+			TrackedThreadId.store(0, std::memory_order_release);
+			return NumAllocations.load(std::memory_order_relaxed);
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			Track();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			Track();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			// Count 为 0 的 Realloc 等同于释放，不计数
+			if (Count > 0)
+			{
+				Track();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				Track();
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override
+		{
+			Inner->Trim(bTrimThreadCaches);
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			Inner->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			Inner->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual bool ValidateHeap() override
+		{
+			return Inner->ValidateHeap();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return TEXT("DragonBoatBenchCounting");
+		}
+
+	private:
+		void Track()
+		{
+			if (TrackedThreadId.load(std::memory_order_acquire) == FPlatformTLS::GetCurrentThreadId())
+			{
+				NumAllocations.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		FMalloc* Inner;
+		std::atomic<uint32> TrackedThreadId{0};
+		std::atomic<int64> NumAllocations{0};
+	};
+
+	FCountingMalloc* GCountingMalloc = nullptr;
+}
+
+void FBenchAllocationCounter::Install()
+{
+	if (!GCountingMalloc)
+	{
+		// 代理永不释放：安装前分配的内存仍由原分配器释放
+		GCountingMalloc = new FCountingMalloc(GMalloc);
+		GMalloc = GCountingMalloc;
+	}
+}
+
+bool FBenchAllocationCounter::IsInstalled()
+{
+	return GCountingMalloc != nullptr;
+}
+
+void FBenchAllocationCounter::Begin()
+{
+	if (GCountingMalloc)
+	{
+		GCountingMalloc->Begin();
+	}
+}
+
+int64 FBenchAllocationCounter::End()
+{
+	return GCountingMalloc ? GCountingMalloc->End() : 0;
+}
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 堆分配计数 - 用计数代理包装 GMalloc
+ * 只统计调用 Begin() 的线程在 Begin/End 之间的 Malloc 与 Realloc，其它线程（任务图、日志）不受影响
+ */
+struct FBenchAllocationCounter
+{
+	// 安装计数代理（PreInit 之后、运行测试之前调用一次）
+	static void Install();
+
+	// 是否已安装
+	static bool IsInstalled();
+
+	// 开始统计当前线程的分配
+	static void Begin();
+
+	// 停止统计，返回期间的分配次数
+	static int64 End();
+};
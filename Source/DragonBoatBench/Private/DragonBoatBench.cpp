@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Match3Benchmarks.h"
+#include "BenchAllocationCounter.h"
+#include "Misc/FileHelper.h"
+#include "RequiredProgramMainCPPInclude.h"
+
+IMPLEMENT_APPLICATION(DragonBoatBench, "DragonBoatBench");
+
+// 用法：DragonBoatBench [-Iterations=1000000] [-Seeds=100000] [-Filter=MatchCheck]
+//       DragonBoatBench -Replay=Saved/Replays/Race.dbreplay [-Iterations=1000000]（只回放并计时一个比赛录像）
+// 校验失败时返回 1，可直接用于 CI
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	FTaskTagScope Scope(ETaskTag::EGameThread);
+	ON_SCOPE_EXIT
+	{
+		RequestEngineExit(TEXT("DragonBoatBench exiting"));
+		FEngineLoop::AppPreExit();
+		FModuleManager::Get().UnloadModulesAtShutdown();
+		FEngineLoop::AppExit();
+	};
+
+	if (int32 Ret = GEngineLoop.PreInit(ArgC, ArgV))
+	{
+		return Ret;
+	}
+
+	// 统计稳态回合的堆分配次数（Alloc.SteadyState）
+	FBenchAllocationCounter::Install();
+
+	FMatch3BenchOptions Options;
+	FParse::Value(FCommandLine::Get(), TEXT("-Iterations="), Options.Iterations);
+	FParse::Value(FCommandLine::Get(), TEXT("-Seeds="), Options.NumSeeds);
+	FParse::Value(FCommandLine::Get(), TEXT("-Filter="), Options.Filter);
+
+	UE_LOG(LogDragonBoatBench, Display, TEXT("DragonBoatBench: %d iterations per case, %d generation seeds"),
+		Options.Iterations, Options.NumSeeds);
+
+	FString ReplayPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-Replay="), ReplayPath))
+	{
+		TArray<uint8> ReplayData;
+		if (!FFileHelper::LoadFileToArray(ReplayData, *ReplayPath))
+		{
+			UE_LOG(LogDragonBoatBench, Error, TEXT("Cannot read replay %s"), *ReplayPath);
+			return 1;
+		}
+		return RunReplayBenchmark(ReplayData, Options) ? 0 : 1;
+	}
+
+	return RunMatch3Benchmarks(Options) ? 0 : 1;
+}
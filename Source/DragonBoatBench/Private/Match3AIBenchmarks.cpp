@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BenchContext.h"
+#include "Match3AIPlayer.h"
+#include "RaceBoatRegistry.h"
+#include "RaceSkillScheduler.h"
+
+namespace Match3Bench
+{
+	namespace
+	{
+		/**
+		 * AI 三消玩家
+		 * 校验：分批执行与一次执行结果相同（批大小不影响模拟）、预热后不分配堆内存、贪心策略获得的技能点不少于随机策略
+		 * 再测量每种策略一次交换（含连消）的耗时
+		 */
+		void RunAIPlayer(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("AI");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumPlayers = 64;
+			constexpr int32 NumMoves = 200;
+			constexpr int32 BatchSize = 7;
+
+			FMatch3SpecialAreas SpecialAreas;
+			SpecialAreas.SetEffect(FMatch3Board::ToIndex(3, 3), EMatch3Effect::MoraleBoost);
+			SpecialAreas.SetEffect(FMatch3Board::ToIndex(3, 1), EMatch3Effect::SpeedUpSelf);
+			SpecialAreas.SetEffect(FMatch3Board::ToIndex(3, 5), EMatch3Effect::SlowDownEnemy);
+
+			FMatch3AIConfig Greedy;
+			Greedy.Policy = EMatch3AIPolicy::Greedy;
+			FMatch3AIConfig Random;
+			Random.Policy = EMatch3AIPolicy::Random;
+			FMatch3AIConfig Mixed;
+			Mixed.Policy = EMatch3AIPolicy::Mixed;
+
+			TUniquePtr<FMatch3AIPlayer> Whole = MakeUnique<FMatch3AIPlayer>();
+			TUniquePtr<FMatch3AIPlayer> Batched = MakeUnique<FMatch3AIPlayer>();
+
+			int32 BatchMismatches = 0;
+			int64 GreedyPoints = 0;
+			int64 RandomPoints = 0;
+			for (int32 Seed = 0; Seed < NumPlayers; ++Seed)
+			{
+				Whole->Initialize(Seed, SpecialAreas);
+				const FMatch3AIBatchResult WholeResult = Whole->PlayMoves(NumMoves, Mixed);
+
+				Batched->Initialize(Seed, SpecialAreas);
+				FMatch3AIBatchResult BatchedResult;
+				for (int32 Played = 0; Played < NumMoves; Played += BatchSize)
+				{
+					BatchedResult.Accumulate(Batched->PlayMoves(FMath::Min(BatchSize, NumMoves - Played), Mixed));
+				}
+				if (BatchedResult.MovesPlayed != WholeResult.MovesPlayed
+					|| BatchedResult.ClearedTiles != WholeResult.ClearedTiles
+					|| BatchedResult.MoraleEarned != WholeResult.MoraleEarned
+					|| BatchedResult.SkillPointsGained != WholeResult.SkillPointsGained
+					|| FMemory::Memcmp(BatchedResult.CascadeDepths, WholeResult.CascadeDepths, sizeof(WholeResult.CascadeDepths)) != 0
+					|| Batched->GetMoraleState().CurrentMorale != Whole->GetMoraleState().CurrentMorale)
+				{
+					BatchMismatches++;
+				}
+
+				Whole->Initialize(Seed, SpecialAreas);
+				GreedyPoints += Whole->PlayMoves(NumMoves, Greedy).SkillPointsGained;
+				Whole->Initialize(Seed, SpecialAreas);
+				RandomPoints += Whole->PlayMoves(NumMoves, Random).SkillPointsGained;
+			}
+
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %10d moves: greedy %lld / random %lld skill points"),
+				Name, NumPlayers * NumMoves, GreedyPoints, RandomPoints);
+			Verify(Context, TEXT("AI batched == one batch"), BatchMismatches, NumPlayers);
+			Verify(Context, TEXT("AI greedy >= random skill points"), GreedyPoints >= RandomPoints ? 0 : 1, 1);
+
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				Whole->Initialize(0, SpecialAreas);
+				Whole->PlayMoves(NumMoves, Mixed);
+
+				FBenchAllocationCounter::Begin();
+				Whole->PlayMoves(NumMoves * 10, Mixed);
+				const int64 NumAllocations = FBenchAllocationCounter::End();
+				Verify(Context, TEXT("AI steady-state allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumMoves * 10);
+			}
+
+			Whole->Initialize(0, SpecialAreas);
+			Run(Context, TEXT("AI.PlayMove.Greedy"), [&Whole, &Greedy](int32 BoardIndex)
+			{
+				GSink = GSink + Whole->PlayMoves(1, Greedy).ClearedTiles;
+			});
+			Run(Context, TEXT("AI.PlayMove.Random"), [&Whole, &Random](int32 BoardIndex)
+			{
+				GSink = GSink + Whole->PlayMoves(1, Random).ClearedTiles;
+			});
+		}
+
+		// 对照组：线性扫描找最早的释放（每个施法者一个时间，-1 表示未调度）
+		struct FScanSkillScheduler
+		{
+			TArray<double> Times;
+
+			int32 FindNext() const
+			{
+				int32 Next = INDEX_NONE;
+				for (int32 Caster = 0; Caster < Times.Num(); ++Caster)
+				{
+					if (Times[Caster] >= 0.0 && (Next == INDEX_NONE || Times[Caster] < Times[Next]))
+					{
+						Next = Caster;
+					}
+				}
+				return Next;
+			}
+
+			int32 PopDue(double Now)
+			{
+				const int32 Next = FindNext();
+				if (Next == INDEX_NONE || Times[Next] > Now)
+				{
+					return INDEX_NONE;
+				}
+				Times[Next] = -1.0;
+				return Next;
+			}
+		};
+
+		/**
+		 * AI技能调度与目标选择
+		 * 调度：随机调度 / 取消 / 取出到期施法者，与线性扫描逐次对照；施法者数增大时堆的代价按对数增长
+		 * 目标：随机进度的比赛中逐次 Observe，超越记录与两两比较先后顺序的结果对照，各策略与按排名直接查找的结果对照
+		 */
+		void RunRaceSkillScheduler(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Race.Skill");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			// ========== 调度 ==========
+
+			constexpr int32 NumCasters = 512;
+			constexpr int32 NumOps = 100000;
+
+			FRaceSkillScheduler Scheduler;
+			FScanSkillScheduler Scan;
+			int32 NumScheduleMismatches = 0;
+			for (int32 Pass = 0; Pass < 2; ++Pass)
+			{
+				// 第二遍重复同样的操作，检查复用容量后不分配堆内存
+				FRandomStream Stream(NumCasters);
+				Scheduler.Reset(NumCasters);
+				Scan.Times.Init(-1.0, NumCasters);
+				if (Pass == 1 && FBenchAllocationCounter::IsInstalled())
+				{
+					FBenchAllocationCounter::Begin();
+				}
+
+				double Now = 0.0;
+				for (int32 Op = 0; Op < NumOps; ++Op)
+				{
+					const int32 Caster = Stream.RandHelper(NumCasters);
+					switch (Stream.RandHelper(4))
+					{
+					case 0:
+					case 1:
+					{
+						// 整数时间，制造同一时刻的释放
+						const double Time = Now + Stream.RandHelper(64);
+						Scheduler.Schedule(Caster, Time);
+						if (Pass == 0)
+						{
+							Scan.Times[Caster] = Time;
+						}
+						break;
+					}
+					case 2:
+						Scheduler.Cancel(Caster);
+						if (Pass == 0)
+						{
+							Scan.Times[Caster] = -1.0;
+						}
+						break;
+					default:
+					{
+						Now += Stream.RandHelper(2);
+						const int32 Popped = Scheduler.PopDue(Now);
+						if (Pass == 0)
+						{
+							NumScheduleMismatches += Popped != Scan.PopDue(Now);
+						}
+						break;
+					}
+					}
+
+					if (Pass == 0)
+					{
+						const int32 Next = Scan.FindNext();
+						NumScheduleMismatches += Scheduler.IsScheduled(Caster) != (Scan.Times[Caster] >= 0.0);
+						NumScheduleMismatches += Scheduler.IsEmpty() ? Next != INDEX_NONE
+							: (Scheduler.GetNextCaster() != Next || Scheduler.GetNextCastTime() != Scan.Times[Next]);
+					}
+				}
+			}
+			const int64 NumAllocations = FBenchAllocationCounter::IsInstalled() ? FBenchAllocationCounter::End() : 0;
+			Verify(Context, TEXT("Race.Skill heap == scan"), NumScheduleMismatches, NumOps);
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				Verify(Context, TEXT("Race.Skill scheduler allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumOps);
+			}
+
+			// ========== 目标选择 ==========
+
+			constexpr int32 NumRaceBoats = 16;
+			constexpr float FinishProgress = 1.0f;
+			FRandomStream Stream(NumRaceBoats);
+			auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+			auto Everyone = [](int32) { return true; };
+
+			FRaceBoatRegistry Registry;
+			Registry.Reset(NumRaceBoats);
+			FRaceSkillTargeting Targeting;
+			Targeting.Reset(NumRaceBoats);
+			TArray<int32> OldRanks;
+			float Progresses[NumRaceBoats] = {};
+			int32 NumOvertakeMismatches = 0;
+			int32 NumOvertakes = 0;
+			int32 NumTargetMismatches = 0;
+			for (int32 Tick = 0; Tick < NumBoards; ++Tick)
+			{
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					Progresses[Boat] += Stream.FRandRange(0.0f, 2.0f) / NumBoards;
+					Registry.SetProgress(Boat, FMath::Min(Progresses[Boat], FinishProgress));
+					if (Progresses[Boat] >= FinishProgress)
+					{
+						Registry.MarkFinished(Boat, (float)Tick);
+					}
+				}
+				OldRanks = Registry.GetRanks();
+				Registry.UpdateRanking();
+				Targeting.Observe(Registry, (double)Tick);
+
+				// 对照：两两比较先后顺序，被多条龙舟超过时取现在紧挨在前面的那条
+				for (int32 Overtaken = 0; Overtaken < NumRaceBoats; ++Overtaken)
+				{
+					int32 Expected = INDEX_NONE;
+					for (int32 Other = 0; Other < NumRaceBoats; ++Other)
+					{
+						if (OldRanks[Other] > OldRanks[Overtaken] && Registry.GetRank(Other) < Registry.GetRank(Overtaken)
+							&& (Expected == INDEX_NONE || Registry.GetRank(Other) > Registry.GetRank(Expected)))
+						{
+							Expected = Other;
+						}
+					}
+					NumOvertakes += Expected != INDEX_NONE;
+					NumOvertakeMismatches += Targeting.GetLastOvertaker(Overtaken, (double)Tick, 0.0) != Expected;
+				}
+
+				// 各策略与按排名直接查找的结果对照
+				for (int32 Caster = 0; Caster < NumRaceBoats; ++Caster)
+				{
+					int32 Leader = INDEX_NONE;
+					int32 Ahead = INDEX_NONE;
+					int32 Behind = INDEX_NONE;
+					for (int32 Rank = 1; Rank <= NumRaceBoats; ++Rank)
+					{
+						const int32 Boat = Registry.GetBoatAtRank(Rank);
+						if (Boat == Caster || Registry.HasFinished(Boat))
+						{
+							continue;
+						}
+						Leader = Leader == INDEX_NONE ? Boat : Leader;
+						Ahead = Rank < Registry.GetRank(Caster) ? Boat : Ahead;
+						Behind = Rank > Registry.GetRank(Caster) && Behind == INDEX_NONE ? Boat : Behind;
+					}
+					const int32 Overtaker = Targeting.GetLastOvertaker(Caster, (double)Tick, 4.0);
+					const int32 Adaptive = Overtaker != INDEX_NONE && !Registry.HasFinished(Overtaker) ? Overtaker : Leader;
+
+					NumTargetMismatches += Targeting.PickTarget(Caster, ERaceTargetPolicy::Leader, (double)Tick, 4.0, Everyone, RandHelper) != Leader;
+					NumTargetMismatches += Targeting.PickTarget(Caster, ERaceTargetPolicy::BoatAhead, (double)Tick, 4.0, Everyone, RandHelper)
+						!= (Ahead != INDEX_NONE ? Ahead : Behind);
+					NumTargetMismatches += Targeting.PickTarget(Caster, ERaceTargetPolicy::Adaptive, (double)Tick, 4.0, Everyone, RandHelper) != Adaptive;
+
+					const int32 RandomTarget = Targeting.PickTarget(Caster, ERaceTargetPolicy::Random, (double)Tick, 4.0, Everyone, RandHelper);
+					NumTargetMismatches += Leader == INDEX_NONE ? RandomTarget != INDEX_NONE
+						: (RandomTarget == Caster || RandomTarget == INDEX_NONE || Registry.HasFinished(RandomTarget));
+				}
+			}
+			Verify(Context, *FString::Printf(TEXT("Race.Skill overtakes == pairwise order (%d overtakes)"), NumOvertakes),
+				NumOvertakeMismatches, NumBoards * NumRaceBoats);
+			Verify(Context, TEXT("Race.Skill targets == rank lookup"), NumTargetMismatches, NumBoards * NumRaceBoats);
+
+			// 每次取出最早的施法者并重新调度；施法者数增大时扫描的代价线性增长，堆按对数增长
+			for (int32 Casters : { 16, 4096 })
+			{
+				FRandomStream TimeStream(Casters);
+				Scheduler.Reset(Casters);
+				Scan.Times.SetNumUninitialized(Casters);
+				for (int32 Caster = 0; Caster < Casters; ++Caster)
+				{
+					const double Time = TimeStream.FRandRange(0.0f, 10.0f);
+					Scheduler.Schedule(Caster, Time);
+					Scan.Times[Caster] = Time;
+				}
+
+				double HeapNow = 0.0;
+				Run(Context, *FString::Printf(TEXT("Race.Skill%d.Heap"), Casters), [&Scheduler, &TimeStream, &HeapNow](int32)
+				{
+					HeapNow = Scheduler.GetNextCastTime();
+					const int32 Caster = Scheduler.PopDue(HeapNow);
+					Scheduler.Schedule(Caster, HeapNow + TimeStream.FRandRange(10.0f, 20.0f));
+					GSink = GSink + Caster;
+				});
+				double ScanNow = 0.0;
+				Run(Context, *FString::Printf(TEXT("Race.Skill%d.Scan"), Casters), [&Scan, &TimeStream, &ScanNow](int32)
+				{
+					const int32 Caster = Scan.FindNext();
+					ScanNow = Scan.Times[Caster];
+					Scan.Times[Caster] = ScanNow + TimeStream.FRandRange(10.0f, 20.0f);
+					GSink = GSink + Caster;
+				});
+			}
+		}
+	}
+
+	void RunAIBenchmarks(FBenchContext& Context)
+	{
+		RunAIPlayer(Context);
+		RunRaceSkillScheduler(Context);
+	}
+}
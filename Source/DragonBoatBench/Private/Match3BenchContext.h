@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Benchmarks.h"
+#include "Match3Game.h"
+#include "BenchAllocationCounter.h"
+#include "HAL/PlatformTime.h"
+
+// 各测试文件共用的测试数据与计时、校验工具
+namespace Match3Bench
+{
+	// 测试用棋盘数量（2的幂，循环取用）
+	constexpr int32 NumBoards = 1024;
+
+	// 累加被测函数的结果，防止编译器优化掉被测代码
+	extern volatile uint64 GSink;
+
+	// 一次有效交换的测试数据
+	struct FSwapCase
+	{
+		FMatch3Game Stable;				// 交换前的稳定棋盘
+		int32 IndexA;					// 交换的两个格子
+		int32 IndexB;
+		FMatch3Board Swapped;			// 交换后
+		uint64 SwapMask;				// 交换的两格
+		uint64 MatchedMask;				// 交换产生的匹配
+		FMatch3Board Cleared;			// 消除后、下落前
+		FMatch3Board Filled;			// 下落填充后
+		uint64 DirtyMask;				// 交换 + 下落改写的所有格子
+		FMatch3Board Settled;			// 结算完所有连消后的稳定棋盘
+	};
+
+	struct FBenchContext
+	{
+		const FMatch3BenchOptions& Options;
+		TArray<FMatch3Board> RandomBoards;	// 完全随机的棋盘（通常含有匹配）
+		TArray<FSwapCase> SwapCases;
+		int32 NumFailedChecks;
+
+		explicit FBenchContext(const FMatch3BenchOptions& InOptions)
+			: Options(InOptions)
+			, NumFailedChecks(0)
+		{}
+
+		bool ShouldRun(const TCHAR* Name) const
+		{
+			return Options.Filter.IsEmpty() || FCString::Stristr(Name, *Options.Filter) != nullptr;
+		}
+	};
+
+	inline double CyclesToNanoseconds(uint64 Cycles)
+	{
+		return FPlatformTime::ToMilliseconds64(Cycles) * 1000000.0;
+	}
+
+	// 运行一项测试：Body(BoardIndex) 共调用 Iterations 次
+	template <typename BodyFunc>
+	void Run(FBenchContext& Context, const TCHAR* Name, BodyFunc&& Body)
+	{
+		if (!Context.ShouldRun(Name))
+		{
+			return;
+		}
+
+		const int32 Iterations = FMath::Max(1, Context.Options.Iterations);
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			Body(Iteration & (NumBoards - 1));
+		}
+		const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+
+		UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %10d ops %10.1f ns/op"),
+			Name, Iterations, CyclesToNanoseconds(Cycles) / Iterations);
+	}
+
+	// 记录校验结果
+	void Verify(FBenchContext& Context, const TCHAR* What, int32 NumFailures, int32 NumChecked);
+
+	// 记录以测试名为前缀的校验结果（"<Name> <What>"）
+	inline void Verify(FBenchContext& Context, const TCHAR* Name, const TCHAR* What, int32 NumFailures, int32 NumChecked)
+	{
+		Verify(Context, *FString::Printf(TEXT("%s %s"), Name, What), NumFailures, NumChecked);
+	}
+
+	/**
+	 * 逐棋盘逐回合校验：每个棋盘以编号为随机种子，Setup(BoardIndex, RandHelper) 返回 false 时跳过该棋盘，
+	 * 否则 Turn(BoardIndex, RandHelper) 连续调用 NumTurnsPerBoard 次，最后调用 Finish(BoardIndex, RandHelper)
+	 * 返回实际走过的回合数（用作校验数）
+	 */
+	template <typename SetupFunc, typename TurnFunc, typename FinishFunc>
+	int32 ForEachBoardTurn(int32 NumTurnsPerBoard, SetupFunc&& Setup, TurnFunc&& Turn, FinishFunc&& Finish)
+	{
+		int32 NumTurns = 0;
+		for (int32 BoardIndex = 0; BoardIndex < NumBoards; ++BoardIndex)
+		{
+			FRandomStream Stream(BoardIndex);
+			auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+
+			if (!Setup(BoardIndex, RandHelper))
+			{
+				continue;
+			}
+
+			for (int32 TurnIndex = 0; TurnIndex < NumTurnsPerBoard; ++TurnIndex)
+			{
+				Turn(BoardIndex, RandHelper);
+			}
+			NumTurns += NumTurnsPerBoard;
+
+			Finish(BoardIndex, RandHelper);
+		}
+		return NumTurns;
+	}
+
+	// 对照组：逐个尝试所有相邻交换（7x7 共 84 个）并全盘扫描，找到第一个有效交换即返回
+	template <typename BoardType>
+	bool HasAnyMoveBruteForce(const BoardType& Board)
+	{
+		const typename BoardType::FMask Playable = Board.GetSwappableMask();
+		BoardType Scratch = Board;
+		for (int32 Index = 0; Index < BoardType::NumCells; ++Index)
+		{
+			const int32 Row = Index / BoardType::Cols;
+			const int32 Col = Index % BoardType::Cols;
+			const int32 Neighbors[2] = {
+				Col + 1 < BoardType::Cols ? Index + 1 : INDEX_NONE,
+				Row + 1 < BoardType::Rows ? Index + BoardType::Cols : INDEX_NONE
+			};
+
+			for (int32 Neighbor : Neighbors)
+			{
+				// 空洞与锁定格子不能参与交换
+				if (Neighbor == INDEX_NONE
+					|| !(Playable & BoardType::CellBit(Index))
+					|| !(Playable & BoardType::CellBit(Neighbor)))
+				{
+					continue;
+				}
+
+				Scratch.SwapCells(Index, Neighbor);
+				const bool bMatch = Scratch.HasMatch();
+				Scratch.SwapCells(Index, Neighbor);
+				if (bMatch)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// 随机选择一个有效交换
+	template <typename MoveIndexType, typename RandFunc>
+	void PickRandomMove(const MoveIndexType& MoveIndex, RandFunc&& RandHelper, int32& OutIndexA, int32& OutIndexB)
+	{
+		const int32 Pick = RandHelper(MoveIndex.Num());
+		int32 MoveNumber = 0;
+		MoveIndex.ForEachMove([Pick, &MoveNumber, &OutIndexA, &OutIndexB](int32 IndexA, int32 IndexB)
+		{
+			if (MoveNumber++ == Pick)
+			{
+				OutIndexA = IndexA;
+				OutIndexB = IndexB;
+			}
+		});
+	}
+
+	// 各子系统的测试入口（每个文件一个），由 RunMatch3Benchmarks 依次调用
+	void RunBoardBenchmarks(FBenchContext& Context);			// Match3BoardBenchmarks.cpp
+	void RunAIBenchmarks(FBenchContext& Context);				// Match3AIBenchmarks.cpp
+	void RunRaceSimulationBenchmarks(FBenchContext& Context);	// RaceSimulationBenchmarks.cpp
+	void RunStatusEffectBenchmarks(FBenchContext& Context);		// RaceStatusEffectBenchmarks.cpp
+	void RunReplayBenchmarks(FBenchContext& Context);			// RaceReplayBenchmarks.cpp
+	void RunNetDeltaBenchmarks(FBenchContext& Context);			// Match3NetDeltaBenchmarks.cpp
+}
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3Benchmarks.h"
+#include "Match3BenchContext.h"
+
+DEFINE_LOG_CATEGORY(LogDragonBoatBench);
+
+namespace Match3Bench
+{
+	volatile uint64 GSink = 0;
+
+	// 记录校验结果
+	void Verify(FBenchContext& Context, const TCHAR* What, int32 NumFailures, int32 NumChecked)
+	{
+		if (NumFailures > 0)
+		{
+			Context.NumFailedChecks++;
+			UE_LOG(LogDragonBoatBench, Error, TEXT("FAILED %s: %d / %d"), What, NumFailures, NumChecked);
+		}
+		else
+		{
+			UE_LOG(LogDragonBoatBench, Display, TEXT("OK     %s (%d checked)"), What, NumChecked);
+		}
+	}
+
+	// 准备测试数据，并校验局部检查、增量索引与全盘结果一致
+	void Prepare(FBenchContext& Context)
+	{
+		auto NoMove = [](int32, int32, uint8, bool) {};
+
+		Context.RandomBoards.SetNum(NumBoards);
+		Context.SwapCases.SetNum(NumBoards);
+
+		int32 LocalMismatches = 0;
+		int32 IndexMismatches = 0;
+		int32 DeadlockMismatches = 0;
+		int32 InvalidBoards = 0;
+
+		for (int32 BoardIndex = 0; BoardIndex < NumBoards; ++BoardIndex)
+		{
+			FRandomStream Stream(BoardIndex);
+			auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+
+			uint8 Cells[FMatch3Board::NumCells];
+			for (uint8& Cell : Cells)
+			{
+				Cell = (uint8)RandHelper(FMatch3Board::NumColors);
+			}
+			Context.RandomBoards[BoardIndex].SetCells(Cells);
+
+			FSwapCase& Case = Context.SwapCases[BoardIndex];
+			Case.Stable.Generate(RandHelper);
+			const FMatch3MoveIndex& StableIndex = Case.Stable.GetMoveIndex();
+			if (Case.Stable.GetBoard().HasMatch() || !StableIndex.HasAnyMove())
+			{
+				InvalidBoards++;
+			}
+
+			PickRandomMove(StableIndex, RandHelper, Case.IndexA, Case.IndexB);
+
+			Case.Swapped = Case.Stable.GetBoard();
+			Case.Swapped.SwapCells(Case.IndexA, Case.IndexB);
+			Case.SwapMask = FMatch3Board::CellBit(Case.IndexA) | FMatch3Board::CellBit(Case.IndexB);
+			Case.MatchedMask = Case.Swapped.FindMatches();
+
+			uint64 LocalHorizontal, LocalVertical;
+			Case.Swapped.FindMatchesNear(Case.SwapMask, LocalHorizontal, LocalVertical);
+			if ((LocalHorizontal | LocalVertical) != Case.MatchedMask)
+			{
+				LocalMismatches++;
+			}
+
+			Case.Cleared = Case.Swapped;
+			Case.Cleared.ClearCells(Case.MatchedMask);
+			Case.Filled = Case.Cleared;
+			Case.DirtyMask = Case.SwapMask
+				| Case.Filled.CollapseAndRefill([&RandHelper]() { return (uint8)RandHelper(FMatch3Board::NumColors); }, NoMove);
+
+			FMatch3MoveIndex Incremental = StableIndex;
+			Incremental.Update(Case.Filled, Case.DirtyMask);
+			FMatch3MoveIndex Rebuilt;
+			Rebuilt.Rebuild(Case.Filled);
+			if (Incremental.GetHorizontalMoves() != Rebuilt.GetHorizontalMoves()
+				|| Incremental.GetVerticalMoves() != Rebuilt.GetVerticalMoves())
+			{
+				IndexMismatches++;
+			}
+
+			FMatch3Game Game = Case.Stable;
+			Game.PlayMove(Case.IndexA, Case.IndexB, RandHelper);
+			Case.Settled = Game.GetBoard();
+			if (HasAnyMoveBruteForce(Case.Settled) != Game.HasAnyValidMove())
+			{
+				DeadlockMismatches++;
+			}
+		}
+
+		Verify(Context, TEXT("Generated boards valid"), InvalidBoards, NumBoards);
+		Verify(Context, TEXT("Local match check == full scan"), LocalMismatches, NumBoards);
+		Verify(Context, TEXT("Incremental index == rebuild"), IndexMismatches, NumBoards);
+		Verify(Context, TEXT("Deadlock index == brute force"), DeadlockMismatches, NumBoards);
+	}
+}
+
+bool RunMatch3Benchmarks(const FMatch3BenchOptions& Options)
+{
+	using namespace Match3Bench;
+
+	FBenchContext Context(Options);
+	Prepare(Context);
+
+	RunBoardBenchmarks(Context);
+	RunAIBenchmarks(Context);
+	RunRaceSimulationBenchmarks(Context);
+	RunStatusEffectBenchmarks(Context);
+	RunReplayBenchmarks(Context);
+	RunNetDeltaBenchmarks(Context);
+
+	if (Context.NumFailedChecks > 0)
+	{
+		UE_LOG(LogDragonBoatBench, Error, TEXT("%d verification(s) failed"), Context.NumFailedChecks);
+		return false;
+	}
+	return true;
+}
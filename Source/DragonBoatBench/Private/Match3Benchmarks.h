@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogDragonBoatBench, Log, All);
+
+// 基准测试参数（可通过命令行覆盖）
+struct FMatch3BenchOptions
+{
+	int32 Iterations;	// 每项测试的调用次数
+	int32 NumSeeds;		// 统计生成耗时分布（P50/P99/最坏）使用的种子数
+	FString Filter;		// 只运行名称包含该字符串的测试（为空时全部运行）
+
+	FMatch3BenchOptions()
+		: Iterations(1000000)
+		, NumSeeds(1000000)
+	{}
+};
+
+// 运行各子系统的微基准测试并校验结果（见 Match3BenchContext.h），任何校验失败时返回 false
+bool RunMatch3Benchmarks(const FMatch3BenchOptions& Options);
+
+// 无头回放一个比赛录像：与录制结果不一致或文件损坏时返回 false，否则计时回放 Iterations / 1000 次
+bool RunReplayBenchmark(const TArray<uint8>& ReplayData, const FMatch3BenchOptions& Options);
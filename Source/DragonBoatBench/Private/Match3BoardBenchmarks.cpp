@@ -0,0 +1,783 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BenchContext.h"
+#include "Match3MoveRanker.h"
+#include "Match3Morale.h"
+
+namespace Match3Bench
+{
+	namespace
+	{
+		// 生成耗时分布（P50/P99/最坏），并校验每个棋盘都有效
+		void RunGenerateDistribution(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Generate.Distribution");
+			const int32 NumSeeds = Context.Options.NumSeeds;
+			if (!Context.ShouldRun(Name) || NumSeeds <= 0)
+			{
+				return;
+			}
+
+			TArray<uint32> GenerateCycles;
+			GenerateCycles.SetNumUninitialized(NumSeeds);
+			uint64 TotalCycles = 0;
+			int32 InvalidBoards = 0;
+
+			for (int32 Seed = 0; Seed < NumSeeds; ++Seed)
+			{
+				FRandomStream Stream(Seed);
+				auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+
+				FMatch3Board Board;
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				FMatch3Generator::Generate(Board, RandHelper);
+				const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+
+				GenerateCycles[Seed] = (uint32)FMath::Min<uint64>(Cycles, MAX_uint32);
+				TotalCycles += Cycles;
+
+				FMatch3MoveIndex MoveIndex;
+				MoveIndex.Rebuild(Board);
+				if (Board.HasMatch() || !MoveIndex.HasAnyMove())
+				{
+					InvalidBoards++;
+				}
+			}
+
+			GenerateCycles.Sort();
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %10d seeds mean %.1f ns, P50 %.1f ns, P99 %.1f ns, worst %.1f ns"),
+				Name, NumSeeds,
+				CyclesToNanoseconds(TotalCycles) / NumSeeds,
+				CyclesToNanoseconds(GenerateCycles[NumSeeds / 2]),
+				CyclesToNanoseconds(GenerateCycles[FMath::Min(NumSeeds - 1, (int32)(NumSeeds * 0.99))]),
+				CyclesToNanoseconds(GenerateCycles.Last()));
+
+			Verify(Context, TEXT("Generate.Distribution boards valid"), InvalidBoards, NumSeeds);
+		}
+
+		// 稳态分配检查：预热后，交换 -> 消除 -> 下落 -> 连消检查 -> 死锁检测的完整回合不得分配堆内存
+		// 与 ADatamanagement 一样，每一步的消除索引与下落移动展开到复用的数组中
+		void VerifySteadyStateAllocations(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Alloc.SteadyState");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+			if (!FBenchAllocationCounter::IsInstalled())
+			{
+				UE_LOG(LogDragonBoatBench, Warning, TEXT("%-28s skipped: allocation counter not installed"), Name);
+				return;
+			}
+
+			constexpr int32 NumWarmupTurns = 100;
+			constexpr int32 NumTurns = 10000;
+
+			struct FFallRecord
+			{
+				int32 FromIndex;
+				int32 ToIndex;
+				uint8 Color;
+				bool bIsNewTile;
+			};
+
+			TArray<int32> ClearedIndices;
+			TArray<FFallRecord> FallMoves;
+			ClearedIndices.Reserve(FMatch3Board::NumCells);
+			FallMoves.Reserve(FMatch3Board::NumCells);
+
+			FRandomStream Stream(Context.SwapCases.Num());
+			auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+			auto NextColor = [&Stream]() { return (uint8)Stream.RandHelper(FMatch3Board::NumColors); };
+
+			FMatch3Game Game;
+			Game.Generate(RandHelper);
+
+			int64 TotalCleared = 0;
+			auto PlayTurn = [&]()
+			{
+				int32 SwapA = INDEX_NONE;
+				int32 SwapB = INDEX_NONE;
+				PickRandomMove(Game.GetMoveIndex(), RandHelper, SwapA, SwapB);
+
+				Game.ApplySwap(SwapA, SwapB);
+				for (;;)
+				{
+					uint64 Horizontal, Vertical;
+					Game.FindMatches(Horizontal, Vertical);
+					if ((Horizontal | Vertical) == 0)
+					{
+						break;
+					}
+
+					ClearedIndices.Reset();
+					FMatch3Game::ForEachMatchedCell(Horizontal, Vertical, [&ClearedIndices](int32 Idx)
+					{
+						ClearedIndices.Add(Idx);
+					});
+					TotalCleared += ClearedIndices.Num();
+
+					Game.ClearCells(Horizontal | Vertical);
+					FallMoves.Reset();
+					Game.CollapseAndRefill(NextColor, [&FallMoves](int32 FromIdx, int32 ToIdx, uint8 Color, bool bIsNewTile)
+					{
+						FallMoves.Add({ FromIdx, ToIdx, Color, bIsNewTile });
+					});
+				}
+
+				Game.Settle();
+				if (!Game.HasAnyValidMove())
+				{
+					Game.Reshuffle(RandHelper);
+				}
+			};
+
+			for (int32 Turn = 0; Turn < NumWarmupTurns; ++Turn)
+			{
+				PlayTurn();
+			}
+
+			FBenchAllocationCounter::Begin();
+			for (int32 Turn = 0; Turn < NumTurns; ++Turn)
+			{
+				PlayTurn();
+			}
+			const int64 NumAllocations = FBenchAllocationCounter::End();
+			GSink = GSink + TotalCleared;
+
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %10d turns %10lld allocations"), Name, NumTurns, NumAllocations);
+			Verify(Context, TEXT("Steady-state turn allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumTurns);
+		}
+
+		/**
+		 * 交换排名（提示）
+		 * 校验排名覆盖全部有效交换且降序、首次消除数与全盘扫描一致、分帧评估与一次评估结果相同，再测量一次完整排名的耗时
+		 * GetGame(BoardIndex) 返回第 BoardIndex 个稳定棋盘
+		 */
+		template <typename GameType, typename GetGameFunc>
+		void RunMoveRanker(FBenchContext& Context, const TCHAR* Name, GetGameFunc&& GetGame)
+		{
+			using BoardType = typename GameType::FBoard;
+			using FRanker = TMatch3MoveRanker<GameType>;
+
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			auto ScoreMove = [](const FMatch3MoveScore& Move)
+			{
+				return Move.ClearedTiles + 5.0f * (Move.EffectHits[(int32)EMatch3Effect::SpeedUpSelf] + Move.EffectHits[(int32)EMatch3Effect::MoraleBoost]);
+			};
+
+			// 排名对象较大（每个有效交换一项），放在堆上复用
+			TUniquePtr<FRanker> Ranker = MakeUnique<FRanker>();
+			TUniquePtr<FRanker> Sliced = MakeUnique<FRanker>();
+
+			int32 CoverageMismatches = 0;
+			int32 ClearedMismatches = 0;
+			int32 SlicedMismatches = 0;
+			int32 NumSlices = 0;
+
+			for (int32 BoardIndex = 0; BoardIndex < NumBoards; ++BoardIndex)
+			{
+				GameType Game = GetGame(BoardIndex);
+
+				// 左上角与中心放置特殊格子，让评分出现差异
+				Game.GetSpecialAreas().SetEffect(0, EMatch3Effect::SpeedUpSelf);
+				Game.GetSpecialAreas().SetEffect(BoardType::NumCells / 2, EMatch3Effect::MoraleBoost);
+
+				Ranker->Reset();
+				Ranker->Update(Game, ScoreMove, 0);
+
+				bool bCoverageOk = Ranker->IsComplete() && Ranker->Num() == Game.GetMoveIndex().Num();
+				for (int32 Rank = 0; Rank < Ranker->Num(); ++Rank)
+				{
+					const FMatch3MoveScore& Move = (*Ranker)[Rank];
+					bCoverageOk &= Game.IsValidSwap(Move.IndexA, Move.IndexB);
+					bCoverageOk &= Rank == 0 || (*Ranker)[Rank - 1].Score >= Move.Score;
+
+					BoardType Swapped = Game.GetBoard();
+					Swapped.SwapCells(Move.IndexA, Move.IndexB);
+					if (FMatch3Bits::Count(Swapped.FindMatches()) != Move.ClearedTiles)
+					{
+						ClearedMismatches++;
+					}
+				}
+				if (!bCoverageOk)
+				{
+					CoverageMismatches++;
+				}
+
+				// 最小预算：每次调用只评估 MovesPerTimeCheck 个交换
+				Sliced->Reset();
+				while (!Sliced->Update(Game, ScoreMove, 1))
+				{
+					NumSlices++;
+				}
+				bool bSameRanking = Sliced->Num() == Ranker->Num();
+				for (int32 Rank = 0; bSameRanking && Rank < Ranker->Num(); ++Rank)
+				{
+					bSameRanking = (*Sliced)[Rank].IndexA == (*Ranker)[Rank].IndexA
+						&& (*Sliced)[Rank].IndexB == (*Ranker)[Rank].IndexB;
+				}
+				if (!bSameRanking)
+				{
+					SlicedMismatches++;
+				}
+			}
+
+			Verify(Context, Name, TEXT("covers all moves in order"), CoverageMismatches, NumBoards);
+			Verify(Context, Name, TEXT("cleared tiles == full scan"), ClearedMismatches, NumBoards);
+			Verify(Context, *FString::Printf(TEXT("%s sliced == one call (%d extra slices)"), Name, NumSlices), SlicedMismatches, NumBoards);
+
+			Run(Context, *FString::Printf(TEXT("%s.RankAll"), Name), [&GetGame, &Ranker, &ScoreMove](int32 BoardIndex)
+			{
+				Ranker->Reset();
+				Ranker->Update(GetGame(BoardIndex), ScoreMove, 0);
+				GSink = GSink + (*Ranker)[0].IndexA;
+			});
+		}
+
+		// 一步消除的派发数据（与 ADatamanagement 的 FMatch3StepResult 对应）
+		struct FDispatchStep
+		{
+			TArray<int32> ClearedIndices;
+			int32 SpeedUpTriggers;
+			int32 SlowDownTriggers;
+			int32 MoraleReward;
+			int32 MoraleAfterStep;
+			int32 SkillPointsGained;
+			int32 SkillPointsAfterStep;
+		};
+
+		// 逐个事件派发：数组按值传参，与蓝图事件把参数复制进调用帧相同
+		DECLARE_MULTICAST_DELEGATE_TwoParams(FOnBenchMatchesCleared, TArray<int32> /*ClearedIndices*/, int32 /*NumEffects*/);
+		DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnBenchMoraleChanged, int32 /*NewMorale*/, int32 /*MaxMorale*/, int32 /*AddedAmount*/);
+		DECLARE_MULTICAST_DELEGATE_TwoParams(FOnBenchSkillPointChanged, int32 /*NewSkillPoints*/, int32 /*MaxSkillPoints*/);
+		DECLARE_MULTICAST_DELEGATE_TwoParams(FOnBenchEffectTriggered, int32 /*TriggerCount*/, float /*Amount*/);
+
+		// 合并派发：每步一个汇总结构，按引用传递
+		DECLARE_MULTICAST_DELEGATE_OneParam(FOnBenchStepResolved, const FDispatchStep& /*Step*/);
+
+		/**
+		 * 每步消除的事件派发开销
+		 * PerEvent 按 ADatamanagement 旧的顺序派发：士气值、每个技能点、加速、减速、消除（复制索引数组）；
+		 * Coalesced 每步只派发一次汇总结构。两者的监听者累计相同的数据，校验结果一致、合并派发不分配堆内存
+		 * （蓝图虚拟机的调用开销不在本程序中，这里只比较事件个数与参数复制的差异）
+		 */
+		void RunEventDispatch(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Dispatch");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			FMatch3SpecialAreas SpecialAreas;
+			SpecialAreas.SetEffect(FMatch3Board::ToIndex(3, 3), EMatch3Effect::MoraleBoost);
+			SpecialAreas.SetEffect(FMatch3Board::ToIndex(3, 1), EMatch3Effect::SpeedUpSelf);
+			SpecialAreas.SetEffect(FMatch3Board::ToIndex(3, 5), EMatch3Effect::SlowDownEnemy);
+
+			// 用测试棋盘的首次消除构造每一步的结果，士气值连续累积（技能点满时清空，保持有技能点事件）
+			const FMatch3MoraleConfig MoraleConfig;
+			FMatch3MoraleState Morale;
+			TArray<FDispatchStep> Steps;
+			Steps.SetNum(NumBoards);
+			for (int32 BoardIndex = 0; BoardIndex < NumBoards; ++BoardIndex)
+			{
+				const uint64 MatchedMask = Context.SwapCases[BoardIndex].MatchedMask;
+				FDispatchStep& Step = Steps[BoardIndex];
+				FMatch3Bits::ForEach(MatchedMask, [&Step](int32 Index)
+				{
+					Step.ClearedIndices.Add(Index);
+				});
+				Step.SpeedUpTriggers = SpecialAreas.CountHits(MatchedMask, EMatch3Effect::SpeedUpSelf);
+				Step.SlowDownTriggers = SpecialAreas.CountHits(MatchedMask, EMatch3Effect::SlowDownEnemy);
+				Step.MoraleReward = FMatch3Morale::CalculateReward(MoraleConfig, FMatch3Bits::Count(MatchedMask),
+					SpecialAreas.CountHits(MatchedMask, EMatch3Effect::MoraleBoost));
+
+				if (Morale.SkillPoints >= MoraleConfig.MaxSkillPoints)
+				{
+					Morale.SkillPoints = 0;
+				}
+				Step.SkillPointsGained = FMatch3Morale::AddMorale(Morale, MoraleConfig, Step.MoraleReward).SkillPointsGained;
+				Step.MoraleAfterStep = Morale.CurrentMorale;
+				Step.SkillPointsAfterStep = Morale.SkillPoints;
+			}
+
+			// 两种派发方式各挂一个监听者，累计相同的数据
+			int64 PerEventSum = 0;
+			FOnBenchMatchesCleared OnMatchesCleared;
+			FOnBenchMoraleChanged OnMoraleChanged;
+			FOnBenchSkillPointChanged OnSkillPointChanged;
+			FOnBenchEffectTriggered OnSpeedUpTriggered;
+			FOnBenchEffectTriggered OnSlowDownTriggered;
+			OnMatchesCleared.AddLambda([&PerEventSum](TArray<int32> ClearedIndices, int32 NumEffects) { PerEventSum += ClearedIndices.Num(); });
+			OnMoraleChanged.AddLambda([&PerEventSum](int32 NewMorale, int32 MaxMorale, int32 AddedAmount) { PerEventSum += AddedAmount; });
+			OnSkillPointChanged.AddLambda([&PerEventSum](int32 NewSkillPoints, int32 MaxSkillPoints) { PerEventSum += 1; });
+			OnSpeedUpTriggered.AddLambda([&PerEventSum](int32 TriggerCount, float Amount) { PerEventSum += TriggerCount; });
+			OnSlowDownTriggered.AddLambda([&PerEventSum](int32 TriggerCount, float Amount) { PerEventSum += TriggerCount; });
+
+			int64 CoalescedSum = 0;
+			FOnBenchStepResolved OnStepResolved;
+			OnStepResolved.AddLambda([&CoalescedSum](const FDispatchStep& Step)
+			{
+				CoalescedSum += Step.ClearedIndices.Num() + Step.MoraleReward + Step.SkillPointsGained
+					+ Step.SpeedUpTriggers + Step.SlowDownTriggers;
+			});
+
+			auto DispatchPerEvent = [&](const FDispatchStep& Step)
+			{
+				OnMoraleChanged.Broadcast(Step.MoraleAfterStep, MoraleConfig.MaxMorale, Step.MoraleReward);
+				for (int32 Gained = 0; Gained < Step.SkillPointsGained; ++Gained)
+				{
+					OnSkillPointChanged.Broadcast(Step.SkillPointsAfterStep, MoraleConfig.MaxSkillPoints);
+				}
+				if (Step.SpeedUpTriggers > 0)
+				{
+					OnSpeedUpTriggered.Broadcast(Step.SpeedUpTriggers, 1.0f);
+				}
+				if (Step.SlowDownTriggers > 0)
+				{
+					OnSlowDownTriggered.Broadcast(Step.SlowDownTriggers, 1.0f);
+				}
+				OnMatchesCleared.Broadcast(Step.ClearedIndices, (int32)(Step.SpeedUpTriggers > 0) + (int32)(Step.SlowDownTriggers > 0));
+			};
+
+			for (const FDispatchStep& Step : Steps)
+			{
+				DispatchPerEvent(Step);
+				OnStepResolved.Broadcast(Step);
+			}
+			Verify(Context, TEXT("Dispatch coalesced == per event"), PerEventSum != CoalescedSum ? 1 : 0, NumBoards);
+
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				FBenchAllocationCounter::Begin();
+				for (const FDispatchStep& Step : Steps)
+				{
+					OnStepResolved.Broadcast(Step);
+				}
+				const int64 NumAllocations = FBenchAllocationCounter::End();
+				Verify(Context, TEXT("Dispatch coalesced allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumBoards);
+			}
+
+			Run(Context, TEXT("Dispatch.PerEvent"), [&Steps, &DispatchPerEvent](int32 BoardIndex)
+			{
+				DispatchPerEvent(Steps[BoardIndex]);
+			});
+			Run(Context, TEXT("Dispatch.Coalesced"), [&Steps, &OnStepResolved](int32 BoardIndex)
+			{
+				OnStepResolved.Broadcast(Steps[BoardIndex]);
+			});
+			GSink = GSink + PerEventSum + CoalescedSum;
+		}
+
+		// 空洞形状：去掉四角各 2x2 与中心 2x2 的格子
+		template <typename BoardType>
+		typename BoardType::FMask MakeHolesShape()
+		{
+			using FMask = typename BoardType::FMask;
+			constexpr int32 Rows = BoardType::Rows;
+			constexpr int32 Cols = BoardType::Cols;
+
+			const FMask Holes = FMatch3Bits::Rect<FMask>(Cols, 0, 2, 0, 2)
+				| FMatch3Bits::Rect<FMask>(Cols, 0, 2, Cols - 2, Cols)
+				| FMatch3Bits::Rect<FMask>(Cols, Rows - 2, Rows, 0, 2)
+				| FMatch3Bits::Rect<FMask>(Cols, Rows - 2, Rows, Cols - 2, Cols)
+				| FMatch3Bits::Rect<FMask>(Cols, Rows / 2 - 1, Rows / 2 + 1, Cols / 2 - 1, Cols / 2 + 1);
+			return BoardType::BoardMask & ~Holes;
+		}
+
+		/**
+		 * 其它棋盘规格（大棋盘、不规则形状）
+		 * 每个棋盘逐步结算若干回合，校验局部检查、增量索引、死锁检测与形状约束，再测量生成与完整回合的耗时
+		 */
+		template <typename GameType>
+		void RunVariant(FBenchContext& Context, const TCHAR* Name, typename GameType::FMask PlayableMask)
+		{
+			using BoardType = typename GameType::FBoard;
+			using FMask = typename GameType::FMask;
+
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumTurnsPerBoard = 32;
+			auto NoMove = [](int32, int32, uint8, bool) {};
+
+			// 空洞中没有方块，且可用格子全部被填满
+			auto IsShapeValid = [PlayableMask](const BoardType& Board)
+			{
+				return !(Board.GetOccupiedMask() & ~PlayableMask) && !Board.GetEmptyMask();
+			};
+
+			struct FVariantCase
+			{
+				GameType Stable;
+				int32 IndexA;
+				int32 IndexB;
+			};
+			TArray<FVariantCase> Cases;
+			Cases.SetNum(NumBoards);
+
+			int32 InvalidBoards = 0;
+			int32 LocalMismatches = 0;
+			int32 IndexMismatches = 0;
+			int32 DeadlockMismatches = 0;
+			int32 ShapeViolations = 0;
+
+			const int32 NumTurns = ForEachBoardTurn(NumTurnsPerBoard,
+				[&Cases, &InvalidBoards, &IsShapeValid, PlayableMask](int32 BoardIndex, auto& RandHelper)
+				{
+					GameType& Game = Cases[BoardIndex].Stable;
+					Game.SetPlayableMask(PlayableMask);
+					Game.Generate(RandHelper);
+					if (Game.GetBoard().HasMatch() || !Game.HasAnyValidMove() || !IsShapeValid(Game.GetBoard()))
+					{
+						InvalidBoards++;
+						return false;
+					}
+					return true;
+				},
+				[&](int32 BoardIndex, auto& RandHelper)
+				{
+					GameType& Game = Cases[BoardIndex].Stable;
+					auto NextColor = [&RandHelper]() { return (uint8)RandHelper(BoardType::NumColors); };
+
+					int32 SwapA = INDEX_NONE;
+					int32 SwapB = INDEX_NONE;
+					PickRandomMove(Game.GetMoveIndex(), RandHelper, SwapA, SwapB);
+
+					Game.ApplySwap(SwapA, SwapB);
+					for (;;)
+					{
+						FMask Horizontal, Vertical;
+						Game.FindMatches(Horizontal, Vertical);
+						if ((Horizontal | Vertical) != Game.GetBoard().FindMatches())
+						{
+							LocalMismatches++;
+						}
+						if (!(Horizontal | Vertical))
+						{
+							break;
+						}
+
+						Game.ClearCells(Horizontal | Vertical);
+						Game.CollapseAndRefill(NextColor, NoMove);
+					}
+
+					Game.Settle();
+					TMatch3MoveIndex<BoardType> Rebuilt;
+					Rebuilt.Rebuild(Game.GetBoard());
+					if (Rebuilt.GetHorizontalMoves() != Game.GetMoveIndex().GetHorizontalMoves()
+						|| Rebuilt.GetVerticalMoves() != Game.GetMoveIndex().GetVerticalMoves())
+					{
+						IndexMismatches++;
+					}
+					if (HasAnyMoveBruteForce(Game.GetBoard()) != Game.HasAnyValidMove())
+					{
+						DeadlockMismatches++;
+					}
+					if (!IsShapeValid(Game.GetBoard()))
+					{
+						ShapeViolations++;
+					}
+					if (!Game.HasAnyValidMove())
+					{
+						Game.Reshuffle(RandHelper);
+					}
+				},
+				[&Cases](int32 BoardIndex, auto& RandHelper)
+				{
+					FVariantCase& Case = Cases[BoardIndex];
+					PickRandomMove(Case.Stable.GetMoveIndex(), RandHelper, Case.IndexA, Case.IndexB);
+				});
+
+			Verify(Context, Name, TEXT("boards valid"), InvalidBoards, NumBoards);
+			Verify(Context, Name, TEXT("local match check == full scan"), LocalMismatches, NumTurns);
+			Verify(Context, Name, TEXT("incremental index == rebuild"), IndexMismatches, NumTurns);
+			Verify(Context, Name, TEXT("deadlock index == brute force"), DeadlockMismatches, NumTurns);
+			Verify(Context, Name, TEXT("shape kept after fall"), ShapeViolations, NumTurns);
+
+			FRandomStream Stream(0);
+			auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+
+			Run(Context, *FString::Printf(TEXT("%s.Generate"), Name), [&RandHelper, PlayableMask](int32 BoardIndex)
+			{
+				BoardType Board;
+				Board.SetPlayableMask(PlayableMask);
+				TMatch3Generator<BoardType>::Generate(Board, RandHelper);
+				GSink = GSink + FMatch3Bits::Count(Board.GetColorMask(0));
+			});
+
+			Run(Context, *FString::Printf(TEXT("%s.PlayMove"), Name), [&Cases, &RandHelper](int32 BoardIndex)
+			{
+				const FVariantCase& Case = Cases[BoardIndex];
+				GameType Game = Case.Stable;
+				GSink = GSink + Game.PlayMove(Case.IndexA, Case.IndexB, RandHelper).ClearedTiles;
+			});
+
+			RunMoveRanker<GameType>(Context, *FString::Printf(TEXT("%s.Hints"), Name), [&Cases](int32 BoardIndex) -> const GameType&
+			{
+				return Cases[BoardIndex].Stable;
+			});
+		}
+
+		/**
+		 * 锁定格子（铁索连环）
+		 * 每个棋盘逐回合重新锁定 NumLockCells 个格子再走一步，校验增量索引、锁定格子不可交换、不会锁成死锁、洗牌保留锁定，
+		 * 并比较贪心选择与随机选择去掉的有效交换数
+		 */
+		template <typename GameType>
+		void RunLockedCells(FBenchContext& Context, const TCHAR* Name, typename GameType::FMask PlayableMask)
+		{
+			using BoardType = typename GameType::FBoard;
+			using FMask = typename GameType::FMask;
+			constexpr int32 Cols = BoardType::Cols;
+
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumTurnsPerBoard = 16;
+			constexpr int32 NumLockCells = 4;
+
+			// 有效交换中不能有以锁定格子为端点的边
+			auto TouchesLocked = [](const GameType& Game)
+			{
+				const FMask Locked = Game.GetLockedMask();
+				return !!((Game.GetMoveIndex().GetHorizontalMoves() & (Locked | (Locked >> 1)))
+					| (Game.GetMoveIndex().GetVerticalMoves() & (Locked | (Locked >> Cols))));
+			};
+			auto IndexMatchesRebuild = [](const GameType& Game)
+			{
+				TMatch3MoveIndex<BoardType> Rebuilt;
+				Rebuilt.Rebuild(Game.GetBoard());
+				return Rebuilt.GetHorizontalMoves() == Game.GetMoveIndex().GetHorizontalMoves()
+					&& Rebuilt.GetVerticalMoves() == Game.GetMoveIndex().GetVerticalMoves();
+			};
+			auto CountRemoved = [](const GameType& Game, FMask Cells)
+			{
+				GameType Scratch = Game;
+				Scratch.SetLockedMask(Scratch.GetLockedMask() | Cells);
+				return Game.GetMoveIndex().Num() - Scratch.GetMoveIndex().Num();
+			};
+
+			TArray<GameType> Cases;
+			Cases.SetNum(NumBoards);
+
+			int32 IndexMismatches = 0;
+			int32 LockedEdges = 0;
+			int32 Deadlocks = 0;
+			int32 DeadlockMismatches = 0;
+			int32 LockedSwapsAccepted = 0;
+			int32 ReshuffleFailures = 0;
+			int64 GreedyRemoved = 0;
+			int64 RandomRemoved = 0;
+
+			const int32 NumTurns = ForEachBoardTurn(NumTurnsPerBoard,
+				[&Cases, PlayableMask](int32 BoardIndex, auto& RandHelper)
+				{
+					GameType& Game = Cases[BoardIndex];
+					Game.SetPlayableMask(PlayableMask);
+					Game.Generate(RandHelper);
+					return true;
+				},
+				[&](int32 BoardIndex, auto& RandHelper)
+				{
+					GameType& Game = Cases[BoardIndex];
+
+					// 贪心选择与同样数量的随机格子
+					const FMask Picked = Game.PickLockCells(NumLockCells, RandHelper);
+					FMask RandomCells = 0;
+					for (int32 Pick = 0; Pick < NumLockCells; ++Pick)
+					{
+						const FMask Available = Game.GetBoard().GetSwappableMask() & ~RandomCells;
+						RandomCells |= BoardType::CellBit(FMatch3Bits::NthIndex(Available, RandHelper(FMatch3Bits::Count(Available))));
+					}
+					GreedyRemoved += CountRemoved(Game, Picked);
+					RandomRemoved += CountRemoved(Game, RandomCells);
+
+					// 换成新的锁定：同时有格子解锁和锁定
+					Game.SetLockedMask(Picked);
+					IndexMismatches += !IndexMatchesRebuild(Game);
+					LockedEdges += TouchesLocked(Game);
+					Deadlocks += !Game.HasAnyValidMove();
+					DeadlockMismatches += HasAnyMoveBruteForce(Game.GetBoard()) != Game.HasAnyValidMove();
+
+					// 以锁定格子为端点的交换一律拒绝
+					FMatch3Bits::ForEach(Picked, [&Game, &LockedSwapsAccepted, &RandHelper](int32 Index)
+					{
+						const int32 Neighbors[2] = { Index % Cols + 1 < Cols ? Index + 1 : INDEX_NONE, Index + Cols < BoardType::NumCells ? Index + Cols : INDEX_NONE };
+						for (int32 Neighbor : Neighbors)
+						{
+							if (Neighbor != INDEX_NONE)
+							{
+								GameType Scratch = Game;
+								LockedSwapsAccepted += Scratch.PlayMove(Index, Neighbor, RandHelper).NumSteps != 0;
+							}
+						}
+					});
+
+					// 洗牌后锁定不变、没有匹配且有有效交换
+					{
+						GameType Scratch = Game;
+						Scratch.Reshuffle(RandHelper);
+						ReshuffleFailures += Scratch.GetLockedMask() != Picked
+							|| Scratch.GetBoard().HasMatch()
+							|| !Scratch.HasAnyValidMove()
+							|| !IndexMatchesRebuild(Scratch)
+							|| TouchesLocked(Scratch);
+					}
+
+					// 走一步，锁定格子上的方块被消除后新方块依旧锁定
+					int32 SwapA = INDEX_NONE;
+					int32 SwapB = INDEX_NONE;
+					PickRandomMove(Game.GetMoveIndex(), RandHelper, SwapA, SwapB);
+					Game.PlayMove(SwapA, SwapB, RandHelper);
+					IndexMismatches += !IndexMatchesRebuild(Game);
+					LockedEdges += TouchesLocked(Game) || Game.GetLockedMask() != Picked;
+				},
+				[](int32, auto&) {});
+
+			Verify(Context, Name, TEXT("incremental index == rebuild"), IndexMismatches, NumTurns * 2);
+			Verify(Context, Name, TEXT("no valid swap touches a locked cell"), LockedEdges, NumTurns * 2);
+			Verify(Context, Name, TEXT("greedy lock never deadlocks"), Deadlocks, NumTurns);
+			Verify(Context, Name, TEXT("deadlock index == brute force"), DeadlockMismatches, NumTurns);
+			Verify(Context, Name, TEXT("locked swaps rejected"), LockedSwapsAccepted, NumTurns);
+			Verify(Context, Name, TEXT("reshuffle keeps locks"), ReshuffleFailures, NumTurns);
+			Verify(Context, Name, TEXT("greedy removes >= random"), GreedyRemoved >= RandomRemoved ? 0 : 1, 1);
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s removed swaps per lock: greedy %.2f, random %.2f"),
+				Name, (double)GreedyRemoved / NumTurns, (double)RandomRemoved / NumTurns);
+
+			FRandomStream Stream(0);
+			auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+
+			Run(Context, *FString::Printf(TEXT("%s.Pick%d"), Name, NumLockCells), [&Cases, &RandHelper](int32 BoardIndex)
+			{
+				GSink = GSink + FMatch3Bits::Count(Cases[BoardIndex].PickLockCells(NumLockCells, RandHelper));
+			});
+
+			Run(Context, *FString::Printf(TEXT("%s.SetLocked"), Name), [&Cases](int32 BoardIndex)
+			{
+				GameType Game = Cases[BoardIndex];
+				Game.SetLockedMask(0);
+				GSink = GSink + Game.GetMoveIndex().Num();
+			});
+		}
+	}
+
+	void RunBoardBenchmarks(FBenchContext& Context)
+	{
+		FRandomStream Stream(0);
+		auto RandHelper = [&Stream](int32 Max) { return Stream.RandHelper(Max); };
+		auto NextColor = [&Stream]() { return (uint8)Stream.RandHelper(FMatch3Board::NumColors); };
+		auto NoMove = [](int32, int32, uint8, bool) {};
+
+		// ========== 匹配检查 ==========
+
+		Run(Context, TEXT("MatchCheck.FullScan"), [&Context](int32 BoardIndex)
+		{
+			GSink = GSink + Context.RandomBoards[BoardIndex].FindMatches();
+		});
+
+		Run(Context, TEXT("MatchCheck.HasMatch"), [&Context](int32 BoardIndex)
+		{
+			GSink = GSink + Context.RandomBoards[BoardIndex].HasMatch();
+		});
+
+		Run(Context, TEXT("MatchCheck.LocalAfterSwap"), [&Context](int32 BoardIndex)
+		{
+			const FSwapCase& Case = Context.SwapCases[BoardIndex];
+			uint64 Horizontal, Vertical;
+			Case.Swapped.FindMatchesNear(Case.SwapMask, Horizontal, Vertical);
+			GSink = GSink + (Horizontal | Vertical);
+		});
+
+		// ========== 下落填充 ==========
+
+		Run(Context, TEXT("Fill.CollapseAndRefill"), [&Context, &NextColor, &NoMove](int32 BoardIndex)
+		{
+			FMatch3Board Board = Context.SwapCases[BoardIndex].Cleared;
+			GSink = GSink + Board.CollapseAndRefill(NextColor, NoMove);
+		});
+
+		// ========== 棋盘生成 ==========
+
+		Run(Context, TEXT("Generate"), [&RandHelper](int32 BoardIndex)
+		{
+			FMatch3Board Board;
+			FMatch3Generator::Generate(Board, RandHelper);
+			GSink = GSink + Board.GetColorMask(0);
+		});
+
+		Run(Context, TEXT("Generate.Reshuffle"), [&Context, &RandHelper](int32 BoardIndex)
+		{
+			FMatch3Board Board = Context.SwapCases[BoardIndex].Settled;
+			GSink = GSink + FMatch3Generator::Reshuffle(Board, RandHelper);
+		});
+
+		RunGenerateDistribution(Context);
+
+		// ========== 死锁检测 ==========
+
+		Run(Context, TEXT("Deadlock.IndexRebuild"), [&Context](int32 BoardIndex)
+		{
+			FMatch3MoveIndex MoveIndex;
+			MoveIndex.Rebuild(Context.SwapCases[BoardIndex].Settled);
+			GSink = GSink + MoveIndex.HasAnyMove();
+		});
+
+		Run(Context, TEXT("Deadlock.IndexUpdate"), [&Context](int32 BoardIndex)
+		{
+			const FSwapCase& Case = Context.SwapCases[BoardIndex];
+			FMatch3MoveIndex MoveIndex = Case.Stable.GetMoveIndex();
+			MoveIndex.Update(Case.Filled, Case.DirtyMask);
+			GSink = GSink + MoveIndex.HasAnyMove();
+		});
+
+		Run(Context, TEXT("Deadlock.BruteForce"), [&Context](int32 BoardIndex)
+		{
+			GSink = GSink + HasAnyMoveBruteForce(Context.SwapCases[BoardIndex].Settled);
+		});
+
+		// ========== 完整回合 ==========
+
+		Run(Context, TEXT("Turn.PlayMove"), [&Context, &RandHelper](int32 BoardIndex)
+		{
+			const FSwapCase& Case = Context.SwapCases[BoardIndex];
+			FMatch3Game Game = Case.Stable;
+			GSink = GSink + Game.PlayMove(Case.IndexA, Case.IndexB, RandHelper).ClearedTiles;
+		});
+
+		// ========== 交换提示 ==========
+
+		RunMoveRanker<FMatch3Game>(Context, TEXT("Hints"), [&Context](int32 BoardIndex) -> const FMatch3Game&
+		{
+			return Context.SwapCases[BoardIndex].Stable;
+		});
+
+		// ========== 事件派发 ==========
+
+		RunEventDispatch(Context);
+
+		// ========== 锁定格子（铁索连环）==========
+
+		RunLockedCells<FMatch3Game>(Context, TEXT("Lock"), FMatch3Board::BoardMask);
+		RunLockedCells<FMatch3Game12x12>(Context, TEXT("Lock.12x12x6.Holes"), MakeHolesShape<FMatch3Game12x12::FBoard>());
+
+		// ========== 内存分配 ==========
+
+		VerifySteadyStateAllocations(Context);
+
+		// ========== 其它棋盘规格 ==========
+
+		RunVariant<FMatch3Game9x9>(Context, TEXT("Variant.9x9x5"), FMatch3Game9x9::FBoard::BoardMask);
+		RunVariant<FMatch3Game12x12>(Context, TEXT("Variant.12x12x6"), FMatch3Game12x12::FBoard::BoardMask);
+		RunVariant<FMatch3Game12x12>(Context, TEXT("Variant.12x12x6.Holes"), MakeHolesShape<FMatch3Game12x12::FBoard>());
+	}
+}
@@ -0,0 +1,291 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BenchContext.h"
+#include "Match3Morale.h"
+#include "Match3NetDelta.h"
+
+namespace Match3Bench
+{
+	namespace
+	{
+		// 网络同步的服务器端棋盘：按 ADatamanagement 逐步模式的操作顺序结算并记录
+		struct FNetDeltaServer
+		{
+			FMatch3Game Game;
+			FMatch3MoraleState Morale;
+			FMatch3MoraleConfig MoraleConfig;
+			FRandomStream Stream;
+			FMatch3NetDeltaWriter Writer;
+			int32 NumSteps;
+
+			explicit FNetDeltaServer(int32 Seed)
+				: Stream(Seed)
+				, NumSteps(0)
+			{
+				Game.Generate([this](int32 Max) { return Stream.RandHelper(Max); });
+				Writer.RecordKeyframe(Game, false, 0);
+			}
+
+			void ReshuffleIfDeadlocked()
+			{
+				if (!Game.HasAnyValidMove())
+				{
+					Game.Reshuffle([this](int32 Max) { return Stream.RandHelper(Max); });
+					Writer.RecordKeyframe(Game, true, 0);
+				}
+			}
+
+			// 一回合：按回合数穿插锁定 / 解锁、特殊格子改变与技能点消耗，再走一步并结算全部连消
+			void PlayTurn(int32 Turn)
+			{
+				auto RandHelper = [this](int32 Max) { return Stream.RandHelper(Max); };
+
+				if (Turn % 8 == 3)
+				{
+					Game.SetLockedMask(Game.GetLockedMask() | Game.PickLockCells(4, RandHelper));
+					Writer.RecordLocked(Game.GetLockedMask());
+					ReshuffleIfDeadlocked();
+				}
+				else if (Turn % 8 == 7)
+				{
+					Game.SetLockedMask(0);
+					Writer.RecordLocked(0);
+				}
+				if (Turn % 16 == 5)
+				{
+					FMatch3SpecialAreas SpecialAreas;
+					for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+					{
+						SpecialAreas.SetEffectMask((EMatch3Effect)Type, FMatch3Board::CellBit(RandHelper(FMatch3Board::NumCells)));
+					}
+					Game.GetSpecialAreas() = SpecialAreas;
+					Writer.RecordSpecialAreas(SpecialAreas);
+				}
+				if (Turn % 5 == 0)
+				{
+					FMatch3Morale::ConsumeSkillPoints(Morale, 1);
+				}
+
+				int32 SwapA = INDEX_NONE;
+				int32 SwapB = INDEX_NONE;
+				PickRandomMove(Game.GetMoveIndex(), RandHelper, SwapA, SwapB);
+				Game.ApplySwap(SwapA, SwapB);
+				Writer.RecordSwap(SwapA, SwapB, true);
+				for (;;)
+				{
+					uint64 Horizontal, Vertical;
+					Game.FindMatches(Horizontal, Vertical);
+					const uint64 MatchedMask = Horizontal | Vertical;
+					if (!MatchedMask)
+					{
+						break;
+					}
+
+					NumSteps++;
+					FMatch3Morale::AddMorale(Morale, MoraleConfig, FMatch3Morale::CalculateReward(MoraleConfig,
+						FMatch3Bits::Count(MatchedMask), Game.GetSpecialAreas().CountHits(MatchedMask, EMatch3Effect::MoraleBoost)));
+					Writer.RecordMorale(Morale);
+					Writer.RecordClear(MatchedMask);
+					Game.ClearCells(MatchedMask);
+					Writer.BeginFill();
+					Game.CollapseAndRefill(
+						[this]()
+						{
+							const uint8 Color = (uint8)Stream.RandHelper(FMatch3Board::NumColors);
+							Writer.RecordFillColor(Color);
+							return Color;
+						},
+						[](int32, int32, uint8, bool) {});
+				}
+				Game.Settle();
+				Writer.RecordSettle();
+				ReshuffleIfDeadlocked();
+			}
+
+			// 取走本回合的消息
+			const TArray<uint8>& Flush()
+			{
+				Writer.RecordMorale(Morale);
+				return Writer.Finish(FMatch3NetDelta::ComputeChecksum(Game, Morale));
+			}
+		};
+
+		// 两块棋盘的方块、锁定、特殊格子、士气值与可交换索引都相同
+		bool SameNetBoard(const FNetDeltaServer& Server, const FMatch3Game& Game, const FMatch3MoraleState& Morale)
+		{
+			bool bSame = FMatch3NetDelta::ComputeChecksum(Server.Game, Server.Morale) == FMatch3NetDelta::ComputeChecksum(Game, Morale)
+				&& Server.Game.GetBoard().GetPlayableMask() == Game.GetBoard().GetPlayableMask()
+				&& Server.Game.GetMoveIndex().GetHorizontalMoves() == Game.GetMoveIndex().GetHorizontalMoves()
+				&& Server.Game.GetMoveIndex().GetVerticalMoves() == Game.GetMoveIndex().GetVerticalMoves();
+			for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+			{
+				bSame &= Server.Game.GetSpecialAreas().GetEffectMask((EMatch3Effect)Type) == Game.GetSpecialAreas().GetEffectMask((EMatch3Effect)Type);
+			}
+			return bSame;
+		}
+
+		/**
+		 * 棋盘网络同步
+		 * 服务器端棋盘每回合取走一条消息，客户端棋盘只应用消息：每回合后两块棋盘必须逐位相同、校验值一致；
+		 * 中途加入的客户端从 Keyframe 开始同步；改动任一字节的消息要么被发现（出错或校验值不一致），要么不影响棋盘
+		 * 报告每回合的字节数，与每个结算步骤发送整个棋盘（每格1字节）比较
+		 */
+		void RunNetDelta(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("NetDelta");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumMatches = 64;
+			constexpr int32 NumTurnsPerMatch = 48;
+			constexpr int32 LateJoinTurn = NumTurnsPerMatch / 2;
+
+			int32 DeltaMismatches = 0;
+			int32 LateJoinMismatches = 0;
+			int32 UndetectedCorruptions = 0;
+			int32 NumCorruptions = 0;
+			int32 InvalidStatesAccepted = 0;
+			int64 KeyframeBytes = 0;
+			int64 NumSteps = 0;
+			int64 NumMessageBytes = 0;
+
+			// 计时用：每条消息与应用前的客户端棋盘
+			struct FNetDeltaCase
+			{
+				FMatch3Game Game;
+				FMatch3MoraleState Morale;
+				TArray<uint8> Message;
+			};
+			TArray<FNetDeltaCase> Cases;
+			Cases.Reserve(NumBoards);
+
+			for (int32 Match = 0; Match < NumMatches; ++Match)
+			{
+				FNetDeltaServer Server(Match + 1);
+				FMatch3Game Client;
+				FMatch3MoraleState ClientMorale;
+				FMatch3Game LateClient;
+				FMatch3MoraleState LateMorale;
+
+				// 开局消息只有 Keyframe
+				{
+					const TArray<uint8>& Message = Server.Flush();
+					KeyframeBytes += Message.Num();
+					DeltaMismatches += !FMatch3NetDelta::Apply(Message.GetData(), Message.Num(), Client, ClientMorale);
+					Server.Writer.Clear();
+				}
+
+				// 流程状态超出范围的 Keyframe（游戏中 EMatch3State 只到 6）：报告错误且不修改棋盘
+				{
+					constexpr uint8 MaxHostState = 6;
+					FMatch3NetDeltaWriter BadWriter;
+					BadWriter.RecordKeyframe(Server.Game, false, MaxHostState + 1);
+					const TArray<uint8>& Bad = BadWriter.Finish(0);
+
+					FMatch3NetDeltaReader Reader(Bad.GetData(), Bad.Num());
+					FMatch3Game Game = Client;
+					EMatch3NetOp Op;
+					bool bReshuffle;
+					uint8 HostState;
+					if (Reader.Next(Op) && Op == EMatch3NetOp::Keyframe)
+					{
+						Reader.ReadKeyframe(Game, bReshuffle, HostState, MaxHostState);
+					}
+					InvalidStatesAccepted += !Reader.HasError() || !SameNetBoard(Server, Game, ClientMorale);
+				}
+
+				for (int32 Turn = 0; Turn < NumTurnsPerMatch; ++Turn)
+				{
+					// 中途加入：服务器为新客户端补发 Keyframe 与士气值（已在游戏中的客户端同样收到）
+					if (Turn == LateJoinTurn)
+					{
+						Server.Writer.RecordKeyframe(Server.Game, false, 0);
+						Server.Writer.ResendMorale();
+					}
+
+					Server.PlayTurn(Turn);
+					const TArray<uint8>& Message = Server.Flush();
+					NumMessageBytes += Message.Num();
+
+					if (Cases.Num() < NumBoards)
+					{
+						Cases.Add(FNetDeltaCase{ Client, ClientMorale, Message });
+					}
+
+					// 改动一个字节：应用到副本上
+					{
+						TArray<uint8> Corrupted = Message;
+						Corrupted[Server.Stream.RandHelper(Corrupted.Num())] ^= 0x5A;
+						FMatch3Game Game = Client;
+						FMatch3MoraleState Morale = ClientMorale;
+						UndetectedCorruptions += FMatch3NetDelta::Apply(Corrupted.GetData(), Corrupted.Num(), Game, Morale)
+							&& !SameNetBoard(Server, Game, Morale);
+						NumCorruptions++;
+					}
+
+					DeltaMismatches += !FMatch3NetDelta::Apply(Message.GetData(), Message.Num(), Client, ClientMorale)
+						|| !SameNetBoard(Server, Client, ClientMorale);
+					if (Turn >= LateJoinTurn)
+					{
+						LateJoinMismatches += !FMatch3NetDelta::Apply(Message.GetData(), Message.Num(), LateClient, LateMorale)
+							|| !SameNetBoard(Server, LateClient, LateMorale);
+					}
+					Server.Writer.Clear();
+				}
+				NumSteps += Server.NumSteps;
+			}
+
+			const int32 NumTurns = NumMatches * NumTurnsPerMatch;
+			Verify(Context, TEXT("NetDelta client == server every turn"), DeltaMismatches, NumTurns + NumMatches);
+			Verify(Context, TEXT("NetDelta late join from keyframe"), LateJoinMismatches, NumMatches * (NumTurnsPerMatch - LateJoinTurn));
+			Verify(Context, TEXT("NetDelta corrupted message detected"), UndetectedCorruptions, NumCorruptions);
+			Verify(Context, TEXT("NetDelta invalid keyframe state rejected"), InvalidStatesAccepted, NumMatches);
+
+			// 对照：交换后与每个结算步骤之后发送整个棋盘
+			const int64 FullBoardBytes = (NumTurns + NumSteps) * FMatch3Board::NumCells;
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %.1f bytes/turn (%.2f steps/turn), keyframe %lld bytes, full board per step %.1f bytes/turn (%.1fx)"),
+				Name, (double)NumMessageBytes / NumTurns, (double)NumSteps / NumTurns, KeyframeBytes / NumMatches,
+				(double)FullBoardBytes / NumTurns, (double)FullBoardBytes / FMath::Max<int64>(NumMessageBytes, 1));
+
+			FNetDeltaServer Server(1);
+			Server.Writer.Clear();
+			int32 ServerTurn = 0;
+			Run(Context, TEXT("NetDelta.ServerTurn"), [&Server, &ServerTurn](int32)
+			{
+				Server.PlayTurn(ServerTurn++);
+				GSink = GSink + Server.Flush().Num();
+				Server.Writer.Clear();
+			});
+
+			Run(Context, TEXT("NetDelta.ClientApply"), [&Cases](int32 BoardIndex)
+			{
+				const FNetDeltaCase& Case = Cases[BoardIndex % Cases.Num()];
+				FMatch3Game Game = Case.Game;
+				FMatch3MoraleState Morale = Case.Morale;
+				GSink = GSink + FMatch3NetDelta::Apply(Case.Message.GetData(), Case.Message.Num(), Game, Morale);
+			});
+
+			// 预热后记录与取走消息不分配堆内存
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				constexpr int32 NumServerTurns = 1000;
+				FBenchAllocationCounter::Begin();
+				for (int32 Turn = 0; Turn < NumServerTurns; ++Turn)
+				{
+					Server.PlayTurn(ServerTurn++);
+					GSink = GSink + Server.Flush().Num();
+					Server.Writer.Clear();
+				}
+				const int64 NumAllocations = FBenchAllocationCounter::End();
+				Verify(Context, TEXT("NetDelta server allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumServerTurns);
+			}
+		}
+	}
+
+	void RunNetDeltaBenchmarks(FBenchContext& Context)
+	{
+		RunNetDelta(Context);
+	}
+}
@@ -0,0 +1,687 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BenchContext.h"
+#include "Match3AIPlayer.h"
+#include "Match3Morale.h"
+#include "RaceBoatRegistry.h"
+#include "RaceSimulation.h"
+#include "RaceSkillScheduler.h"
+#include "RaceReplay.h"
+#include "RaceSnapshot.h"
+
+namespace Match3Bench
+{
+	namespace
+	{
+		/**
+		 * 合成比赛的录制端：按 ADatamanagement 与 URaceSimulationComponent 的规则驱动玩家棋盘与比赛模拟（3条龙舟），同时录像
+		 * 玩家约每0.5秒操作一次（有效交换、无效交换、结算中的点击、取消选中），AI每3秒施法（水淹七军、铁索连环、空城计），
+		 * AI三消每秒一批加速，20秒时改变难度（特殊格子布局）
+		 */
+		struct FSyntheticRace
+		{
+			static constexpr int32 NumRaceBoats = 3;
+
+			FMatch3Game Game;
+			FMatch3MoraleConfig MoraleConfig;
+			FMatch3MoraleState Morale;
+			FRandomStream BoardStream;
+			FRandomStream RefillStream;
+			FRandomStream InputStream;
+			FRaceSimulation Simulation;
+			FRaceReplayWriter Writer;
+			TArray<uint8> Data;
+			int32 NumSwaps;
+			double Time;
+
+			FSyntheticRace()
+				: NumSwaps(0)
+				, Time(0.0)
+			{}
+
+			void Record(int32 Seed)
+			{
+				InputStream.Initialize(Seed);
+				BoardStream.Initialize(Seed * 3 + 1);
+				RefillStream.Initialize(Seed * 3 + 2);
+
+				// 默认布局：中间一行的加速 / 士气提升 / 减速
+				const int32 CenterRow = FMatch3Board::Rows / 2 * FMatch3Board::Cols;
+				Game.GetSpecialAreas().SetEffect(CenterRow + 1, EMatch3Effect::SpeedUpSelf);
+				Game.GetSpecialAreas().SetEffect(CenterRow + 3, EMatch3Effect::MoraleBoost);
+				Game.GetSpecialAreas().SetEffect(CenterRow + 5, EMatch3Effect::SlowDownEnemy);
+				Game.Generate([this](int32 Max) { return BoardStream.RandHelper(Max); });
+
+				Simulation.Reset(FRaceSimConfig(), NumRaceBoats);
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					Simulation.SetBaseSpeed(Boat, 146.0f + 4.0f * Boat);
+				}
+
+				FRaceReplayHeader Header;
+				Header.RaceSeed = Seed;
+				Header.BoardSeed = BoardStream.GetCurrentSeed();
+				Header.RefillSeed = RefillStream.GetCurrentSeed();
+				Header.Capture(Game, MoraleConfig, Morale, &Simulation);
+				Writer.Begin(Header, 0.0);
+
+				int64 UnlockStep = -1;
+				while (!Simulation.IsRaceComplete() && Simulation.GetSimTime() < 300.0f)
+				{
+					Time = Simulation.GetSimTime();
+					const int64 Step = Simulation.GetStepCount();
+					if (Step % 30 == 0)
+					{
+						PlayerTurn();
+					}
+					if (Step % 90 == 45 && (Morale.SkillPoints > 0 || InputStream.RandHelper(4) == 0))
+					{
+						// 巧借东风；技能点不足时也会尝试
+						const bool bSuccess = FMatch3Morale::ConsumeSkillPoints(Morale, 1);
+						Writer.RecordCastSkill(Time, 0, 0, bSuccess);
+						if (bSuccess)
+						{
+							ApplyStatus(0, ERaceStatus::EastWind, 250.0f, 5.0f, 0);
+						}
+					}
+					if (Step % 60 == 30)
+					{
+						ApplyStatus(1 + InputStream.RandHelper(2), ERaceStatus::SpeedBoost, 25.0f * (1 + InputStream.RandHelper(2)), 3.0f, INDEX_NONE);
+					}
+					if (Step % 180 == 90)
+					{
+						UnlockStep = AISkill(UnlockStep);
+					}
+					if (Step == UnlockStep)
+					{
+						Game.SetLockedMask(0);
+						Writer.RecordUnlockCells(Time);
+					}
+					if (Step == 1200)
+					{
+						FMatch3SpecialAreas SpecialAreas;
+						SpecialAreas.SetEffect(InputStream.RandHelper(FMatch3Board::NumCells), EMatch3Effect::SpeedUpSelf);
+						SpecialAreas.SetEffect(InputStream.RandHelper(FMatch3Board::NumCells), EMatch3Effect::SlowDownEnemy);
+						SpecialAreas.SetEffect(InputStream.RandHelper(FMatch3Board::NumCells), EMatch3Effect::MoraleBoost);
+						Writer.RecordDifficulty(Time, 2);
+						Writer.RecordSpecialAreas(Time, SpecialAreas);
+						Game.GetSpecialAreas() = SpecialAreas;
+					}
+
+					// 边录边取走
+					if (Writer.GetPendingBytes().Num() >= 1024)
+					{
+						Flush();
+					}
+					Simulation.Step();
+				}
+				Writer.RecordChecksum(Time, FRaceReplayPlayer::ComputeChecksum(Game, Morale));
+				Writer.End(Simulation.GetSimTime(), &Simulation);
+				Flush();
+			}
+
+			void Flush()
+			{
+				Data.Append(Writer.GetPendingBytes());
+				Writer.ClearPending();
+			}
+
+			void ApplyStatus(int32 Boat, ERaceStatus Status, float Magnitude, float Duration, int32 Source)
+			{
+				const bool bApplied = Simulation.ApplyStatus(Boat, Status, Magnitude, Duration, Source);
+				Writer.RecordStatus(Time, Simulation.GetStepCount(), Boat, (int32)Status, Magnitude, Duration, Source, bApplied);
+			}
+
+			void Tap(int32 TileIndex, bool bBoardBusy)
+			{
+				Writer.RecordTileInput(Time, TileIndex, bBoardBusy);
+			}
+
+			void PlayerTurn()
+			{
+				const FMatch3MoveIndex& MoveIndex = Game.GetMoveIndex();
+				const int32 Kind = InputStream.RandHelper(10);
+				if (Kind == 0 || MoveIndex.Num() == 0)
+				{
+					// 选中后取消
+					const int32 TileIndex = InputStream.RandHelper(FMatch3Board::NumCells);
+					Tap(TileIndex, false);
+					Tap(TileIndex, false);
+					return;
+				}
+
+				// 随机的相邻交换（通常无效）或随机的有效交换；Kind == 2 时第二次点击发生在结算动画中
+				int32 IndexA;
+				int32 IndexB;
+				if (Kind == 1)
+				{
+					IndexA = InputStream.RandHelper(FMatch3Board::NumCells - FMatch3Board::Cols);
+					IndexB = IndexA + FMatch3Board::Cols;
+				}
+				else
+				{
+					const int32 NumHorizontal = FMatch3Bits::Count(MoveIndex.GetHorizontalMoves());
+					const int32 Pick = InputStream.RandHelper(MoveIndex.Num());
+					IndexA = Pick < NumHorizontal
+						? FMatch3Bits::NthIndex(MoveIndex.GetHorizontalMoves(), Pick)
+						: FMatch3Bits::NthIndex(MoveIndex.GetVerticalMoves(), Pick - NumHorizontal);
+					IndexB = IndexA + (Pick < NumHorizontal ? 1 : FMatch3Board::Cols);
+				}
+
+				const bool bBoardBusy = Kind == 2;
+				Tap(IndexA, false);
+				Tap(IndexB, bBoardBusy);
+				if (!bBoardBusy && Game.IsValidSwap(IndexA, IndexB))
+				{
+					PlaySwap(IndexA, IndexB);
+				}
+			}
+
+			// 与 ADatamanagement::ResolveCascade 相同：逐步消除、士气值、加速/减速格子、填充，稳定后检查死锁并写入校验值
+			void PlaySwap(int32 IndexA, int32 IndexB)
+			{
+				NumSwaps++;
+				Game.ApplySwap(IndexA, IndexB);
+				for (;;)
+				{
+					uint64 Horizontal, Vertical;
+					Game.FindMatches(Horizontal, Vertical);
+					const uint64 MatchedMask = Horizontal | Vertical;
+					if (!MatchedMask)
+					{
+						break;
+					}
+
+					const FMatch3SpecialAreas& SpecialAreas = Game.GetSpecialAreas();
+					FMatch3Morale::AddMorale(Morale, MoraleConfig, FMatch3Morale::CalculateReward(MoraleConfig,
+						FMatch3Bits::Count(MatchedMask), SpecialAreas.CountHits(MatchedMask, EMatch3Effect::MoraleBoost)));
+					if (const int32 SpeedUpHits = SpecialAreas.CountHits(MatchedMask, EMatch3Effect::SpeedUpSelf))
+					{
+						ApplyStatus(0, ERaceStatus::SpeedBoost, 25.0f * SpeedUpHits, 3.0f, INDEX_NONE);
+					}
+					if (const int32 SlowDownHits = SpecialAreas.CountHits(MatchedMask, EMatch3Effect::SlowDownEnemy))
+					{
+						for (int32 Boat = 1; Boat < NumRaceBoats; ++Boat)
+						{
+							ApplyStatus(Boat, ERaceStatus::SlowDown, -20.0f * SlowDownHits, 3.0f, 0);
+						}
+					}
+
+					Game.ClearCells(MatchedMask);
+					Game.CollapseAndRefill(
+						[this]() { return (uint8)RefillStream.RandRange(0, FMatch3Board::NumColors - 1); },
+						[](int32, int32, uint8, bool) {});
+				}
+				Game.Settle();
+				ReshuffleIfDeadlocked();
+				Writer.RecordChecksum(Time, FRaceReplayPlayer::ComputeChecksum(Game, Morale));
+			}
+
+			void ReshuffleIfDeadlocked()
+			{
+				if (!Game.HasAnyValidMove())
+				{
+					Game.Reshuffle([this](int32 Max) { return BoardStream.RandHelper(Max); });
+				}
+			}
+
+			// AI施法，返回铁索连环的解锁步（没有新的锁定时返回原值）
+			int64 AISkill(int64 UnlockStep)
+			{
+				const int32 Caster = 1 + InputStream.RandHelper(2);
+				switch (InputStream.RandHelper(3))
+				{
+				case 0:
+				{
+					const int32 Target = (Caster + 1 + InputStream.RandHelper(2)) % NumRaceBoats;
+					Writer.RecordAISkill(Time, Caster, 1, Target, Simulation.GetStatusEffects().IsImmune(Target));
+					ApplyStatus(Target, ERaceStatus::FloodSeven, 0.0f, 2.0f, Caster);
+					return UnlockStep;
+				}
+				case 1:
+				{
+					Writer.RecordAISkill(Time, Caster, 3, 0, Simulation.GetStatusEffects().IsImmune(0));
+					const bool bWasLocked = Game.GetLockedMask() != 0;
+					ApplyStatus(0, ERaceStatus::IronChain, 4.0f, 4.0f, Caster);
+					if (bWasLocked || !Simulation.GetStatusEffects().Has(0, ERaceStatus::IronChain))
+					{
+						return UnlockStep;
+					}
+					const uint64 Picked = Game.PickLockCells(4, [this](int32 Max) { return InputStream.RandHelper(Max); });
+					Game.SetLockedMask(Game.GetLockedMask() | Picked);
+					Writer.RecordLockCells(Time, Picked);
+					ReshuffleIfDeadlocked();
+					Writer.RecordChecksum(Time, FRaceReplayPlayer::ComputeChecksum(Game, Morale));
+					return Simulation.GetStatusEffects().GetExpireStep(0, ERaceStatus::IronChain);
+				}
+				default:
+					Writer.RecordAISkill(Time, Caster, 4, Caster, false);
+					ApplyStatus(Caster, ERaceStatus::EmptyCity, 0.0f, 3.0f, Caster);
+					return UnlockStep;
+				}
+			}
+		};
+
+		// 回放一次并与录制结果比较，返回不一致的数量（读取错误算作一次）
+		int32 CheckReplay(const TArray<uint8>& Data, FRaceReplayPlayer& Player)
+		{
+			if (!Player.Open(Data.GetData(), Data.Num()) || !Player.PlayToEnd())
+			{
+				return Player.GetStats().NumMismatches() + 1;
+			}
+			return Player.GetStats().NumMismatches();
+		}
+
+		// 计时：从文件头开始完整回放 NumRuns 次
+		void TimeReplay(const TCHAR* Name, const TArray<uint8>& Data, FRaceReplayPlayer& Player, int32 NumRuns)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (int32 Run = 0; Run < NumRuns; ++Run)
+			{
+				Player.Open(Data.GetData(), Data.Num());
+				Player.PlayToEnd();
+				GSink = GSink + Player.GetStats().NumEvents;
+			}
+			const double WallSeconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) / 1000.0 / NumRuns;
+			const float RaceSeconds = Player.GetSimulation().GetSimTime();
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %d bytes, %d events, %.1f s race replayed in %.3f ms (%.0fx real time)"),
+				Name, Data.Num(), Player.GetStats().NumEvents, RaceSeconds, WallSeconds * 1000.0, RaceSeconds / FMath::Max(WallSeconds, 1e-9));
+		}
+
+		/**
+		 * 比赛录像
+		 * 合成比赛录制后无头回放：每个校验值、技能释放、状态效果与完成时间都必须与录制时一致；
+		 * 篡改文件头中的填充流种子后回放必须发现不一致，截断的录像必须报告未读完
+		 * 计时：整场比赛的回放（性能回归基准）
+		 */
+		void RunRaceReplay(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Replay");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumRaces = 8;
+			int32 NumMismatches = 0;
+			int32 NumSwapMismatches = 0;
+			int32 MaxBytes = 0;
+			FRaceReplayPlayer Player;
+			TArray<uint8> LongestRace;
+			for (int32 Seed = 1; Seed <= NumRaces; ++Seed)
+			{
+				FSyntheticRace Race;
+				Race.Record(Seed);
+				NumMismatches += CheckReplay(Race.Data, Player);
+				NumMismatches += FRaceReplayPlayer::ComputeChecksum(Player.GetGame(), Player.GetMorale())
+					!= FRaceReplayPlayer::ComputeChecksum(Race.Game, Race.Morale);
+				NumSwapMismatches += Player.GetStats().NumSwaps != Race.NumSwaps;
+				if (Race.Data.Num() > MaxBytes)
+				{
+					MaxBytes = Race.Data.Num();
+					LongestRace = Race.Data;
+				}
+			}
+			Verify(Context, TEXT("Replay matches recording"), NumMismatches, NumRaces);
+			Verify(Context, TEXT("Replay swaps == recorded swaps"), NumSwapMismatches, NumRaces);
+			Verify(Context, TEXT("Replay size <= 16 KB per race"), MaxBytes > 16 * 1024 ? 1 : 0, NumRaces);
+
+			// 篡改：填充流种子（文件头偏移 16）改变后，连消填充的方块不同
+			TArray<uint8> Tampered = LongestRace;
+			Tampered[16] ^= 0x5A;
+			Player.Open(Tampered.GetData(), Tampered.Num());
+			Player.PlayToEnd();
+			Verify(Context, TEXT("Replay detects divergence"), Player.GetStats().NumChecksumMismatches > 0 ? 0 : 1, 1);
+
+			// 截断：去掉最后的结束事件
+			TArray<uint8> Truncated = LongestRace;
+			Truncated.SetNum(Truncated.Num() - 4);
+			Player.Open(Truncated.GetData(), Truncated.Num());
+			Verify(Context, TEXT("Replay rejects truncated file"), !Player.PlayToEnd() && !Player.HasEnded() ? 0 : 1, 1);
+
+			TimeReplay(TEXT("Replay.FullRace"), LongestRace, Player, FMath::Max(1, Context.Options.Iterations / 1000));
+		}
+
+		// 快照用的比赛：三条龙舟的模拟与登记表、两条AI的三消棋盘、AI技能调度与目标选择，按模拟步推进
+		struct FSnapshotRace
+		{
+			static constexpr int32 NumRaceBoats = 3;
+			static constexpr int32 StepsPerBatch = 30;
+
+			FRaceSimulation Simulation;
+			FRaceBoatRegistry Registry;
+			FRaceSkillScheduler Scheduler;
+			FRaceSkillTargeting Targeting;
+			FMatch3AIPlayer Players[NumRaceBoats - 1];
+			FMatch3AIConfig AIConfig;
+			FRandomStream SkillStream;
+
+			void Start(int32 Seed)
+			{
+				FRaceSimConfig Config;
+				Config.TrackLength = 3000.0f;
+				Simulation.Reset(Config, NumRaceBoats);
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					Simulation.SetBaseSpeed(Boat, 150.0f + 5.0f * Boat);
+				}
+				Registry.Reset(NumRaceBoats);
+				Targeting.Reset(NumRaceBoats);
+				Scheduler.Reset(NumRaceBoats - 1);
+				SkillStream.Initialize(Seed);
+
+				FMatch3SpecialAreas SpecialAreas;
+				SpecialAreas.SetEffect(FMatch3Board::NumCells / 2 - 2, EMatch3Effect::SpeedUpSelf);
+				SpecialAreas.SetEffect(FMatch3Board::NumCells / 2 + 2, EMatch3Effect::SlowDownEnemy);
+				for (int32 Caster = 0; Caster < NumRaceBoats - 1; ++Caster)
+				{
+					Players[Caster].Initialize(Seed * 7 + Caster, SpecialAreas);
+					ScheduleCast(Caster);
+				}
+			}
+
+			double Now() const
+			{
+				return Simulation.GetSimTime();
+			}
+
+			// 释放时间与超越记忆都落在两步中间，快照中相对时间的舍入不会改变先后
+			void ScheduleCast(int32 Caster)
+			{
+				Scheduler.Schedule(Caster, Now() + (SkillStream.RandRange(30, 150) + 0.5) * Simulation.GetConfig().FixedStepSeconds);
+			}
+
+			// 完成比赛的AI不再交换与释放技能
+			void Step()
+			{
+				if (Simulation.GetStepCount() % StepsPerBatch == 0)
+				{
+					for (int32 Caster = 0; Caster < NumRaceBoats - 1; ++Caster)
+					{
+						const int32 Boat = Caster + 1;
+						if (Simulation.HasFinished(Boat))
+						{
+							continue;
+						}
+						const FMatch3AIBatchResult Batch = Players[Caster].PlayMoves(2, AIConfig);
+						if (const int64 SpeedUpHits = Batch.EffectHits[(int32)EMatch3Effect::SpeedUpSelf])
+						{
+							Simulation.ApplyStatus(Boat, ERaceStatus::SpeedBoost, 25.0f * SpeedUpHits, 3.0f, INDEX_NONE);
+						}
+						if (const int64 SlowDownHits = Batch.EffectHits[(int32)EMatch3Effect::SlowDownEnemy])
+						{
+							for (int32 Other = 0; Other < NumRaceBoats; ++Other)
+							{
+								if (Other != Boat)
+								{
+									Simulation.ApplyStatus(Other, ERaceStatus::SlowDown, -20.0f * SlowDownHits, 3.0f, Boat);
+								}
+							}
+						}
+					}
+				}
+
+				for (int32 Caster = Scheduler.PopDue(Now()); Caster != INDEX_NONE; Caster = Scheduler.PopDue(Now()))
+				{
+					const int32 Boat = Caster + 1;
+					if (Simulation.HasFinished(Boat))
+					{
+						continue;
+					}
+					const double MemorySeconds = 5.0 + 0.5 * Simulation.GetConfig().FixedStepSeconds;
+					const int32 Target = Targeting.PickTarget(Boat, ERaceTargetPolicy::Adaptive, Now(), MemorySeconds,
+						[this](int32 BoatIndex) { return !Simulation.GetStatusEffects().IsImmune(BoatIndex); },
+						[this](int32 Max) { return SkillStream.RandHelper(Max); });
+					if (Target != INDEX_NONE)
+					{
+						Simulation.ApplyStatus(Target, ERaceStatus::FloodSeven, 0.0f, 1.5f, Boat);
+					}
+					else
+					{
+						Simulation.ApplyStatus(Boat, ERaceStatus::EmptyCity, 0.0f, 3.0f, Boat);
+					}
+					ScheduleCast(Caster);
+				}
+
+				Simulation.Step();
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					Registry.SetProgress(Boat, Simulation.GetProgress(Boat));
+					if (Simulation.HasFinished(Boat) && !Registry.HasFinished(Boat))
+					{
+						Registry.MarkFinished(Boat, Simulation.GetFinishTime(Boat));
+					}
+				}
+				Registry.UpdateRanking();
+				Targeting.Observe(Registry, Now());
+			}
+
+			void RunToFinish()
+			{
+				while (!Simulation.IsRaceComplete() && Simulation.GetStepCount() < 100000)
+				{
+					Step();
+				}
+			}
+
+			void Write(FRaceSnapshotWriter& Writer) const
+			{
+				Simulation.WriteSnapshot(Writer);
+				Registry.WriteSnapshot(Writer);
+				Scheduler.WriteSnapshot(Writer, Now());
+				Targeting.WriteSnapshot(Writer, Now());
+				FRaceSnapshot::WriteStream(Writer, SkillStream);
+				for (const FMatch3AIPlayer& Player : Players)
+				{
+					Player.WriteSnapshot(Writer);
+				}
+			}
+
+			// 模拟先恢复，调度与目标选择的相对时间以恢复后的模拟时间为准
+			void Read(FRaceSnapshotReader& Reader)
+			{
+				Simulation.ReadSnapshot(Reader);
+				Registry.ReadSnapshot(Reader);
+				Scheduler.ReadSnapshot(Reader, Now());
+				Targeting.ReadSnapshot(Reader, Now());
+				FRaceSnapshot::ReadStream(Reader, SkillStream);
+				for (FMatch3AIPlayer& Player : Players)
+				{
+					Player.ReadSnapshot(Reader);
+				}
+			}
+
+			int32 Save(TArray<uint8>& Data) const
+			{
+				FRaceSnapshotWriter Writer(Data);
+				Write(Writer);
+				return Writer.Finish();
+			}
+
+			bool Restore(const TArray<uint8>& Data)
+			{
+				FRaceSnapshotReader Reader(Data.GetData(), Data.Num());
+				if (!Reader.IsValid())
+				{
+					return false;
+				}
+				Read(Reader);
+				return !Reader.HasError();
+			}
+		};
+
+		// 两场比赛的完成时间、排名与AI棋盘都逐位相同
+		bool SameRaceResult(const FSnapshotRace& A, const FSnapshotRace& B)
+		{
+			bool bSame = A.Simulation.GetStepCount() == B.Simulation.GetStepCount();
+			for (int32 Boat = 0; Boat < FSnapshotRace::NumRaceBoats; ++Boat)
+			{
+				bSame &= A.Simulation.GetFinishTime(Boat) == B.Simulation.GetFinishTime(Boat)
+					&& A.Registry.GetRank(Boat) == B.Registry.GetRank(Boat);
+			}
+			for (int32 Caster = 0; Caster < FSnapshotRace::NumRaceBoats - 1; ++Caster)
+			{
+				bSame &= FRaceReplayPlayer::ComputeChecksum(A.Players[Caster].GetGame(), A.Players[Caster].GetMoraleState())
+					== FRaceReplayPlayer::ComputeChecksum(B.Players[Caster].GetGame(), B.Players[Caster].GetMoraleState());
+			}
+			return bSame;
+		}
+
+		/**
+		 * 比赛快照
+		 * 比赛中途保存，恢复到另一场比赛后重新保存必须逐字节相同，两场比赛继续到结束的完成时间、排名与AI棋盘必须逐位一致；
+		 * 连消中途（待检查格子非空）的棋盘恢复后继续结算的结果相同；任一字节被改动或截断的快照在恢复任何状态之前被拒绝
+		 * 计时：一次保存与恢复（每帧回滚缓冲的开销），预热后保存不分配堆内存
+		 */
+		void RunRaceSnapshot(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Snapshot");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumRaces = 8;
+			int32 ResaveMismatches = 0;
+			int32 ResultMismatches = 0;
+			int32 MaxBytes = 0;
+			TArray<uint8> Data;
+			TArray<uint8> Resaved;
+			for (int32 Seed = 1; Seed <= NumRaces; ++Seed)
+			{
+				// 每场比赛在不同的步数保存
+				FSnapshotRace Original;
+				Original.Start(Seed);
+				for (int32 Step = 0; Step < 200 + 97 * Seed; ++Step)
+				{
+					Original.Step();
+				}
+				MaxBytes = FMath::Max(MaxBytes, Original.Save(Data));
+
+				FSnapshotRace Restored;
+				Restored.Start(Seed + 1000);
+				ResaveMismatches += !Restored.Restore(Data) || (Restored.Save(Resaved), Resaved != Data);
+
+				Original.RunToFinish();
+				Restored.RunToFinish();
+				ResultMismatches += !Original.Simulation.IsRaceComplete() || !SameRaceResult(Original, Restored);
+			}
+			Verify(Context, TEXT("Snapshot resave == original bytes"), ResaveMismatches, NumRaces);
+			Verify(Context, TEXT("Snapshot restored race == uninterrupted"), ResultMismatches, NumRaces);
+			Verify(Context, TEXT("Snapshot size <= 1 KB"), MaxBytes > 1024 ? 1 : 0, NumRaces);
+
+			// 连消中途：交换后尚未结算的棋盘，恢复后用同一个填充流继续结算
+			int32 CascadeMismatches = 0;
+			for (int32 CaseIndex = 0; CaseIndex < NumBoards; ++CaseIndex)
+			{
+				const FSwapCase& Case = Context.SwapCases[CaseIndex % Context.SwapCases.Num()];
+				FMatch3Game Original = Case.Stable;
+				Original.ApplySwap(Case.IndexA, Case.IndexB);
+				{
+					FRaceSnapshotWriter Writer(Data);
+					FRaceSnapshot::WriteGame(Writer, Original);
+					Writer.Finish();
+				}
+				FMatch3Game Restored;
+				FRaceSnapshotReader Reader(Data.GetData(), Data.Num());
+				FRaceSnapshot::ReadGame(Reader, Restored);
+
+				auto Resolve = [CaseIndex](FMatch3Game& Game)
+				{
+					FRandomStream Stream(CaseIndex);
+					for (;;)
+					{
+						uint64 Horizontal, Vertical;
+						Game.FindMatches(Horizontal, Vertical);
+						if (!(Horizontal | Vertical))
+						{
+							break;
+						}
+						Game.ClearCells(Horizontal | Vertical);
+						Game.CollapseAndRefill([&Stream]() { return (uint8)Stream.RandHelper(FMatch3Board::NumColors); }, [](int32, int32, uint8, bool) {});
+					}
+					Game.Settle();
+				};
+				Resolve(Original);
+				Resolve(Restored);
+				CascadeMismatches += Reader.HasError()
+					|| FRaceReplayPlayer::ComputeChecksum(Original, FMatch3MoraleState()) != FRaceReplayPlayer::ComputeChecksum(Restored, FMatch3MoraleState())
+					|| Original.GetMoveIndex().Num() != Restored.GetMoveIndex().Num();
+			}
+			Verify(Context, TEXT("Snapshot mid-cascade board resumes"), CascadeMismatches, NumBoards);
+
+			// 改动任一字节（CRC32 能发现所有单字节错误）或截断
+			FSnapshotRace Race;
+			Race.Start(1);
+			for (int32 Step = 0; Step < 600; ++Step)
+			{
+				Race.Step();
+			}
+			Race.Save(Data);
+			int32 AcceptedCorruptions = 0;
+			for (int32 ByteIndex = 0; ByteIndex < Data.Num(); ++ByteIndex)
+			{
+				TArray<uint8> Corrupted = Data;
+				Corrupted[ByteIndex] ^= 0x5A;
+				AcceptedCorruptions += FRaceSnapshotReader(Corrupted.GetData(), Corrupted.Num()).IsValid();
+			}
+			Verify(Context, TEXT("Snapshot rejects corrupted byte"), AcceptedCorruptions, Data.Num());
+			Verify(Context, TEXT("Snapshot rejects truncated data"), FRaceSnapshotReader(Data.GetData(), Data.Num() - 1).IsValid() ? 1 : 0, 1);
+
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %d bytes mid-race, %d bytes max, %lld bits of state"),
+				Name, Data.Num(), MaxBytes, (int64)(Data.Num() - FRaceSnapshotWriter::HeaderBytes) * 8);
+
+			Run(Context, TEXT("Snapshot.Save"), [&Race, &Data](int32)
+			{
+				GSink = GSink + Race.Save(Data);
+			});
+
+			FSnapshotRace Restored;
+			Restored.Start(1);
+			Run(Context, TEXT("Snapshot.Restore"), [&Restored, &Data](int32)
+			{
+				GSink = GSink + Restored.Restore(Data);
+			});
+
+			// 每帧保存到同一个数组：预热之后不分配堆内存
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				constexpr int32 NumSaves = 1000;
+				FBenchAllocationCounter::Begin();
+				for (int32 Save = 0; Save < NumSaves; ++Save)
+				{
+					GSink = GSink + Race.Save(Data);
+				}
+				const int64 NumAllocations = FBenchAllocationCounter::End();
+				Verify(Context, TEXT("Snapshot save allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumSaves);
+			}
+		}
+	}
+
+	void RunReplayBenchmarks(FBenchContext& Context)
+	{
+		RunRaceReplay(Context);
+		RunRaceSnapshot(Context);
+	}
+}
+
+bool RunReplayBenchmark(const TArray<uint8>& ReplayData, const FMatch3BenchOptions& Options)
+{
+	using namespace Match3Bench;
+
+	FRaceReplayPlayer Player;
+	const int32 NumMismatches = CheckReplay(ReplayData, Player);
+	const FRaceReplayStats& Stats = Player.GetStats();
+	UE_LOG(LogDragonBoatBench, Display, TEXT("Replay: seed %d, %d swaps (%d rejected), %d reshuffles, %d skills, %d AI skills, %d statuses, %d checksums"),
+		Player.GetHeader().RaceSeed, Stats.NumSwaps, Stats.NumRejectedSwaps, Stats.NumReshuffles, Stats.NumSkillCasts,
+		Stats.NumAISkills, Stats.NumStatuses, Stats.NumChecksums);
+	if (NumMismatches > 0)
+	{
+		UE_LOG(LogDragonBoatBench, Error, TEXT("Replay diverged at %.3f s (checksum %d, skill %d, status %d, finish %d), or the file is corrupt"),
+			Stats.FirstMismatchTime, Stats.NumChecksumMismatches, Stats.NumCastMismatches, Stats.NumStatusMismatches, Stats.NumFinishMismatches);
+		return false;
+	}
+
+	TimeReplay(TEXT("Replay.File"), ReplayData, Player, FMath::Max(1, Options.Iterations / 1000));
+	return true;
+}
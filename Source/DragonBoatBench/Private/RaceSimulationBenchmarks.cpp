@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BenchContext.h"
+#include "RaceBoatRegistry.h"
+#include "RaceSimulation.h"
+
+namespace Match3Bench
+{
+	namespace
+	{
+		/**
+		 * 龙舟排名（64 条龙舟，进度随机游走）
+		 * 校验：增量排名与完整排序结果相同、报告的排名变化恰好是排名改变的龙舟、稳态更新不分配堆内存
+		 * 再测量每次进度更新的增量排名与完整排序的耗时
+		 */
+		void RunRaceRanking(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Race");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumRaceBoats = 64;
+			constexpr float FinishProgress = 0.9f;
+
+			// 每次进度更新的进度快照：每条龙舟有基础速度，每次更新随机加减速，整场比赛跨越 NumBoards 次更新
+			TArray<float> Snapshots;
+			Snapshots.SetNumUninitialized(NumBoards * NumRaceBoats);
+			{
+				FRandomStream Stream(NumRaceBoats);
+				float Progresses[NumRaceBoats] = {};
+				float BaseSpeeds[NumRaceBoats];
+				for (float& BaseSpeed : BaseSpeeds)
+				{
+					BaseSpeed = Stream.FRandRange(1.0f, 1.2f) / NumBoards;
+				}
+				for (int32 Tick = 0; Tick < NumBoards; ++Tick)
+				{
+					for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+					{
+						Progresses[Boat] += BaseSpeeds[Boat] * Stream.FRandRange(0.5f, 1.5f);
+						Snapshots[Tick * NumRaceBoats + Boat] = FMath::Min(Progresses[Boat], 1.0f);
+					}
+				}
+			}
+
+			// 对照组：与旧实现相同，每次更新完整排序
+			TArray<float> SortProgresses;
+			TArray<float> SortFinishTimes;
+			TArray<int32> SortOrder;
+			TArray<int32> SortRanks;
+			SortProgresses.SetNumZeroed(NumRaceBoats);
+			SortFinishTimes.Init(-1.0f, NumRaceBoats);
+			SortOrder.SetNumUninitialized(NumRaceBoats);
+			SortRanks.SetNumUninitialized(NumRaceBoats);
+			auto FullSort = [&]()
+			{
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					SortOrder[Boat] = Boat;
+				}
+				SortOrder.Sort([&](int32 A, int32 B)
+				{
+					const bool bFinishedA = SortFinishTimes[A] >= 0.0f;
+					const bool bFinishedB = SortFinishTimes[B] >= 0.0f;
+					if (bFinishedA != bFinishedB)
+						return bFinishedA;
+					if (bFinishedA && SortFinishTimes[A] != SortFinishTimes[B])
+						return SortFinishTimes[A] < SortFinishTimes[B];
+					if (!bFinishedA && SortProgresses[A] != SortProgresses[B])
+						return SortProgresses[A] > SortProgresses[B];
+					return A < B;
+				});
+				for (int32 Rank = 0; Rank < NumRaceBoats; ++Rank)
+				{
+					SortRanks[SortOrder[Rank]] = Rank + 1;
+				}
+			};
+
+			// 完整跑一场（含完成），逐次对照
+			FRaceBoatRegistry Registry;
+			Registry.Reset(NumRaceBoats);
+			TArray<int32> OldRanks;
+			int32 NumRankMismatches = 0;
+			int32 NumChangeMismatches = 0;
+			int32 NumReportedChanges = 0;
+			for (int32 Tick = 0; Tick < NumBoards; ++Tick)
+			{
+				OldRanks = Registry.GetRanks();
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					const float Progress = Snapshots[Tick * NumRaceBoats + Boat];
+					if (Registry.HasFinished(Boat))
+					{
+						continue;
+					}
+					Registry.SetProgress(Boat, Progress);
+					SortProgresses[Boat] = Progress;
+					if (Progress >= FinishProgress)
+					{
+						Registry.MarkFinished(Boat, (float)Tick);
+						SortFinishTimes[Boat] = (float)Tick;
+					}
+				}
+
+				Registry.UpdateRanking();
+				FullSort();
+
+				int32 NumChangedRanks = 0;
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					NumRankMismatches += Registry.GetRank(Boat) != SortRanks[Boat];
+					NumRankMismatches += Registry.GetBoatAtRank(SortRanks[Boat]) != Boat;
+					NumChangedRanks += Registry.GetRank(Boat) != OldRanks[Boat];
+				}
+				NumChangeMismatches += Registry.GetNumRankChanges() != NumChangedRanks;
+				for (int32 ChangeIndex = 0; ChangeIndex < Registry.GetNumRankChanges(); ++ChangeIndex)
+				{
+					const FRaceRankChange& Change = Registry.GetRankChange(ChangeIndex);
+					NumChangeMismatches += Change.OldRank != OldRanks[Change.BoatIndex] || Change.NewRank != Registry.GetRank(Change.BoatIndex)
+						|| Change.OldRank == Change.NewRank;
+				}
+				NumReportedChanges += Registry.GetNumRankChanges();
+			}
+			Verify(Context, TEXT("Race incremental rank == full sort"), NumRankMismatches, NumBoards * NumRaceBoats);
+			Verify(Context, TEXT("Race rank changes reported"), NumChangeMismatches, NumReportedChanges);
+			Verify(Context, TEXT("Race all boats finished"), Registry.GetNumFinished() != NumRaceBoats ? 1 : 0, NumRaceBoats);
+
+			// 测速时不标记完成，快照循环使用（回到起点时有一次大幅重排）
+			Registry.Reset(NumRaceBoats);
+			SortFinishTimes.Init(-1.0f, NumRaceBoats);
+			auto UpdateIncremental = [&Registry, &Snapshots](int32 Tick)
+			{
+				const float* Progresses = &Snapshots[Tick * NumRaceBoats];
+				for (int32 Boat = 0; Boat < NumRaceBoats; ++Boat)
+				{
+					Registry.SetProgress(Boat, Progresses[Boat]);
+				}
+				return Registry.UpdateRanking();
+			};
+
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				FBenchAllocationCounter::Begin();
+				for (int32 Tick = 0; Tick < NumBoards; ++Tick)
+				{
+					GSink = GSink + UpdateIncremental(Tick);
+				}
+				const int64 NumAllocations = FBenchAllocationCounter::End();
+				Verify(Context, TEXT("Race ranking allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumBoards);
+			}
+
+			Run(Context, TEXT("Race.Rank64.Incremental"), [&UpdateIncremental](int32 Tick)
+			{
+				GSink = GSink + UpdateIncremental(Tick);
+			});
+			Run(Context, TEXT("Race.Rank64.FullSort"), [&Snapshots, &SortProgresses, &SortRanks, &FullSort](int32 Tick)
+			{
+				FMemory::Memcpy(SortProgresses.GetData(), &Snapshots[Tick * NumRaceBoats], NumRaceBoats * sizeof(float));
+				FullSort();
+				GSink = GSink + SortRanks[0];
+			});
+		}
+
+		// 比赛模拟的一个脚本输入（在第 Step 步之前施加）
+		struct FRaceSimEvent
+		{
+			int64 Step;
+			int32 BoatIndex;
+			ERaceStatus Status;
+			float Magnitude;
+			float Duration;
+		};
+
+		void ApplyRaceSimEvent(FRaceSimulation& Simulation, const FRaceSimEvent& Event)
+		{
+			Simulation.ApplyStatus(Event.BoatIndex, Event.Status, Event.Magnitude, Event.Duration);
+		}
+
+		// 按脚本跑完一场比赛（无头）
+		void RunScriptedRace(FRaceSimulation& Simulation, const FRaceSimConfig& Config, const TArray<float>& BaseSpeeds,
+			const TArray<FRaceSimEvent>& Events, float MaxSeconds)
+		{
+			Simulation.Reset(Config, BaseSpeeds.Num());
+			for (int32 Boat = 0; Boat < BaseSpeeds.Num(); ++Boat)
+			{
+				Simulation.SetBaseSpeed(Boat, BaseSpeeds[Boat]);
+			}
+
+			const int64 MaxSteps = FMath::FloorToInt64(MaxSeconds / Config.FixedStepSeconds);
+			int32 NextEvent = 0;
+			while (!Simulation.IsRaceComplete() && Simulation.GetStepCount() < MaxSteps)
+			{
+				for (; NextEvent < Events.Num() && Events[NextEvent].Step <= Simulation.GetStepCount(); ++NextEvent)
+				{
+					ApplyRaceSimEvent(Simulation, Events[NextEvent]);
+				}
+				Simulation.Step();
+			}
+		}
+
+		/**
+		 * 龙舟比赛模拟（固定步长）
+		 * 校验：同样的输入两次结果逐位相同、按不同帧时间推进与逐步推进结果相同、无头跑完一场比赛远快于真实时间（至少1000倍）、
+		 * 预热后不分配堆内存；再测量 64 条龙舟每一步的耗时
+		 */
+		void RunRaceSimulation(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Race.Sim");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumSimBoats = 64;
+			constexpr float MaxSeconds = 600.0f;
+			const FRaceSimConfig Config;
+
+			// 基础速度约 150，一场约 65 秒；平均每 0.25 秒一个输入（加速/减速格子、巧借东风、水淹七军）
+			FRandomStream Stream(NumSimBoats);
+			TArray<float> BaseSpeeds;
+			for (int32 Boat = 0; Boat < NumSimBoats; ++Boat)
+			{
+				BaseSpeeds.Add(Stream.FRandRange(140.0f, 160.0f));
+			}
+			TArray<FRaceSimEvent> Events;
+			for (int64 Step = 0; Step < 4000; Step += 1 + Stream.RandHelper(30))
+			{
+				const int32 Boat = Stream.RandHelper(NumSimBoats);
+				switch (Stream.RandHelper(4))
+				{
+				case 0:		Events.Add({ Step, Boat, ERaceStatus::SpeedBoost, 50.0f, 3.0f }); break;
+				case 1:		Events.Add({ Step, Boat, ERaceStatus::SlowDown, -30.0f, 3.0f }); break;
+				case 2:		Events.Add({ Step, Boat, ERaceStatus::EastWind, 250.0f, 5.0f }); break;
+				default:	Events.Add({ Step, Boat, ERaceStatus::FloodSeven, 0.0f, 3.0f }); break;
+				}
+			}
+
+			// 1. 同样的输入结果逐位相同
+			FRaceSimulation Simulation;
+			FRaceSimulation Reference;
+			RunScriptedRace(Reference, Config, BaseSpeeds, Events, MaxSeconds);
+			RunScriptedRace(Simulation, Config, BaseSpeeds, Events, MaxSeconds);
+			int32 NumMismatches = 0;
+			for (int32 Boat = 0; Boat < NumSimBoats; ++Boat)
+			{
+				NumMismatches += Simulation.GetFinishTime(Boat) != Reference.GetFinishTime(Boat);
+			}
+			Verify(Context, TEXT("Race.Sim deterministic"), NumMismatches, NumSimBoats);
+			Verify(Context, TEXT("Race.Sim all boats finished"), Reference.IsRaceComplete() ? 0 : 1, NumSimBoats);
+
+			// 2. 帧时间不影响结果：输入都在第0步施加，一边逐步推进，一边按 5~50 毫秒的随机帧时间推进
+			TArray<FRaceSimEvent> StartEvents;
+			for (const FRaceSimEvent& Event : Events)
+			{
+				StartEvents.Add({ 0, Event.BoatIndex, Event.Status, Event.Magnitude, Event.Duration * (1 + Event.Step % 7) });
+			}
+			RunScriptedRace(Reference, Config, BaseSpeeds, StartEvents, MaxSeconds);
+			Simulation.Reset(Config, NumSimBoats);
+			for (int32 Boat = 0; Boat < NumSimBoats; ++Boat)
+			{
+				Simulation.SetBaseSpeed(Boat, BaseSpeeds[Boat]);
+			}
+			for (const FRaceSimEvent& Event : StartEvents)
+			{
+				ApplyRaceSimEvent(Simulation, Event);
+			}
+			while (!Simulation.IsRaceComplete() && Simulation.GetSimTime() < MaxSeconds)
+			{
+				Simulation.Advance(Stream.FRandRange(0.005f, 0.05f));
+			}
+			NumMismatches = 0;
+			for (int32 Boat = 0; Boat < NumSimBoats; ++Boat)
+			{
+				NumMismatches += Simulation.GetFinishTime(Boat) != Reference.GetFinishTime(Boat);
+			}
+			Verify(Context, TEXT("Race.Sim frame rate independent"), NumMismatches, NumSimBoats);
+
+			// 3. 无头跑完整场比赛的速度（预热之后）
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				FBenchAllocationCounter::Begin();
+			}
+			RunScriptedRace(Simulation, Config, BaseSpeeds, Events, MaxSeconds);
+			const int64 NumAllocations = FBenchAllocationCounter::IsInstalled() ? FBenchAllocationCounter::End() : 0;
+			const double WallSeconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) / 1000.0;
+			const double SpeedUp = Simulation.GetSimTime() / FMath::Max(WallSeconds, 1e-9);
+			UE_LOG(LogDragonBoatBench, Display, TEXT("%-28s %d boats, %.1f s simulated in %.3f ms (%.0fx real time)"),
+				TEXT("Race.Sim.FullRace"), NumSimBoats, Simulation.GetSimTime(), WallSeconds * 1000.0, SpeedUp);
+			Verify(Context, TEXT("Race.Sim headless >= 1000x real time"), SpeedUp < 1000.0 ? 1 : 0, 1);
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				Verify(Context, TEXT("Race.Sim allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), (int32)Simulation.GetStepCount());
+			}
+
+			// 4. 每一步的耗时（每满 64 步随机加入一个加速效果，保持效果数量稳定）
+			Simulation.Reset(Config, NumSimBoats);
+			for (int32 Boat = 0; Boat < NumSimBoats; ++Boat)
+			{
+				Simulation.SetBaseSpeed(Boat, 0.0f);
+			}
+			Run(Context, TEXT("Race.Sim64.Step"), [&Simulation, &Stream](int32 Iteration)
+			{
+				if ((Iteration & 63) == 0)
+				{
+					Simulation.ApplyStatus(Stream.RandHelper(NumSimBoats), ERaceStatus::SpeedBoost, 1.0f, 3.0f);
+				}
+				Simulation.Step();
+				GSink = GSink + Simulation.GetStatusEffects().Num();
+			});
+		}
+	}
+
+	void RunRaceSimulationBenchmarks(FBenchContext& Context)
+	{
+		RunRaceRanking(Context);
+		RunRaceSimulation(Context);
+	}
+}
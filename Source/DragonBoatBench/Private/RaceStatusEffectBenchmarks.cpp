@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3BenchContext.h"
+#include "RaceStatusEffects.h"
+
+namespace Match3Bench
+{
+	namespace
+	{
+		// 状态效果的逐项扫描实现（对照组：每个效果一个计时器，每步检查所有效果）
+		struct FScanStatusEffects
+		{
+			struct FEffect
+			{
+				int32 Target;
+				ERaceStatus Status;
+				float Magnitude;
+				int64 ExpireStep;
+			};
+
+			TArray<FEffect> Effects;
+
+			bool Has(int32 Target, ERaceStatus Status) const
+			{
+				for (const FEffect& Effect : Effects)
+				{
+					if (Effect.Target == Target && Effect.Status == Status)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			bool Apply(int32 Target, ERaceStatus Status, float Magnitude, int64 ExpireStep, int32 SourceIndex)
+			{
+				if (FRaceStatusEffects::IsDebuff(Status) && SourceIndex != INDEX_NONE && SourceIndex != Target
+					&& Has(Target, ERaceStatus::EmptyCity))
+				{
+					return false;
+				}
+				if (FRaceStatusEffects::GetStacking(Status) == ERaceStatusStacking::Refresh)
+				{
+					for (FEffect& Effect : Effects)
+					{
+						if (Effect.Target == Target && Effect.Status == Status)
+						{
+							Effect.Magnitude = Magnitude;
+							Effect.ExpireStep = FMath::Max(Effect.ExpireStep, ExpireStep);
+							return true;
+						}
+					}
+				}
+				Effects.Add({ Target, Status, Magnitude, ExpireStep });
+				return true;
+			}
+
+			int32 Expire(int64 Step)
+			{
+				int32 NumExpired = 0;
+				for (int32 EffectIndex = Effects.Num() - 1; EffectIndex >= 0; --EffectIndex)
+				{
+					if (Effects[EffectIndex].ExpireStep <= Step)
+					{
+						Effects.RemoveAtSwap(EffectIndex, 1, EAllowShrinking::No);
+						NumExpired++;
+					}
+				}
+				return NumExpired;
+			}
+
+			void Get(int32 Target, ERaceStatus Status, int32& OutStackCount, float& OutMagnitude) const
+			{
+				OutStackCount = 0;
+				OutMagnitude = 0.0f;
+				for (const FEffect& Effect : Effects)
+				{
+					if (Effect.Target == Target && Effect.Status == Status)
+					{
+						OutStackCount++;
+						OutMagnitude += Effect.Magnitude;
+					}
+				}
+			}
+		};
+
+		/**
+		 * 状态效果（时间轮）
+		 * 校验：随机施加各种效果（叠加、刷新、空城计免疫），每一步的层数、数值与生效掩码和逐项扫描相同，预热后不分配堆内存；
+		 * 再对比大量长效果同时生效时，时间轮与逐项扫描每一步的耗时
+		 */
+		void RunRaceStatusEffects(FBenchContext& Context)
+		{
+			const TCHAR* Name = TEXT("Race.Status");
+			if (!Context.ShouldRun(Name))
+			{
+				return;
+			}
+
+			constexpr int32 NumTargets = 64;
+			constexpr int32 NumSteps = 20000;
+			constexpr int32 NumStatusTypes = FRaceStatusEffects::NumStatusTypes;
+
+			// 随机输入：持续 1~1200 步（跨越多圈时间轮），一部分来自敌方
+			FRandomStream Stream(NumTargets);
+			auto ApplyRandom = [&Stream](int64 Step, auto&& ApplyFunc)
+			{
+				const int32 Target = Stream.RandHelper(NumTargets);
+				const ERaceStatus Status = (ERaceStatus)Stream.RandHelper(NumStatusTypes);
+				const float Magnitude = (float)(1 + Stream.RandHelper(100));
+				const int64 Duration = 1 + Stream.RandHelper(Stream.RandHelper(4) == 0 ? 1200 : 180);
+				const int32 Source = Stream.RandHelper(3) == 0 ? INDEX_NONE : Stream.RandHelper(NumTargets);
+				ApplyFunc(Target, Status, Magnitude, Step + Duration, Source);
+			};
+
+			FRaceStatusEffects Wheel;
+			FScanStatusEffects Scan;
+			int32 NumMismatches = 0;
+			int32 NumBlocked = 0;
+			for (int32 Pass = 0; Pass < 2; ++Pass)
+			{
+				// 第二遍重复同样的输入，检查复用容量后不分配堆内存
+				Stream.Initialize(NumTargets);
+				Wheel.Reset(NumTargets);
+				Scan.Effects.Reset();
+				if (Pass == 1 && FBenchAllocationCounter::IsInstalled())
+				{
+					FBenchAllocationCounter::Begin();
+				}
+				for (int64 Step = 0; Step < NumSteps; ++Step)
+				{
+					Wheel.Expire(Step);
+					if (Pass == 0)
+					{
+						Scan.Expire(Step);
+					}
+
+					const int32 NumApplies = Stream.RandHelper(4);
+					for (int32 Apply = 0; Apply < NumApplies; ++Apply)
+					{
+						ApplyRandom(Step, [&](int32 Target, ERaceStatus Status, float Magnitude, int64 ExpireStep, int32 Source)
+						{
+							const bool bApplied = Wheel.Apply(Target, Status, Magnitude, ExpireStep, Source);
+							if (Pass == 0)
+							{
+								NumMismatches += bApplied != Scan.Apply(Target, Status, Magnitude, ExpireStep, Source);
+								NumBlocked += !bApplied;
+							}
+						});
+					}
+
+					if (Pass == 0 && (Step & 15) == 0)
+					{
+						for (int32 Target = 0; Target < NumTargets; ++Target)
+						{
+							uint32 ScanMask = 0;
+							for (int32 Status = 0; Status < NumStatusTypes; ++Status)
+							{
+								int32 StackCount;
+								float Magnitude;
+								Scan.Get(Target, (ERaceStatus)Status, StackCount, Magnitude);
+								NumMismatches += StackCount != Wheel.GetStackCount(Target, (ERaceStatus)Status);
+								NumMismatches += FMath::Abs(Magnitude - Wheel.GetMagnitude(Target, (ERaceStatus)Status)) > 0.01f;
+								ScanMask |= StackCount > 0 ? 1u << Status : 0u;
+							}
+							NumMismatches += ScanMask != Wheel.GetActiveMask(Target);
+						}
+					}
+				}
+			}
+			const int64 NumAllocations = FBenchAllocationCounter::IsInstalled() ? FBenchAllocationCounter::End() : 0;
+			Verify(Context, TEXT("Race.Status wheel == scan"), NumMismatches, NumSteps);
+			Verify(Context, TEXT("Race.Status immunity blocks debuffs"), NumBlocked > 0 ? 0 : 1, 1);
+			if (FBenchAllocationCounter::IsInstalled())
+			{
+				Verify(Context, TEXT("Race.Status allocations == 0"), (int32)FMath::Min<int64>(NumAllocations, MAX_int32), NumSteps);
+			}
+
+			// 每一步到期 + 施加一个效果；长效果（约 4000 个同时生效）时扫描的代价随效果数量增长，时间轮保持不变
+			constexpr int32 LongDuration = 4096;
+			Wheel.Reset(NumTargets);
+			Scan.Effects.Reset();
+			for (int64 Step = 0; Step < LongDuration; ++Step)
+			{
+				Wheel.Apply((int32)(Step % NumTargets), ERaceStatus::SpeedBoost, 1.0f, Step + LongDuration, INDEX_NONE);
+				Scan.Apply((int32)(Step % NumTargets), ERaceStatus::SpeedBoost, 1.0f, Step + LongDuration, INDEX_NONE);
+			}
+			int64 WheelStep = LongDuration;
+			Run(Context, TEXT("Race.Status4k.Wheel"), [&Wheel, &WheelStep](int32 Iteration)
+			{
+				GSink = GSink + Wheel.Expire(WheelStep);
+				Wheel.Apply(Iteration % NumTargets, ERaceStatus::SpeedBoost, 1.0f, WheelStep + LongDuration, INDEX_NONE);
+				WheelStep++;
+			});
+			int64 ScanStep = LongDuration;
+			Run(Context, TEXT("Race.Status4k.Scan"), [&Scan, &ScanStep](int32 Iteration)
+			{
+				GSink = GSink + Scan.Expire(ScanStep);
+				Scan.Apply(Iteration % NumTargets, ERaceStatus::SpeedBoost, 1.0f, ScanStep + LongDuration, INDEX_NONE);
+				ScanStep++;
+			});
+		}
+	}
+
+	void RunStatusEffectBenchmarks(FBenchContext& Context)
+	{
+		RunRaceStatusEffects(Context);
+	}
+}
@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+// 三消与比赛排名的核心逻辑：只依赖 Core，不依赖 UObject/Engine
+// 游戏模块（DragonBoat）与独立的基准测试程序（DragonBoatBench）共用
+public class DragonBoatCore : ModuleRules
+{
+	public DragonBoatCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3AIPlayer.h"
+#include "RaceSnapshot.h"
+
+void FMatch3AIPlayer::Initialize(int32 Seed, const FMatch3SpecialAreas& SpecialAreas)
+{
+	Stream.Initialize(Seed);
+	Morale = FMatch3MoraleState();
+	Ranker.Reset();
+
+	Game.GetSpecialAreas() = SpecialAreas;
+	Game.SetLockedMask(0);
+	Game.Generate([this](int32 Max) { return Stream.RandHelper(Max); });
+}
+
+int32 FMatch3AIPlayer::LockCells(int32 NumCells)
+{
+	const uint64 Picked = Game.PickLockCells(NumCells, [this](int32 Max) { return Stream.RandHelper(Max); });
+	Game.SetLockedMask(Game.GetLockedMask() | Picked);
+	if (!Game.HasAnyValidMove())
+	{
+		Game.Reshuffle([this](int32 Max) { return Stream.RandHelper(Max); });
+	}
+	return FMatch3Bits::Count(Picked);
+}
+
+void FMatch3AIPlayer::UnlockAllCells()
+{
+	Game.SetLockedMask(0);
+}
+
+FMatch3AIBatchResult FMatch3AIPlayer::PlayMoves(int32 NumMoves, const FMatch3AIConfig& Config)
+{
+	FMatch3AIBatchResult Batch;
+	auto RandHelper = [this](int32 Max) { return Stream.RandHelper(Max); };
+
+	for (int32 Move = 0; Move < NumMoves; ++Move)
+	{
+		int32 IndexA;
+		int32 IndexB;
+		if (!PickMove(Config, IndexA, IndexB))
+		{
+			// 正常情况下 PlayMove 已在死锁时洗牌，这里只是保险
+			Game.Reshuffle(RandHelper);
+			Batch.Reshuffles++;
+			continue;
+		}
+
+		const FMatch3TurnResult Turn = Game.PlayMove(IndexA, IndexB, RandHelper);
+		Batch.MovesPlayed++;
+		Batch.ClearedTiles += Turn.ClearedTiles;
+		Batch.Reshuffles += Turn.bReshuffled ? 1 : 0;
+		Batch.CascadeDepths[FMath::Min(Turn.NumSteps, FMatch3AIBatchResult::MaxCascadeDepth)]++;
+		for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			Batch.EffectHits[Type] += Turn.EffectHits[Type];
+		}
+
+		// 士气值奖励与消除方块数、士气提升格子数成线性关系，整个回合一次结算与逐步结算结果相同
+		const int32 Reward = FMatch3Morale::CalculateReward(
+			Config.Morale, Turn.ClearedTiles, Turn.EffectHits[(int32)EMatch3Effect::MoraleBoost]);
+		Batch.MoraleEarned += Reward;
+		Batch.SkillPointsGained += FMatch3Morale::AddMorale(Morale, Config.Morale, Reward).SkillPointsGained;
+
+		// 技能点立即移交，AI 棋盘上永远不会因技能点已满而拒绝士气值
+		Morale.SkillPoints = 0;
+	}
+	return Batch;
+}
+
+bool FMatch3AIPlayer::PickMove(const FMatch3AIConfig& Config, int32& OutIndexA, int32& OutIndexB)
+{
+	const FMatch3MoveIndex& MoveIndex = Game.GetMoveIndex();
+	if (!MoveIndex.HasAnyMove())
+	{
+		return false;
+	}
+
+	const bool bGreedy = Config.Policy == EMatch3AIPolicy::Greedy
+		|| (Config.Policy == EMatch3AIPolicy::Mixed && Stream.GetFraction() < Config.GreedyChance);
+
+	if (bGreedy)
+	{
+		// 首次消除的士气值最高者优先，同分时加速/减速格子多者优先
+		const FMatch3MoraleConfig& MoraleConfig = Config.Morale;
+		Ranker.Update(Game, [&MoraleConfig](const FMatch3MoveScore& Move)
+		{
+			return FMatch3Morale::CalculateReward(MoraleConfig, Move.ClearedTiles, Move.EffectHits[(int32)EMatch3Effect::MoraleBoost])
+				+ 0.5f * (Move.EffectHits[(int32)EMatch3Effect::SpeedUpSelf] + Move.EffectHits[(int32)EMatch3Effect::SlowDownEnemy]);
+		}, 0);
+
+		OutIndexA = Ranker[0].IndexA;
+		OutIndexB = Ranker[0].IndexB;
+		return true;
+	}
+
+	// 随机选择：横向与纵向有效交换按位索引统一编号
+	const int32 NumHorizontal = FMatch3Bits::Count(MoveIndex.GetHorizontalMoves());
+	const int32 Pick = Stream.RandHelper(MoveIndex.Num());
+	if (Pick < NumHorizontal)
+	{
+		OutIndexA = FMatch3Bits::NthIndex(MoveIndex.GetHorizontalMoves(), Pick);
+		OutIndexB = OutIndexA + 1;
+	}
+	else
+	{
+		OutIndexA = FMatch3Bits::NthIndex(MoveIndex.GetVerticalMoves(), Pick - NumHorizontal);
+		OutIndexB = OutIndexA + FMatch3Board::Cols;
+	}
+	return true;
+}
+
+void FMatch3AIPlayer::WriteSnapshot(FRaceSnapshotWriter& Writer) const
+{
+	FRaceSnapshot::WriteGame(Writer, Game);
+	FRaceSnapshot::WriteStream(Writer, Stream);
+	FRaceSnapshot::WriteMorale(Writer, Morale);
+}
+
+void FMatch3AIPlayer::WriteSnapshot(FRaceSnapshotWriter& Writer, const FCheckpoint& Checkpoint)
+{
+	FRaceSnapshot::WriteGame(Writer, Checkpoint.Game);
+	FRaceSnapshot::WriteStream(Writer, Checkpoint.Stream);
+	FRaceSnapshot::WriteMorale(Writer, Checkpoint.Morale);
+}
+
+void FMatch3AIPlayer::ReadSnapshot(FRaceSnapshotReader& Reader)
+{
+	FRaceSnapshot::ReadGame(Reader, Game);
+	FRaceSnapshot::ReadStream(Reader, Stream);
+	FRaceSnapshot::ReadMorale(Reader, Morale);
+	Ranker.Reset();
+}
+
+void FMatch3AIPlayer::ReadSnapshot(FRaceSnapshotReader& Reader, FCheckpoint& OutCheckpoint)
+{
+	FRaceSnapshot::ReadGame(Reader, OutCheckpoint.Game);
+	FRaceSnapshot::ReadStream(Reader, OutCheckpoint.Stream);
+	FRaceSnapshot::ReadMorale(Reader, OutCheckpoint.Morale);
+}
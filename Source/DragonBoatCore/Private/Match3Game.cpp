@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3Game.h"
+
+// 显式实例化所有已发布的棋盘规格，任何规格无法编译时在核心模块内即可发现
+template struct TMatch3Board<7, 7, 4>;
+template struct TMatch3Board<9, 9, 5>;
+template struct TMatch3Board<12, 12, 6>;
+
+template class TMatch3Game<FMatch3Board>;
+template class TMatch3Game<TMatch3Board<9, 9, 5>>;
+template class TMatch3Game<TMatch3Board<12, 12, 6>>;
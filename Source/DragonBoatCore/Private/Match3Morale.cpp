@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3Morale.h"
+
+int32 FMatch3Morale::CalculateReward(const FMatch3MoraleConfig& Config, int32 TileCount, int32 MoraleBoostCount)
+{
+	// 基础士气值：每个方块贡献固定值，特殊格子额外加成
+	return TileCount * Config.MoralePerTile + MoraleBoostCount * Config.SpecialMoraleBonus;
+}
+
+FMatch3MoraleResult FMatch3Morale::AddMorale(FMatch3MoraleState& State, const FMatch3MoraleConfig& Config, int32 Amount)
+{
+	FMatch3MoraleResult Result;
+	if (Amount <= 0)
+	{
+		Result.MoraleAfterAdd = State.CurrentMorale;
+		return Result;
+	}
+
+	// 技能点已满：拒绝增加，士气值保持为0
+	if (State.SkillPoints >= Config.MaxSkillPoints)
+	{
+		Result.bRejected = true;
+		State.CurrentMorale = 0;
+		return Result;
+	}
+
+	State.CurrentMorale += Amount;
+	Result.MoraleAfterAdd = State.CurrentMorale;
+
+	// 士气值满时转换为技能点
+	while (State.CurrentMorale >= Config.MaxMorale && State.SkillPoints < Config.MaxSkillPoints)
+	{
+		State.CurrentMorale -= Config.MaxMorale;
+		State.SkillPoints++;
+		Result.SkillPointsGained++;
+
+		// 技能点已满，强制清零士气值
+		if (State.SkillPoints >= Config.MaxSkillPoints)
+		{
+			State.CurrentMorale = 0;
+			Result.bResetOnFull = true;
+		}
+	}
+
+	// 确保士气值不超过上限（额外的安全检查）
+	if (State.CurrentMorale > Config.MaxMorale)
+	{
+		State.CurrentMorale = Config.MaxMorale;
+		Result.bCapped = true;
+	}
+
+	return Result;
+}
+
+bool FMatch3Morale::ConsumeSkillPoints(FMatch3MoraleState& State, int32 Amount)
+{
+	if (State.SkillPoints < Amount)
+	{
+		return false;
+	}
+
+	State.SkillPoints -= Amount;
+	return true;
+}
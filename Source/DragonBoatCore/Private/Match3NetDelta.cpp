@@ -0,0 +1,293 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Match3NetDelta.h"
+#include "RaceReplay.h"
+
+// ========================================
+// 写入
+// ========================================
+
+void FMatch3NetDeltaWriter::BeginOp(EMatch3NetOp Op)
+{
+	Writer.WriteBits((uint64)Op, OpBits);
+	++NumPendingOps;
+}
+
+void FMatch3NetDeltaWriter::RecordKeyframe(const FMatch3Game& Game, bool bReshuffle, uint8 HostState)
+{
+	BeginOp(EMatch3NetOp::Keyframe);
+	Writer.WriteBool(bReshuffle);
+	Writer.WriteBits(HostState, StateBits);
+
+	const FMatch3Board& Board = Game.GetBoard();
+	Writer.WriteMask(Board.GetPlayableMask());
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+	{
+		Writer.WriteMask(Game.GetSpecialAreas().GetEffectMask((EMatch3Effect)Type));
+	}
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		Writer.WriteBits(Board.GetColor(Index), BitsPerCell);
+	}
+	Writer.WriteMask(Board.GetLockedMask());
+	++NumKeyframes;
+}
+
+void FMatch3NetDeltaWriter::RecordSwap(int32 IndexA, int32 IndexB, bool bWholeCascade)
+{
+	BeginOp(EMatch3NetOp::Swap);
+	Writer.WriteBits(IndexA, CellBits);
+	Writer.WriteBits(IndexB, CellBits);
+	Writer.WriteBool(bWholeCascade);
+}
+
+void FMatch3NetDeltaWriter::RecordClear(uint64 ClearedMask)
+{
+	BeginOp(EMatch3NetOp::Clear);
+	Writer.WriteMask(ClearedMask);
+}
+
+void FMatch3NetDeltaWriter::RecordLocked(uint64 LockedMask)
+{
+	BeginOp(EMatch3NetOp::Locked);
+	Writer.WriteMask(LockedMask);
+}
+
+void FMatch3NetDeltaWriter::RecordSpecialAreas(const FMatch3SpecialAreas& SpecialAreas)
+{
+	BeginOp(EMatch3NetOp::SpecialAreas);
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+	{
+		Writer.WriteMask(SpecialAreas.GetEffectMask((EMatch3Effect)Type));
+	}
+}
+
+void FMatch3NetDeltaWriter::RecordMorale(const FMatch3MoraleState& Morale)
+{
+	if (Morale.CurrentMorale == LastMorale.CurrentMorale && Morale.SkillPoints == LastMorale.SkillPoints)
+	{
+		return;
+	}
+
+	BeginOp(EMatch3NetOp::Morale);
+	Writer.WritePacked((uint64)FMath::Max(Morale.CurrentMorale, 0));
+	Writer.WritePacked((uint64)FMath::Max(Morale.SkillPoints, 0));
+	LastMorale = Morale;
+}
+
+const TArray<uint8>& FMatch3NetDeltaWriter::Finish(uint32 Checksum)
+{
+	Writer.WriteBits((uint64)EMatch3NetOp::End, OpBits);
+	Writer.WriteBits(Checksum, 32);
+	++NumMessages;
+	TotalBytes += Pending.Num();
+	return Pending;
+}
+
+void FMatch3NetDeltaWriter::Clear()
+{
+	Writer.Reset();
+	NumPendingOps = 0;
+}
+
+// ========================================
+// 读取
+// ========================================
+
+bool FMatch3NetDeltaReader::Next(EMatch3NetOp& OutOp)
+{
+	if (bEnded || Reader.HasError())
+	{
+		return false;
+	}
+
+	const uint64 Op = Reader.ReadBits(FMatch3NetDeltaWriter::OpBits);
+	if (Op >= (uint64)EMatch3NetOp::Count)
+	{
+		Reader.SetError();
+	}
+	if (Reader.HasError())
+	{
+		return false;
+	}
+
+	OutOp = (EMatch3NetOp)Op;
+	if (OutOp == EMatch3NetOp::End)
+	{
+		Checksum = (uint32)Reader.ReadBits(32);
+		bEnded = !Reader.HasError();
+		return false;
+	}
+	return true;
+}
+
+void FMatch3NetDeltaReader::ReadKeyframe(FMatch3Game& Game, bool& bOutReshuffle, uint8& OutHostState, uint8 MaxHostState)
+{
+	bOutReshuffle = Reader.ReadBool();
+	OutHostState = (uint8)Reader.ReadBits(FMatch3NetDeltaWriter::StateBits);
+	if (OutHostState > MaxHostState)
+	{
+		Reader.SetError();
+	}
+
+	const uint64 PlayableMask = Reader.ReadMask();
+	FMatch3SpecialAreas SpecialAreas;
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+	{
+		SpecialAreas.SetEffectMask((EMatch3Effect)Type, Reader.ReadMask());
+	}
+	uint8 Cells[FMatch3Board::NumCells];
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		Cells[Index] = (uint8)Reader.ReadBits(FMatch3NetDeltaWriter::BitsPerCell);
+		if (Cells[Index] > FMatch3Board::EmptyColor)
+		{
+			Reader.SetError();
+		}
+	}
+	const uint64 LockedMask = Reader.ReadMask();
+	if (Reader.HasError())
+	{
+		return;
+	}
+
+	// 与快照相同的顺序：形状、特殊格子、方块、锁定
+	Game.SetPlayableMask(PlayableMask);
+	Game.GetSpecialAreas() = SpecialAreas;
+	Game.SetCells(Cells);
+	Game.SetLockedMask(LockedMask);
+}
+
+void FMatch3NetDeltaReader::ReadSwap(int32& OutIndexA, int32& OutIndexB, bool& bOutWholeCascade)
+{
+	OutIndexA = (int32)Reader.ReadBits(FMatch3NetDeltaWriter::CellBits);
+	OutIndexB = (int32)Reader.ReadBits(FMatch3NetDeltaWriter::CellBits);
+	bOutWholeCascade = Reader.ReadBool();
+
+	const int32 Low = FMath::Min(OutIndexA, OutIndexB);
+	const int32 High = FMath::Max(OutIndexA, OutIndexB);
+	const bool bAdjacent = (High - Low == 1 && Low % FMatch3Board::Cols != FMatch3Board::Cols - 1)
+		|| High - Low == FMatch3Board::Cols;
+	if (High >= FMatch3Board::NumCells || !bAdjacent)
+	{
+		Reader.SetError();
+	}
+}
+
+uint8 FMatch3NetDeltaReader::ReadFillColor()
+{
+	const uint8 Color = (uint8)Reader.ReadBits(FMatch3NetDeltaWriter::ColorBits);
+	if (Color >= FMatch3Board::NumColors)
+	{
+		Reader.SetError();
+		return 0;
+	}
+	return Color;
+}
+
+void FMatch3NetDeltaReader::ReadSpecialAreas(FMatch3SpecialAreas& OutSpecialAreas)
+{
+	FMatch3SpecialAreas SpecialAreas;
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+	{
+		SpecialAreas.SetEffectMask((EMatch3Effect)Type, Reader.ReadMask());
+	}
+	if (!Reader.HasError())
+	{
+		OutSpecialAreas = SpecialAreas;
+	}
+}
+
+void FMatch3NetDeltaReader::ReadMorale(FMatch3MoraleState& OutMorale)
+{
+	const int32 CurrentMorale = Reader.ReadCount(MAX_int32);
+	const int32 SkillPoints = Reader.ReadCount(MAX_int32);
+	if (!Reader.HasError())
+	{
+		OutMorale = FMatch3MoraleState(CurrentMorale, SkillPoints);
+	}
+}
+
+// ========================================
+// 应用
+// ========================================
+
+bool FMatch3NetDelta::Apply(const uint8* Data, int32 Size, FMatch3Game& Game, FMatch3MoraleState& Morale)
+{
+	FMatch3NetDeltaReader Reader(Data, Size);
+	EMatch3NetOp Op;
+	while (Reader.Next(Op))
+	{
+		switch (Op)
+		{
+		case EMatch3NetOp::Keyframe:
+			{
+				bool bReshuffle;
+				uint8 HostState;
+				Reader.ReadKeyframe(Game, bReshuffle, HostState);
+			}
+			break;
+
+		case EMatch3NetOp::Swap:
+			{
+				int32 IndexA, IndexB;
+				bool bWholeCascade;
+				Reader.ReadSwap(IndexA, IndexB, bWholeCascade);
+				if (!Reader.HasError())
+				{
+					Game.ApplySwap(IndexA, IndexB);
+				}
+			}
+			break;
+
+		case EMatch3NetOp::Clear:
+			Game.ClearCells(Reader.ReadMask());
+			break;
+
+		case EMatch3NetOp::Fill:
+			Reader.ReadFill(Game, [](int32, int32, uint8, bool) {});
+			break;
+
+		case EMatch3NetOp::Settle:
+			Game.Settle();
+			break;
+
+		case EMatch3NetOp::Locked:
+			Game.SetLockedMask(Reader.ReadMask());
+			break;
+
+		case EMatch3NetOp::SpecialAreas:
+			Reader.ReadSpecialAreas(Game.GetSpecialAreas());
+			break;
+
+		case EMatch3NetOp::Morale:
+			Reader.ReadMorale(Morale);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return Reader.HasEnded() && Reader.GetChecksum() == ComputeChecksum(Game, Morale);
+}
+
+uint32 FMatch3NetDelta::ComputeChecksum(const FMatch3Game& Game, const FMatch3MoraleState& Morale)
+{
+	// 在录像校验值上继续混入形状与特殊格子（录像中它们由事件直接记录，同步中则可能在传输中损坏）
+	uint32 Hash = FRaceReplayPlayer::ComputeChecksum(Game, Morale);
+	auto Mix = [&Hash](uint64 Value)
+	{
+		for (int32 Shift = 0; Shift < 64; Shift += 8)
+		{
+			Hash = (Hash ^ (uint32)((Value >> Shift) & 0xFF)) * 16777619u;
+		}
+	};
+
+	Mix(Game.GetBoard().GetPlayableMask());
+	for (int32 Type = 1; Type < FMatch3SpecialAreas::NumEffectTypes; ++Type)
+	{
+		Mix(Game.GetSpecialAreas().GetEffectMask((EMatch3Effect)Type));
+	}
+	return Hash;
+}
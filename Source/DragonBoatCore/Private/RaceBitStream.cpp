@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceBitStream.h"
+
+// ========================================
+// 写入
+// ========================================
+
+void FRaceBitWriter::WriteBits(uint64 Value, int32 InNumBits)
+{
+	if (InNumBits < 64)
+	{
+		Value &= (1ull << InNumBits) - 1;
+	}
+
+	// 先填满当前字节的剩余位，之后每次写入一个整字节
+	while (InNumBits > 0)
+	{
+		const int32 BitInByte = (int32)(NumBits & 7);
+		if (BitInByte == 0)
+		{
+			Bytes.Add(0);
+		}
+		const int32 Take = FMath::Min(8 - BitInByte, InNumBits);
+		Bytes.Last() |= (uint8)(Value << BitInByte);
+		Value >>= Take;
+		InNumBits -= Take;
+		NumBits += Take;
+	}
+}
+
+void FRaceBitWriter::WriteFloat(float Value)
+{
+	uint32 Bits;
+	FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+	WriteBits(Bits, 32);
+}
+
+void FRaceBitWriter::WritePacked(uint64 Value)
+{
+	do
+	{
+		const uint64 Group = Value & 0x7F;
+		Value >>= 7;
+		WriteBits(Group | (Value ? 0x80 : 0), 8);
+	}
+	while (Value);
+}
+
+// ========================================
+// 读取
+// ========================================
+
+uint64 FRaceBitReader::ReadBits(int32 NumBits)
+{
+	if (bError || BitOffset + NumBits > SizeBits)
+	{
+		bError = true;
+		return 0;
+	}
+
+	uint64 Value = 0;
+	int32 NumRead = 0;
+	while (NumRead < NumBits)
+	{
+		const int32 BitInByte = (int32)(BitOffset & 7);
+		const int32 Take = FMath::Min(8 - BitInByte, NumBits - NumRead);
+		const uint64 Chunk = (Data[BitOffset >> 3] >> BitInByte) & ((1u << Take) - 1);
+		Value |= Chunk << NumRead;
+		NumRead += Take;
+		BitOffset += Take;
+	}
+	return Value;
+}
+
+float FRaceBitReader::ReadFloat()
+{
+	const uint32 Bits = (uint32)ReadBits(32);
+	float Value;
+	FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+uint64 FRaceBitReader::ReadPacked()
+{
+	uint64 Value = 0;
+	for (int32 Shift = 0; Shift < 64; Shift += 7)
+	{
+		const uint64 Group = ReadBits(8);
+		Value |= (Group & 0x7F) << Shift;
+		if (!(Group & 0x80))
+		{
+			return Value;
+		}
+	}
+	bError = true;
+	return 0;
+}
+
+int32 FRaceBitReader::ReadCount(int32 MaxCount)
+{
+	const uint64 Count = ReadPacked();
+	if (Count > (uint64)MaxCount)
+	{
+		bError = true;
+		return 0;
+	}
+	return (int32)Count;
+}
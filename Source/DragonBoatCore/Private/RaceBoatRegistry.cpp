@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceBoatRegistry.h"
+#include "RaceSnapshot.h"
+
+void FRaceBoatRegistry::Reset(int32 NumBoats)
+{
+	NumBoats = FMath::Max(0, NumBoats);
+
+	Progresses.Reset(NumBoats);
+	FinishTimes.Reset(NumBoats);
+	Ranks.Reset(NumBoats);
+	RankOrder.Reset(NumBoats);
+	for (int32 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		Progresses.Add(0.0f);
+		FinishTimes.Add(-1.0f);
+		Ranks.Add(BoatIndex + 1);
+		RankOrder.Add(BoatIndex);
+	}
+
+	PreviousRanks.Reset(NumBoats);
+	PreviousRanks.AddZeroed(NumBoats);
+	MovedBoats.Reset(NumBoats);
+	RankChanges.Reset(NumBoats);
+	NumFinished = 0;
+}
+
+int32 FRaceBoatRegistry::MarkFinished(int32 BoatIndex, float FinishTime)
+{
+	if (HasFinished(BoatIndex))
+	{
+		return INDEX_NONE;
+	}
+
+	FinishTimes[BoatIndex] = FMath::Max(0.0f, FinishTime);
+	return ++NumFinished;
+}
+
+int32 FRaceBoatRegistry::UpdateRanking()
+{
+	RankChanges.Reset();
+
+	// 插入排序：顺序基本不变时每条龙舟只比较一次，超越时只交换相邻的龙舟
+	for (int32 Position = 1; Position < RankOrder.Num(); ++Position)
+	{
+		for (int32 Current = Position; Current > 0 && IsAhead(RankOrder[Current], RankOrder[Current - 1]); --Current)
+		{
+			const int32 Overtaking = RankOrder[Current];
+			const int32 Overtaken = RankOrder[Current - 1];
+			for (int32 Boat : { Overtaking, Overtaken })
+			{
+				if (PreviousRanks[Boat] == 0)
+				{
+					PreviousRanks[Boat] = Ranks[Boat];
+					MovedBoats.Add(Boat);
+				}
+			}
+
+			RankOrder[Current - 1] = Overtaking;
+			RankOrder[Current] = Overtaken;
+			Ranks[Overtaking] = Current;
+			Ranks[Overtaken] = Current + 1;
+		}
+	}
+
+	// 只检查被移动过的龙舟（超越后又被反超的龙舟排名可能不变）
+	MovedBoats.Sort();
+	for (int32 Boat : MovedBoats)
+	{
+		if (Ranks[Boat] != PreviousRanks[Boat])
+		{
+			RankChanges.Add({ Boat, PreviousRanks[Boat], Ranks[Boat] });
+		}
+		PreviousRanks[Boat] = 0;
+	}
+	MovedBoats.Reset();
+
+	return RankChanges.Num();
+}
+
+void FRaceBoatRegistry::WriteSnapshot(FRaceSnapshotWriter& Writer) const
+{
+	Writer.WritePacked(Num());
+	for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+	{
+		Writer.WriteFloat(Progresses[BoatIndex]);
+		Writer.WriteFloat(FinishTimes[BoatIndex]);
+		Writer.WritePacked(Ranks[BoatIndex]);
+	}
+}
+
+void FRaceBoatRegistry::ReadSnapshot(FRaceSnapshotReader& Reader)
+{
+	const int32 NumBoats = Reader.ReadCount(1024);
+	Reset(NumBoats);
+
+	// 排名顺序由每条龙舟的排名还原，每个名次必须恰好出现一次
+	for (int32& Boat : RankOrder)
+	{
+		Boat = INDEX_NONE;
+	}
+	for (int32 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		Progresses[BoatIndex] = Reader.ReadFloat();
+		FinishTimes[BoatIndex] = Reader.ReadFloat();
+		const int32 Rank = Reader.ReadCount(NumBoats);
+		if (Rank < 1 || RankOrder[Rank - 1] != INDEX_NONE)
+		{
+			Reader.SetError();
+			Reset(NumBoats);
+			return;
+		}
+		Ranks[BoatIndex] = Rank;
+		RankOrder[Rank - 1] = BoatIndex;
+		NumFinished += HasFinished(BoatIndex) ? 1 : 0;
+	}
+}
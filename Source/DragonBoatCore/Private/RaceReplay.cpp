@@ -0,0 +1,799 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceReplay.h"
+
+// ========================================
+// 文件头与事件
+// ========================================
+
+FRaceReplayHeader::FRaceReplayHeader()
+	: RaceSeed(0)
+	, BoardSeed(0)
+	, RefillSeed(0)
+	, PlayableMask(0)
+	, LockedMask(0)
+{
+	for (int32 Type = 0; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		EffectMasks[Type] = 0;
+	}
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		Cells[Index] = FMatch3Board::EmptyColor;
+	}
+}
+
+void FRaceReplayHeader::Capture(const FMatch3Game& Game, const FMatch3MoraleConfig& InMoraleConfig, const FMatch3MoraleState& InMorale, const FRaceSimulation* Simulation)
+{
+	const FMatch3Board& Board = Game.GetBoard();
+	PlayableMask = Board.GetPlayableMask();
+	LockedMask = Board.GetLockedMask();
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		EffectMasks[Type] = Game.GetSpecialAreas().GetEffectMask((EMatch3Effect)Type);
+	}
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		Cells[Index] = Board.GetColor(Index);
+	}
+
+	MoraleConfig = InMoraleConfig;
+	Morale = InMorale;
+
+	BaseSpeeds.Reset();
+	if (Simulation)
+	{
+		SimConfig = Simulation->GetConfig();
+		for (int32 BoatIndex = 0; BoatIndex < Simulation->Num(); ++BoatIndex)
+		{
+			BaseSpeeds.Add(Simulation->GetBaseSpeed(BoatIndex));
+		}
+	}
+}
+
+void FRaceReplayEvent::Clear(ERaceReplayEvent InType, double InTime)
+{
+	Type = InType;
+	Time = InTime;
+	Index = 0;
+	Value = 0;
+	Target = INDEX_NONE;
+	bFlag = false;
+	Magnitude = 0.0f;
+	Duration = 0.0f;
+	Step = 0;
+	Checksum = 0;
+	for (int32 EffectType = 0; EffectType < (int32)EMatch3Effect::Count; ++EffectType)
+	{
+		Masks[EffectType] = 0;
+	}
+	FinishTimes.Reset();
+}
+
+// ========================================
+// 写入
+// ========================================
+
+void FRaceReplayWriter::Begin(const FRaceReplayHeader& Header, double Time)
+{
+	Pending.Reset();
+	TotalBytes = 0;
+	NumEvents = 0;
+	StartTime = Time;
+	LastTimeMs = 0;
+	LastStep = 0;
+	bRecording = true;
+
+	WriteUInt32(Magic);
+	WriteVarint(Version);
+
+	// 棋盘规格：与回放端的 FMatch3Board 不同时拒绝回放
+	WriteByte((uint8)FMatch3Board::Rows);
+	WriteByte((uint8)FMatch3Board::Cols);
+	WriteByte((uint8)FMatch3Board::NumColors);
+
+	WriteUInt32((uint32)Header.RaceSeed);
+	WriteUInt32((uint32)Header.BoardSeed);
+	WriteUInt32((uint32)Header.RefillSeed);
+
+	WriteVarint(Header.PlayableMask);
+	WriteVarint(Header.LockedMask);
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		WriteVarint(Header.EffectMasks[Type]);
+	}
+
+	// 每格4位（空格子记为15）
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; Index += 2)
+	{
+		const uint8 Low = FMath::Min<uint8>(Header.Cells[Index], 15);
+		const uint8 High = Index + 1 < FMatch3Board::NumCells ? FMath::Min<uint8>(Header.Cells[Index + 1], 15) : 15;
+		WriteByte(Low | (High << 4));
+	}
+
+	WriteVarint(Header.MoraleConfig.MaxMorale);
+	WriteVarint(Header.MoraleConfig.MoralePerTile);
+	WriteVarint(Header.MoraleConfig.SpecialMoraleBonus);
+	WriteVarint(Header.MoraleConfig.MaxSkillPoints);
+	WriteVarint(Header.Morale.CurrentMorale);
+	WriteVarint(Header.Morale.SkillPoints);
+
+	WriteFloat(Header.SimConfig.FixedStepSeconds);
+	WriteFloat(Header.SimConfig.TrackLength);
+	WriteVarint(Header.SimConfig.MaxStepsPerAdvance);
+	WriteVarint(Header.BaseSpeeds.Num());
+	for (float Speed : Header.BaseSpeeds)
+	{
+		WriteFloat(Speed);
+	}
+}
+
+void FRaceReplayWriter::End(double Time, const FRaceSimulation* Simulation)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	BeginEvent(ERaceReplayEvent::End, Time);
+	const int64 Step = Simulation ? Simulation->GetStepCount() : LastStep;
+	WriteVarint((uint64)FMath::Max<int64>(Step - LastStep, 0));
+	const int32 NumBoats = Simulation ? Simulation->Num() : 0;
+	WriteVarint(NumBoats);
+	for (int32 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		WriteFloat(Simulation->GetFinishTime(BoatIndex));
+	}
+
+	bRecording = false;
+}
+
+void FRaceReplayWriter::BeginEvent(ERaceReplayEvent Type, double Time)
+{
+	// 时间只增不减（同一毫秒内的事件间隔为0）
+	const int64 TimeMs = FMath::Max<int64>(FMath::RoundToInt64((Time - StartTime) * 1000.0), LastTimeMs);
+	WriteByte((uint8)Type);
+	WriteVarint((uint64)(TimeMs - LastTimeMs));
+	LastTimeMs = TimeMs;
+	NumEvents++;
+}
+
+void FRaceReplayWriter::RecordTileInput(double Time, int32 TileIndex, bool bBoardBusy)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::TileInput, Time);
+	WriteVarint(((uint64)TileIndex << 1) | (bBoardBusy ? 1 : 0));
+}
+
+void FRaceReplayWriter::RecordCastSkill(double Time, int32 SlotIndex, int32 Skill, bool bSuccess)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::CastSkill, Time);
+	WriteZigZag(SlotIndex);
+	WriteVarint(((uint64)Skill << 1) | (bSuccess ? 1 : 0));
+}
+
+void FRaceReplayWriter::RecordDifficulty(double Time, int32 Level)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::Difficulty, Time);
+	WriteVarint(Level);
+}
+
+void FRaceReplayWriter::RecordSpecialAreas(double Time, const FMatch3SpecialAreas& SpecialAreas)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::SpecialAreas, Time);
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		WriteVarint(SpecialAreas.GetEffectMask((EMatch3Effect)Type));
+	}
+}
+
+void FRaceReplayWriter::RecordLockCells(double Time, uint64 LockedMask)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::LockCells, Time);
+	WriteVarint(LockedMask);
+}
+
+void FRaceReplayWriter::RecordUnlockCells(double Time)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::UnlockCells, Time);
+}
+
+void FRaceReplayWriter::RecordAISkill(double Time, int32 CasterIndex, int32 Skill, int32 TargetIndex, bool bBlocked)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::AISkill, Time);
+	WriteVarint(CasterIndex);
+	WriteVarint(((uint64)Skill << 1) | (bBlocked ? 1 : 0));
+	WriteZigZag(TargetIndex);
+}
+
+void FRaceReplayWriter::RecordStatus(double Time, int64 Step, int32 BoatIndex, int32 Status, float Magnitude, float Duration, int32 SourceIndex, bool bApplied)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::Status, Time);
+	WriteVarint((uint64)FMath::Max<int64>(Step - LastStep, 0));
+	LastStep = FMath::Max(Step, LastStep);
+	WriteVarint(BoatIndex);
+	WriteVarint(((uint64)Status << 1) | (bApplied ? 1 : 0));
+	WriteFloat(Magnitude);
+	WriteFloat(Duration);
+	WriteZigZag(SourceIndex);
+}
+
+void FRaceReplayWriter::RecordChecksum(double Time, uint32 Checksum)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+	BeginEvent(ERaceReplayEvent::Checksum, Time);
+	WriteUInt32(Checksum);
+}
+
+void FRaceReplayWriter::WriteVarint(uint64 Value)
+{
+	while (Value >= 0x80)
+	{
+		Pending.Add((uint8)(Value | 0x80));
+		Value >>= 7;
+	}
+	Pending.Add((uint8)Value);
+}
+
+void FRaceReplayWriter::WriteFloat(float Value)
+{
+	uint32 Bits;
+	FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+	WriteUInt32(Bits);
+}
+
+void FRaceReplayWriter::WriteUInt32(uint32 Value)
+{
+	// 小端序，与平台无关
+	for (int32 Shift = 0; Shift < 32; Shift += 8)
+	{
+		Pending.Add((uint8)(Value >> Shift));
+	}
+}
+
+// ========================================
+// 读取
+// ========================================
+
+bool FRaceReplayReader::Open(const uint8* InData, int32 InSize, FRaceReplayHeader& OutHeader)
+{
+	Data = InData;
+	Size = InSize;
+	Offset = 0;
+	LastTimeMs = 0;
+	LastStep = 0;
+	bError = false;
+	bEnded = false;
+
+	uint32 FileMagic = 0;
+	uint64 FileVersion = 0;
+	uint8 Rows = 0, Cols = 0, NumColors = 0;
+	if (!ReadUInt32(FileMagic) || FileMagic != FRaceReplayWriter::Magic
+		|| !ReadVarint(FileVersion) || FileVersion != FRaceReplayWriter::Version
+		|| !ReadByte(Rows) || !ReadByte(Cols) || !ReadByte(NumColors)
+		|| Rows != FMatch3Board::Rows || Cols != FMatch3Board::Cols || NumColors != FMatch3Board::NumColors)
+	{
+		bError = true;
+		return false;
+	}
+
+	uint32 Seeds[3];
+	for (uint32& Seed : Seeds)
+	{
+		ReadUInt32(Seed);
+	}
+	OutHeader.RaceSeed = (int32)Seeds[0];
+	OutHeader.BoardSeed = (int32)Seeds[1];
+	OutHeader.RefillSeed = (int32)Seeds[2];
+
+	ReadVarint(OutHeader.PlayableMask);
+	ReadVarint(OutHeader.LockedMask);
+	OutHeader.EffectMasks[0] = 0;
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		ReadVarint(OutHeader.EffectMasks[Type]);
+	}
+
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; Index += 2)
+	{
+		uint8 Packed = 0xFF;
+		ReadByte(Packed);
+		const uint8 Low = Packed & 15;
+		const uint8 High = Packed >> 4;
+		OutHeader.Cells[Index] = Low < FMatch3Board::NumColors ? Low : FMatch3Board::EmptyColor;
+		if (Index + 1 < FMatch3Board::NumCells)
+		{
+			OutHeader.Cells[Index + 1] = High < FMatch3Board::NumColors ? High : FMatch3Board::EmptyColor;
+		}
+	}
+
+	uint64 Values[6] = {};
+	for (uint64& Value : Values)
+	{
+		ReadVarint(Value);
+	}
+	OutHeader.MoraleConfig.MaxMorale = (int32)Values[0];
+	OutHeader.MoraleConfig.MoralePerTile = (int32)Values[1];
+	OutHeader.MoraleConfig.SpecialMoraleBonus = (int32)Values[2];
+	OutHeader.MoraleConfig.MaxSkillPoints = (int32)Values[3];
+	OutHeader.Morale = FMatch3MoraleState((int32)Values[4], (int32)Values[5]);
+
+	uint64 MaxStepsPerAdvance = 0;
+	uint64 NumBoats = 0;
+	ReadFloat(OutHeader.SimConfig.FixedStepSeconds);
+	ReadFloat(OutHeader.SimConfig.TrackLength);
+	ReadVarint(MaxStepsPerAdvance);
+	ReadVarint(NumBoats);
+	OutHeader.SimConfig.MaxStepsPerAdvance = (int32)MaxStepsPerAdvance;
+
+	// 每条龙舟至少4字节，龙舟数超过剩余数据时视为损坏
+	if (bError || NumBoats > (uint64)(Size - Offset) / 4)
+	{
+		bError = true;
+		return false;
+	}
+	OutHeader.BaseSpeeds.Reset((int32)NumBoats);
+	for (uint64 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		float Speed = 0.0f;
+		ReadFloat(Speed);
+		OutHeader.BaseSpeeds.Add(Speed);
+	}
+	return !bError;
+}
+
+bool FRaceReplayReader::Next(FRaceReplayEvent& OutEvent)
+{
+	if (bError || bEnded)
+	{
+		return false;
+	}
+
+	uint8 Type = 0;
+	uint64 TimeDelta = 0;
+	if (!ReadByte(Type) || !ReadVarint(TimeDelta) || Type >= (uint8)ERaceReplayEvent::Count)
+	{
+		bError = true;
+		return false;
+	}
+	LastTimeMs += (int64)TimeDelta;
+	OutEvent.Clear((ERaceReplayEvent)Type, LastTimeMs / 1000.0);
+
+	uint64 Value = 0;
+	int64 Signed = 0;
+	switch (OutEvent.Type)
+	{
+	case ERaceReplayEvent::End:
+	{
+		uint64 NumBoats = 0;
+		ReadVarint(Value);
+		ReadVarint(NumBoats);
+		if (bError || NumBoats > (uint64)(Size - Offset) / 4)
+		{
+			bError = true;
+			return false;
+		}
+		OutEvent.Step = LastStep + (int64)Value;
+		for (uint64 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+		{
+			float FinishTime = -1.0f;
+			ReadFloat(FinishTime);
+			OutEvent.FinishTimes.Add(FinishTime);
+		}
+		bEnded = !bError;
+		break;
+	}
+
+	case ERaceReplayEvent::TileInput:
+		ReadVarint(Value);
+		OutEvent.Index = (int32)(Value >> 1);
+		OutEvent.bFlag = (Value & 1) != 0;
+		break;
+
+	case ERaceReplayEvent::CastSkill:
+		ReadZigZag(Signed);
+		ReadVarint(Value);
+		OutEvent.Index = (int32)Signed;
+		OutEvent.Value = (int32)(Value >> 1);
+		OutEvent.bFlag = (Value & 1) != 0;
+		break;
+
+	case ERaceReplayEvent::Difficulty:
+		ReadVarint(Value);
+		OutEvent.Index = (int32)Value;
+		break;
+
+	case ERaceReplayEvent::SpecialAreas:
+		for (int32 EffectType = 1; EffectType < (int32)EMatch3Effect::Count; ++EffectType)
+		{
+			ReadVarint(OutEvent.Masks[EffectType]);
+		}
+		break;
+
+	case ERaceReplayEvent::LockCells:
+		ReadVarint(OutEvent.Masks[0]);
+		break;
+
+	case ERaceReplayEvent::UnlockCells:
+		break;
+
+	case ERaceReplayEvent::AISkill:
+		ReadVarint(Value);
+		OutEvent.Index = (int32)Value;
+		ReadVarint(Value);
+		OutEvent.Value = (int32)(Value >> 1);
+		OutEvent.bFlag = (Value & 1) != 0;
+		ReadZigZag(Signed);
+		OutEvent.Target = (int32)Signed;
+		break;
+
+	case ERaceReplayEvent::Status:
+		ReadVarint(Value);
+		LastStep += (int64)Value;
+		OutEvent.Step = LastStep;
+		ReadVarint(Value);
+		OutEvent.Index = (int32)Value;
+		ReadVarint(Value);
+		OutEvent.Value = (int32)(Value >> 1);
+		OutEvent.bFlag = (Value & 1) != 0;
+		ReadFloat(OutEvent.Magnitude);
+		ReadFloat(OutEvent.Duration);
+		ReadZigZag(Signed);
+		OutEvent.Target = (int32)Signed;
+		break;
+
+	case ERaceReplayEvent::Checksum:
+		ReadUInt32(OutEvent.Checksum);
+		break;
+
+	default:
+		bError = true;
+		break;
+	}
+
+	return !bError;
+}
+
+bool FRaceReplayReader::ReadByte(uint8& OutValue)
+{
+	if (Offset >= Size)
+	{
+		bError = true;
+		return false;
+	}
+	OutValue = Data[Offset++];
+	return true;
+}
+
+bool FRaceReplayReader::ReadVarint(uint64& OutValue)
+{
+	OutValue = 0;
+	for (int32 Shift = 0; Shift < 64; Shift += 7)
+	{
+		uint8 Byte;
+		if (!ReadByte(Byte))
+		{
+			return false;
+		}
+		OutValue |= (uint64)(Byte & 0x7F) << Shift;
+		if ((Byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	bError = true;
+	return false;
+}
+
+bool FRaceReplayReader::ReadZigZag(int64& OutValue)
+{
+	uint64 Value;
+	if (!ReadVarint(Value))
+	{
+		return false;
+	}
+	OutValue = (int64)(Value >> 1) ^ -(int64)(Value & 1);
+	return true;
+}
+
+bool FRaceReplayReader::ReadFloat(float& OutValue)
+{
+	uint32 Bits;
+	if (!ReadUInt32(Bits))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&OutValue, &Bits, sizeof(Bits));
+	return true;
+}
+
+bool FRaceReplayReader::ReadUInt32(uint32& OutValue)
+{
+	if (Offset + 4 > Size)
+	{
+		bError = true;
+		return false;
+	}
+	OutValue = (uint32)Data[Offset] | ((uint32)Data[Offset + 1] << 8) | ((uint32)Data[Offset + 2] << 16) | ((uint32)Data[Offset + 3] << 24);
+	Offset += 4;
+	return true;
+}
+
+// ========================================
+// 无头回放
+// ========================================
+
+bool FRaceReplayPlayer::Open(const uint8* Data, int32 Size)
+{
+	Stats = FRaceReplayStats();
+	SelectedTileIndex = INDEX_NONE;
+	if (!Reader.Open(Data, Size, Header))
+	{
+		return false;
+	}
+
+	// 玩家棋盘：形状、特殊格子、方块、锁定依次恢复
+	Game.SetPlayableMask(Header.PlayableMask);
+	FMatch3SpecialAreas& SpecialAreas = Game.GetSpecialAreas();
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		SpecialAreas.SetEffectMask((EMatch3Effect)Type, Header.EffectMasks[Type]);
+	}
+	Game.SetCells(Header.Cells);
+	Game.SetLockedMask(Header.LockedMask);
+	Morale = Header.Morale;
+
+	BoardStream.Initialize(Header.BoardSeed);
+	RefillStream.Initialize(Header.RefillSeed);
+
+	Simulation.Reset(Header.SimConfig, Header.BaseSpeeds.Num());
+	for (int32 BoatIndex = 0; BoatIndex < Header.BaseSpeeds.Num(); ++BoatIndex)
+	{
+		Simulation.SetBaseSpeed(BoatIndex, Header.BaseSpeeds[BoatIndex]);
+	}
+	return true;
+}
+
+bool FRaceReplayPlayer::PlayToEnd()
+{
+	while (Step())
+	{
+	}
+	return HasEnded() && !HasError();
+}
+
+bool FRaceReplayPlayer::Step()
+{
+	if (!Reader.Next(Event))
+	{
+		return false;
+	}
+	Stats.NumEvents++;
+
+	switch (Event.Type)
+	{
+	case ERaceReplayEvent::TileInput:
+		HandleTileInput(Event);
+		break;
+
+	case ERaceReplayEvent::CastSkill:
+		Stats.NumSkillCasts++;
+		// 成功的释放消耗1个技能点；录制时技能点不足的释放，回放中也必须没有技能点
+		if (Event.bFlag ? !FMatch3Morale::ConsumeSkillPoints(Morale, 1) : Morale.SkillPoints >= 1)
+		{
+			RecordMismatch(Stats.NumCastMismatches, Event.Time);
+		}
+		break;
+
+	case ERaceReplayEvent::SpecialAreas:
+		for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			Game.GetSpecialAreas().SetEffectMask((EMatch3Effect)Type, Event.Masks[Type]);
+		}
+		break;
+
+	case ERaceReplayEvent::LockCells:
+		// 录制时若棋盘正在结算，死锁由结算结束时的 SettleBoard 检查；回放中交换已结算完毕，统一在这里检查
+		Game.SetLockedMask(Game.GetLockedMask() | Event.Masks[0]);
+		ReshuffleIfDeadlocked();
+		break;
+
+	case ERaceReplayEvent::UnlockCells:
+		Game.SetLockedMask(0);
+		break;
+
+	case ERaceReplayEvent::AISkill:
+		Stats.NumAISkills++;
+		break;
+
+	case ERaceReplayEvent::Status:
+	{
+		Stats.NumStatuses++;
+		while (Simulation.GetStepCount() < Event.Step)
+		{
+			Simulation.Step();
+		}
+		const bool bValid = Event.Index >= 0 && Event.Index < Simulation.Num() && Event.Value < (int32)ERaceStatus::Count;
+		const bool bApplied = bValid && Simulation.ApplyStatus(Event.Index, (ERaceStatus)Event.Value, Event.Magnitude, Event.Duration, Event.Target);
+		if (bApplied != Event.bFlag)
+		{
+			RecordMismatch(Stats.NumStatusMismatches, Event.Time);
+		}
+		break;
+	}
+
+	case ERaceReplayEvent::Checksum:
+		Stats.NumChecksums++;
+		if (ComputeChecksum(Game, Morale) != Event.Checksum)
+		{
+			RecordMismatch(Stats.NumChecksumMismatches, Event.Time);
+		}
+		break;
+
+	case ERaceReplayEvent::End:
+		while (Simulation.GetStepCount() < Event.Step)
+		{
+			Simulation.Step();
+		}
+		for (int32 BoatIndex = 0; BoatIndex < Simulation.Num(); ++BoatIndex)
+		{
+			const float Expected = Event.FinishTimes.IsValidIndex(BoatIndex) ? Event.FinishTimes[BoatIndex] : -1.0f;
+			if (Simulation.GetFinishTime(BoatIndex) != Expected)
+			{
+				RecordMismatch(Stats.NumFinishMismatches, Event.Time);
+			}
+		}
+		break;
+
+	case ERaceReplayEvent::Difficulty:
+	default:
+		break;
+	}
+	return true;
+}
+
+void FRaceReplayPlayer::HandleTileInput(const FRaceReplayEvent& InEvent)
+{
+	// 与 ADatamanagement::HandleTileInput 相同的选中规则
+	Stats.NumTileInputs++;
+	const int32 TileIndex = InEvent.Index;
+	if (TileIndex < 0 || TileIndex >= FMatch3Board::NumCells)
+	{
+		return;
+	}
+
+	if (SelectedTileIndex == INDEX_NONE)
+	{
+		SelectedTileIndex = TileIndex;
+		return;
+	}
+	if (SelectedTileIndex == TileIndex)
+	{
+		SelectedTileIndex = INDEX_NONE;
+		return;
+	}
+
+	const int32 RowDistance = FMath::Abs(SelectedTileIndex / FMatch3Board::Cols - TileIndex / FMatch3Board::Cols);
+	const int32 ColDistance = FMath::Abs(SelectedTileIndex % FMatch3Board::Cols - TileIndex % FMatch3Board::Cols);
+	if (RowDistance + ColDistance != 1)
+	{
+		SelectedTileIndex = TileIndex;
+		return;
+	}
+
+	// 结算期间的交换被 TrySwap 拒绝
+	if (!InEvent.bFlag && Game.IsValidSwap(SelectedTileIndex, TileIndex))
+	{
+		PlaySwap(SelectedTileIndex, TileIndex);
+	}
+	else
+	{
+		Stats.NumRejectedSwaps++;
+	}
+	SelectedTileIndex = INDEX_NONE;
+}
+
+void FRaceReplayPlayer::PlaySwap(int32 IndexA, int32 IndexB)
+{
+	Stats.NumSwaps++;
+	Game.ApplySwap(IndexA, IndexB);
+
+	const FMatch3SpecialAreas& SpecialAreas = Game.GetSpecialAreas();
+	for (;;)
+	{
+		uint64 Horizontal, Vertical;
+		Game.FindMatches(Horizontal, Vertical);
+		const uint64 MatchedMask = Horizontal | Vertical;
+		if (!MatchedMask)
+		{
+			break;
+		}
+
+		// 士气值逐步结算（技能点已满时的拒绝规则与逐步顺序有关）
+		const int32 Reward = FMatch3Morale::CalculateReward(Header.MoraleConfig, FMatch3Bits::Count(MatchedMask),
+			SpecialAreas.CountHits(MatchedMask, EMatch3Effect::MoraleBoost));
+		FMatch3Morale::AddMorale(Morale, Header.MoraleConfig, Reward);
+
+		Game.ClearCells(MatchedMask);
+		Game.CollapseAndRefill(
+			[this]() { return (uint8)RefillStream.RandRange(0, FMatch3Board::NumColors - 1); },
+			[](int32, int32, uint8, bool) {});
+	}
+
+	Game.Settle();
+	ReshuffleIfDeadlocked();
+}
+
+void FRaceReplayPlayer::ReshuffleIfDeadlocked()
+{
+	if (!Game.HasAnyValidMove())
+	{
+		Game.Reshuffle([this](int32 Max) { return BoardStream.RandHelper(Max); });
+		Stats.NumReshuffles++;
+	}
+}
+
+void FRaceReplayPlayer::RecordMismatch(int32& Counter, double Time)
+{
+	if (Stats.NumMismatches() == 0)
+	{
+		Stats.FirstMismatchTime = Time;
+	}
+	Counter++;
+}
+
+uint32 FRaceReplayPlayer::ComputeChecksum(const FMatch3Game& Game, const FMatch3MoraleState& Morale)
+{
+	// FNV-1a：颜色掩码、锁定掩码、士气值、技能点
+	uint64 Hash = 14695981039346656037ull;
+	auto Mix = [&Hash](uint64 Value)
+	{
+		for (int32 Shift = 0; Shift < 64; Shift += 8)
+		{
+			Hash = (Hash ^ ((Value >> Shift) & 0xFF)) * 1099511628211ull;
+		}
+	};
+
+	const FMatch3Board& Board = Game.GetBoard();
+	for (int32 Color = 0; Color < FMatch3Board::NumColors; ++Color)
+	{
+		Mix(Board.GetColorMask(Color));
+	}
+	Mix(Board.GetLockedMask());
+	Mix(((uint64)(uint32)Morale.CurrentMorale << 32) | (uint32)Morale.SkillPoints);
+	return (uint32)(Hash ^ (Hash >> 32));
+}
@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceSimulation.h"
+#include "RaceSnapshot.h"
+
+void FRaceSimulation::Reset(const FRaceSimConfig& InConfig, int32 NumBoats)
+{
+	Config = InConfig;
+	Config.FixedStepSeconds = FMath::Max(Config.FixedStepSeconds, UE_KINDA_SMALL_NUMBER);
+	Config.TrackLength = FMath::Max(Config.TrackLength, UE_KINDA_SMALL_NUMBER);
+	Config.MaxStepsPerAdvance = FMath::Max(Config.MaxStepsPerAdvance, 1);
+	NumBoats = FMath::Max(0, NumBoats);
+
+	BaseSpeeds.Reset(NumBoats);
+	BaseSpeeds.AddZeroed(NumBoats);
+	Speeds.Reset(NumBoats);
+	Speeds.AddZeroed(NumBoats);
+	Distances.Reset(NumBoats);
+	Distances.AddZeroed(NumBoats);
+	PreviousDistances.Reset(NumBoats);
+	PreviousDistances.AddZeroed(NumBoats);
+	FinishTimes.Reset(NumBoats);
+	for (int32 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		FinishTimes.Add(-1.0f);
+	}
+
+	Statuses.Reset(NumBoats);
+	StepCount = 0;
+	Accumulator = 0.0f;
+	NumFinished = 0;
+}
+
+bool FRaceSimulation::ApplyStatus(int32 BoatIndex, ERaceStatus Status, float Magnitude, float DurationSeconds, int32 SourceIndex)
+{
+	if (HasFinished(BoatIndex))
+	{
+		return false;
+	}
+	return Statuses.Apply(BoatIndex, Status, Magnitude, StepCount + DurationToSteps(DurationSeconds), SourceIndex);
+}
+
+int32 FRaceSimulation::Advance(float DeltaSeconds)
+{
+	Accumulator += FMath::Max(0.0f, DeltaSeconds);
+
+	int32 NumSteps = 0;
+	while (Accumulator >= Config.FixedStepSeconds)
+	{
+		if (NumSteps == Config.MaxStepsPerAdvance)
+		{
+			// 卡顿：丢弃追不上的时间（模拟时间比真实时间慢，但每一步仍然相同）
+			Accumulator = 0.0f;
+			break;
+		}
+		Accumulator -= Config.FixedStepSeconds;
+		Step();
+		NumSteps++;
+	}
+	return NumSteps;
+}
+
+void FRaceSimulation::Step()
+{
+	// 1. 到期的状态效果失效，速度 = 基础速度 + 生效中的速度效果
+	Statuses.Expire(StepCount);
+	for (int32 BoatIndex = 0; BoatIndex < Speeds.Num(); ++BoatIndex)
+	{
+		Speeds[BoatIndex] = BaseSpeeds[BoatIndex]
+			+ Statuses.GetMagnitude(BoatIndex, ERaceStatus::SpeedBoost)
+			+ Statuses.GetMagnitude(BoatIndex, ERaceStatus::SlowDown)
+			+ Statuses.GetMagnitude(BoatIndex, ERaceStatus::EastWind);
+	}
+
+	// 2. 推进位置，到达终点时按本步内的位置插值出完成时间
+	const float StepSeconds = Config.FixedStepSeconds;
+	for (int32 BoatIndex = 0; BoatIndex < Distances.Num(); ++BoatIndex)
+	{
+		const float Distance = Distances[BoatIndex];
+		PreviousDistances[BoatIndex] = Distance;
+		if (FinishTimes[BoatIndex] >= 0.0f)
+		{
+			Speeds[BoatIndex] = 0.0f;
+			continue;
+		}
+
+		const float Speed = Statuses.Has(BoatIndex, ERaceStatus::FloodSeven) ? 0.0f : FMath::Max(0.0f, Speeds[BoatIndex]);
+		Speeds[BoatIndex] = Speed;
+
+		const float NewDistance = Distance + Speed * StepSeconds;
+		if (NewDistance >= Config.TrackLength)
+		{
+			const float StepFraction = (Config.TrackLength - Distance) / (NewDistance - Distance);
+			FinishTimes[BoatIndex] = (StepCount + StepFraction) * StepSeconds;
+			Distances[BoatIndex] = Config.TrackLength;
+			NumFinished++;
+		}
+		else
+		{
+			Distances[BoatIndex] = NewDistance;
+		}
+	}
+
+	StepCount++;
+}
+
+int32 FRaceSimulation::RunToFinish(float MaxSeconds)
+{
+	const int64 MaxSteps = FMath::FloorToInt64(MaxSeconds / Config.FixedStepSeconds);
+	int32 NumSteps = 0;
+	while (!IsRaceComplete() && StepCount < MaxSteps)
+	{
+		Step();
+		NumSteps++;
+	}
+	Accumulator = 0.0f;
+	return NumSteps;
+}
+
+// ========================================
+// 快照
+// ========================================
+
+void FRaceSimulation::WriteSnapshot(FRaceSnapshotWriter& Writer) const
+{
+	Writer.WriteFloat(Config.FixedStepSeconds);
+	Writer.WriteFloat(Config.TrackLength);
+	Writer.WritePacked(Config.MaxStepsPerAdvance);
+
+	Writer.WritePacked(Num());
+	for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+	{
+		Writer.WriteFloat(BaseSpeeds[BoatIndex]);
+		Writer.WriteFloat(Speeds[BoatIndex]);
+		Writer.WriteFloat(Distances[BoatIndex]);
+		Writer.WriteFloat(PreviousDistances[BoatIndex]);
+		Writer.WriteFloat(FinishTimes[BoatIndex]);
+	}
+
+	Writer.WritePacked((uint64)StepCount);
+	Writer.WriteFloat(Accumulator);
+	Statuses.WriteSnapshot(Writer, StepCount);
+}
+
+void FRaceSimulation::ReadSnapshot(FRaceSnapshotReader& Reader)
+{
+	FRaceSimConfig InConfig;
+	InConfig.FixedStepSeconds = Reader.ReadFloat();
+	InConfig.TrackLength = Reader.ReadFloat();
+	InConfig.MaxStepsPerAdvance = Reader.ReadCount(MAX_int32);
+	Reset(InConfig, Reader.ReadCount(1024));
+
+	for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+	{
+		BaseSpeeds[BoatIndex] = Reader.ReadFloat();
+		Speeds[BoatIndex] = Reader.ReadFloat();
+		Distances[BoatIndex] = Reader.ReadFloat();
+		PreviousDistances[BoatIndex] = Reader.ReadFloat();
+		FinishTimes[BoatIndex] = Reader.ReadFloat();
+		NumFinished += FinishTimes[BoatIndex] >= 0.0f ? 1 : 0;
+	}
+
+	StepCount = (int64)Reader.ReadPacked();
+	Accumulator = Reader.ReadFloat();
+	Statuses.ReadSnapshot(Reader, StepCount);
+	if (Statuses.NumTargets() != Num())
+	{
+		Reader.SetError();
+	}
+}
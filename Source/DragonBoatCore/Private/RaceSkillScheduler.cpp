@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceSkillScheduler.h"
+#include "RaceBoatRegistry.h"
+#include "RaceSnapshot.h"
+
+// ========================================
+// 释放调度
+// ========================================
+
+void FRaceSkillScheduler::Reset(int32 InNumCasters)
+{
+	const int32 Count = FMath::Max(0, InNumCasters);
+
+	Heap.Reset(Count);
+	HeapPositions.Reset(Count);
+	for (int32 Caster = 0; Caster < Count; ++Caster)
+	{
+		HeapPositions.Add(INDEX_NONE);
+	}
+}
+
+void FRaceSkillScheduler::Schedule(int32 Caster, double Time)
+{
+	const int32 Position = HeapPositions[Caster];
+	if (Position == INDEX_NONE)
+	{
+		Heap.Add(FEntry{ Time, Caster });
+		HeapPositions[Caster] = Heap.Num() - 1;
+		SiftUp(Heap.Num() - 1);
+		return;
+	}
+
+	// 提前时向上调整，推迟时向下调整
+	const bool bEarlier = Time < Heap[Position].Time;
+	Heap[Position].Time = Time;
+	if (bEarlier)
+	{
+		SiftUp(Position);
+	}
+	else
+	{
+		SiftDown(Position);
+	}
+}
+
+void FRaceSkillScheduler::Cancel(int32 Caster)
+{
+	const int32 Position = HeapPositions[Caster];
+	if (Position == INDEX_NONE)
+	{
+		return;
+	}
+
+	// 用最后一个元素填补空位，再向上或向下调整
+	HeapPositions[Caster] = INDEX_NONE;
+	const FEntry Last = Heap.Pop(EAllowShrinking::No);
+	if (Position < Heap.Num())
+	{
+		Place(Position, Last);
+		SiftUp(Position);
+		SiftDown(HeapPositions[Last.Caster]);
+	}
+}
+
+int32 FRaceSkillScheduler::PopDue(double Now)
+{
+	if (Heap.Num() == 0 || Heap[0].Time > Now)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Caster = Heap[0].Caster;
+	Cancel(Caster);
+	return Caster;
+}
+
+void FRaceSkillScheduler::SiftUp(int32 Position)
+{
+	const FEntry Entry = Heap[Position];
+	while (Position > 0)
+	{
+		const int32 Parent = (Position - 1) / 2;
+		if (!IsEarlier(Entry, Heap[Parent]))
+		{
+			break;
+		}
+		Place(Position, Heap[Parent]);
+		Position = Parent;
+	}
+	Place(Position, Entry);
+}
+
+void FRaceSkillScheduler::SiftDown(int32 Position)
+{
+	const FEntry Entry = Heap[Position];
+	const int32 Count = Heap.Num();
+	for (;;)
+	{
+		int32 Child = 2 * Position + 1;
+		if (Child >= Count)
+		{
+			break;
+		}
+		if (Child + 1 < Count && IsEarlier(Heap[Child + 1], Heap[Child]))
+		{
+			Child++;
+		}
+		if (!IsEarlier(Heap[Child], Entry))
+		{
+			break;
+		}
+		Place(Position, Heap[Child]);
+		Position = Child;
+	}
+	Place(Position, Entry);
+}
+
+// ========================================
+// 目标选择
+// ========================================
+
+void FRaceSkillTargeting::Reset(int32 NumBoats)
+{
+	NumBoats = FMath::Max(0, NumBoats);
+
+	Ranks.Reset(NumBoats);
+	RankOrder.Reset(NumBoats);
+	Overtakers.Reset(NumBoats);
+	for (int32 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		Ranks.Add(BoatIndex + 1);
+		RankOrder.Add(BoatIndex);
+		Overtakers.Add(INDEX_NONE);
+	}
+
+	Finished.Reset(NumBoats);
+	Finished.AddZeroed(NumBoats);
+	OvertakeTimes.Reset(NumBoats);
+	OvertakeTimes.AddZeroed(NumBoats);
+	ChangedBoats.Reset(NumBoats);
+}
+
+void FRaceSkillTargeting::Observe(const FRaceBoatRegistry& Registry, double Time)
+{
+	if (Registry.Num() != Num())
+	{
+		Reset(Registry.Num());
+	}
+
+	// 排名改变的龙舟（Ranks 此时仍是上一次的排名）
+	ChangedBoats.Reset();
+	for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+	{
+		Finished[BoatIndex] = Registry.HasFinished(BoatIndex) ? 1 : 0;
+		RankOrder[Registry.GetRank(BoatIndex) - 1] = BoatIndex;
+		if (Registry.GetRank(BoatIndex) != Ranks[BoatIndex])
+		{
+			ChangedBoats.Add(BoatIndex);
+		}
+	}
+
+	// 先后顺序改变的两条龙舟中至少有一条排名改变：只需把排名改变的龙舟与其它所有龙舟比较
+	// 同一次更新中被多条龙舟超过时，记录现在紧挨在前面的那条
+	auto RecordOvertake = [this, &Registry, Time](int32 Overtaking, int32 Overtaken)
+	{
+		if (Overtakers[Overtaken] == INDEX_NONE || OvertakeTimes[Overtaken] != Time
+			|| Registry.GetRank(Overtaking) > Registry.GetRank(Overtakers[Overtaken]))
+		{
+			Overtakers[Overtaken] = Overtaking;
+			OvertakeTimes[Overtaken] = Time;
+		}
+	};
+	for (int32 Changed : ChangedBoats)
+	{
+		for (int32 Other = 0; Other < Num(); ++Other)
+		{
+			const bool bWasAhead = Ranks[Changed] < Ranks[Other];
+			const bool bIsAhead = Registry.GetRank(Changed) < Registry.GetRank(Other);
+			if (Other == Changed || bWasAhead == bIsAhead)
+			{
+				continue;
+			}
+			if (bIsAhead)
+			{
+				RecordOvertake(Changed, Other);
+			}
+			else
+			{
+				RecordOvertake(Other, Changed);
+			}
+		}
+	}
+
+	for (int32 Changed : ChangedBoats)
+	{
+		Ranks[Changed] = Registry.GetRank(Changed);
+	}
+}
+
+// ========================================
+// 快照
+// ========================================
+
+void FRaceSkillScheduler::WriteSnapshot(FRaceSnapshotWriter& Writer, double Now) const
+{
+	Writer.WritePacked(NumCasters());
+	for (int32 Caster = 0; Caster < NumCasters(); ++Caster)
+	{
+		Writer.WriteBool(IsScheduled(Caster));
+		if (IsScheduled(Caster))
+		{
+			Writer.WriteFloat((float)(GetCastTime(Caster) - Now));
+		}
+	}
+}
+
+void FRaceSkillScheduler::ReadSnapshot(FRaceSnapshotReader& Reader, double Now)
+{
+	Reset(Reader.ReadCount(1024));
+	for (int32 Caster = 0; Caster < NumCasters() && !Reader.HasError(); ++Caster)
+	{
+		if (Reader.ReadBool())
+		{
+			Schedule(Caster, Now + Reader.ReadFloat());
+		}
+	}
+}
+
+void FRaceSkillTargeting::WriteSnapshot(FRaceSnapshotWriter& Writer, double Now) const
+{
+	Writer.WritePacked(Num());
+	for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+	{
+		Writer.WritePacked(Ranks[BoatIndex]);
+		Writer.WriteBool(Finished[BoatIndex] != 0);
+		Writer.WritePackedSigned(Overtakers[BoatIndex]);
+		if (Overtakers[BoatIndex] != INDEX_NONE)
+		{
+			Writer.WriteFloat((float)(Now - OvertakeTimes[BoatIndex]));
+		}
+	}
+}
+
+void FRaceSkillTargeting::ReadSnapshot(FRaceSnapshotReader& Reader, double Now)
+{
+	const int32 NumBoats = Reader.ReadCount(1024);
+	Reset(NumBoats);
+	for (int32& Boat : RankOrder)
+	{
+		Boat = INDEX_NONE;
+	}
+	for (int32 BoatIndex = 0; BoatIndex < NumBoats; ++BoatIndex)
+	{
+		const int32 Rank = Reader.ReadCount(NumBoats);
+		Finished[BoatIndex] = Reader.ReadBool() ? 1 : 0;
+		const int64 Overtaker = Reader.ReadPackedSigned();
+		if (Rank < 1 || RankOrder[Rank - 1] != INDEX_NONE || Overtaker < INDEX_NONE || Overtaker >= NumBoats)
+		{
+			Reader.SetError();
+			Reset(NumBoats);
+			return;
+		}
+		Ranks[BoatIndex] = Rank;
+		RankOrder[Rank - 1] = BoatIndex;
+		Overtakers[BoatIndex] = (int32)Overtaker;
+		OvertakeTimes[BoatIndex] = Overtaker != INDEX_NONE ? Now - Reader.ReadFloat() : 0.0;
+	}
+}
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceSnapshot.h"
+
+static_assert(FMatch3Board::EmptyColor < (1 << FRaceSnapshot::BitsPerCell), "Colors and the empty marker must fit in BitsPerCell");
+static_assert(std::is_same_v<FMatch3Board::FMask, uint64>, "Snapshot masks are written as 64-bit integers");
+
+// ========================================
+// 写入
+// ========================================
+
+FRaceSnapshotWriter::FRaceSnapshotWriter(TArray<uint8>& InBytes)
+	: FRaceBitWriter(InBytes)
+{
+	// 文件头按字节写入，数据长度与 CRC 先占位
+	WriteBits(Magic, 32);
+	WriteBits(Version, 8);
+	WriteBits(FMatch3Board::Rows, 8);
+	WriteBits(FMatch3Board::Cols, 8);
+	WriteBits(FMatch3Board::NumColors, 8);
+	WriteBits(0, 32);
+	WriteBits(0, 32);
+}
+
+int32 FRaceSnapshotWriter::Finish()
+{
+	const int32 PayloadSize = Bytes.Num() - HeaderBytes;
+	const uint32 Crc = FCrc::MemCrc32(Bytes.GetData() + HeaderBytes, PayloadSize);
+	for (int32 Byte = 0; Byte < 4; ++Byte)
+	{
+		Bytes[8 + Byte] = (uint8)((uint32)PayloadSize >> (8 * Byte));
+		Bytes[12 + Byte] = (uint8)(Crc >> (8 * Byte));
+	}
+	return Bytes.Num();
+}
+
+// ========================================
+// 读取
+// ========================================
+
+FRaceSnapshotReader::FRaceSnapshotReader(const uint8* InData, int32 InSize)
+	: FRaceBitReader(InData, InSize)
+	, bValid(false)
+{
+	if (InSize < FRaceSnapshotWriter::HeaderBytes)
+	{
+		bError = true;
+		return;
+	}
+
+	const bool bHeaderMatches = ReadBits(32) == FRaceSnapshotWriter::Magic
+		&& ReadBits(8) == FRaceSnapshotWriter::Version
+		&& ReadBits(8) == FMatch3Board::Rows
+		&& ReadBits(8) == FMatch3Board::Cols
+		&& ReadBits(8) == FMatch3Board::NumColors;
+	const int32 PayloadSize = (int32)ReadBits(32);
+	const uint32 Crc = (uint32)ReadBits(32);
+
+	bValid = bHeaderMatches
+		&& PayloadSize == InSize - FRaceSnapshotWriter::HeaderBytes
+		&& Crc == FCrc::MemCrc32(Data + FRaceSnapshotWriter::HeaderBytes, PayloadSize);
+	bError = !bValid;
+}
+
+// ========================================
+// 通用数据
+// ========================================
+
+void FRaceSnapshot::WriteGame(FRaceSnapshotWriter& Writer, const FMatch3Game& Game)
+{
+	const FMatch3Board& Board = Game.GetBoard();
+	Writer.WriteMask(Board.GetPlayableMask());
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		Writer.WriteMask(Game.GetSpecialAreas().GetEffectMask((EMatch3Effect)Type));
+	}
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		Writer.WriteBits(Board.GetColor(Index), BitsPerCell);
+	}
+	Writer.WriteMask(Board.GetLockedMask());
+
+	// 稳定的棋盘只需要1位
+	const uint64 PendingDirty = Game.GetPendingDirtyMask();
+	Writer.WriteBool(PendingDirty != 0);
+	if (PendingDirty)
+	{
+		Writer.WriteMask(PendingDirty);
+	}
+}
+
+void FRaceSnapshot::ReadGame(FRaceSnapshotReader& Reader, FMatch3Game& Game)
+{
+	const uint64 PlayableMask = Reader.ReadMask();
+	FMatch3SpecialAreas SpecialAreas;
+	for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+	{
+		SpecialAreas.SetEffectMask((EMatch3Effect)Type, Reader.ReadMask());
+	}
+	uint8 Cells[FMatch3Board::NumCells];
+	for (int32 Index = 0; Index < FMatch3Board::NumCells; ++Index)
+	{
+		Cells[Index] = (uint8)Reader.ReadBits(BitsPerCell);
+	}
+	const uint64 LockedMask = Reader.ReadMask();
+	const uint64 PendingDirty = Reader.ReadBool() ? Reader.ReadMask() : 0;
+	if (Reader.HasError())
+	{
+		return;
+	}
+
+	// 与录像回放相同的顺序：形状、特殊格子、方块、锁定
+	Game.SetPlayableMask(PlayableMask);
+	Game.GetSpecialAreas() = SpecialAreas;
+	Game.SetCells(Cells, PendingDirty);
+	Game.SetLockedMask(LockedMask);
+}
+
+void FRaceSnapshot::WriteMorale(FRaceSnapshotWriter& Writer, const FMatch3MoraleState& Morale)
+{
+	Writer.WritePacked((uint64)FMath::Max(Morale.CurrentMorale, 0));
+	Writer.WritePacked((uint64)FMath::Max(Morale.SkillPoints, 0));
+}
+
+void FRaceSnapshot::ReadMorale(FRaceSnapshotReader& Reader, FMatch3MoraleState& Morale)
+{
+	Morale.CurrentMorale = Reader.ReadCount(MAX_int32);
+	Morale.SkillPoints = Reader.ReadCount(MAX_int32);
+}
+
+void FRaceSnapshot::WriteStream(FRaceSnapshotWriter& Writer, const FRandomStream& Stream)
+{
+	Writer.WriteBits((uint32)Stream.GetCurrentSeed(), 32);
+}
+
+void FRaceSnapshot::ReadStream(FRaceSnapshotReader& Reader, FRandomStream& Stream)
+{
+	Stream.Initialize((int32)(uint32)Reader.ReadBits(32));
+}
@@ -0,0 +1,224 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RaceStatusEffects.h"
+#include "RaceSnapshot.h"
+
+static_assert((FRaceStatusEffects::NumSlots & (FRaceStatusEffects::NumSlots - 1)) == 0, "NumSlots must be a power of two");
+static_assert(FRaceStatusEffects::NumStatusTypes <= 32, "ActiveMasks holds one bit per status");
+
+FRaceStatusEffects::FRaceStatusEffects()
+	: NumActiveEntries(0)
+{
+	for (int32& Head : Slots)
+	{
+		Head = INDEX_NONE;
+	}
+}
+
+void FRaceStatusEffects::Reset(int32 InNumTargets)
+{
+	InNumTargets = FMath::Max(0, InNumTargets);
+
+	Entries.Reset();
+	FreeEntries.Reset();
+	for (int32& Head : Slots)
+	{
+		Head = INDEX_NONE;
+	}
+
+	States.Reset(InNumTargets * NumStatusTypes);
+	States.AddDefaulted(InNumTargets * NumStatusTypes);
+	ActiveMasks.Reset(InNumTargets);
+	ActiveMasks.AddZeroed(InNumTargets);
+	NumActiveEntries = 0;
+}
+
+bool FRaceStatusEffects::Apply(int32 Target, ERaceStatus Status, float Magnitude, int64 ExpireStep, int32 SourceIndex)
+{
+	if (IsDebuff(Status) && SourceIndex != INDEX_NONE && SourceIndex != Target && IsImmune(Target))
+	{
+		return false;
+	}
+
+	FState& State = GetState(Target, Status);
+	if (GetStacking(Status) == ERaceStatusStacking::Refresh && State.RefreshEntry != INDEX_NONE)
+	{
+		// 已有一层：移到新的到期槽
+		FEntry& Entry = Entries[State.RefreshEntry];
+		Entry.Magnitude = Magnitude;
+		State.Magnitude = Magnitude;
+		if (ExpireStep > Entry.ExpireStep)
+		{
+			Unlink(State.RefreshEntry);
+			Entry.ExpireStep = ExpireStep;
+			State.LatestExpireStep = ExpireStep;
+			Link(State.RefreshEntry);
+		}
+		return true;
+	}
+
+	int32 EntryIndex;
+	if (FreeEntries.Num() > 0)
+	{
+		EntryIndex = FreeEntries.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		EntryIndex = Entries.AddUninitialized();
+	}
+
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.ExpireStep = ExpireStep;
+	Entry.Magnitude = Magnitude;
+	Entry.Target = Target;
+	Entry.Status = Status;
+	Link(EntryIndex);
+
+	State.StackCount++;
+	State.Magnitude += Magnitude;
+	State.LatestExpireStep = FMath::Max(State.LatestExpireStep, ExpireStep);
+	if (GetStacking(Status) == ERaceStatusStacking::Refresh)
+	{
+		State.RefreshEntry = EntryIndex;
+	}
+	ActiveMasks[Target] |= StatusBit(Status);
+	NumActiveEntries++;
+	return true;
+}
+
+int32 FRaceStatusEffects::Expire(int64 Step)
+{
+	int32 NumExpired = 0;
+	int32 EntryIndex = Slots[Step & (NumSlots - 1)];
+	while (EntryIndex != INDEX_NONE)
+	{
+		const FEntry& Entry = Entries[EntryIndex];
+		const int32 NextIndex = Entry.Next;
+
+		// 同一槽中还有之后几圈才到期的效果
+		if (Entry.ExpireStep <= Step)
+		{
+			Unlink(EntryIndex);
+
+			FState& State = GetState(Entry.Target, Entry.Status);
+			State.StackCount--;
+			State.Magnitude -= Entry.Magnitude;
+			if (State.StackCount == 0)
+			{
+				// 最后一层到期：清零（避免浮点加减的残差）
+				State = FState();
+				ActiveMasks[Entry.Target] &= ~StatusBit(Entry.Status);
+			}
+
+			FreeEntries.Add(EntryIndex);
+			NumActiveEntries--;
+			NumExpired++;
+		}
+		EntryIndex = NextIndex;
+	}
+	return NumExpired;
+}
+
+void FRaceStatusEffects::Link(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+	int32& Head = Slots[Entry.ExpireStep & (NumSlots - 1)];
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = Head;
+	if (Head != INDEX_NONE)
+	{
+		Entries[Head].Prev = EntryIndex;
+	}
+	Head = EntryIndex;
+}
+
+void FRaceStatusEffects::Unlink(int32 EntryIndex)
+{
+	const FEntry& Entry = Entries[EntryIndex];
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		Slots[Entry.ExpireStep & (NumSlots - 1)] = Entry.Next;
+	}
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+}
+
+// ========================================
+// 快照
+// ========================================
+
+void FRaceStatusEffects::WriteSnapshot(FRaceSnapshotWriter& Writer, int64 CurrentStep) const
+{
+	Writer.WritePacked(NumTargets());
+	Writer.WritePacked(NumActiveEntries);
+
+	// 每个槽从链表尾写到头：恢复时依次插入链表头，槽内顺序与现在相同
+	for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+	{
+		int32 Tail = Slots[Slot];
+		while (Tail != INDEX_NONE && Entries[Tail].Next != INDEX_NONE)
+		{
+			Tail = Entries[Tail].Next;
+		}
+		for (int32 EntryIndex = Tail; EntryIndex != INDEX_NONE; EntryIndex = Entries[EntryIndex].Prev)
+		{
+			const FEntry& Entry = Entries[EntryIndex];
+			Writer.WritePacked(Entry.Target);
+			Writer.WriteBits((uint64)Entry.Status, 3);
+			Writer.WritePacked((uint64)FMath::Max<int64>(Entry.ExpireStep - CurrentStep, 0));
+			Writer.WriteFloat(Entry.Magnitude);
+		}
+	}
+
+	// 叠加效果的数值和与逐层相加的顺序有关，直接保存
+	for (int32 Target = 0; Target < NumTargets(); ++Target)
+	{
+		Writer.WriteBits(ActiveMasks[Target], NumStatusTypes);
+		for (uint32 Remaining = ActiveMasks[Target]; Remaining; Remaining &= Remaining - 1)
+		{
+			Writer.WriteFloat(GetState(Target, (ERaceStatus)FMath::CountTrailingZeros(Remaining)).Magnitude);
+		}
+	}
+}
+
+void FRaceStatusEffects::ReadSnapshot(FRaceSnapshotReader& Reader, int64 CurrentStep)
+{
+	static_assert(NumStatusTypes <= 8, "Status types are written in 3 bits");
+
+	Reset(Reader.ReadCount(1024));
+	const int32 NumEntries = Reader.ReadCount(MAX_int32);
+	for (int32 Entry = 0; Entry < NumEntries && !Reader.HasError(); ++Entry)
+	{
+		// 目标索引按龙舟数检查（损坏的数据不会回绕为负数）
+		const int32 Target = Reader.ReadCount(FMath::Max(NumTargets() - 1, 0));
+		const uint64 Status = Reader.ReadBits(3);
+		const int64 ExpireStep = CurrentStep + (int64)Reader.ReadPacked();
+		const float Magnitude = Reader.ReadFloat();
+		if (Target >= NumTargets() || Status >= (uint64)NumStatusTypes)
+		{
+			Reader.SetError();
+			break;
+		}
+		Apply(Target, (ERaceStatus)Status, Magnitude, ExpireStep, INDEX_NONE);
+	}
+
+	for (int32 Target = 0; Target < NumTargets() && !Reader.HasError(); ++Target)
+	{
+		const uint32 ActiveMask = (uint32)Reader.ReadBits(NumStatusTypes);
+		if (ActiveMask != ActiveMasks[Target])
+		{
+			Reader.SetError();
+			break;
+		}
+		for (uint32 Remaining = ActiveMask; Remaining; Remaining &= Remaining - 1)
+		{
+			GetState(Target, (ERaceStatus)FMath::CountTrailingZeros(Remaining)).Magnitude = Reader.ReadFloat();
+		}
+	}
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Match3Game.h"
+#include "Match3Morale.h"
+#include "Match3MoveRanker.h"
+
+class FRaceSnapshotWriter;
+class FRaceSnapshotReader;
+
+// AI 选择交换的策略
+enum class EMatch3AIPolicy : uint8
+{
+	Random = 0,		// 随机选择一个有效交换
+	Greedy,			// 选择首次消除士气值最高的交换
+	Mixed,			// 按 GreedyChance 的概率贪心，否则随机
+};
+
+// AI 模拟配置（每批开始时由游戏线程拷贝一份交给工作线程）
+struct FMatch3AIConfig
+{
+	EMatch3AIPolicy Policy;
+	float GreedyChance;				// Mixed 策略下贪心选择的概率（0~1）
+	FMatch3MoraleConfig Morale;		// 与玩家相同的士气值规则
+
+	FMatch3AIConfig()
+		: Policy(EMatch3AIPolicy::Greedy)
+		, GreedyChance(0.5f)
+	{}
+};
+
+// 一批模拟的结果（可累加，用于多批或多局汇总）
+struct FMatch3AIBatchResult
+{
+	// 连消深度分布的最后一档（该档统计深度 >= MaxCascadeDepth 的交换）
+	static constexpr int32 MaxCascadeDepth = 8;
+
+	int64 MovesPlayed;
+	int64 ClearedTiles;
+	int64 MoraleEarned;			// 消除获得的士气值（转换为技能点之前）
+	int64 EffectHits[(int32)EMatch3Effect::Count];	// 各类特殊格子的触发次数
+	int64 SkillPointsGained;	// 本批转换得到的技能点（已从 AI 棋盘移交给调用方）
+	int64 Reshuffles;			// 死锁洗牌次数
+	int64 CascadeDepths[MaxCascadeDepth + 1];	// 按消除步数统计的交换数（下标1起）
+
+	FMatch3AIBatchResult()
+		: MovesPlayed(0)
+		, ClearedTiles(0)
+		, MoraleEarned(0)
+		, SkillPointsGained(0)
+		, Reshuffles(0)
+	{
+		for (int32 Type = 0; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			EffectHits[Type] = 0;
+		}
+		for (int32 Depth = 0; Depth <= MaxCascadeDepth; ++Depth)
+		{
+			CascadeDepths[Depth] = 0;
+		}
+	}
+
+	void Accumulate(const FMatch3AIBatchResult& Other)
+	{
+		MovesPlayed += Other.MovesPlayed;
+		ClearedTiles += Other.ClearedTiles;
+		MoraleEarned += Other.MoraleEarned;
+		SkillPointsGained += Other.SkillPointsGained;
+		Reshuffles += Other.Reshuffles;
+		for (int32 Type = 0; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			EffectHits[Type] += Other.EffectHits[Type];
+		}
+		for (int32 Depth = 0; Depth <= MaxCascadeDepth; ++Depth)
+		{
+			CascadeDepths[Depth] += Other.CascadeDepths[Depth];
+		}
+	}
+};
+
+/**
+ * AI 三消玩家 - 在自己的无头棋盘上按策略连续交换，用与玩家相同的士气值规则积累技能点
+ * 不访问任何共享状态，可以在工作线程上运行；同一时间只能有一个线程调用 PlayMoves
+ * 初始化之后不再分配堆内存
+ */
+class DRAGONBOATCORE_API FMatch3AIPlayer
+{
+public:
+	// 用种子生成棋盘，特殊格子布局与玩家棋盘相同，清空士气值
+	void Initialize(int32 Seed, const FMatch3SpecialAreas& SpecialAreas);
+
+	// 连续执行 NumMoves 次交换（每次含全部连消与死锁洗牌）
+	FMatch3AIBatchResult PlayMoves(int32 NumMoves, const FMatch3AIConfig& Config);
+
+	// 铁索连环：锁定去掉有效交换最多的 NumCells 个格子，返回锁定的数量 / 解除所有锁定（与 PlayMoves 不能同时调用）
+	int32 LockCells(int32 NumCells);
+	void UnlockAllCells();
+
+	const FMatch3Game& GetGame() const { return Game; }
+	const FMatch3MoraleState& GetMoraleState() const { return Morale; }
+
+	// 快照：棋盘、随机流与士气值（与 PlayMoves 不能同时调用）
+	void WriteSnapshot(FRaceSnapshotWriter& Writer) const;
+	void ReadSnapshot(FRaceSnapshotReader& Reader);
+
+	// 检查点：派发一批之前由游戏线程保存，批次进行中写入快照时代替正在被工作线程修改的棋盘
+	// 只拷贝定长数据（不含交换排名缓冲），不分配堆内存；写入的格式与 WriteSnapshot 相同
+	struct FCheckpoint
+	{
+		FMatch3Game Game;
+		FRandomStream Stream;
+		FMatch3MoraleState Morale;
+	};
+
+	void SaveCheckpoint(FCheckpoint& OutCheckpoint) const
+	{
+		OutCheckpoint.Game = Game;
+		OutCheckpoint.Stream = Stream;
+		OutCheckpoint.Morale = Morale;
+	}
+
+	// 回到检查点（从快照恢复时使用，与 ReadSnapshot 相同）
+	void RestoreCheckpoint(const FCheckpoint& Checkpoint)
+	{
+		Game = Checkpoint.Game;
+		Stream = Checkpoint.Stream;
+		Morale = Checkpoint.Morale;
+		Ranker.Reset();
+	}
+
+	static void WriteSnapshot(FRaceSnapshotWriter& Writer, const FCheckpoint& Checkpoint);
+	static void ReadSnapshot(FRaceSnapshotReader& Reader, FCheckpoint& OutCheckpoint);
+
+private:
+	// 按策略选择一个有效交换，死锁时返回 false
+	bool PickMove(const FMatch3AIConfig& Config, int32& OutIndexA, int32& OutIndexB);
+
+	// AI 的棋盘
+	FMatch3Game Game;
+
+	// 棋盘生成、下落补充与策略决策共用的随机流（与玩家的随机流互不影响）
+	FRandomStream Stream;
+
+	// 未满一个技能点的士气值（技能点每批移交给调用方）
+	FMatch3MoraleState Morale;
+
+	// 贪心策略使用的交换排名
+	TMatch3MoveRanker<FMatch3Game> Ranker;
+};
@@ -0,0 +1,501 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Mask.h"
+
+/**
+ * 三消位棋盘 - 每种颜色用一个掩码保存 InRows x InCols 个格子
+ * 行数、列数与颜色数都是编译期常量，每种规格的移位与掩码在编译期确定，颜色循环可完全展开
+ * 位索引与 OrbGrid 索引一致：行号 * Cols + 列号（第0行在最上方）
+ * 颜色值 0 ~ NumColors-1 为各颜色，NumColors 为空（默认规格下与 ETileColor 一致）
+ *
+ * 不规则棋盘：PlayableMask 之外的格子是空洞，永远没有方块；方块下落时越过空洞落到下方的可用格子
+ * 锁定格子（铁索连环）：LockedMask 中的格子不能参与交换，方块仍然可以被匹配消除，新方块落入后依旧锁定
+ */
+template <int32 InRows, int32 InCols, int32 InNumColors>
+struct TMatch3Board
+{
+	static_assert(InRows >= 4 && InCols >= 4, "Board needs room for a 4-cell move pattern in both directions");
+	static_assert(InNumColors >= 4 && InNumColors <= 8, "Generator needs at least 4 colors; color sets are stored in 8 bits");
+
+	// 棋盘大小
+	static constexpr int32 Rows = InRows;
+	static constexpr int32 Cols = InCols;
+	static constexpr int32 NumCells = Rows * Cols;
+
+	// 颜色数量与空格子的颜色值
+	static constexpr int32 NumColors = InNumColors;
+	static constexpr uint8 EmptyColor = (uint8)NumColors;
+
+	// 掩码类型：不超过 64 格时为 uint64
+	using FMask = TMatch3Mask<NumCells>;
+
+	// 整个棋盘的有效位
+	static constexpr FMask BoardMask = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, Cols);
+
+	// 第0列的所有格子（左移 Col 位得到任意一列）
+	static constexpr FMask ColumnMask = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, 1);
+
+	// 横向3连的起点只能在第 0 ~ Cols-3 列
+	static constexpr FMask HorizontalStartMask = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, Cols - 2);
+
+	// 纵向3连的起点只能在第 0 ~ Rows-3 行
+	static constexpr FMask VerticalStartMask = FMatch3Bits::Rect<FMask>(Cols, 0, Rows - 2, 0, Cols);
+
+	// 横向/纵向可检查的起点总数（全盘扫描的工作量）
+	static constexpr int32 NumRunStarts = Rows * (Cols - 2) + (Rows - 2) * Cols;
+
+	TMatch3Board()
+		: PlayableMask(BoardMask)
+		, LockedMask(0)
+	{
+		Reset();
+	}
+
+	// 清空棋盘（形状保持不变）
+	void Reset()
+	{
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			ColorMasks[Color] = 0;
+		}
+	}
+
+	static FORCEINLINE constexpr FMask CellBit(int32 Index)
+	{
+		return FMatch3Bits::Bit<FMask>(Index);
+	}
+
+	static FORCEINLINE constexpr int32 ToIndex(int32 Row, int32 Col)
+	{
+		return Row * Cols + Col;
+	}
+
+	// ========== 棋盘形状 ==========
+
+	// 可放置方块的格子（默认整个棋盘）
+	FORCEINLINE FMask GetPlayableMask() const
+	{
+		return PlayableMask;
+	}
+
+	// 是否为规则的矩形棋盘
+	FORCEINLINE bool IsFullShape() const
+	{
+		return PlayableMask == BoardMask;
+	}
+
+	// 设置棋盘形状，空洞中的方块与锁定被移除
+	void SetPlayableMask(FMask Mask)
+	{
+		PlayableMask = Mask & BoardMask;
+		LockedMask &= PlayableMask;
+		ClearCells(~PlayableMask);
+	}
+
+	// ========== 锁定格子 ==========
+
+	// 不能参与交换的格子（清空棋盘时保持不变）
+	FORCEINLINE FMask GetLockedMask() const
+	{
+		return LockedMask;
+	}
+
+	// 可以参与交换的格子：可用且未锁定
+	FORCEINLINE FMask GetSwappableMask() const
+	{
+		return PlayableMask & ~LockedMask;
+	}
+
+	// 设置锁定格子（空洞不能锁定）
+	void SetLockedMask(FMask Mask)
+	{
+		LockedMask = Mask & PlayableMask;
+	}
+
+	// ========== 格子读写 ==========
+
+	// 读取格子颜色
+	uint8 GetColor(int32 Index) const
+	{
+		const FMask Bit = CellBit(Index);
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			if (ColorMasks[Color] & Bit)
+			{
+				return (uint8)Color;
+			}
+		}
+		return EmptyColor;
+	}
+
+	// 写入格子颜色（EmptyColor 表示清空，空洞只能写入 EmptyColor）
+	void SetColor(int32 Index, uint8 Color)
+	{
+		const FMask Bit = CellBit(Index);
+		for (int32 C = 0; C < NumColors; ++C)
+		{
+			ColorMasks[C] &= ~Bit;
+		}
+		if (Color < NumColors && (PlayableMask & Bit))
+		{
+			ColorMasks[Color] |= Bit;
+		}
+	}
+
+	// 从逐格颜色数组整体写入棋盘（Cells 长度为 NumCells，空洞中的值被忽略）
+	void SetCells(const uint8* Cells)
+	{
+		Reset();
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			if (Cells[Index] < NumColors)
+			{
+				ColorMasks[Cells[Index]] |= CellBit(Index);
+			}
+		}
+		ClearCells(~PlayableMask);
+	}
+
+	// 获取某种颜色的掩码
+	FORCEINLINE FMask GetColorMask(int32 Color) const
+	{
+		return ColorMasks[Color];
+	}
+
+	// 所有非空格子
+	FORCEINLINE FMask GetOccupiedMask() const
+	{
+		FMask Occupied = ColorMasks[0];
+		for (int32 Color = 1; Color < NumColors; ++Color)
+		{
+			Occupied |= ColorMasks[Color];
+		}
+		return Occupied;
+	}
+
+	// 所有空格子（不含空洞）
+	FORCEINLINE FMask GetEmptyMask() const
+	{
+		return PlayableMask & ~GetOccupiedMask();
+	}
+
+	// 交换两个格子（对每种颜色做位交换）
+	void SwapCells(int32 IndexA, int32 IndexB)
+	{
+		const FMask BitA = CellBit(IndexA);
+		const FMask BitB = CellBit(IndexB);
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			const FMask Mask = ColorMasks[Color];
+			const bool bHasA = (bool)(Mask & BitA);
+			const bool bHasB = (bool)(Mask & BitB);
+			if (bHasA != bHasB)
+			{
+				ColorMasks[Color] = Mask ^ (BitA | BitB);
+			}
+		}
+	}
+
+	// 清空掩码中的所有格子
+	FORCEINLINE void ClearCells(FMask Mask)
+	{
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			ColorMasks[Color] &= ~Mask;
+		}
+	}
+
+	// ========== 匹配查找 ==========
+
+	// 单色掩码中横向3连及以上的所有格子
+	static FORCEINLINE FMask HorizontalRuns(FMask Mask)
+	{
+		const FMask Starts = Mask & (Mask >> 1) & (Mask >> 2) & HorizontalStartMask;
+		return Starts | (Starts << 1) | (Starts << 2);
+	}
+
+	// 单色掩码中纵向3连及以上的所有格子（最后两行移位后自然为0，无需额外掩码）
+	static FORCEINLINE FMask VerticalRuns(FMask Mask)
+	{
+		const FMask Starts = Mask & (Mask >> Cols) & (Mask >> (Cols * 2));
+		return Starts | (Starts << Cols) | (Starts << (Cols * 2));
+	}
+
+	// 查找所有匹配，分别返回横向与纵向匹配的格子
+	void FindMatches(FMask& OutHorizontal, FMask& OutVertical) const
+	{
+		OutHorizontal = 0;
+		OutVertical = 0;
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			OutHorizontal |= HorizontalRuns(ColorMasks[Color]);
+			OutVertical |= VerticalRuns(ColorMasks[Color]);
+		}
+	}
+
+	// 查找所有匹配的格子
+	FMask FindMatches() const
+	{
+		FMask Horizontal, Vertical;
+		FindMatches(Horizontal, Vertical);
+		return Horizontal | Vertical;
+	}
+
+	// 覆盖到脏格子的横向3连起点（起点 s 覆盖 s, s+1, s+2）
+	static FORCEINLINE FMask HorizontalStartsNear(FMask DirtyMask)
+	{
+		return (DirtyMask | (DirtyMask >> 1) | (DirtyMask >> 2)) & HorizontalStartMask;
+	}
+
+	// 覆盖到脏格子的纵向3连起点
+	static FORCEINLINE FMask VerticalStartsNear(FMask DirtyMask)
+	{
+		return (DirtyMask | (DirtyMask >> Cols) | (DirtyMask >> (Cols * 2))) & VerticalStartMask;
+	}
+
+	/**
+	 * 局部匹配查找：只检查经过脏格子的行与列
+	 * 前提：修改前棋盘没有匹配（交换前的空闲棋盘、或消除后未变动的格子），
+	 * 此时任何新匹配必然包含脏格子，结果与全盘 FindMatches 完全一致
+	 */
+	void FindMatchesNear(FMask DirtyMask, FMask& OutHorizontal, FMask& OutVertical) const
+	{
+		const FMask HStartsNear = HorizontalStartsNear(DirtyMask);
+		const FMask VStartsNear = VerticalStartsNear(DirtyMask);
+
+		OutHorizontal = 0;
+		OutVertical = 0;
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			const FMask Mask = ColorMasks[Color];
+			const FMask HStarts = Mask & (Mask >> 1) & (Mask >> 2) & HStartsNear;
+			const FMask VStarts = Mask & (Mask >> Cols) & (Mask >> (Cols * 2)) & VStartsNear;
+			OutHorizontal |= HStarts | (HStarts << 1) | (HStarts << 2);
+			OutVertical |= VStarts | (VStarts << Cols) | (VStarts << (Cols * 2));
+		}
+	}
+
+	// 局部检查：是否存在包含脏格子的匹配
+	bool HasMatchNear(FMask DirtyMask) const
+	{
+		const FMask HStartsNear = HorizontalStartsNear(DirtyMask);
+		const FMask VStartsNear = VerticalStartsNear(DirtyMask);
+
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			const FMask Mask = ColorMasks[Color];
+			const FMask HStarts = Mask & (Mask >> 1) & (Mask >> 2) & HStartsNear;
+			const FMask VStarts = Mask & (Mask >> Cols) & (Mask >> (Cols * 2)) & VStartsNear;
+			if (HStarts | VStarts)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * 十字邻域：掩码中每个格子同行左右各2格、同列上下各2格（含自身）
+	 * 一个格子能否参与匹配只取决于这个范围内的格子
+	 */
+	static FMask CrossNeighborhood(FMask Mask)
+	{
+		constexpr FMask NotLeftCol = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 1, Cols);
+		constexpr FMask NotLeftTwoCols = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 2, Cols);
+		constexpr FMask NotRightCol = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, Cols - 1);
+		constexpr FMask NotRightTwoCols = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, Cols - 2);
+
+		return Mask
+			| ((Mask >> 1) & NotRightCol) | ((Mask >> 2) & NotRightTwoCols)
+			| ((Mask << 1) & NotLeftCol) | ((Mask << 2) & NotLeftTwoCols)
+			| (Mask >> Cols) | (Mask >> (Cols * 2))
+			| ((Mask << Cols) & BoardMask) | ((Mask << (Cols * 2)) & BoardMask);
+	}
+
+	// 局部检查需要检查的起点数量（用于统计节省的工作量）
+	static FORCEINLINE int32 CountRunStartsNear(FMask DirtyMask)
+	{
+		return FMatch3Bits::Count(HorizontalStartsNear(DirtyMask)) + FMatch3Bits::Count(VerticalStartsNear(DirtyMask));
+	}
+
+	// 是否存在任意匹配
+	bool HasMatch() const
+	{
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			const FMask Mask = ColorMasks[Color];
+			const FMask HStarts = Mask & (Mask >> 1) & (Mask >> 2) & HorizontalStartMask;
+			const FMask VStarts = Mask & (Mask >> Cols) & (Mask >> (Cols * 2));
+			if (HStarts | VStarts)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// ========== 下落填充 ==========
+
+	/**
+	 * 下落并填充空格子
+	 * 每列中方块的下落距离 = 其下方空格子数量（掩码 popcount），新方块从顶部依次填入
+	 * 含空洞的列逐格压实：方块越过空洞落到下方的可用格子，新方块填入最上方的可用格子
+	 * 回调顺序与旧版逐格实现一致：逐列，先新方块（自上而下），再下落的方块（自上而下）
+	 * @param NextColor	生成新方块颜色：uint8()
+	 * @param OnMove	记录移动：void(int32 FromIndex, int32 ToIndex, uint8 Color, bool bIsNewTile)
+	 * @return			内容被改写的格子（新方块与下落方块的目标位置），供局部匹配检查使用
+	 */
+	template <typename NextColorFunc, typename MoveFunc>
+	FMask CollapseAndRefill(NextColorFunc&& NextColor, MoveFunc&& OnMove)
+	{
+		const FMask Empty = GetEmptyMask();
+		if (!Empty)
+		{
+			return 0;
+		}
+
+		// 不规则棋盘走逐格压实的路径，规则棋盘保持 popcount 快速路径
+		if (!IsFullShape())
+		{
+			return CollapseAndRefillWithHoles(Empty, NextColor, OnMove);
+		}
+
+		FMask ChangedMask = 0;
+		FMask NewMasks[NumColors] = {};
+
+		for (int32 Col = 0; Col < Cols; ++Col)
+		{
+			const FMask ColBits = ColumnMask << Col;
+			const FMask ColEmpty = Empty & ColBits;
+
+			// 该列没有空格子，原样保留
+			if (!ColEmpty)
+			{
+				for (int32 Color = 0; Color < NumColors; ++Color)
+				{
+					NewMasks[Color] |= ColorMasks[Color] & ColBits;
+				}
+				continue;
+			}
+
+			const int32 MissingCount = FMatch3Bits::Count(ColEmpty);
+
+			// 新生成的方块
+			for (int32 Row = 0; Row < MissingCount; ++Row)
+			{
+				const int32 ToIdx = Row * Cols + Col;
+				const uint8 NewColor = NextColor();
+				NewMasks[NewColor] |= CellBit(ToIdx);
+				ChangedMask |= CellBit(ToIdx);
+				OnMove(-(MissingCount - Row), ToIdx, NewColor, true);
+			}
+
+			// 下落的方块（按位从上到下遍历）
+			FMatch3Bits::ForEach(ColBits & ~Empty, [&](int32 FromIdx)
+			{
+				const int32 Drop = FMatch3Bits::Count(ColEmpty >> FromIdx);
+				const int32 ToIdx = FromIdx + Drop * Cols;
+				const uint8 Color = GetColor(FromIdx);
+				NewMasks[Color] |= CellBit(ToIdx);
+
+				if (Drop > 0)
+				{
+					ChangedMask |= CellBit(ToIdx);
+					OnMove(FromIdx, ToIdx, Color, false);
+				}
+			});
+		}
+
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			ColorMasks[Color] = NewMasks[Color];
+		}
+
+		return ChangedMask;
+	}
+
+private:
+	// 不规则棋盘的下落：逐列压实，第 k 个（自上而下）方块落到第 MissingCount + k 个可用格子
+	template <typename NextColorFunc, typename MoveFunc>
+	FORCENOINLINE FMask CollapseAndRefillWithHoles(FMask Empty, NextColorFunc& NextColor, MoveFunc& OnMove)
+	{
+		FMask ChangedMask = 0;
+		FMask NewMasks[NumColors] = {};
+
+		for (int32 Col = 0; Col < Cols; ++Col)
+		{
+			const FMask ColBits = ColumnMask << Col;
+			const FMask ColEmpty = Empty & ColBits;
+			if (!ColEmpty)
+			{
+				for (int32 Color = 0; Color < NumColors; ++Color)
+				{
+					NewMasks[Color] |= ColorMasks[Color] & ColBits;
+				}
+				continue;
+			}
+
+			// 该列的可用格子（自上而下）
+			int32 Slots[Rows];
+			int32 NumSlots = 0;
+			FMatch3Bits::ForEach(PlayableMask & ColBits, [&Slots, &NumSlots](int32 Index)
+			{
+				Slots[NumSlots++] = Index;
+			});
+
+			// 新生成的方块
+			const int32 MissingCount = FMatch3Bits::Count(ColEmpty);
+			for (int32 Slot = 0; Slot < MissingCount; ++Slot)
+			{
+				const int32 ToIdx = Slots[Slot];
+				const uint8 NewColor = NextColor();
+				NewMasks[NewColor] |= CellBit(ToIdx);
+				ChangedMask |= CellBit(ToIdx);
+				OnMove(-(MissingCount - Slot), ToIdx, NewColor, true);
+			}
+
+			// 下落的方块
+			int32 NextSlot = MissingCount;
+			for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+			{
+				const int32 FromIdx = Slots[Slot];
+				if (ColEmpty & CellBit(FromIdx))
+				{
+					continue;
+				}
+
+				const int32 ToIdx = Slots[NextSlot++];
+				const uint8 Color = GetColor(FromIdx);
+				NewMasks[Color] |= CellBit(ToIdx);
+
+				if (ToIdx != FromIdx)
+				{
+					ChangedMask |= CellBit(ToIdx);
+					OnMove(FromIdx, ToIdx, Color, false);
+				}
+			}
+		}
+
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			ColorMasks[Color] = NewMasks[Color];
+		}
+
+		return ChangedMask;
+	}
+
+	// 每种颜色一个掩码
+	FMask ColorMasks[NumColors];
+
+	// 可放置方块的格子
+	FMask PlayableMask;
+
+	// 锁定的格子
+	FMask LockedMask;
+};
+
+// 默认棋盘：7x7、4种颜色（与 ETileColor 一致）
+using FMatch3Board = TMatch3Board<7, 7, 4>;
@@ -0,0 +1,307 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+#include "Match3MoveIndex.h"
+#include "Match3Generator.h"
+#include "Match3SpecialAreas.h"
+
+// 一次交换（含所有连消）的结算结果
+struct FMatch3TurnResult
+{
+	int32 NumSteps;			// 消除步数（首次消除 + 连消次数），0 表示交换无效
+	int32 ClearedTiles;		// 消除的方块总数
+	int32 EffectHits[(int32)EMatch3Effect::Count];	// 各类特殊格子的触发次数
+	bool bReshuffled;		// 结算后出现死锁并已洗牌
+
+	FMatch3TurnResult()
+		: NumSteps(0)
+		, ClearedTiles(0)
+		, bReshuffled(false)
+	{
+		for (int32 Type = 0; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			EffectHits[Type] = 0;
+		}
+	}
+};
+
+/**
+ * 三消对局 - 位棋盘 + 可交换索引 + 特殊格子，不依赖 UObject
+ * 既可以由 ADatamanagement 按动画节奏逐步驱动（ApplySwap -> FindMatches -> ClearCells -> CollapseAndRefill -> Settle），
+ * 也可以用 PlayMove 无动画一次结算（基准测试、离线模拟）
+ *
+ * 棋盘规格由 BoardType（TMatch3Board<Rows, Cols, NumColors>）在编译期确定
+ *
+ * RandHelper(int32 Max) 返回 [0, Max) 的随机整数
+ */
+template <typename BoardType>
+class TMatch3Game
+{
+public:
+	using FBoard = BoardType;
+	using FMoveIndex = TMatch3MoveIndex<BoardType>;
+	using FSpecialAreas = TMatch3SpecialAreas<BoardType>;
+	using FGenerator = TMatch3Generator<BoardType>;
+	using FMask = typename BoardType::FMask;
+
+	TMatch3Game()
+		: PendingDirtyMask(0)
+		, MoveIndexDirtyMask(0)
+		, BoardRevision(0)
+	{}
+
+	// ========== 数据访问 ==========
+
+	const BoardType& GetBoard() const { return Board; }
+	const FMoveIndex& GetMoveIndex() const { return MoveIndex; }
+	FSpecialAreas& GetSpecialAreas() { return SpecialAreas; }
+	const FSpecialAreas& GetSpecialAreas() const { return SpecialAreas; }
+
+	// 上次改动的格子（交换的两格或下落改写的格子），供下一次局部匹配检查使用
+	FMask GetPendingDirtyMask() const { return PendingDirtyMask; }
+
+	// 棋盘修订号：棋盘内容或形状每次改变时递增，用于判断缓存的分析结果（如交换排名）是否过期
+	uint32 GetBoardRevision() const { return BoardRevision; }
+
+	// 清空棋盘与可交换索引（特殊格子与棋盘形状保持不变）
+	void Reset()
+	{
+		Board.Reset();
+		MoveIndex.Reset();
+		PendingDirtyMask = 0;
+		MoveIndexDirtyMask = 0;
+		BoardRevision++;
+	}
+
+	// 设置不规则棋盘形状（之后需要重新生成棋盘）
+	void SetPlayableMask(FMask Mask)
+	{
+		Board.SetPlayableMask(Mask);
+		OnBoardReplaced();
+	}
+
+	// ========== 锁定格子（铁索连环）==========
+
+	FMask GetLockedMask() const { return Board.GetLockedMask(); }
+
+	/**
+	 * 设置锁定格子：锁定格子不能交换，可交换索引、死锁检测与洗牌都排除它们
+	 * 棋盘稳定时立即更新可交换索引，结算过程中则留到 Settle；
+	 * 锁定可能造成死锁，调用方在棋盘稳定后检查 HasAnyValidMove 并洗牌
+	 */
+	void SetLockedMask(FMask Mask)
+	{
+		const FMask Changed = Board.GetLockedMask() ^ (Mask & Board.GetPlayableMask());
+		if (!Changed)
+		{
+			return;
+		}
+
+		Board.SetLockedMask(Mask);
+		BoardRevision++;
+		if (MoveIndexDirtyMask)
+		{
+			MoveIndexDirtyMask |= Changed;
+		}
+		else
+		{
+			MoveIndex.Update(Board, Changed);
+		}
+	}
+
+	// 选择锁定后去掉有效交换最多的 NumCells 个未锁定格子（不会锁到没有有效交换），见 TMatch3MoveIndex::PickBlockingCells
+	template <typename RandFunc>
+	FMask PickLockCells(int32 NumCells, RandFunc&& RandHelper) const
+	{
+		return MoveIndex.PickBlockingCells(Board.GetSwappableMask(), NumCells, RandHelper);
+	}
+
+	// ========== 棋盘生成 ==========
+
+	// 生成没有匹配、且至少有一个有效交换的棋盘
+	template <typename RandFunc>
+	void Generate(RandFunc&& RandHelper)
+	{
+		FGenerator::Generate(Board, RandHelper);
+		OnBoardReplaced();
+	}
+
+	// 死锁洗牌：重新排列现有方块；无法排成有效棋盘时改为重新生成
+	// 返回 false 表示使用了重新生成
+	template <typename RandFunc>
+	bool Reshuffle(RandFunc&& RandHelper)
+	{
+		const bool bPermuted = FGenerator::Reshuffle(Board, RandHelper);
+		if (!bPermuted)
+		{
+			FGenerator::Generate(Board, RandHelper);
+		}
+		OnBoardReplaced();
+		return bPermuted;
+	}
+
+	// 整体写入棋盘（Cells 长度为 NumCells，用于恢复录像或快照中的棋盘）
+	// PendingDirty 为结算中的棋盘下一次局部匹配检查要扫描的格子（稳定的棋盘为0）
+	void SetCells(const uint8* Cells, FMask PendingDirty = 0)
+	{
+		Board.SetCells(Cells);
+		OnBoardReplaced();
+		PendingDirtyMask = PendingDirty;
+		MoveIndexDirtyMask = PendingDirty;
+	}
+
+	// ========== 逐步驱动 ==========
+
+	// O(1) 判断交换是否有效（棋盘稳定时有效）
+	bool IsValidSwap(int32 IndexA, int32 IndexB) const
+	{
+		return MoveIndex.IsValidSwap(IndexA, IndexB);
+	}
+
+	// 执行交换（不做验证），记录脏格子
+	void ApplySwap(int32 IndexA, int32 IndexB)
+	{
+		Board.SwapCells(IndexA, IndexB);
+		BoardRevision++;
+
+		const FMask SwapMask = BoardType::CellBit(IndexA) | BoardType::CellBit(IndexB);
+		PendingDirtyMask = SwapMask;
+		MoveIndexDirtyMask |= SwapMask;
+	}
+
+	// 查找匹配：只扫描经过上次改动格子的行与列
+	void FindMatches(FMask& OutHorizontal, FMask& OutVertical) const
+	{
+		Board.FindMatchesNear(PendingDirtyMask, OutHorizontal, OutVertical);
+	}
+
+	// 清空格子
+	void ClearCells(FMask Mask)
+	{
+		Board.ClearCells(Mask);
+		BoardRevision++;
+	}
+
+	// 下落并填充空格子，OnMove(From, To, Color, bIsNewTile) 的顺序与 TMatch3Board::CollapseAndRefill 一致
+	template <typename NextColorFunc, typename MoveFunc>
+	FMask CollapseAndRefill(NextColorFunc&& NextColor, MoveFunc&& OnMove)
+	{
+		PendingDirtyMask = Board.CollapseAndRefill(NextColor, OnMove);
+		BoardRevision++;
+		MoveIndexDirtyMask |= PendingDirtyMask;
+		return PendingDirtyMask;
+	}
+
+	// 棋盘稳定后调用：只重新评估改动格子附近的交换，返回重新评估的交换数
+	int32 Settle()
+	{
+		const int32 NumEvaluated = MoveIndex.Update(Board, MoveIndexDirtyMask);
+		PendingDirtyMask = 0;
+		MoveIndexDirtyMask = 0;
+		return NumEvaluated;
+	}
+
+	// 是否存在有效交换（死锁即为 false）
+	bool HasAnyValidMove() const
+	{
+		return MoveIndex.HasAnyMove();
+	}
+
+	// 按消除顺序遍历匹配的格子：先横向匹配（行优先），再仅属纵向匹配的格子（列优先）
+	template <typename VisitFunc>
+	static void ForEachMatchedCell(FMask Horizontal, FMask Vertical, VisitFunc&& Visit)
+	{
+		FMatch3Bits::ForEach(Horizontal, Visit);
+		const FMask VerticalOnly = Vertical & ~Horizontal;
+		for (int32 Col = 0; VerticalOnly && Col < BoardType::Cols; ++Col)
+		{
+			FMatch3Bits::ForEach(VerticalOnly & (BoardType::ColumnMask << Col), Visit);
+		}
+	}
+
+	// ========== 无动画结算 ==========
+
+	// 执行一次交换并结算所有连消，死锁时自动洗牌；交换无效时不修改棋盘
+	template <typename RandFunc>
+	FMatch3TurnResult PlayMove(int32 IndexA, int32 IndexB, RandFunc&& RandHelper)
+	{
+		FMatch3TurnResult Result;
+		if (!IsValidSwap(IndexA, IndexB))
+		{
+			return Result;
+		}
+
+		ApplySwap(IndexA, IndexB);
+
+		for (;;)
+		{
+			FMask Horizontal, Vertical;
+			FindMatches(Horizontal, Vertical);
+			const FMask MatchedMask = Horizontal | Vertical;
+			if (!MatchedMask)
+			{
+				break;
+			}
+
+			Result.NumSteps++;
+			Result.ClearedTiles += FMatch3Bits::Count(MatchedMask);
+			for (int32 Type = 1; Type < FSpecialAreas::NumEffectTypes; ++Type)
+			{
+				Result.EffectHits[Type] += SpecialAreas.CountHits(MatchedMask, (EMatch3Effect)Type);
+			}
+
+			ClearCells(MatchedMask);
+			CollapseAndRefill(
+				[&RandHelper]() { return (uint8)RandHelper(BoardType::NumColors); },
+				[](int32, int32, uint8, bool) {});
+		}
+
+		Settle();
+		if (!HasAnyValidMove())
+		{
+			Reshuffle(RandHelper);
+			Result.bReshuffled = true;
+		}
+		return Result;
+	}
+
+private:
+	// 棋盘整体替换后重建可交换索引
+	void OnBoardReplaced()
+	{
+		MoveIndex.Rebuild(Board);
+		PendingDirtyMask = 0;
+		MoveIndexDirtyMask = 0;
+		BoardRevision++;
+	}
+
+	// 位棋盘
+	BoardType Board;
+
+	// 可交换索引（棋盘稳定时保持最新）
+	FMoveIndex MoveIndex;
+
+	// 特殊格子布局
+	FSpecialAreas SpecialAreas;
+
+	// 上次改动的格子
+	FMask PendingDirtyMask;
+
+	// 自上次更新可交换索引以来改动过的格子
+	FMask MoveIndexDirtyMask;
+
+	// 棋盘修订号
+	uint32 BoardRevision;
+};
+
+// ========== 棋盘规格 ==========
+
+// 默认规格：7x7、4种颜色（ADatamanagement 使用，颜色与 ETileColor 一致）
+using FMatch3Game = TMatch3Game<FMatch3Board>;
+
+// 大棋盘规格：新玩法使用
+using FMatch3Game9x9 = TMatch3Game<TMatch3Board<9, 9, 5>>;
+using FMatch3Game12x12 = TMatch3Game<TMatch3Board<12, 12, 6>>;
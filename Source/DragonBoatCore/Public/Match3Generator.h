@@ -0,0 +1,287 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+/**
+ * 构造式棋盘生成器 - 单次遍历、时间有上界，不需要重试
+ * 1. 先在随机位置埋入一个“交换一次即可3连”的4格图案（X Y X X 或 X X Y X），保证至少有一个有效交换
+ * 2. 其余格子逐个选择颜色，排除会与已确定格子组成3连的颜色
+ *    按行优先顺序填充时，已确定的3格窗口最多排除3种颜色，4种颜色中总有可选颜色，因此结果一定没有匹配
+ * 不规则棋盘跳过空洞；图案只埋在4格都可用的位置，形状中必须存在横向或纵向连续4个可用格子
+ * 有锁定格子时图案优先埋在4格都未锁定的位置，保证埋入的交换不被锁定
+ *
+ * RandHelper(int32 Max) 返回 [0, Max) 的随机整数
+ */
+template <typename BoardType>
+struct TMatch3Generator
+{
+	using FMask = typename BoardType::FMask;
+
+	static constexpr int32 Rows = BoardType::Rows;
+	static constexpr int32 Cols = BoardType::Cols;
+	static constexpr int32 NumCells = BoardType::NumCells;
+	static constexpr int32 NumColors = BoardType::NumColors;
+
+	// 洗牌时重新排列的最大尝试次数
+	static constexpr int32 MaxReshuffleAttempts = 16;
+
+	// 生成一个没有匹配、且至少有一个有效交换的棋盘
+	template <typename RandFunc>
+	static void Generate(BoardType& Board, RandFunc&& RandHelper)
+	{
+		uint8 Cells[NumCells];
+		FMask Assigned = 0;
+		const FMask Holes = ~Board.GetPlayableMask();
+
+		// 1. 埋入保证可交换的图案
+		const uint8 X = (uint8)RandHelper(NumColors);
+		const uint8 Y = (uint8)((X + 1 + RandHelper(NumColors - 1)) % NumColors);
+		PlantMovePattern(Board, Cells, Assigned, X, Y, RandHelper);
+
+		// 2. 逐格填充不会形成匹配的颜色（空洞保持为空）
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			if (Assigned & BoardType::CellBit(Index))
+			{
+				continue;
+			}
+			if (Holes & BoardType::CellBit(Index))
+			{
+				Cells[Index] = BoardType::EmptyColor;
+				continue;
+			}
+
+			const uint32 Allowed = ~ForbiddenColors(Cells, Assigned, Index) & AllColorsMask;
+			checkSlow(Allowed != 0);
+			Cells[Index] = PickNthColor(Allowed, RandHelper(FMath::CountBits(Allowed)));
+			Assigned |= BoardType::CellBit(Index);
+		}
+
+		Board.SetCells(Cells);
+	}
+
+	/**
+	 * 死锁洗牌：重新排列棋盘上现有的方块（每种颜色数量不变）
+	 * 同样先埋入可交换图案，再按剩余数量加权随机填充
+	 * @return 是否成功（颜色分布过于极端、或尝试次数用尽时返回 false，由调用方改为重新生成）
+	 */
+	template <typename RandFunc>
+	static bool Reshuffle(BoardType& Board, RandFunc&& RandHelper)
+	{
+		int32 Counts[NumColors];
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			Counts[Color] = FMatch3Bits::Count(Board.GetColorMask(Color));
+		}
+		const FMask Holes = ~Board.GetPlayableMask();
+
+		// 至少需要一种颜色有3个以上、另一种颜色有1个以上才能埋入图案
+		uint32 XCandidates = 0;
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			if (Counts[Color] >= 3)
+			{
+				XCandidates |= 1u << Color;
+			}
+		}
+		if (XCandidates == 0)
+		{
+			return false;
+		}
+
+		uint8 Cells[NumCells];
+		for (int32 Attempt = 0; Attempt < MaxReshuffleAttempts; ++Attempt)
+		{
+			int32 Remaining[NumColors];
+			for (int32 Color = 0; Color < NumColors; ++Color)
+			{
+				Remaining[Color] = Counts[Color];
+			}
+
+			const uint8 X = PickNthColor(XCandidates, RandHelper(FMath::CountBits(XCandidates)));
+			const uint32 YCandidates = NonEmptyColors(Remaining) & ~(1u << X);
+			if (YCandidates == 0)
+			{
+				return false;
+			}
+			const uint8 Y = PickNthColor(YCandidates, RandHelper(FMath::CountBits(YCandidates)));
+
+			FMask Assigned = 0;
+			PlantMovePattern(Board, Cells, Assigned, X, Y, RandHelper);
+			Remaining[X] -= 3;
+			Remaining[Y] -= 1;
+
+			bool bSucceeded = true;
+			for (int32 Index = 0; Index < NumCells; ++Index)
+			{
+				if (Assigned & BoardType::CellBit(Index))
+				{
+					continue;
+				}
+				if (Holes & BoardType::CellBit(Index))
+				{
+					Cells[Index] = BoardType::EmptyColor;
+					continue;
+				}
+
+				const uint32 Allowed = ~ForbiddenColors(Cells, Assigned, Index) & NonEmptyColors(Remaining);
+				if (Allowed == 0)
+				{
+					bSucceeded = false;
+					break;
+				}
+
+				// 按剩余数量加权，优先消耗数量多的颜色，降低末尾无色可选的概率
+				int32 TotalWeight = 0;
+				for (int32 Color = 0; Color < NumColors; ++Color)
+				{
+					if (Allowed & (1u << Color))
+					{
+						TotalWeight += Remaining[Color];
+					}
+				}
+
+				int32 Pick = RandHelper(TotalWeight);
+				uint8 Chosen = 0;
+				for (int32 Color = 0; Color < NumColors; ++Color)
+				{
+					if (Allowed & (1u << Color))
+					{
+						if (Pick < Remaining[Color])
+						{
+							Chosen = (uint8)Color;
+							break;
+						}
+						Pick -= Remaining[Color];
+					}
+				}
+
+				Cells[Index] = Chosen;
+				Remaining[Chosen]--;
+				Assigned |= BoardType::CellBit(Index);
+			}
+
+			if (bSucceeded)
+			{
+				Board.SetCells(Cells);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+private:
+	static constexpr uint32 AllColorsMask = (1u << NumColors) - 1;
+
+	// 在随机位置（横向或纵向）埋入 X Y X X 或 X X Y X，交换 Y 与相邻的 X 即可形成3连
+	template <typename RandFunc>
+	static void PlantMovePattern(const BoardType& Board, uint8* Cells, FMask& Assigned, uint8 X, uint8 Y, RandFunc&& RandHelper)
+	{
+		bool bHorizontal;
+		int32 StartIdx;
+		if (Board.IsFullShape() && !Board.GetLockedMask())
+		{
+			bHorizontal = RandHelper(2) == 0;
+			const int32 Row = bHorizontal ? RandHelper(Rows) : RandHelper(Rows - 3);
+			const int32 Col = bHorizontal ? RandHelper(Cols - 3) : RandHelper(Cols);
+			StartIdx = Row * Cols + Col;
+		}
+		else
+		{
+			// 不规则棋盘或有锁定格子：在4格都可交换的起点中随机选择，没有时退回为4格都可用
+			FMask HorizontalStarts, VerticalStarts;
+			FindPatternStarts(Board.GetSwappableMask(), HorizontalStarts, VerticalStarts);
+			if (!HorizontalStarts && !VerticalStarts)
+			{
+				FindPatternStarts(Board.GetPlayableMask(), HorizontalStarts, VerticalStarts);
+			}
+			const int32 NumHorizontal = FMatch3Bits::Count(HorizontalStarts);
+			const int32 NumStarts = NumHorizontal + FMatch3Bits::Count(VerticalStarts);
+			if (NumStarts == 0)
+			{
+				checkf(false, TEXT("Match3 board shape has no 4 consecutive playable cells"));
+				return;
+			}
+
+			const int32 Pick = RandHelper(NumStarts);
+			bHorizontal = Pick < NumHorizontal;
+			StartIdx = bHorizontal
+				? FMatch3Bits::NthIndex(HorizontalStarts, Pick)
+				: FMatch3Bits::NthIndex(VerticalStarts, Pick - NumHorizontal);
+		}
+
+		const int32 Step = bHorizontal ? 1 : Cols;
+		const int32 GapOffset = 1 + RandHelper(2);
+		for (int32 Offset = 0; Offset < 4; ++Offset)
+		{
+			const int32 Index = StartIdx + Offset * Step;
+			Cells[Index] = (Offset == GapOffset) ? Y : X;
+			Assigned |= BoardType::CellBit(Index);
+		}
+	}
+
+	// 掩码 P 中横向 / 纵向连续4格的起点
+	static void FindPatternStarts(FMask P, FMask& OutHorizontal, FMask& OutVertical)
+	{
+		OutHorizontal = P & (P >> 1) & (P >> 2) & (P >> 3) & FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, Cols - 3);
+		OutVertical = P & (P >> Cols) & (P >> (Cols * 2)) & (P >> (Cols * 3)) & FMatch3Bits::Rect<FMask>(Cols, 0, Rows - 3, 0, Cols);
+	}
+
+	// 会与已确定格子组成3连的颜色（按位返回）
+	static uint32 ForbiddenColors(const uint8* Cells, const FMask& Assigned, int32 Index)
+	{
+		const int32 Row = Index / Cols;
+		const int32 Col = Index % Cols;
+		uint32 Forbidden = 0;
+
+		auto CheckPair = [Cells, Assigned, &Forbidden](int32 A, int32 B)
+		{
+			if ((Assigned & BoardType::CellBit(A)) && (Assigned & BoardType::CellBit(B)) && Cells[A] == Cells[B])
+			{
+				Forbidden |= 1u << Cells[A];
+			}
+		};
+
+		// 横向：左侧两个、左右各一个、右侧两个
+		if (Col >= 2) CheckPair(Index - 1, Index - 2);
+		if (Col >= 1 && Col < Cols - 1) CheckPair(Index - 1, Index + 1);
+		if (Col < Cols - 2) CheckPair(Index + 1, Index + 2);
+
+		// 纵向：上方两个、上下各一个、下方两个
+		if (Row >= 2) CheckPair(Index - Cols, Index - Cols * 2);
+		if (Row >= 1 && Row < Rows - 1) CheckPair(Index - Cols, Index + Cols);
+		if (Row < Rows - 2) CheckPair(Index + Cols, Index + Cols * 2);
+
+		return Forbidden;
+	}
+
+	// 剩余数量大于0的颜色（按位返回）
+	static uint32 NonEmptyColors(const int32* Remaining)
+	{
+		uint32 Colors = 0;
+		for (int32 Color = 0; Color < NumColors; ++Color)
+		{
+			if (Remaining[Color] > 0)
+			{
+				Colors |= 1u << Color;
+			}
+		}
+		return Colors;
+	}
+
+	// 取颜色集合中的第 N 个颜色
+	static uint8 PickNthColor(uint32 Colors, int32 N)
+	{
+		for (int32 Skip = 0; Skip < N; ++Skip)
+		{
+			Colors &= Colors - 1;
+		}
+		return (uint8)FMath::CountTrailingZeros(Colors);
+	}
+};
+
+using FMatch3Generator = TMatch3Generator<FMatch3Board>;
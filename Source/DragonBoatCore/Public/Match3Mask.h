@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+
+/**
+ * 宽位掩码 - 由 NumWords 个 uint64 组成的定长无符号整数，用于超过 64 格的棋盘（如 12x12 = 144 格）
+ * 位运算与移位的语义与 uint64 相同（移出最高位的部分被丢弃），棋盘代码对两种掩码的写法完全一致
+ * 移位量在棋盘代码中几乎都是编译期常量，内联后每个字只剩一两条移位指令
+ */
+template <int32 NumWords>
+struct TMatch3WideMask
+{
+	static_assert(NumWords > 1, "Boards with at most 64 cells use uint64 masks");
+
+	uint64 Words[NumWords];
+
+	constexpr TMatch3WideMask()
+		: Words{}
+	{}
+
+	// 允许从 uint64 隐式构造，与 uint64 掩码一样可以写 Mask = 0、Mask != 0
+	constexpr TMatch3WideMask(uint64 LowWord)
+		: Words{ LowWord }
+	{}
+
+	static constexpr TMatch3WideMask Bit(int32 Index)
+	{
+		TMatch3WideMask Result;
+		Result.Words[Index >> 6] = 1ULL << (Index & 63);
+		return Result;
+	}
+
+	constexpr explicit operator bool() const
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			if (Words[Word])
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	constexpr bool operator==(const TMatch3WideMask& Other) const
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			if (Words[Word] != Other.Words[Word])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	constexpr bool operator!=(const TMatch3WideMask& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	constexpr TMatch3WideMask operator~() const
+	{
+		TMatch3WideMask Result;
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Result.Words[Word] = ~Words[Word];
+		}
+		return Result;
+	}
+
+	constexpr TMatch3WideMask& operator&=(const TMatch3WideMask& Other)
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Words[Word] &= Other.Words[Word];
+		}
+		return *this;
+	}
+
+	constexpr TMatch3WideMask& operator|=(const TMatch3WideMask& Other)
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Words[Word] |= Other.Words[Word];
+		}
+		return *this;
+	}
+
+	constexpr TMatch3WideMask& operator^=(const TMatch3WideMask& Other)
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Words[Word] ^= Other.Words[Word];
+		}
+		return *this;
+	}
+
+	constexpr TMatch3WideMask& operator<<=(int32 Shift)
+	{
+		const int32 WordShift = Shift >> 6;
+		const int32 BitShift = Shift & 63;
+		for (int32 Word = NumWords - 1; Word >= 0; --Word)
+		{
+			const int32 Source = Word - WordShift;
+			uint64 Value = Source >= 0 ? Words[Source] << BitShift : 0;
+			if (BitShift != 0 && Source - 1 >= 0)
+			{
+				Value |= Words[Source - 1] >> (64 - BitShift);
+			}
+			Words[Word] = Value;
+		}
+		return *this;
+	}
+
+	constexpr TMatch3WideMask& operator>>=(int32 Shift)
+	{
+		const int32 WordShift = Shift >> 6;
+		const int32 BitShift = Shift & 63;
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			const int32 Source = Word + WordShift;
+			uint64 Value = Source < NumWords ? Words[Source] >> BitShift : 0;
+			if (BitShift != 0 && Source + 1 < NumWords)
+			{
+				Value |= Words[Source + 1] << (64 - BitShift);
+			}
+			Words[Word] = Value;
+		}
+		return *this;
+	}
+
+	friend constexpr TMatch3WideMask operator&(TMatch3WideMask A, const TMatch3WideMask& B) { return A &= B; }
+	friend constexpr TMatch3WideMask operator|(TMatch3WideMask A, const TMatch3WideMask& B) { return A |= B; }
+	friend constexpr TMatch3WideMask operator^(TMatch3WideMask A, const TMatch3WideMask& B) { return A ^= B; }
+	friend constexpr TMatch3WideMask operator<<(TMatch3WideMask A, int32 Shift) { return A <<= Shift; }
+	friend constexpr TMatch3WideMask operator>>(TMatch3WideMask A, int32 Shift) { return A >>= Shift; }
+};
+
+// 格子数为 NumBits 的棋盘使用的掩码类型：不超过 64 格时为 uint64，否则为宽位掩码
+template <int32 NumBits>
+using TMatch3Mask = std::conditional_t<(NumBits <= 64), uint64, TMatch3WideMask<(NumBits + 63) / 64>>;
+
+/**
+ * 掩码工具 - 对 uint64 与宽位掩码提供相同的接口（计数、遍历、构造）
+ */
+struct FMatch3Bits
+{
+	// 第 Index 位
+	template <typename MaskType>
+	static constexpr MaskType Bit(int32 Index)
+	{
+		if constexpr (std::is_same_v<MaskType, uint64>)
+		{
+			return 1ULL << Index;
+		}
+		else
+		{
+			return MaskType::Bit(Index);
+		}
+	}
+
+	// 网格中 [RowBegin, RowEnd) x [ColBegin, ColEnd) 的矩形区域（行宽为 Cols）
+	template <typename MaskType>
+	static constexpr MaskType Rect(int32 Cols, int32 RowBegin, int32 RowEnd, int32 ColBegin, int32 ColEnd)
+	{
+		MaskType Mask = 0;
+		for (int32 Row = RowBegin; Row < RowEnd; ++Row)
+		{
+			for (int32 Col = ColBegin; Col < ColEnd; ++Col)
+			{
+				Mask |= Bit<MaskType>(Row * Cols + Col);
+			}
+		}
+		return Mask;
+	}
+
+	static FORCEINLINE int32 Count(uint64 Mask)
+	{
+		return FMath::CountBits(Mask);
+	}
+
+	template <int32 NumWords>
+	static FORCEINLINE int32 Count(const TMatch3WideMask<NumWords>& Mask)
+	{
+		int32 Total = 0;
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			Total += FMath::CountBits(Mask.Words[Word]);
+		}
+		return Total;
+	}
+
+	// 按位索引升序遍历所有置位：Visit(int32 Index)
+	template <typename VisitFunc>
+	static FORCEINLINE void ForEach(uint64 Mask, VisitFunc&& Visit)
+	{
+		for (uint64 Bits = Mask; Bits; Bits &= Bits - 1)
+		{
+			Visit((int32)FMath::CountTrailingZeros64(Bits));
+		}
+	}
+
+	template <int32 NumWords, typename VisitFunc>
+	static FORCEINLINE void ForEach(const TMatch3WideMask<NumWords>& Mask, VisitFunc&& Visit)
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			for (uint64 Bits = Mask.Words[Word]; Bits; Bits &= Bits - 1)
+			{
+				Visit(Word * 64 + (int32)FMath::CountTrailingZeros64(Bits));
+			}
+		}
+	}
+
+	// 最低置位的索引，Mask 为 0 时返回 INDEX_NONE
+	static FORCEINLINE int32 FirstIndex(uint64 Mask)
+	{
+		return Mask ? (int32)FMath::CountTrailingZeros64(Mask) : INDEX_NONE;
+	}
+
+	template <int32 NumWords>
+	static FORCEINLINE int32 FirstIndex(const TMatch3WideMask<NumWords>& Mask)
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			if (Mask.Words[Word])
+			{
+				return Word * 64 + (int32)FMath::CountTrailingZeros64(Mask.Words[Word]);
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	// 第 N 个置位（从0开始，按位索引升序）的索引，不存在时返回 INDEX_NONE
+	template <typename MaskType>
+	static int32 NthIndex(const MaskType& Mask, int32 N)
+	{
+		int32 Result = INDEX_NONE;
+		ForEach(Mask, [&Result, &N](int32 Index)
+		{
+			if (N-- == 0)
+			{
+				Result = Index;
+			}
+		});
+		return Result;
+	}
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// 士气值配置
+struct FMatch3MoraleConfig
+{
+	int32 MaxMorale;			// 士气值上限（满时转换为技能点）
+	int32 MoralePerTile;		// 每个消除方块贡献的士气值
+	int32 SpecialMoraleBonus;	// 特殊格子（士气提升）额外的士气值
+	int32 MaxSkillPoints;		// 最大技能点数量
+
+	FMatch3MoraleConfig()
+		: MaxMorale(100)
+		, MoralePerTile(5)
+		, SpecialMoraleBonus(20)
+		, MaxSkillPoints(3)
+	{}
+};
+
+// 士气值状态
+struct FMatch3MoraleState
+{
+	int32 CurrentMorale;
+	int32 SkillPoints;
+
+	FMatch3MoraleState()
+		: CurrentMorale(0)
+		, SkillPoints(0)
+	{}
+
+	FMatch3MoraleState(int32 InMorale, int32 InSkillPoints)
+		: CurrentMorale(InMorale)
+		, SkillPoints(InSkillPoints)
+	{}
+};
+
+// 一次增加士气值的结果（调用方据此按顺序通知UI）
+struct FMatch3MoraleResult
+{
+	bool bRejected;				// 技能点已满，拒绝增加（士气值被清零）
+	int32 MoraleAfterAdd;		// 增加后、转换为技能点前的士气值
+	int32 SkillPointsGained;	// 转换得到的技能点
+	bool bResetOnFull;			// 转换后技能点已满，士气值被清零
+	bool bCapped;				// 士气值超过上限被截断
+
+	FMatch3MoraleResult()
+		: bRejected(false)
+		, MoraleAfterAdd(0)
+		, SkillPointsGained(0)
+		, bResetOnFull(false)
+		, bCapped(false)
+	{}
+};
+
+/**
+ * 士气值与技能点规则 - 消除方块积累士气值，士气值满时转换为技能点
+ */
+struct DRAGONBOATCORE_API FMatch3Morale
+{
+	// 计算一次消除的士气值奖励
+	static int32 CalculateReward(const FMatch3MoraleConfig& Config, int32 TileCount, int32 MoraleBoostCount);
+
+	// 增加士气值并转换为技能点（Amount <= 0 时不做任何修改）
+	static FMatch3MoraleResult AddMorale(FMatch3MoraleState& State, const FMatch3MoraleConfig& Config, int32 Amount);
+
+	// 消耗技能点，不足时返回 false
+	static bool ConsumeSkillPoints(FMatch3MoraleState& State, int32 Amount);
+};
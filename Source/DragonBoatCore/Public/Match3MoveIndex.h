@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+/**
+ * 可交换索引 - 用两个边掩码记录棋盘上所有有效交换（7x7 棋盘共 7*6*2 = 84 条相邻边）
+ * 棋盘变化后只重新评估改动格子十字邻域内的边
+ * 只在棋盘稳定（没有匹配）时更新，此时“交换后能形成匹配”即为有效交换
+ * 一端为空洞或锁定格子的边永远无效（锁定改变后用改变的格子调用 Update）
+ */
+template <typename BoardType>
+struct TMatch3MoveIndex
+{
+	using FMask = typename BoardType::FMask;
+
+	static constexpr int32 Rows = BoardType::Rows;
+	static constexpr int32 Cols = BoardType::Cols;
+
+	// 横向边：格子 i 与 i+1（i 不在最右列）
+	static constexpr FMask HorizontalEdgeMask = FMatch3Bits::Rect<FMask>(Cols, 0, Rows, 0, Cols - 1);
+
+	// 纵向边：格子 i 与 i+Cols（i 不在最下行）
+	static constexpr FMask VerticalEdgeMask = FMatch3Bits::Rect<FMask>(Cols, 0, Rows - 1, 0, Cols);
+
+	// 相邻边总数
+	static constexpr int32 NumEdges = Rows * (Cols - 1) + (Rows - 1) * Cols;
+
+	TMatch3MoveIndex()
+		: HorizontalMoves(0)
+		, VerticalMoves(0)
+	{}
+
+	// 清空索引
+	void Reset()
+	{
+		HorizontalMoves = 0;
+		VerticalMoves = 0;
+	}
+
+	// 全量重建（新棋盘/洗牌后调用）
+	int32 Rebuild(const BoardType& Board)
+	{
+		Reset();
+		return Update(Board, BoardType::BoardMask);
+	}
+
+	/**
+	 * 增量更新：重新评估所有端点落在改动格子十字邻域内的边
+	 * @param Board		当前棋盘（必须没有匹配）
+	 * @param DirtyMask	自上次更新以来改动过的格子
+	 * @return			重新评估的边数量
+	 */
+	int32 Update(const BoardType& Board, FMask DirtyMask)
+	{
+		if (!DirtyMask)
+		{
+			return 0;
+		}
+
+		const FMask Swappable = Board.GetSwappableMask();
+		const FMask Influence = BoardType::CrossNeighborhood(DirtyMask);
+		const FMask HorizontalCandidates = (Influence | (Influence >> 1)) & HorizontalEdgeMask;
+		const FMask VerticalCandidates = (Influence | (Influence >> Cols)) & VerticalEdgeMask;
+
+		// 两端都可交换（可用且未锁定）的边才需要试交换
+		const FMask HorizontalPlayable = HorizontalCandidates & Swappable & (Swappable >> 1);
+		const FMask VerticalPlayable = VerticalCandidates & Swappable & (Swappable >> Cols);
+
+		BoardType Scratch = Board;
+		HorizontalMoves = (HorizontalMoves & ~HorizontalCandidates) | EvaluateEdges(Scratch, HorizontalPlayable, 1);
+		VerticalMoves = (VerticalMoves & ~VerticalCandidates) | EvaluateEdges(Scratch, VerticalPlayable, Cols);
+
+		return FMatch3Bits::Count(HorizontalPlayable) + FMatch3Bits::Count(VerticalPlayable);
+	}
+
+	// O(1) 判断两个格子的交换是否有效
+	bool IsValidSwap(int32 IndexA, int32 IndexB) const
+	{
+		const int32 Low = FMath::Min(IndexA, IndexB);
+		const int32 High = FMath::Max(IndexA, IndexB);
+		if (Low < 0 || High >= BoardType::NumCells)
+		{
+			return false;
+		}
+
+		if (High - Low == 1)
+		{
+			return (bool)(HorizontalMoves & BoardType::CellBit(Low));
+		}
+		if (High - Low == Cols)
+		{
+			return (bool)(VerticalMoves & BoardType::CellBit(Low));
+		}
+		return false;
+	}
+
+	// 是否存在任意有效交换（死锁检测）
+	FORCEINLINE bool HasAnyMove() const
+	{
+		return (bool)(HorizontalMoves | VerticalMoves);
+	}
+
+	// 有效交换数量
+	FORCEINLINE int32 Num() const
+	{
+		return FMatch3Bits::Count(HorizontalMoves) + FMatch3Bits::Count(VerticalMoves);
+	}
+
+	FORCEINLINE FMask GetHorizontalMoves() const { return HorizontalMoves; }
+	FORCEINLINE FMask GetVerticalMoves() const { return VerticalMoves; }
+
+	// 遍历所有有效交换：Visit(int32 IndexA, int32 IndexB)，IndexA < IndexB
+	template <typename VisitFunc>
+	void ForEachMove(VisitFunc&& Visit) const
+	{
+		FMatch3Bits::ForEach(HorizontalMoves, [&Visit](int32 Index)
+		{
+			Visit(Index, Index + 1);
+		});
+		FMatch3Bits::ForEach(VerticalMoves, [&Visit](int32 Index)
+		{
+			Visit(Index, Index + Cols);
+		});
+	}
+
+	/**
+	 * 选择 NumCells 个要锁定的格子，使去掉的有效交换尽量多（铁索连环的目标选择）
+	 * 贪心：每次在候选格子中选关联有效交换最多的一个（一样多时随机），去掉这些交换后继续；
+	 * 不选会去掉最后剩余交换的格子，没有可去掉的交换时在不影响交换的候选格子中随机选择
+	 * 每次选择只需十几次位运算：所有格子的关联交换数（0~4）按位平面同时求出
+	 * @return 选中的格子（候选不足时少于 NumCells 个）
+	 */
+	template <typename RandFunc>
+	FMask PickBlockingCells(FMask Candidates, int32 NumCells, RandFunc&& RandHelper) const
+	{
+		FMask Horizontal = HorizontalMoves;
+		FMask Vertical = VerticalMoves;
+		FMask Picked = 0;
+		for (int32 Pick = 0; Pick < NumCells; ++Pick)
+		{
+			const FMask Available = Candidates & ~Picked;
+			if (!Available)
+			{
+				break;
+			}
+
+			// 每个格子关联的有效交换数：边的两个端点各加1，结果按位平面保存（Bit0 + 2*Bit1 + 4*Bit2）
+			FMask Bit0 = 0;
+			FMask Bit1 = 0;
+			FMask Bit2 = 0;
+			auto AddEndpoints = [&Bit0, &Bit1, &Bit2](FMask Endpoints)
+			{
+				const FMask Carry0 = Bit0 & Endpoints;
+				Bit0 ^= Endpoints;
+				const FMask Carry1 = Bit1 & Carry0;
+				Bit1 ^= Carry0;
+				Bit2 |= Carry1;
+			};
+			AddEndpoints(Horizontal);
+			AddEndpoints(Horizontal << 1);
+			AddEndpoints(Vertical);
+			AddEndpoints(Vertical << Cols);
+
+			// 关联数为 1/2/3/4 的格子
+			const FMask Levels[4] = { Bit0 & ~Bit1 & ~Bit2, Bit1 & ~Bit0 & ~Bit2, Bit0 & Bit1 & ~Bit2, Bit2 };
+			const int32 NumRemaining = FMatch3Bits::Count(Horizontal) + FMatch3Bits::Count(Vertical);
+
+			FMask Choices = 0;
+			for (int32 Level = 4; Level >= 1 && !Choices; --Level)
+			{
+				if (Level < NumRemaining)
+				{
+					Choices = Levels[Level - 1] & Available;
+				}
+			}
+			if (!Choices)
+			{
+				Choices = Available & ~(Bit0 | Bit1 | Bit2);
+			}
+			if (!Choices)
+			{
+				break;
+			}
+
+			const FMask Cell = BoardType::CellBit(FMatch3Bits::NthIndex(Choices, RandHelper(FMatch3Bits::Count(Choices))));
+			Picked |= Cell;
+			Horizontal &= ~(Cell | (Cell >> 1));
+			Vertical &= ~(Cell | (Cell >> Cols));
+		}
+		return Picked;
+	}
+
+private:
+	// 逐条试交换候选边，返回其中有效的边
+	static FMask EvaluateEdges(BoardType& Scratch, FMask Candidates, int32 Step)
+	{
+		FMask ValidEdges = 0;
+		FMatch3Bits::ForEach(Candidates, [&Scratch, &ValidEdges, Step](int32 Index)
+		{
+			// 同色交换不会改变棋盘，必然无效
+			if (Scratch.GetColor(Index) == Scratch.GetColor(Index + Step))
+			{
+				return;
+			}
+
+			Scratch.SwapCells(Index, Index + Step);
+			if (Scratch.HasMatchNear(BoardType::CellBit(Index) | BoardType::CellBit(Index + Step)))
+			{
+				ValidEdges |= BoardType::CellBit(Index);
+			}
+			Scratch.SwapCells(Index, Index + Step);
+		});
+		return ValidEdges;
+	}
+
+	// 位 i：格子 i 与 i+1 交换有效
+	FMask HorizontalMoves;
+
+	// 位 i：格子 i 与 i+Cols 交换有效
+	FMask VerticalMoves;
+};
+
+using FMatch3MoveIndex = TMatch3MoveIndex<FMatch3Board>;
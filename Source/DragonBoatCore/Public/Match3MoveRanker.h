@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "Match3Game.h"
+
+// 一个有效交换的首次消除评估
+struct FMatch3MoveScore
+{
+	int32 IndexA;
+	int32 IndexB;
+	int32 ClearedTiles;		// 首次消除的方块数
+	int32 EffectHits[(int32)EMatch3Effect::Count];	// 首次消除中各类特殊格子的触发次数
+	float Score;			// 由调用方的评分函数给出，越高越好
+
+	FMatch3MoveScore()
+		: IndexA(INDEX_NONE)
+		, IndexB(INDEX_NONE)
+		, ClearedTiles(0)
+		, Score(0.0f)
+	{
+		for (int32 Type = 0; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			EffectHits[Type] = 0;
+		}
+	}
+};
+
+/**
+ * 交换排名 - 为提示高亮按得分排序所有有效交换
+ * 只评估交换后的首次消除：连消取决于随机补充的方块，提示阶段无法预知
+ *
+ * 可以分帧执行：Update 在周期预算用完时返回，下次调用从中断处继续；
+ * 棋盘改变（对局修订号变化）后自动重新开始
+ * 所有存储都是定长数组，评估过程不分配堆内存
+ */
+template <typename GameType>
+class TMatch3MoveRanker
+{
+public:
+	using FBoard = typename GameType::FBoard;
+	using FMask = typename GameType::FMask;
+
+	// 有效交换数量上限（所有相邻边）
+	static constexpr int32 MaxMoves = TMatch3MoveIndex<FBoard>::NumEdges;
+
+	// 两次读取时钟之间评估的交换数（读时钟本身也有开销）
+	static constexpr int32 MovesPerTimeCheck = 4;
+
+	TMatch3MoveRanker()
+	{
+		Reset();
+	}
+
+	// 丢弃排名，下次 Update 从头开始
+	void Reset()
+	{
+		Revision = 0;
+		bHasRevision = false;
+		NumRanked = 0;
+		RemainingHorizontal = 0;
+		RemainingVertical = 0;
+	}
+
+	/**
+	 * 继续评估尚未评估的交换，直到全部完成或用完周期预算
+	 * 每次调用至少评估一个交换，预算再小也能在有限帧内完成
+	 * @param Game			当前对局（必须处于稳定状态）
+	 * @param ScoreMove		float(const FMatch3MoveScore&) 评分函数
+	 * @param BudgetCycles	本次调用的预算（FPlatformTime::Cycles64 单位），0 表示不限
+	 * @return				所有有效交换是否都已评估
+	 */
+	template <typename ScoreFunc>
+	bool Update(const GameType& Game, ScoreFunc&& ScoreMove, uint64 BudgetCycles)
+	{
+		if (!bHasRevision || Revision != Game.GetBoardRevision())
+		{
+			Revision = Game.GetBoardRevision();
+			bHasRevision = true;
+			NumRanked = 0;
+			RemainingHorizontal = Game.GetMoveIndex().GetHorizontalMoves();
+			RemainingVertical = Game.GetMoveIndex().GetVerticalMoves();
+		}
+
+		const uint64 StartCycles = BudgetCycles > 0 ? FPlatformTime::Cycles64() : 0;
+		int32 NumEvaluated = 0;
+		while (!IsComplete())
+		{
+			// 先横向边再纵向边，各自按位索引升序
+			int32 IndexA;
+			int32 IndexB;
+			if (RemainingHorizontal)
+			{
+				IndexA = FMatch3Bits::FirstIndex(RemainingHorizontal);
+				IndexB = IndexA + 1;
+				RemainingHorizontal &= ~FBoard::CellBit(IndexA);
+			}
+			else
+			{
+				IndexA = FMatch3Bits::FirstIndex(RemainingVertical);
+				IndexB = IndexA + FBoard::Cols;
+				RemainingVertical &= ~FBoard::CellBit(IndexA);
+			}
+
+			FMatch3MoveScore Move = Evaluate(Game, IndexA, IndexB);
+			Move.Score = ScoreMove(Move);
+			Insert(Move);
+
+			if (BudgetCycles > 0 && ++NumEvaluated % MovesPerTimeCheck == 0
+				&& FPlatformTime::Cycles64() - StartCycles >= BudgetCycles)
+			{
+				break;
+			}
+		}
+		return IsComplete();
+	}
+
+	// 所有有效交换是否都已评估
+	bool IsComplete() const
+	{
+		return bHasRevision && !RemainingHorizontal && !RemainingVertical;
+	}
+
+	// 已评估的交换数，按得分降序（同分时按评估顺序）
+	int32 Num() const { return NumRanked; }
+	const FMatch3MoveScore& operator[](int32 Rank) const { return Ranked[Rank]; }
+
+	// 评估单个交换的首次消除（不修改对局）
+	static FMatch3MoveScore Evaluate(const GameType& Game, int32 IndexA, int32 IndexB)
+	{
+		FMatch3MoveScore Move;
+		Move.IndexA = IndexA;
+		Move.IndexB = IndexB;
+
+		FBoard Scratch = Game.GetBoard();
+		Scratch.SwapCells(IndexA, IndexB);
+
+		FMask Horizontal, Vertical;
+		Scratch.FindMatchesNear(FBoard::CellBit(IndexA) | FBoard::CellBit(IndexB), Horizontal, Vertical);
+		const FMask MatchedMask = Horizontal | Vertical;
+
+		Move.ClearedTiles = FMatch3Bits::Count(MatchedMask);
+		for (int32 Type = 1; Type < (int32)EMatch3Effect::Count; ++Type)
+		{
+			Move.EffectHits[Type] = Game.GetSpecialAreas().CountHits(MatchedMask, (EMatch3Effect)Type);
+		}
+		return Move;
+	}
+
+private:
+	// 插入到第一个得分更低的位置之前，保持降序且同分稳定
+	void Insert(const FMatch3MoveScore& Move)
+	{
+		int32 Position = NumRanked;
+		while (Position > 0 && Ranked[Position - 1].Score < Move.Score)
+		{
+			Ranked[Position] = Ranked[Position - 1];
+			--Position;
+		}
+		Ranked[Position] = Move;
+		++NumRanked;
+	}
+
+	// 排名对应的对局修订号
+	uint32 Revision;
+	bool bHasRevision;
+
+	// 已评估的交换（降序）
+	FMatch3MoveScore Ranked[MaxMoves];
+	int32 NumRanked;
+
+	// 尚未评估的交换（与可交换索引的位含义相同）
+	FMask RemainingHorizontal;
+	FMask RemainingVertical;
+};
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Game.h"
+#include "Match3Morale.h"
+#include "RaceBitStream.h"
+
+// 棋盘同步操作类型（写入消息，只能在末尾追加）
+enum class EMatch3NetOp : uint8
+{
+	End,			// 消息结束：发送端棋盘的校验值
+	Keyframe,		// 完整棋盘：形状、特殊格子、方块、锁定（初始化、洗牌、重新同步）
+	Swap,			// 有效交换的两个格子，以及之后是否紧接着整条连消链
+	Clear,			// 一步消除的格子掩码
+	Fill,			// 下落填充：按 NextColor 的调用顺序写入新方块的颜色，数量由接收端的空格子决定
+	Settle,			// 连消结束，棋盘稳定
+	Locked,			// 锁定格子改变（新的锁定掩码）
+	SpecialAreas,	// 特殊格子布局改变（每种效果的掩码）
+	Morale,			// 士气值与技能点改变
+
+	Count
+};
+
+/**
+ * 棋盘同步写入 - 服务器端按棋盘的改变顺序记录操作，每帧取走一条消息发给客户端
+ * 不发送整个棋盘，只发送改变：交换是两个格子索引，消除是一个格子掩码，下落只发送新方块的颜色（每个2位），
+ * 下落的位置由客户端用同一个 CollapseAndRefill 算出（与服务器逐位相同，也得到同样的下落动画）
+ *
+ * 消息末尾带棋盘校验值，客户端应用后比较，不一致时请求 Keyframe 重新同步
+ * 待发送缓冲在取走后保留容量，预热后记录与取走都不分配堆内存
+ */
+class DRAGONBOATCORE_API FMatch3NetDeltaWriter
+{
+public:
+	static constexpr int32 OpBits = 4;
+	static constexpr int32 CellBits = 6;
+	static constexpr int32 ColorBits = 2;
+	static constexpr int32 StateBits = 3;
+	static constexpr int32 BitsPerCell = 3;
+
+	static_assert((int32)EMatch3NetOp::Count <= (1 << OpBits), "Ops must fit in OpBits");
+	static_assert(FMatch3Board::NumCells <= (1 << CellBits), "Cell indices must fit in CellBits");
+	static_assert(FMatch3Board::NumColors <= (1 << ColorBits), "Colors must fit in ColorBits");
+	static_assert(FMatch3Board::EmptyColor < (1 << BitsPerCell), "Colors and the empty marker must fit in BitsPerCell");
+
+	FMatch3NetDeltaWriter()
+		: Writer(Pending)
+		, LastMorale(INDEX_NONE, INDEX_NONE)
+		, NumPendingOps(0)
+		, NumMessages(0)
+		, NumKeyframes(0)
+		, TotalBytes(0)
+	{}
+
+	// ========== 操作 ==========
+
+	// 完整棋盘；HostState 为发送端当时的棋盘流程状态（由调用方解释）
+	void RecordKeyframe(const FMatch3Game& Game, bool bReshuffle, uint8 HostState);
+
+	// bWholeCascade：发送端一次性结算了整条连消链，同一条消息中接着是全部的 Clear / Fill 与 Settle
+	void RecordSwap(int32 IndexA, int32 IndexB, bool bWholeCascade);
+	void RecordClear(uint64 ClearedMask);
+
+	// 下落填充：先 BeginFill，再按 NextColor 的调用顺序记录每个新方块的颜色
+	void BeginFill() { BeginOp(EMatch3NetOp::Fill); }
+	void RecordFillColor(uint8 Color) { Writer.WriteBits(Color, ColorBits); }
+
+	void RecordSettle() { BeginOp(EMatch3NetOp::Settle); }
+	void RecordLocked(uint64 LockedMask);
+	void RecordSpecialAreas(const FMatch3SpecialAreas& SpecialAreas);
+
+	// 士气值与技能点：与上次发送的相同时不写入
+	void RecordMorale(const FMatch3MoraleState& Morale);
+
+	// 下一次 RecordMorale 一定写入（重新同步时）
+	void ResendMorale() { LastMorale = FMatch3MoraleState(INDEX_NONE, INDEX_NONE); }
+
+	// ========== 消息 ==========
+
+	bool HasPendingOps() const { return NumPendingOps > 0; }
+
+	// 写入 End 与校验值，返回完整的消息（下一次 Clear 之前有效）
+	const TArray<uint8>& Finish(uint32 Checksum);
+
+	// 取走消息后清空待发送缓冲（保留容量）
+	void Clear();
+
+	// ========== 统计 ==========
+
+	int32 GetNumMessages() const { return NumMessages; }
+	int32 GetNumKeyframes() const { return NumKeyframes; }
+	int64 GetTotalBytes() const { return TotalBytes; }
+
+	void ResetStats()
+	{
+		NumMessages = 0;
+		NumKeyframes = 0;
+		TotalBytes = 0;
+	}
+
+private:
+	void BeginOp(EMatch3NetOp Op);
+
+	TArray<uint8> Pending;
+	FRaceBitWriter Writer;
+	FMatch3MoraleState LastMorale;
+	int32 NumPendingOps;
+
+	int32 NumMessages;
+	int32 NumKeyframes;
+	int64 TotalBytes;
+};
+
+/**
+ * 棋盘同步读取 - 依次读取消息中的操作，由调用方应用到自己的棋盘（以便按操作播放动画）
+ * 数据损坏（越界、索引无效）时停止并报告错误，调用方请求 Keyframe 重新同步
+ */
+class DRAGONBOATCORE_API FMatch3NetDeltaReader
+{
+public:
+	FMatch3NetDeltaReader(const uint8* InData, int32 InSize)
+		: Reader(InData, InSize)
+		, Checksum(0)
+		, bEnded(false)
+	{}
+
+	// 读取下一个操作的类型；读到 End 之后或出错时返回 false
+	bool Next(EMatch3NetOp& OutOp);
+
+	// Keyframe：直接替换棋盘（出错时不修改）；流程状态超过 MaxHostState 视为数据损坏
+	void ReadKeyframe(FMatch3Game& Game, bool& bOutReshuffle, uint8& OutHostState,
+		uint8 MaxHostState = (1 << FMatch3NetDeltaWriter::StateBits) - 1);
+
+	// Swap：两个格子必须相邻
+	void ReadSwap(int32& OutIndexA, int32& OutIndexB, bool& bOutWholeCascade);
+
+	// Clear / Locked
+	uint64 ReadMask() { return Reader.ReadMask(); }
+
+	// Fill：用消息中的颜色执行 CollapseAndRefill，OnMove 与服务器端的顺序相同
+	template <typename MoveFunc>
+	uint64 ReadFill(FMatch3Game& Game, MoveFunc&& OnMove)
+	{
+		return Game.CollapseAndRefill([this]() { return ReadFillColor(); }, OnMove);
+	}
+
+	void ReadSpecialAreas(FMatch3SpecialAreas& OutSpecialAreas);
+	void ReadMorale(FMatch3MoraleState& OutMorale);
+
+	bool HasError() const { return Reader.HasError(); }
+	bool HasEnded() const { return bEnded; }
+
+	// End 中的校验值（读到 End 之后有效）
+	uint32 GetChecksum() const { return Checksum; }
+
+private:
+	uint8 ReadFillColor();
+
+	FRaceBitReader Reader;
+	uint32 Checksum;
+	bool bEnded;
+};
+
+/**
+ * 无表现地应用整条消息（基准测试与无头客户端使用）
+ */
+struct DRAGONBOATCORE_API FMatch3NetDelta
+{
+	// 应用消息中的全部操作，返回是否完整读完且校验值一致
+	static bool Apply(const uint8* Data, int32 Size, FMatch3Game& Game, FMatch3MoraleState& Morale);
+
+	// 棋盘校验值：录像的 Checksum（颜色、锁定、士气值、技能点）再加上形状与特殊格子
+	static uint32 ComputeChecksum(const FMatch3Game& Game, const FMatch3MoraleState& Morale);
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+// 特殊格子效果类型（数值与 ESlotEffectType 一致）
+enum class EMatch3Effect : uint8
+{
+	None = 0,
+	SpeedUpSelf,
+	SlowDownEnemy,
+	MoraleBoost,
+
+	Count
+};
+
+/**
+ * 特殊格子布局 - 每种效果用一个掩码保存所在格子
+ * 统计一次消除触发了多少个特殊格子只需要 与运算 + popcount
+ */
+template <typename BoardType>
+struct TMatch3SpecialAreas
+{
+	using FMask = typename BoardType::FMask;
+
+	static constexpr int32 NumEffectTypes = (int32)EMatch3Effect::Count;
+
+	TMatch3SpecialAreas()
+	{
+		Reset();
+	}
+
+	// 清空所有特殊格子
+	void Reset()
+	{
+		for (int32 Type = 0; Type < NumEffectTypes; ++Type)
+		{
+			EffectMasks[Type] = 0;
+		}
+	}
+
+	// 设置格子的效果（None 表示清除）
+	void SetEffect(int32 Index, EMatch3Effect Effect)
+	{
+		const FMask Bit = BoardType::CellBit(Index);
+		for (int32 Type = 1; Type < NumEffectTypes; ++Type)
+		{
+			EffectMasks[Type] &= ~Bit;
+		}
+		if (Effect != EMatch3Effect::None)
+		{
+			EffectMasks[(int32)Effect] |= Bit;
+		}
+	}
+
+	// 整体设置某种效果的所有格子（预编译的布局直接写入掩码），这些格子原有的其他效果被清除
+	void SetEffectMask(EMatch3Effect Effect, FMask Mask)
+	{
+		for (int32 Type = 1; Type < NumEffectTypes; ++Type)
+		{
+			EffectMasks[Type] &= ~Mask;
+		}
+		if (Effect != EMatch3Effect::None)
+		{
+			EffectMasks[(int32)Effect] = Mask;
+		}
+	}
+
+	// 读取格子的效果
+	EMatch3Effect GetEffect(int32 Index) const
+	{
+		const FMask Bit = BoardType::CellBit(Index);
+		for (int32 Type = 1; Type < NumEffectTypes; ++Type)
+		{
+			if (EffectMasks[Type] & Bit)
+			{
+				return (EMatch3Effect)Type;
+			}
+		}
+		return EMatch3Effect::None;
+	}
+
+	// 某种效果的所有格子
+	FMask GetEffectMask(EMatch3Effect Effect) const
+	{
+		return Effect == EMatch3Effect::None ? FMask(0) : EffectMasks[(int32)Effect];
+	}
+
+	// 所有特殊格子
+	FMask GetAnyEffectMask() const
+	{
+		FMask Mask = 0;
+		for (int32 Type = 1; Type < NumEffectTypes; ++Type)
+		{
+			Mask |= EffectMasks[Type];
+		}
+		return Mask;
+	}
+
+	// 被消除的格子中某种效果的触发次数
+	int32 CountHits(FMask ClearedMask, EMatch3Effect Effect) const
+	{
+		return FMatch3Bits::Count(ClearedMask & GetEffectMask(Effect));
+	}
+
+private:
+	// 每种效果所在的格子（下标0即 None 不使用）
+	FMask EffectMasks[NumEffectTypes];
+};
+
+using FMatch3SpecialAreas = TMatch3SpecialAreas<FMatch3Board>;
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Board.h"
+
+/**
+ * 位流写入 - 按位紧凑写入（不按字节对齐），写入调用方的字节数组
+ * 比赛快照与棋盘网络同步共用
+ *
+ * 构造与 Reset 时清空字节数组但保留容量：同一个数组反复写入不分配堆内存
+ */
+class DRAGONBOATCORE_API FRaceBitWriter
+{
+public:
+	explicit FRaceBitWriter(TArray<uint8>& InBytes)
+		: Bytes(InBytes)
+		, NumBits(0)
+	{
+		Bytes.Reset();
+	}
+
+	// 清空已写入的数据，从头开始写
+	void Reset()
+	{
+		Bytes.Reset();
+		NumBits = 0;
+	}
+
+	// 写入 NumBits 位（1~64，低位在前）
+	void WriteBits(uint64 Value, int32 NumBits);
+	void WriteBool(bool bValue) { WriteBits(bValue ? 1 : 0, 1); }
+	void WriteFloat(float Value);
+
+	// 变长整数：每组7位 + 1位继续标志
+	void WritePacked(uint64 Value);
+	void WritePackedSigned(int64 Value) { WritePacked(((uint64)Value << 1) ^ (uint64)(Value >> 63)); }
+
+	// 按棋盘格子数写入掩码
+	void WriteMask(uint64 Mask) { WriteBits(Mask, FMatch3Board::NumCells); }
+
+	int64 GetNumBits() const { return NumBits; }
+
+protected:
+	TArray<uint8>& Bytes;
+	int64 NumBits;
+};
+
+/**
+ * 位流读取 - 读越界时记录错误并返回0，之后的读取都返回0
+ */
+class DRAGONBOATCORE_API FRaceBitReader
+{
+public:
+	FRaceBitReader(const uint8* InData, int32 InSize)
+		: Data(InData)
+		, SizeBits((int64)FMath::Max(InSize, 0) * 8)
+		, BitOffset(0)
+		, bError(false)
+	{}
+
+	// 读取过程中出错（越界或数据与当前对象不符）
+	bool HasError() const { return bError; }
+	void SetError() { bError = true; }
+
+	uint64 ReadBits(int32 NumBits);
+	bool ReadBool() { return ReadBits(1) != 0; }
+	float ReadFloat();
+	uint64 ReadPacked();
+	int64 ReadPackedSigned()
+	{
+		const uint64 Value = ReadPacked();
+		return (int64)(Value >> 1) ^ -(int64)(Value & 1);
+	}
+	uint64 ReadMask() { return ReadBits(FMatch3Board::NumCells); }
+
+	// 读取一个数量并检查上限，超过时记录错误并返回0
+	int32 ReadCount(int32 MaxCount);
+
+	// 剩余的位数（最后一个字节的填充位也计算在内）
+	int64 GetRemainingBits() const { return SizeBits - BitOffset; }
+
+protected:
+	const uint8* Data;
+	int64 SizeBits;
+	int64 BitOffset;
+	bool bError;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FRaceSnapshotWriter;
+class FRaceSnapshotReader;
+
+// 一次排名变化
+struct FRaceRankChange
+{
+	int32 BoatIndex;
+	int32 OldRank;
+	int32 NewRank;
+};
+
+/**
+ * 龙舟登记表 - 任意数量龙舟的进度、排名与完成数据，按结构数组（每个字段一个数组）存放
+ * 排名顺序在两次更新之间几乎不变：增量插入排序只移动顺序变化的龙舟，代价为 O(龙舟数 + 交换次数)
+ *
+ * 数组在 Reset 时按龙舟数分配，之后的更新不分配堆内存；
+ * 进度与排名数组可以直接交给UI（下标即龙舟索引）
+ */
+class DRAGONBOATCORE_API FRaceBoatRegistry
+{
+public:
+	FRaceBoatRegistry()
+		: NumFinished(0)
+	{}
+
+	// 按龙舟数重置（进度0、全部未完成、排名按索引），保留已分配的容量
+	void Reset(int32 NumBoats);
+
+	int32 Num() const { return Progresses.Num(); }
+	int32 GetNumFinished() const { return NumFinished; }
+
+	// ========== 每条龙舟的数据（下标为龙舟索引）==========
+
+	float GetProgress(int32 BoatIndex) const { return Progresses[BoatIndex]; }
+	int32 GetRank(int32 BoatIndex) const { return Ranks[BoatIndex]; }
+	bool HasFinished(int32 BoatIndex) const { return FinishTimes[BoatIndex] >= 0.0f; }
+	float GetFinishTime(int32 BoatIndex) const { return FinishTimes[BoatIndex]; }
+
+	// 排名第 Rank（从1开始）的龙舟
+	int32 GetBoatAtRank(int32 Rank) const { return RankOrder[Rank - 1]; }
+
+	// 所有龙舟的进度 / 排名（从1开始）/ 完成时间（-1 表示未完成）
+	const TArray<float>& GetProgresses() const { return Progresses; }
+	const TArray<int32>& GetRanks() const { return Ranks; }
+	const TArray<float>& GetFinishTimes() const { return FinishTimes; }
+
+	// ========== 更新 ==========
+
+	// 设置未完成龙舟的进度（已完成的龙舟保持完成时的进度）
+	void SetProgress(int32 BoatIndex, float Progress)
+	{
+		if (!HasFinished(BoatIndex))
+		{
+			Progresses[BoatIndex] = Progress;
+		}
+	}
+
+	// 标记龙舟完成，返回完成名次（第几个完成）；已完成时返回 INDEX_NONE
+	int32 MarkFinished(int32 BoatIndex, float FinishTime);
+
+	/**
+	 * 按当前进度重新排名：已完成的在前（按完成时间），未完成的按进度降序，相同时索引小的在前
+	 * 只有顺序改变的龙舟会被移动并记录到排名变化中
+	 * @return 排名变化的龙舟数
+	 */
+	int32 UpdateRanking();
+
+	// 最近一次 UpdateRanking 的排名变化（按龙舟索引升序）
+	int32 GetNumRankChanges() const { return RankChanges.Num(); }
+	const FRaceRankChange& GetRankChange(int32 ChangeIndex) const { return RankChanges[ChangeIndex]; }
+
+	// ========== 快照 ==========
+
+	// 进度、完成时间与排名（恢复时按龙舟数重置，排名不是一个排列时记录错误）
+	void WriteSnapshot(FRaceSnapshotWriter& Writer) const;
+	void ReadSnapshot(FRaceSnapshotReader& Reader);
+
+private:
+	// 龙舟 A 是否排在 B 之前
+	bool IsAhead(int32 BoatA, int32 BoatB) const
+	{
+		const bool bFinishedA = FinishTimes[BoatA] >= 0.0f;
+		const bool bFinishedB = FinishTimes[BoatB] >= 0.0f;
+		if (bFinishedA != bFinishedB)
+		{
+			return bFinishedA;
+		}
+		if (bFinishedA && FinishTimes[BoatA] != FinishTimes[BoatB])
+		{
+			return FinishTimes[BoatA] < FinishTimes[BoatB];
+		}
+		if (!bFinishedA && Progresses[BoatA] != Progresses[BoatB])
+		{
+			return Progresses[BoatA] > Progresses[BoatB];
+		}
+		return BoatA < BoatB;
+	}
+
+	// 每条龙舟的数据
+	TArray<float> Progresses;
+	TArray<float> FinishTimes;
+	TArray<int32> Ranks;
+
+	// 按排名排列的龙舟索引
+	TArray<int32> RankOrder;
+
+	// 本次更新中被移动过的龙舟及其更新前的排名（排名为0表示未移动）
+	TArray<int32> MovedBoats;
+	TArray<int32> PreviousRanks;
+
+	// 最近一次更新的排名变化
+	TArray<FRaceRankChange> RankChanges;
+
+	int32 NumFinished;
+};
@@ -0,0 +1,288 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Game.h"
+#include "Match3Morale.h"
+#include "RaceSimulation.h"
+
+// 录像事件类型（写入文件，只能在末尾追加）
+enum class ERaceReplayEvent : uint8
+{
+	End,			// 录像结束：模拟步数与每条龙舟的完成时间
+	TileInput,		// 玩家点击格子（格子索引、当时棋盘是否正在结算）
+	CastSkill,		// 玩家释放技能（槽位、技能、是否成功）
+	Difficulty,		// 难度改变（难度等级，只用于统计，效果由 SpecialAreas 记录）
+	SpecialAreas,	// 特殊格子布局改变（每种效果的掩码）
+	LockCells,		// 铁索连环锁定格子（新锁定的格子掩码）
+	UnlockCells,	// 解除所有锁定
+	AISkill,		// AI施法决策（施法者、技能、目标、是否被免疫，效果由 Status 记录）
+	Status,			// 状态效果（模拟步、龙舟、效果、数值、持续时间、施加者、是否生效）
+	Checksum,		// 玩家棋盘稳定后的校验值（棋盘、锁定、士气值、技能点）
+
+	Count
+};
+
+/**
+ * 录像文件头 - 开始录制时的完整初始状态
+ * 直接保存棋盘与随机流的当前种子，而不是只保存比赛种子：
+ * 棋盘可能不是由种子刚生成的（播种时棋盘正在结算），回放也不需要重新执行生成
+ */
+struct DRAGONBOATCORE_API FRaceReplayHeader
+{
+	int32 RaceSeed;				// 比赛种子（只用于记录）
+	int32 BoardSeed;			// 棋盘流的当前种子（死锁洗牌）
+	int32 RefillSeed;			// 填充流的当前种子（下落填充）
+
+	// 玩家棋盘
+	uint64 PlayableMask;
+	uint64 LockedMask;
+	uint64 EffectMasks[(int32)EMatch3Effect::Count];
+	uint8 Cells[FMatch3Board::NumCells];
+
+	// 士气值
+	FMatch3MoraleConfig MoraleConfig;
+	FMatch3MoraleState Morale;
+
+	// 比赛模拟（从第0步开始）
+	FRaceSimConfig SimConfig;
+	TArray<float> BaseSpeeds;
+
+	FRaceReplayHeader();
+
+	// 从玩家棋盘、士气值与刚开始的比赛模拟读取（种子由调用方填写）
+	void Capture(const FMatch3Game& Game, const FMatch3MoraleConfig& InMoraleConfig, const FMatch3MoraleState& InMorale, const FRaceSimulation* Simulation);
+};
+
+// 一个录像事件（各字段的含义见 ERaceReplayEvent，未用到的字段为0）
+struct DRAGONBOATCORE_API FRaceReplayEvent
+{
+	ERaceReplayEvent Type;
+	double Time;			// 距录制开始的秒数（毫秒精度）
+
+	int32 Index;			// 格子 / 槽位 / 难度 / 施法者 / 龙舟
+	int32 Value;			// 技能 / 状态效果
+	int32 Target;			// 目标 / 施加者（INDEX_NONE 表示没有）
+	bool bFlag;				// 棋盘正在结算 / 释放成功 / 被免疫 / 状态生效
+	float Magnitude;
+	float Duration;
+	int64 Step;				// 模拟步
+	uint32 Checksum;
+	uint64 Masks[(int32)EMatch3Effect::Count];	// LockCells 只用 Masks[0]
+	TArray<float> FinishTimes;					// End
+
+	FRaceReplayEvent()
+	{
+		Clear(ERaceReplayEvent::End, 0.0);
+	}
+
+	void Clear(ERaceReplayEvent InType, double InTime);
+};
+
+/**
+ * 比赛录像写入 - 紧凑的二进制流：事件类型1字节 + 与上一事件的毫秒间隔（变长整数）+ 按类型编码的参数
+ * 整数与掩码用变长编码，模拟步记录与上一个状态效果的差值，一场比赛通常只有几KB
+ *
+ * 只写入内存中的待写缓冲，调用方定期取走 GetPendingBytes 写入文件（边录边写，不在结束时一次保存）
+ */
+class DRAGONBOATCORE_API FRaceReplayWriter
+{
+public:
+	static constexpr uint32 Magic = 0x50524244;	// "DBRP"
+	static constexpr uint32 Version = 1;
+
+	FRaceReplayWriter()
+		: bRecording(false)
+		, StartTime(0.0)
+		, LastTimeMs(0)
+		, LastStep(0)
+		, NumEvents(0)
+		, TotalBytes(0)
+	{}
+
+	// 开始录制：写入文件头，之后的事件时间相对 Time
+	void Begin(const FRaceReplayHeader& Header, double Time);
+
+	// 写入 End 事件并停止录制（待写缓冲中的数据仍需取走）
+	void End(double Time, const FRaceSimulation* Simulation);
+
+	bool IsRecording() const { return bRecording; }
+
+	// ========== 事件（Time 与 Begin 使用同一时钟，未录制时不做任何事）==========
+
+	void RecordTileInput(double Time, int32 TileIndex, bool bBoardBusy);
+	void RecordCastSkill(double Time, int32 SlotIndex, int32 Skill, bool bSuccess);
+	void RecordDifficulty(double Time, int32 Level);
+	void RecordSpecialAreas(double Time, const FMatch3SpecialAreas& SpecialAreas);
+	void RecordLockCells(double Time, uint64 LockedMask);
+	void RecordUnlockCells(double Time);
+	void RecordAISkill(double Time, int32 CasterIndex, int32 Skill, int32 TargetIndex, bool bBlocked);
+	void RecordStatus(double Time, int64 Step, int32 BoatIndex, int32 Status, float Magnitude, float Duration, int32 SourceIndex, bool bApplied);
+	void RecordChecksum(double Time, uint32 Checksum);
+
+	// ========== 输出 ==========
+
+	const TArray<uint8>& GetPendingBytes() const { return Pending; }
+	void ClearPending() { TotalBytes += Pending.Num(); Pending.Reset(); }
+
+	int32 GetNumEvents() const { return NumEvents; }
+	int64 GetTotalBytes() const { return TotalBytes + Pending.Num(); }
+
+private:
+	// 写入事件类型与时间间隔
+	void BeginEvent(ERaceReplayEvent Type, double Time);
+
+	void WriteByte(uint8 Value) { Pending.Add(Value); }
+	void WriteVarint(uint64 Value);
+	void WriteZigZag(int64 Value) { WriteVarint(((uint64)Value << 1) ^ (uint64)(Value >> 63)); }
+	void WriteFloat(float Value);
+	void WriteUInt32(uint32 Value);
+
+	TArray<uint8> Pending;
+
+	bool bRecording;
+	double StartTime;
+	int64 LastTimeMs;
+	int64 LastStep;
+	int32 NumEvents;
+
+	// 已取走的字节数
+	int64 TotalBytes;
+};
+
+/**
+ * 比赛录像读取 - 依次解码文件头与事件，数据损坏或版本不符时停止并报告错误
+ */
+class DRAGONBOATCORE_API FRaceReplayReader
+{
+public:
+	FRaceReplayReader()
+		: Data(nullptr)
+		, Size(0)
+		, Offset(0)
+		, LastTimeMs(0)
+		, LastStep(0)
+		, bError(false)
+		, bEnded(false)
+	{}
+
+	// 读取文件头（Data 在读取期间必须保持有效）
+	bool Open(const uint8* InData, int32 InSize, FRaceReplayHeader& OutHeader);
+
+	// 读取下一个事件；读到 End 之后或出错时返回 false
+	bool Next(FRaceReplayEvent& OutEvent);
+
+	bool HasError() const { return bError; }
+	bool HasEnded() const { return bEnded; }
+	int32 GetOffset() const { return Offset; }
+
+private:
+	bool ReadByte(uint8& OutValue);
+	bool ReadVarint(uint64& OutValue);
+	bool ReadZigZag(int64& OutValue);
+	bool ReadFloat(float& OutValue);
+	bool ReadUInt32(uint32& OutValue);
+
+	const uint8* Data;
+	int32 Size;
+	int32 Offset;
+	int64 LastTimeMs;
+	int64 LastStep;
+	bool bError;
+	bool bEnded;
+};
+
+// 回放统计
+struct FRaceReplayStats
+{
+	int32 NumEvents;
+	int32 NumTileInputs;
+	int32 NumSwaps;				// 有效交换
+	int32 NumRejectedSwaps;		// 无效交换与结算期间的交换
+	int32 NumReshuffles;
+	int32 NumSkillCasts;
+	int32 NumAISkills;
+	int32 NumStatuses;
+	int32 NumChecksums;
+
+	// 与录制结果不一致的次数（0 表示回放完全复现）
+	int32 NumChecksumMismatches;
+	int32 NumCastMismatches;
+	int32 NumStatusMismatches;
+	int32 NumFinishMismatches;
+	double FirstMismatchTime;	// -1 表示没有不一致
+
+	FRaceReplayStats()
+		: NumEvents(0), NumTileInputs(0), NumSwaps(0), NumRejectedSwaps(0), NumReshuffles(0)
+		, NumSkillCasts(0), NumAISkills(0), NumStatuses(0), NumChecksums(0)
+		, NumChecksumMismatches(0), NumCastMismatches(0), NumStatusMismatches(0), NumFinishMismatches(0)
+		, FirstMismatchTime(-1.0)
+	{}
+
+	int32 NumMismatches() const
+	{
+		return NumChecksumMismatches + NumCastMismatches + NumStatusMismatches + NumFinishMismatches;
+	}
+};
+
+/**
+ * 比赛录像无头回放 - 不需要 World、UObject 与渲染，按事件顺序以最快速度重新执行整场比赛：
+ * 玩家棋盘按 ADatamanagement 的规则重放点击（选中、相邻交换、连消、填充流与棋盘流、士气值、技能点、锁定）；
+ * 比赛模拟在记录的模拟步施加状态效果，直到录像结束时的步数
+ *
+ * 每个 Checksum、技能释放、状态效果与最终完成时间都与录制结果比较，
+ * 一致时回放就是一次完整、可重复的比赛，可直接作为性能回归基准
+ */
+class DRAGONBOATCORE_API FRaceReplayPlayer
+{
+public:
+	FRaceReplayPlayer()
+		: SelectedTileIndex(INDEX_NONE)
+	{}
+
+	// 打开录像并恢复初始状态，格式错误时返回 false
+	bool Open(const uint8* Data, int32 Size);
+
+	// 回放下一个事件，录像结束或出错时返回 false
+	bool Step();
+
+	// 回放到录像结束，返回是否完整读完（不一致见 GetStats）
+	bool PlayToEnd();
+
+	bool HasError() const { return Reader.HasError(); }
+	bool HasEnded() const { return Reader.HasEnded(); }
+
+	const FRaceReplayHeader& GetHeader() const { return Header; }
+	const FRaceReplayStats& GetStats() const { return Stats; }
+	const FMatch3Game& GetGame() const { return Game; }
+	const FMatch3MoraleState& GetMorale() const { return Morale; }
+	const FRaceSimulation& GetSimulation() const { return Simulation; }
+
+	// 玩家棋盘的校验值（录制与回放使用同一个函数）
+	static uint32 ComputeChecksum(const FMatch3Game& Game, const FMatch3MoraleState& Morale);
+
+private:
+	void HandleTileInput(const FRaceReplayEvent& Event);
+
+	// 按 ADatamanagement::ResolveCascade 的顺序结算一次有效交换
+	void PlaySwap(int32 IndexA, int32 IndexB);
+
+	// 死锁时用棋盘流洗牌
+	void ReshuffleIfDeadlocked();
+
+	void RecordMismatch(int32& Counter, double Time);
+
+	FRaceReplayReader Reader;
+	FRaceReplayHeader Header;
+	FRaceReplayEvent Event;
+	FRaceReplayStats Stats;
+
+	FMatch3Game Game;
+	FMatch3MoraleState Morale;
+	FRandomStream BoardStream;
+	FRandomStream RefillStream;
+	int32 SelectedTileIndex;
+
+	FRaceSimulation Simulation;
+};
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RaceStatusEffects.h"
+
+// 比赛模拟配置
+struct FRaceSimConfig
+{
+	float FixedStepSeconds;		// 固定步长（秒）
+	float TrackLength;			// 赛道长度（UE单位）
+	int32 MaxStepsPerAdvance;	// 一次 Advance 最多执行的步数（卡顿时丢弃多余的时间，避免越追越慢）
+
+	FRaceSimConfig()
+		: FixedStepSeconds(1.0f / 60.0f)
+		, TrackLength(10000.0f)
+		, MaxStepsPerAdvance(30)
+	{}
+};
+
+/**
+ * 龙舟比赛模拟 - 固定步长推进每条龙舟的位置，速度 = 基础速度 + 加速/减速/东风效果（不低于0），水淹七军期间速度为0
+ * 状态效果的持续时间换算为整数步，由 FRaceStatusEffects 的时间轮到期，结果只取决于输入发生在第几步，与渲染帧率无关；
+ * 游戏中由 URaceSimulationComponent 每帧 Advance，龙舟 Actor 只跟随位置；
+ * 无头运行时直接 Step / RunToFinish，不需要 World 与渲染
+ *
+ * Reset 之后（效果数量不超过已有容量时）不分配堆内存
+ */
+class DRAGONBOATCORE_API FRaceSimulation
+{
+public:
+	FRaceSimulation()
+		: StepCount(0)
+		, Accumulator(0.0f)
+		, NumFinished(0)
+	{}
+
+	// 按龙舟数重置（位置0、基础速度0、没有状态效果），保留已分配的容量
+	void Reset(const FRaceSimConfig& InConfig, int32 NumBoats);
+
+	const FRaceSimConfig& GetConfig() const { return Config; }
+	int32 Num() const { return Distances.Num(); }
+
+	// ========== 输入（从下一步开始生效）==========
+
+	void SetBaseSpeed(int32 BoatIndex, float Speed) { BaseSpeeds[BoatIndex] = Speed; }
+	float GetBaseSpeed(int32 BoatIndex) const { return BaseSpeeds[BoatIndex]; }
+
+	/**
+	 * 给龙舟（及其棋盘）施加状态效果 DurationSeconds，叠加/刷新规则见 FRaceStatusEffects
+	 * @param SourceIndex 施加者龙舟（INDEX_NONE 表示非敌方来源）
+	 * @return false 表示龙舟已完成或被空城计免疫
+	 */
+	bool ApplyStatus(int32 BoatIndex, ERaceStatus Status, float Magnitude, float DurationSeconds, int32 SourceIndex = INDEX_NONE);
+
+	// ========== 推进 ==========
+
+	// 按帧时间推进：累积时间，每满一个固定步长执行一步，返回执行的步数
+	int32 Advance(float DeltaSeconds);
+
+	// 执行一步
+	void Step();
+
+	// 无头快进：一直执行到所有龙舟完成或模拟时间达到 MaxSeconds，返回执行的步数
+	int32 RunToFinish(float MaxSeconds);
+
+	// ========== 查询 ==========
+
+	int64 GetStepCount() const { return StepCount; }
+	float GetSimTime() const { return StepCount * Config.FixedStepSeconds; }
+
+	// 累积的不足一步的时间占步长的比例（0~1），用于在两步之间插值显示
+	float GetInterpolationAlpha() const { return Accumulator / Config.FixedStepSeconds; }
+
+	float GetDistance(int32 BoatIndex) const { return Distances[BoatIndex]; }
+	float GetInterpolatedDistance(int32 BoatIndex) const
+	{
+		return FMath::Lerp(PreviousDistances[BoatIndex], Distances[BoatIndex], GetInterpolationAlpha());
+	}
+	float GetProgress(int32 BoatIndex) const { return Distances[BoatIndex] / Config.TrackLength; }
+
+	// 当前步使用的速度（不含下一步才生效的输入）
+	float GetSpeed(int32 BoatIndex) const { return Speeds[BoatIndex]; }
+	bool IsStopped(int32 BoatIndex) const { return Statuses.Has(BoatIndex, ERaceStatus::FloodSeven); }
+
+	// 完成时间按最后一步内的位置插值（秒，-1 表示未完成）
+	bool HasFinished(int32 BoatIndex) const { return FinishTimes[BoatIndex] >= 0.0f; }
+	float GetFinishTime(int32 BoatIndex) const { return FinishTimes[BoatIndex]; }
+	int32 GetNumFinished() const { return NumFinished; }
+	bool IsRaceComplete() const { return NumFinished >= Num(); }
+
+	// 状态效果（剩余步数 = GetExpireStep - GetStepCount）
+	const FRaceStatusEffects& GetStatusEffects() const { return Statuses; }
+
+	// ========== 快照 ==========
+
+	// 配置、每条龙舟的数据、步数、累积时间与状态效果（恢复后继续推进的结果与不中断时逐位一致）
+	void WriteSnapshot(FRaceSnapshotWriter& Writer) const;
+	void ReadSnapshot(FRaceSnapshotReader& Reader);
+
+private:
+	// 持续时间换算为步数（向上取整，至少一步）
+	int64 DurationToSteps(float DurationSeconds) const
+	{
+		return FMath::Max<int64>(1, FMath::CeilToInt64(DurationSeconds / Config.FixedStepSeconds));
+	}
+
+	FRaceSimConfig Config;
+
+	// 每条龙舟的数据
+	TArray<float> BaseSpeeds;
+	TArray<float> Speeds;
+	TArray<float> Distances;
+	TArray<float> PreviousDistances;
+	TArray<float> FinishTimes;
+
+	// 每条龙舟的状态效果（每步到期一次）
+	FRaceStatusEffects Statuses;
+
+	// 已执行的步数
+	int64 StepCount;
+
+	// 累积的不足一步的时间
+	float Accumulator;
+
+	int32 NumFinished;
+};
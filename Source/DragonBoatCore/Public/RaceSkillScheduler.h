@@ -0,0 +1,217 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FRaceBoatRegistry;
+class FRaceSnapshotWriter;
+class FRaceSnapshotReader;
+
+/**
+ * AI技能释放调度 - 每个施法者独立的下次释放时间，全部放在一个二叉最小堆中
+ * 堆顶就是最早要释放的施法者，只需要一个计时器对准堆顶；
+ * 调度、取消、取出堆顶都是 O(log 施法者数)，同一时间按施法者索引小的在前
+ *
+ * 数组在 Reset 时按施法者数分配，之后的调度不分配堆内存
+ */
+class DRAGONBOATCORE_API FRaceSkillScheduler
+{
+public:
+	// 按施法者数重置（全部未调度），保留已分配的容量
+	void Reset(int32 InNumCasters);
+
+	int32 NumCasters() const { return HeapPositions.Num(); }
+
+	// 已调度的施法者数
+	int32 Num() const { return Heap.Num(); }
+	bool IsEmpty() const { return Heap.Num() == 0; }
+
+	// 设置施法者的下次释放时间（已调度时改为新时间）
+	void Schedule(int32 Caster, double Time);
+
+	// 取消施法者的调度（未调度时不做任何事）
+	void Cancel(int32 Caster);
+
+	bool IsScheduled(int32 Caster) const { return HeapPositions[Caster] != INDEX_NONE; }
+	double GetCastTime(int32 Caster) const { return Heap[HeapPositions[Caster]].Time; }
+
+	// 最早释放的施法者与时间（堆为空时不可调用）
+	int32 GetNextCaster() const { return Heap[0].Caster; }
+	double GetNextCastTime() const { return Heap[0].Time; }
+
+	// 取出一个到期（释放时间 <= Now）的施法者，没有到期的施法者时返回 INDEX_NONE
+	int32 PopDue(double Now);
+
+	// 快照：释放时间保存为相对 Now 的秒数（恢复到另一个时钟时同样相对 Now）
+	void WriteSnapshot(FRaceSnapshotWriter& Writer, double Now) const;
+	void ReadSnapshot(FRaceSnapshotReader& Reader, double Now);
+
+private:
+	struct FEntry
+	{
+		double Time;
+		int32 Caster;
+	};
+
+	static bool IsEarlier(const FEntry& A, const FEntry& B)
+	{
+		return A.Time != B.Time ? A.Time < B.Time : A.Caster < B.Caster;
+	}
+
+	// 把元素放到堆的指定位置并记录位置
+	void Place(int32 Position, const FEntry& Entry)
+	{
+		Heap[Position] = Entry;
+		HeapPositions[Entry.Caster] = Position;
+	}
+
+	void SiftUp(int32 Position);
+	void SiftDown(int32 Position);
+
+	// 最小堆
+	TArray<FEntry> Heap;
+
+	// 每个施法者在堆中的位置（INDEX_NONE 表示未调度）
+	TArray<int32> HeapPositions;
+};
+
+// AI技能的目标选择策略
+enum class ERaceTargetPolicy : uint8
+{
+	Random,		// 在可选目标中随机
+	Leader,		// 排名最靠前的对手（自己领先时即紧随其后的龙舟）
+	BoatAhead,	// 紧挨在自己前面的龙舟（自己领先时改为紧随其后的龙舟）
+	Adaptive,	// 最近超过自己的龙舟，没有时攻击领先者
+	Count
+};
+
+/**
+ * AI技能目标选择 - 根据比赛实时排名选择减益目标
+ * 每次排名更新时 Observe 一次：保存排名顺序，并与上一次的排名比较，记录每条龙舟最近一次被谁超过；
+ * 只比较排名变化的龙舟（两条龙舟的先后顺序改变时至少有一条的排名改变），代价为 O(排名变化数 x 龙舟数)
+ *
+ * 龙舟索引与 FRaceBoatRegistry 一致；Reset 之后（龙舟数不变时）不分配堆内存
+ */
+class DRAGONBOATCORE_API FRaceSkillTargeting
+{
+public:
+	// 按龙舟数重置（排名按索引、没有超越记录），保留已分配的容量
+	void Reset(int32 NumBoats);
+
+	int32 Num() const { return Ranks.Num(); }
+
+	// 读取一次排名更新（龙舟数与登记表不同时先按登记表重置）
+	void Observe(const FRaceBoatRegistry& Registry, double Time);
+
+	int32 GetRank(int32 BoatIndex) const { return Ranks[BoatIndex]; }
+	bool HasFinished(int32 BoatIndex) const { return Finished[BoatIndex] != 0; }
+
+	// 快照：排名、完成状态与超越记录（超越时间相对 Now）
+	void WriteSnapshot(FRaceSnapshotWriter& Writer, double Now) const;
+	void ReadSnapshot(FRaceSnapshotReader& Reader, double Now);
+
+	// 在 Now 之前 MemorySeconds 内最近一次超过该龙舟的龙舟，没有时返回 INDEX_NONE
+	int32 GetLastOvertaker(int32 BoatIndex, double Now, double MemorySeconds) const
+	{
+		return Overtakers[BoatIndex] != INDEX_NONE && Now - OvertakeTimes[BoatIndex] <= MemorySeconds
+			? Overtakers[BoatIndex] : INDEX_NONE;
+	}
+
+	/**
+	 * 为施法者选择减益目标：只在未完成、不是施法者且 CanTarget 返回 true 的龙舟中选择
+	 * @param MemorySeconds Adaptive 策略中"最近"超越的时间范围
+	 * @return 目标龙舟，没有可选目标时返回 INDEX_NONE
+	 */
+	template <typename FilterFunc, typename RandFunc>
+	int32 PickTarget(int32 Caster, ERaceTargetPolicy Policy, double Now, double MemorySeconds, FilterFunc&& CanTarget, RandFunc&& RandHelper) const
+	{
+		auto IsCandidate = [this, Caster, &CanTarget](int32 BoatIndex)
+		{
+			return BoatIndex != Caster && !Finished[BoatIndex] && CanTarget(BoatIndex);
+		};
+
+		switch (Policy)
+		{
+		case ERaceTargetPolicy::Random:
+		{
+			int32 NumCandidates = 0;
+			for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+			{
+				NumCandidates += IsCandidate(BoatIndex) ? 1 : 0;
+			}
+			if (NumCandidates == 0)
+			{
+				return INDEX_NONE;
+			}
+
+			int32 Pick = RandHelper(NumCandidates);
+			for (int32 BoatIndex = 0; BoatIndex < Num(); ++BoatIndex)
+			{
+				if (IsCandidate(BoatIndex) && Pick-- == 0)
+				{
+					return BoatIndex;
+				}
+			}
+			return INDEX_NONE;
+		}
+
+		case ERaceTargetPolicy::BoatAhead:
+		{
+			// 从自己的名次向前找，再向后找
+			const int32 CasterRank = Ranks[Caster];
+			for (int32 Rank = CasterRank - 1; Rank >= 1; --Rank)
+			{
+				if (IsCandidate(RankOrder[Rank - 1]))
+				{
+					return RankOrder[Rank - 1];
+				}
+			}
+			for (int32 Rank = CasterRank + 1; Rank <= Num(); ++Rank)
+			{
+				if (IsCandidate(RankOrder[Rank - 1]))
+				{
+					return RankOrder[Rank - 1];
+				}
+			}
+			return INDEX_NONE;
+		}
+
+		case ERaceTargetPolicy::Adaptive:
+		{
+			const int32 Overtaker = GetLastOvertaker(Caster, Now, MemorySeconds);
+			if (Overtaker != INDEX_NONE && IsCandidate(Overtaker))
+			{
+				return Overtaker;
+			}
+		}
+		[[fallthrough]];
+
+		case ERaceTargetPolicy::Leader:
+		default:
+			for (int32 BoatIndex : RankOrder)
+			{
+				if (IsCandidate(BoatIndex))
+				{
+					return BoatIndex;
+				}
+			}
+			return INDEX_NONE;
+		}
+	}
+
+private:
+	// 上一次的排名（从1开始）与完成状态
+	TArray<int32> Ranks;
+	TArray<uint8> Finished;
+
+	// 按排名排列的龙舟索引
+	TArray<int32> RankOrder;
+
+	// 本次排名与上一次不同的龙舟
+	TArray<int32> ChangedBoats;
+
+	// 每条龙舟最近一次被谁超过、发生的时间
+	TArray<int32> Overtakers;
+	TArray<double> OvertakeTimes;
+};
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Match3Game.h"
+#include "Match3Morale.h"
+#include "RaceBitStream.h"
+
+/**
+ * 比赛快照写入 - 在位流前写入固定的文件头：标识、版本、棋盘规格、数据长度与 CRC（Finish 时回填），读取端在恢复任何状态之前先校验
+ *
+ * 写入前 Reset 字节数组但保留容量：同一个数组反复写入（每帧的回滚缓冲）不分配堆内存
+ */
+class DRAGONBOATCORE_API FRaceSnapshotWriter : public FRaceBitWriter
+{
+public:
+	static constexpr uint32 Magic = 0x4E534244;	// "DBSN"
+	static constexpr uint32 Version = 1;
+
+	// 文件头字节数：标识4 + 版本1 + 行列颜色3 + 数据长度4 + CRC4
+	static constexpr int32 HeaderBytes = 16;
+
+	explicit FRaceSnapshotWriter(TArray<uint8>& InBytes);
+
+	// 回填文件头中的数据长度与 CRC，返回快照的总字节数
+	int32 Finish();
+};
+
+/**
+ * 比赛快照读取 - 构造时校验文件头、数据长度与 CRC
+ */
+class DRAGONBOATCORE_API FRaceSnapshotReader : public FRaceBitReader
+{
+public:
+	FRaceSnapshotReader(const uint8* InData, int32 InSize);
+
+	// 文件头、长度与 CRC 都正确（false 时不应恢复任何状态）
+	bool IsValid() const { return bValid; }
+
+private:
+	bool bValid;
+};
+
+/**
+ * 快照中通用数据的编码：玩家 / AI 棋盘（每格3位）、士气值、随机流
+ */
+struct DRAGONBOATCORE_API FRaceSnapshot
+{
+	// 每格的位数：颜色 0 ~ NumColors-1，空格子为 NumColors
+	static constexpr int32 BitsPerCell = 3;
+
+	// 棋盘：形状、特殊格子、方块、锁定，以及结算中待检查匹配的格子
+	static void WriteGame(FRaceSnapshotWriter& Writer, const FMatch3Game& Game);
+	static void ReadGame(FRaceSnapshotReader& Reader, FMatch3Game& Game);
+
+	static void WriteMorale(FRaceSnapshotWriter& Writer, const FMatch3MoraleState& Morale);
+	static void ReadMorale(FRaceSnapshotReader& Reader, FMatch3MoraleState& Morale);
+
+	// 随机流只保存当前种子（恢复后后续的随机序列与保存时相同）
+	static void WriteStream(FRaceSnapshotWriter& Writer, const FRandomStream& Stream);
+	static void ReadStream(FRaceSnapshotReader& Reader, FRandomStream& Stream);
+};
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FRaceSnapshotWriter;
+class FRaceSnapshotReader;
+
+// 状态效果类型（龙舟速度效果 + 三消棋盘效果，每条龙舟对应自己的棋盘）
+enum class ERaceStatus : uint8
+{
+	SpeedBoost = 0,		// 加速格子：速度 + 数值（每次触发独立计时，叠加）
+	SlowDown,			// 减速格子：速度 + 数值（负数，叠加）
+	EastWind,			// 巧借东风：速度 + 数值
+	FloodSeven,			// 水淹七军：停船
+	HeavyFog,			// 大雾：棋盘被遮挡（数值为透明度）
+	IronChain,			// 铁索连环：棋盘格子被锁定（数值为格子数）
+	EmptyCity,			// 空城计：免疫敌方施加的减益
+
+	Count
+};
+
+// 重复施加同一种效果时的规则
+enum class ERaceStatusStacking : uint8
+{
+	Stack,		// 每次施加独立计时，数值相加
+	Refresh,	// 只保留一份：结束时间取较晚者，数值取最新一次
+};
+
+/**
+ * 状态效果表 - 每个目标（龙舟及其棋盘）的状态效果，按步（FRaceSimulation 的固定步）计时
+ * 到期由一个时间轮处理：按到期步数散列到 NumSlots 个槽，每步只检查当前槽，
+ * 代价与同时生效的效果数量无关（每个效果每转一圈最多被检查一次）
+ *
+ * 空城计生效期间，来自其它目标的减益（减速、水淹七军、大雾、铁索连环）被拒绝
+ * Reset 之后（效果数量不超过已有容量时）不分配堆内存
+ */
+class DRAGONBOATCORE_API FRaceStatusEffects
+{
+public:
+	// 时间轮槽数（2的幂；60步/秒时一圈约4.3秒）
+	static constexpr int32 NumSlots = 256;
+	static constexpr int32 NumStatusTypes = (int32)ERaceStatus::Count;
+
+	static ERaceStatusStacking GetStacking(ERaceStatus Status)
+	{
+		return Status == ERaceStatus::SpeedBoost || Status == ERaceStatus::SlowDown
+			? ERaceStatusStacking::Stack : ERaceStatusStacking::Refresh;
+	}
+
+	// 是否为减益（空城计可以免疫）
+	static bool IsDebuff(ERaceStatus Status)
+	{
+		return Status == ERaceStatus::SlowDown || Status == ERaceStatus::FloodSeven
+			|| Status == ERaceStatus::HeavyFog || Status == ERaceStatus::IronChain;
+	}
+
+	FRaceStatusEffects();
+
+	// 按目标数重置（清空所有效果），保留已分配的容量
+	void Reset(int32 NumTargets);
+
+	int32 NumTargets() const { return ActiveMasks.Num(); }
+
+	/**
+	 * 施加效果：从 CurrentStep 起生效，到 ExpireStep（不含）结束
+	 * @param SourceIndex 施加者（INDEX_NONE 表示非敌方来源，不检查免疫）
+	 * @return false 表示被空城计免疫
+	 */
+	bool Apply(int32 Target, ERaceStatus Status, float Magnitude, int64 ExpireStep, int32 SourceIndex);
+
+	// 处理在 Step 到期的效果（必须按步依次调用），返回到期的效果数
+	int32 Expire(int64 Step);
+
+	// ========== 查询 ==========
+
+	bool Has(int32 Target, ERaceStatus Status) const { return (ActiveMasks[Target] & StatusBit(Status)) != 0; }
+	bool IsImmune(int32 Target) const { return Has(Target, ERaceStatus::EmptyCity); }
+
+	// 生效中的效果（位 = 1 << ERaceStatus）
+	uint32 GetActiveMask(int32 Target) const { return ActiveMasks[Target]; }
+
+	// 数值（叠加效果为所有层之和）
+	float GetMagnitude(int32 Target, ERaceStatus Status) const { return GetState(Target, Status).Magnitude; }
+	int32 GetStackCount(int32 Target, ERaceStatus Status) const { return GetState(Target, Status).StackCount; }
+
+	// 最晚一层的到期步数（未生效时为0）
+	int64 GetExpireStep(int32 Target, ERaceStatus Status) const { return GetState(Target, Status).LatestExpireStep; }
+
+	// 所有目标生效中的效果层数
+	int32 Num() const { return NumActiveEntries; }
+
+	// ========== 快照 ==========
+
+	// 写入所有效果层（到期步数相对 CurrentStep）与每种效果的数值和
+	void WriteSnapshot(FRaceSnapshotWriter& Writer, int64 CurrentStep) const;
+
+	// 按目标数重置后恢复：时间轮每个槽内的顺序与数值和都与保存时相同，之后的到期结果逐位一致
+	void ReadSnapshot(FRaceSnapshotReader& Reader, int64 CurrentStep);
+
+private:
+	static uint32 StatusBit(ERaceStatus Status) { return 1u << (uint32)Status; }
+
+	// 一层效果（时间轮槽内的双向链表节点）
+	struct FEntry
+	{
+		int64 ExpireStep;
+		float Magnitude;
+		int32 Target;
+		ERaceStatus Status;
+		int32 Prev;
+		int32 Next;
+	};
+
+	// 一个目标的一种效果
+	struct FState
+	{
+		int32 StackCount;
+		float Magnitude;
+		int64 LatestExpireStep;
+		int32 RefreshEntry;		// Refresh 规则下唯一的一层
+
+		FState()
+			: StackCount(0), Magnitude(0.0f), LatestExpireStep(0), RefreshEntry(INDEX_NONE)
+		{}
+	};
+
+	FState& GetState(int32 Target, ERaceStatus Status) { return States[Target * NumStatusTypes + (int32)Status]; }
+	const FState& GetState(int32 Target, ERaceStatus Status) const { return States[Target * NumStatusTypes + (int32)Status]; }
+
+	// 插入 / 移出到期步数对应的槽
+	void Link(int32 EntryIndex);
+	void Unlink(int32 EntryIndex);
+
+	// 效果层（到期后放回空闲列表复用）
+	TArray<FEntry> Entries;
+	TArray<int32> FreeEntries;
+
+	// 时间轮：每个槽的链表头
+	int32 Slots[NumSlots];
+
+	// 每个目标的效果状态与生效掩码
+	TArray<FState> States;
+	TArray<uint32> ActiveMasks;
+
+	int32 NumActiveEntries;
+};